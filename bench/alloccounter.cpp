@@ -0,0 +1,54 @@
+#include "benchmark.h"
+#include <atomic>
+#include <cstdlib>
+
+static std::atomic<unsigned long long> allocations(0);
+
+quint64 allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+bool allocationCountingAvailable()
+{
+    return true;
+}
+
+// Interpose the allocator entry points; symbols in the executable take
+// precedence over libc for every shared library, Qt included.
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) __THROW
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) __THROW
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) __THROW
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+
+#else
+
+bool allocationCountingAvailable()
+{
+    return false;
+}
+
+#endif
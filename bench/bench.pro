@@ -0,0 +1,74 @@
+QT       += core concurrent
+QT       -= gui
+CONFIG   += c++11 console release
+CONFIG   -= app_bundle
+TARGET   = macsfancontrol-bench
+TEMPLATE = app
+
+INCLUDEPATH += ../src ../tools/sysfsgen
+
+# Benchmark sources
+SOURCES += \
+    main.cpp \
+    bench_virtualsensors.cpp \
+    bench_sensorfilter.cpp \
+    bench_feedforward.cpp \
+    bench_latency.cpp \
+    bench_rpmtracking.cpp \
+    bench_io.cpp \
+    bench_replay.cpp \
+    bench_discovery.cpp \
+    bench_hwmonreaders.cpp \
+    bench_realtime.cpp \
+    bench_watchdog.cpp \
+    bench_critical.cpp \
+    bench_fanbackend.cpp \
+    bench_optimizer.cpp \
+    bench_influence.cpp \
+    bench_predictive.cpp \
+    ../tools/sysfsgen/synthetictree.cpp \
+    alloccounter.cpp \
+    ../src/virtualsensors.cpp \
+    ../src/sensorfilter.cpp \
+    ../src/fancontroller.cpp \
+    ../src/latencystats.cpp \
+    ../src/fancalibration.cpp \
+    ../src/rpmtracker.cpp \
+    ../src/fansampler.cpp \
+    ../src/realtime.cpp \
+    ../src/fanwatchdog.cpp \
+    ../src/criticalguard.cpp \
+    ../src/fanbackend.cpp \
+    ../src/fanzone.cpp \
+    ../src/influencemodel.cpp \
+    ../src/acousticoptimizer.cpp \
+    ../src/influenceidentifier.cpp \
+    ../src/predictivecontroller.cpp \
+    ../src/thermalmodel.cpp \
+    ../src/smcinterface.cpp \
+    ../src/hwmoninterface.cpp \
+    ../src/hwmonscanner.cpp \
+    ../src/hwmonreaders.cpp \
+    ../src/readprofiler.cpp \
+    ../src/sensordescriptions.cpp \
+    ../src/sensorpipeline.cpp \
+    ../src/controltrace.cpp \
+    ../src/discoverymanifest.cpp \
+    ../src/fansnapshot.cpp
+
+HEADERS += \
+    benchmark.h \
+    ../tools/sysfsgen/synthetictree.h \
+    ../src/smcinterface.h \
+    ../src/hwmoninterface.h \
+    ../src/fansampler.h \
+    ../src/criticalguard.h
+
+# Recorded workload traces replayed by the controller benchmarks
+DEFINES += BENCH_TRACE_DIR=\\\"$$PWD/traces\\\"
+
+# Thermal models the optimizer is identified on and compared against
+DEFINES += BENCH_MODEL_DIR=\\\"$$PWD/../tools/thermalsim/models\\\"
+
+# Compiler flags
+QMAKE_CXXFLAGS += -Wall -Wextra
@@ -0,0 +1,159 @@
+#include "benchmark.h"
+#include "criticalguard.h"
+#include "latencystats.h"
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+#include <QFile>
+#include <QThread>
+#include <unistd.h>
+
+namespace {
+
+const int INTERVAL_MS = 50;
+const int TRIALS = 20;
+const int LIMIT = 90000;
+const int RELEASE = 85000;
+
+// A file and the value it holds once its fan is at maximum
+struct MaxCheck {
+    QString path;
+    int value;
+};
+
+int readValue(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    bool ok = false;
+    int value = file.readLine().trimmed().toInt(&ok);
+    return ok ? value : -1;
+}
+
+bool allAtMaximum(const QVector<MaxCheck>& checks)
+{
+    for (const MaxCheck& check : checks) {
+        if (readValue(check.path) != check.value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// In place, as the kernel updates an attribute; SyntheticSysfsTree::setValue()
+// replaces the file, and the guard's open descriptor would keep the old one
+void setTemperature(const QString& path, int millidegrees)
+{
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        file.write(QByteArray::number(millidegrees) + "\n");
+    }
+}
+
+// Every fan in manual mode at a low speed, as the normal control loop leaves them
+void setLow(SMCInterface *smc, HWMonInterface *hwmon)
+{
+    for (int i = 0; i < smc->getFans().size(); i++) {
+        smc->setFanManualMode(i, true);
+        smc->setFanSpeed(i, smc->getFans()[i].minRPM);
+    }
+    for (int i = 0; i < hwmon->getFans().size(); i++) {
+        hwmon->setFanManualMode(i, true);
+        hwmon->setFanPWM(i, 60);
+    }
+}
+
+} // namespace
+
+// Thermal emergency fast path: a critical sensor on the synthetic tree is
+// pushed over its limit, and the time until every fan file shows maximum
+// speed is measured from outside (sensor write to fan files) and by the
+// guard itself (read that saw the crossing to its last fan write).
+void runCriticalBenchmarks(const SyntheticSysfsTree::Options& options)
+{
+    SyntheticSysfsTree tree(options);
+    if (!tree.isValid()) {
+        fprintf(stderr, "critical: cannot create synthetic sysfs tree\n");
+        return;
+    }
+
+    SMCInterface smc;
+    smc.setSysfsRoot(tree.root());
+    HWMonInterface hwmon;
+    hwmon.setSysfsRoot(tree.root());
+    hwmon.setSmcAvailable(smc.initialize());
+    hwmon.initialize();
+    if (smc.getSensors().isEmpty()) {
+        fprintf(stderr, "critical: the synthetic tree has no SMC sensors\n");
+        return;
+    }
+
+    TempSensor watched = smc.getSensors().first();
+    CriticalSensorGuard guard;
+    guard.addSensor({watched.label, watched.sysfsPath, LIMIT, RELEASE});
+    QVector<MaxCheck> checks;
+    for (const FanInfo& fan : smc.getFans()) {
+        guard.addSMCFan(fan.sysfsPath, fan.maxRPM);
+        checks.append({fan.sysfsPath + "_manual", 1});
+        checks.append({fan.sysfsPath + "_output", fan.maxRPM});
+    }
+    for (const HWMonFan& fan : hwmon.getFans()) {
+        QString pwm = fan.devicePath + "/pwm" + QString::number(fan.fanNumber);
+        guard.addHWMonFan(fan.devicePath, fan.fanNumber);
+        checks.append({pwm + "_enable", 1});
+        checks.append({pwm, 255});
+    }
+
+    setTemperature(watched.sysfsPath, LIMIT - 20000);
+    setLow(&smc, &hwmon);
+    guard.start(INTERVAL_MS);
+    QThread::msleep(INTERVAL_MS * 4);
+    check("critical", !guard.isEmergency() && !allAtMaximum(checks), "guard tripped below the limit");
+
+    LatencyHistogram endToEnd;
+    int missed = 0;
+    for (int trial = 0; trial < TRIALS; trial++) {
+        // Land at a different phase of the guard's interval every time
+        usleep(static_cast<useconds_t>((trial * 7919) % (INTERVAL_MS * 1000)));
+        qint64 crossed = monotonicNs();
+        setTemperature(watched.sysfsPath, LIMIT + 5000);
+        while (!allAtMaximum(checks) && monotonicNs() - crossed < 1000000000LL) {
+            usleep(200);
+        }
+        if (allAtMaximum(checks)) {
+            endToEnd.record(monotonicNs() - crossed);
+        } else {
+            missed++;
+        }
+
+        // Between release and limit the emergency holds
+        setTemperature(watched.sysfsPath, (LIMIT + RELEASE) / 2);
+        QThread::msleep(INTERVAL_MS * 3);
+        check("critical", guard.isEmergency(), "emergency released above the release temperature");
+
+        setTemperature(watched.sysfsPath, RELEASE - 5000);
+        qint64 cooled = monotonicNs();
+        while (guard.isEmergency() && monotonicNs() - cooled < 1000000000LL) {
+            usleep(1000);
+        }
+        check("critical", !guard.isEmergency(), "emergency not released below the release temperature");
+        setLow(&smc, &hwmon);
+    }
+    guard.stop();
+
+    LatencyHistogram internal = guard.getTripLatency();
+    LatencyHistogram tickCost = guard.getTickCost();
+    printf("%-48s p50=%8.3f ms  max=%8.3f ms  (%d trips, %d ms interval, %d fans)\n",
+           "critical/sensor write to fans at maximum", endToEnd.percentile(0.50) / 1.0e6,
+           endToEnd.max() / 1.0e6, TRIALS, INTERVAL_MS, guard.getFanCount());
+    printf("%-48s p50=%8.3f ms  max=%8.3f ms\n", "critical/crossing read to last fan write",
+           internal.percentile(0.50) / 1.0e6, internal.max() / 1.0e6);
+    printf("%-48s p50=%8.3f ms  max=%8.3f ms  (%llu ticks)\n", "critical/guard tick",
+           tickCost.percentile(0.50) / 1.0e6, tickCost.max() / 1.0e6,
+           static_cast<unsigned long long>(tickCost.count()));
+    check("critical", missed == 0, "crossing not acted on within 1 s");
+    check("critical", internal.count() == static_cast<quint64>(TRIALS), "guard did not trip once per crossing");
+    check("critical", endToEnd.max() < (INTERVAL_MS + 20) * 1000000LL, "fans not at maximum within one interval + 20 ms");
+    fflush(stdout);
+}
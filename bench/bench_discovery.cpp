@@ -0,0 +1,146 @@
+#include "benchmark.h"
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+#include "sensorpipeline.h"
+#include "discoverymanifest.h"
+#include "fansnapshot.h"
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+namespace {
+
+QString readLine(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+    QTextStream in(&file);
+    return in.readLine();
+}
+
+// The hwmon discovery HWMonDirectory replaced, kept as a baseline:
+// QDir::entryList with wildcards, a QRegularExpression per matching file and
+// a concatenated path per attribute. Returns the number of channels found.
+int legacyHWMonScan(const QString& root)
+{
+    int channels = 0;
+    QString hwmonRoot = root + "/sys/class/hwmon";
+    for (const QString& hwmonDev : QDir(hwmonRoot).entryList(QStringList() << "hwmon*", QDir::Dirs)) {
+        QString hwmonPath = hwmonRoot + "/" + hwmonDev;
+        if (readLine(hwmonPath + "/name").trimmed().isEmpty()) {
+            continue;
+        }
+        QDir dir(hwmonPath);
+        for (const QString& fanFile : dir.entryList(QStringList() << "fan*_input", QDir::Files)) {
+            QRegularExpression re("fan(\\d+)_input");
+            QRegularExpressionMatch match = re.match(fanFile);
+            if (!match.hasMatch()) {
+                continue;
+            }
+            QString basePath = hwmonPath + "/fan" + match.captured(1);
+            QString pwmPath = hwmonPath + "/pwm" + match.captured(1);
+            readLine(basePath + "_input");
+            readLine(basePath + "_min");
+            readLine(basePath + "_max");
+            readLine(basePath + "_label");
+            QFile::exists(pwmPath);
+            readLine(pwmPath);
+            readLine(pwmPath + "_enable");
+            channels++;
+        }
+        for (const QString& tempFile : dir.entryList(QStringList() << "temp*_input", QDir::Files)) {
+            QRegularExpression re("temp(\\d+)_input");
+            QRegularExpressionMatch match = re.match(tempFile);
+            if (!match.hasMatch()) {
+                continue;
+            }
+            QString basePath = hwmonPath + "/temp" + match.captured(1);
+            readLine(basePath + "_input");
+            readLine(basePath + "_label");
+            channels++;
+        }
+    }
+    return channels;
+}
+
+// Startup as MainWindow does it: bring up both backends, then take the
+// first raw sample. Fresh backends every call, like a new process.
+void startup(const QString& root, const QString& manifestPath, bool expectWarm)
+{
+    SMCInterface smc;
+    smc.setSysfsRoot(root);
+    HWMonInterface hwmon;
+    hwmon.setSysfsRoot(root);
+    DiscoveryManifest::Result result = DiscoveryManifest::initializeBackends(&smc, &hwmon, manifestPath);
+    if (result.warm != expectWarm) {
+        fprintf(stderr, "discovery: expected a %s start\n", expectWarm ? "warm" : "cold");
+    }
+
+    SensorFilterBank filters;
+    VirtualSensorEngine virtualSensors;
+    SensorPipeline pipeline(&smc, &hwmon, &filters, &virtualSensors);
+    pipeline.readHardware();
+}
+
+} // namespace
+
+void runDiscoveryBenchmarks(const SyntheticSysfsTree::Options& options)
+{
+    SyntheticSysfsTree tree(options);
+    QTemporaryDir cacheDir;
+    if (!tree.isValid() || !cacheDir.isValid()) {
+        fprintf(stderr, "discovery: cannot create synthetic sysfs tree\n");
+        return;
+    }
+    QString manifestPath = cacheDir.path() + "/discovery.ini";
+    QString root = tree.root();
+    QString shape = QString("%1 hwmon x%2").arg(options.hwmonDevices).arg(options.hwmonSensorsPerDevice);
+
+    // hwmon discovery alone, before and after the directory-fd scanner
+    runBenchmark(QString("discovery/hwmon scan QDir+regex (baseline), %1").arg(shape), 15, 1,
+                 [&root]() {
+                     legacyHWMonScan(root);
+                 });
+    runBenchmark(QString("discovery/HWMonInterface::initialize, %1").arg(shape), 15, 1,
+                 [&root]() {
+                     HWMonInterface hwmon;
+                     hwmon.setSysfsRoot(root);
+                     hwmon.setSmcAvailable(true);
+                     hwmon.initialize();
+                 });
+
+    // Cold: full discovery plus writing the manifest, as on a first launch
+    runBenchmark(QString("discovery/time to first sample cold, %1").arg(shape), 15, 1,
+                 [&root, &manifestPath]() {
+                     QFile::remove(manifestPath);
+                     startup(root, manifestPath, false);
+                 });
+
+    // Warm: key check and restore from the manifest the cold runs left behind
+    runBenchmark(QString("discovery/time to first sample warm, %1").arg(shape), 15, 1,
+                 [&root, &manifestPath]() {
+                     startup(root, manifestPath, true);
+                 });
+
+    // One macsfanctl invocation minus process start: warm topology, snapshot
+    // and JSON, which is what a monitoring agent polling every second pays
+    runBenchmark(QString("discovery/macsfanctl snapshot warm, %1").arg(shape), 15, 1,
+                 [&root, &manifestPath]() {
+                     SMCInterface smc;
+                     smc.setSysfsRoot(root);
+                     HWMonInterface hwmon;
+                     hwmon.setSysfsRoot(root);
+                     DiscoveryManifest::initializeBackends(&smc, &hwmon, manifestPath);
+                     FanSnapshot::capture(&smc, &hwmon).toJson();
+                 });
+
+    SMCInterface smc;
+    smc.setSysfsRoot(root);
+    runBenchmark("discovery/manifest key check", 15, 5, [&root, &smc]() {
+        DiscoveryManifest::currentKey(root, smc.probeBasePath());
+    });
+}
@@ -0,0 +1,169 @@
+#include "benchmark.h"
+#include "fanbackend.h"
+#include "fanzone.h"
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+
+namespace {
+
+} // namespace
+
+// Fan side of MainWindow::updateSensorData: read every fan, then give every
+// fan a new target. "per fan" is the loop before FanBackends, testing each
+// fan's source; "grouped" reads with one batch per backend and writes the
+// queued targets with setSpeeds(). Run with synchronous hwmon reads and with
+// the async readers, whose latest round the batch copies in one pass.
+void runFanBackendBenchmarks(const SyntheticSysfsTree::Options& options)
+{
+    SyntheticSysfsTree::Options fanOptions = options;
+    fanOptions.smcFans = 6;
+    fanOptions.hwmonFansPerDevice = 3;
+    SyntheticSysfsTree tree(fanOptions);
+    if (!tree.isValid()) {
+        fprintf(stderr, "fanbackend: cannot create synthetic sysfs tree\n");
+        return;
+    }
+
+    SMCInterface smc;
+    smc.setSysfsRoot(tree.root());
+    HWMonInterface hwmon;
+    hwmon.setSysfsRoot(tree.root());
+    hwmon.setSmcAvailable(smc.initialize());
+    hwmon.initialize();
+
+    // Interleaved, as fans appear when hwmon devices are discovered between SMC fans
+    QVector<FanSource> sources;
+    QVector<int> sourceIndices;
+    QVector<int> minRPM;
+    QVector<int> maxRPM;
+    FanBackends backends(&smc, &hwmon);
+    QVector<FanInfo> smcFans = smc.getFans();
+    QVector<HWMonFan> hwmonFans = hwmon.getFans();
+    for (int i = 0; i < qMax(smcFans.size(), hwmonFans.size()); i++) {
+        if (i < smcFans.size()) {
+            sources.append(FAN_SOURCE_SMC);
+            sourceIndices.append(i);
+            minRPM.append(smcFans[i].minRPM);
+            maxRPM.append(smcFans[i].maxRPM);
+            backends.addFan(FAN_SOURCE_SMC, i);
+        }
+        if (i < hwmonFans.size()) {
+            sources.append(FAN_SOURCE_HWMON);
+            sourceIndices.append(i);
+            minRPM.append(hwmonFans[i].minRPM);
+            maxRPM.append(hwmonFans[i].maxRPM);
+            backends.addFan(FAN_SOURCE_HWMON, i);
+        }
+    }
+    int fanCount = sources.size();
+    for (int i = 0; i < fanCount; i++) {
+        backends.setManual(i, true);
+    }
+
+    QVector<int> speeds(fanCount, -1);
+    int flip = 0;
+    auto perFanTick = [&]() {
+        flip ^= 1;
+        for (int i = 0; i < fanCount; i++) {
+            if (sources[i] == FAN_SOURCE_SMC) {
+                speeds[i] = smc.getFanCurrentRPM(sourceIndices[i]);
+            } else if (sources[i] == FAN_SOURCE_HWMON) {
+                speeds[i] = hwmon.getFanCurrentRPM(sourceIndices[i]);
+            }
+        }
+        for (int i = 0; i < fanCount; i++) {
+            int rpm = flip ? maxRPM[i] : minRPM[i];
+            if (sources[i] == FAN_SOURCE_SMC) {
+                smc.setFanSpeed(sourceIndices[i], rpm);
+            } else if (sources[i] == FAN_SOURCE_HWMON) {
+                hwmon.setFanSpeed(sourceIndices[i], rpm);
+            }
+        }
+    };
+
+    QVector<FanSpeedWrite> writes;
+    writes.reserve(fanCount);
+    bool allWritten = true;
+    auto groupedTick = [&]() {
+        flip ^= 1;
+        backends.readSpeeds(&speeds);
+        writes.clear();
+        for (int i = 0; i < fanCount; i++) {
+            FanSpeedWrite write = {i, flip ? maxRPM[i] : minRPM[i], monotonicNs(), 0, false};
+            writes.append(write);
+        }
+        backends.setSpeeds(&writes);
+        for (const FanSpeedWrite& write : writes) {
+            allWritten = allWritten && write.ok;
+        }
+    };
+
+    QString suffix = QString(" x%1 fans").arg(fanCount);
+    runBenchmark("fanbackend/sync per fan" + suffix, 25, 20, perFanTick);
+    runBenchmark("fanbackend/sync grouped" + suffix, 25, 20, groupedTick);
+
+    // The readers hold the fan speeds of the last round; reads become copies
+    hwmon.setAsyncReads(HWMonReaders::DEFAULT_DEADLINE_MS);
+    hwmon.getTemperatures();
+    runBenchmark("fanbackend/async per fan" + suffix, 25, 20, perFanTick);
+    runBenchmark("fanbackend/async grouped" + suffix, 25, 20, groupedTick);
+
+    QVector<int> expected(fanCount, -1);
+    for (int i = 0; i < fanCount; i++) {
+        expected[i] = sources[i] == FAN_SOURCE_SMC ? smc.getFanCurrentRPM(sourceIndices[i])
+                                                   : hwmon.getFanCurrentRPM(sourceIndices[i]);
+    }
+    backends.readSpeeds(&speeds);
+    check("fanbackend", speeds == expected, "grouped reads differ from per-fan reads");
+    check("fanbackend", allWritten, "grouped writes failed");
+    for (int i = 0; i < fanCount; i++) {
+        TickLatencyStats::Backend expected = sources[i] == FAN_SOURCE_SMC ? TickLatencyStats::BACKEND_SMC
+                                                                          : TickLatencyStats::BACKEND_HWMON;
+        check("fanbackend", backends.getLatencyBackend(i) == expected, "fan reported under the wrong backend");
+    }
+    hwmon.setAsyncReads(0);
+
+    // Every fan in one zone led by fan 0: one controller decision fanned out
+    // to all fans and written as one batch
+    FanZones zones;
+    FanZone zone;
+    zone.name = "All";
+    for (int i = 0; i < fanCount; i++) {
+        FanZoneMember member = {i, FanZones::DEFAULT_SCALE, 0};
+        zone.members.append(member);
+        zones.setFanRange(i, minRPM[i], maxRPM[i]);
+    }
+    QString errorMessage;
+    check("fanbackend", zones.setZones(QVector<FanZone>() << zone, fanCount, &errorMessage), "zone of every fan rejected");
+    QVector<int> followers = zones.getFollowers(0);
+    bool atLimits = followers.size() == fanCount - 1;
+    for (int fan : followers) {
+        atLimits = atLimits && zones.followerTarget(fan, maxRPM[0]) == maxRPM[fan]
+                   && zones.followerTarget(fan, minRPM[0]) == minRPM[fan];
+    }
+    check("fanbackend", atLimits, "followers not at their own limits with the lead at its limits");
+
+    runBenchmark("fanbackend/zone decision fanned out" + suffix, 25, 20, [&]() {
+        flip ^= 1;
+        int leadRPM = flip ? maxRPM[0] : minRPM[0];
+        qint64 decided = monotonicNs();
+        writes.clear();
+        FanSpeedWrite lead = {0, leadRPM, decided, 0, false};
+        writes.append(lead);
+        for (int fan : followers) {
+            FanSpeedWrite write = {fan, zones.followerTarget(fan, leadRPM), decided, 0, false};
+            writes.append(write);
+        }
+        backends.setSpeeds(&writes);
+    });
+
+    // Half scale puts a follower at the middle of its range when the lead is at maximum
+    if (fanCount > 1) {
+        zone.members[1].scale = 50;
+        zones.setZones(QVector<FanZone>() << zone, fanCount);
+        int middle = (minRPM[1] + maxRPM[1]) / 2;
+        check("fanbackend", qAbs(zones.followerTarget(1, maxRPM[0]) - middle) <= 1, "follower scale not applied");
+    }
+    zone.members.resize(1);
+    check("fanbackend", !zones.setZones(QVector<FanZone>() << zone, fanCount), "single-fan zone accepted");
+}
@@ -0,0 +1,157 @@
+#include "benchmark.h"
+#include "fancontroller.h"
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QtMath>
+
+#ifndef BENCH_TRACE_DIR
+#define BENCH_TRACE_DIR "traces"
+#endif
+
+namespace {
+
+// Replays recorded CPU utilization through a small thermal model of a Mac Pro
+// CPU (die + heatsink) cooled by one fan driven by FanController, and compares
+// the plain curve against the feed-forward variants.
+const double AMBIENT = 25.0;            // °C
+const double IDLE_POWER = 15.0;         // W
+const double LOAD_POWER = 135.0;        // W added at 100% utilization
+const double DIE_CAPACITY = 15.0;       // J/K
+const double DIE_TO_SINK = 0.12;        // K/W
+const double SINK_CAPACITY = 250.0;     // J/K
+const double SINK_G_MIN = 1.0;          // W/K to ambient at minimum RPM
+const double SINK_G_SPAN = 2.5;         // W/K added at maximum RPM
+const double FAN_SPINUP = 3.0;          // Fan time constant, seconds
+const double STEP = 0.05;               // Simulation step, seconds
+const double LIMIT = 80.0;              // °C, for time-above-limit
+
+const int MIN_RPM = 800;
+const int MAX_RPM = 5200;
+
+struct TraceSample {
+    double time;            // Seconds
+    double utilization;     // 0.0-1.0
+};
+
+QVector<TraceSample> loadTrace(const QString& fileName)
+{
+    QVector<TraceSample> trace;
+    QFile file(QString(BENCH_TRACE_DIR) + "/" + fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning("Cannot open trace %s", qPrintable(file.fileName()));
+        return trace;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QStringList fields = line.split(',');
+        if (fields.size() >= 2) {
+            trace.append({fields[0].toDouble(), fields[1].toDouble()});
+        }
+    }
+    return trace;
+}
+
+struct ReplayResult {
+    double peakTemp;        // °C
+    double secondsAbove;    // Time above LIMIT
+    double meanRPM;
+    int writes;             // Fan target changes
+};
+
+ReplayResult replay(const QVector<TraceSample>& trace, double lead, double boost)
+{
+    FanController controller(MIN_RPM, MAX_RPM);
+    controller.setCurve(45, 85);
+    controller.setFeedForward(lead, boost);
+
+    double die = 40.0;
+    double sink = 40.0;
+    double rpm = MIN_RPM;
+    int target = MIN_RPM;
+
+    ReplayResult result = {0.0, 0.0, 0.0, 0};
+    double rpmSum = 0.0;
+    int steps = 0;
+    const int stepsPerSample = qRound(1.0 / STEP);
+
+    for (const TraceSample& sample : trace) {
+        // One sensor tick per trace sample, as in MainWindow::updateSensorData
+        controller.setCpuLoad(sample.utilization);
+        if (controller.update(qRound(die * 1000.0), qRound64(sample.time * 1000.0), &target)) {
+            result.writes++;
+        }
+
+        double power = IDLE_POWER + LOAD_POWER * sample.utilization;
+        for (int i = 0; i < stepsPerSample; i++) {
+            double conductance = SINK_G_MIN + SINK_G_SPAN * (rpm - MIN_RPM) / (MAX_RPM - MIN_RPM);
+            double dieToSink = (die - sink) / DIE_TO_SINK;
+            die += STEP * (power - dieToSink) / DIE_CAPACITY;
+            sink += STEP * (dieToSink - conductance * (sink - AMBIENT)) / SINK_CAPACITY;
+            rpm += STEP / FAN_SPINUP * (target - rpm);
+
+            result.peakTemp = qMax(result.peakTemp, die);
+            if (die > LIMIT) {
+                result.secondsAbove += STEP;
+            }
+            rpmSum += rpm;
+            steps++;
+        }
+    }
+
+    result.meanRPM = steps > 0 ? rpmSum / steps : 0.0;
+    return result;
+}
+
+void replayTrace(const QString& fileName)
+{
+    QVector<TraceSample> trace = loadTrace(fileName);
+    if (trace.isEmpty()) {
+        return;
+    }
+
+    struct Variant {
+        const char *name;
+        double lead;
+        double boost;
+    };
+    const Variant variants[] = {
+        {"curve only", 0.0, 0.0},
+        {"lead 10s", 10.0, 0.0},
+        {"cpu boost 15C", 0.0, 15.0},
+        {"lead 10s + cpu boost 15C", 10.0, 15.0},
+    };
+
+    printf("feedforward/replay %s (%d s)\n", qPrintable(fileName), trace.size());
+    for (const Variant& variant : variants) {
+        ReplayResult result = replay(trace, variant.lead, variant.boost);
+        printf("  %-28s peak %5.1f C  above %.0fC %5.0f s  mean %5.0f RPM  %4d writes\n",
+               variant.name, result.peakTemp, LIMIT, result.secondsAbove,
+               result.meanRPM, result.writes);
+    }
+}
+
+} // namespace
+
+void runFeedForwardBenchmarks()
+{
+    replayTrace("kernel_build.csv");
+    replayTrace("incremental_builds.csv");
+
+    // Per-tick cost of the controller itself
+    FanController controller(MIN_RPM, MAX_RPM);
+    controller.setCurve(45, 85);
+    controller.setFeedForward(10.0, 15.0);
+    qint64 timestamp = 0;
+    int target = 0;
+    runBenchmark("feedforward/update", 25, 10000, [&controller, &timestamp, &target]() {
+        timestamp += 1000;
+        controller.setCpuLoad((timestamp / 1000 % 10) / 10.0);
+        controller.update(50000 + static_cast<int>(timestamp / 1000 % 20) * 500, timestamp, &target);
+    });
+}
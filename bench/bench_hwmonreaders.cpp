@@ -0,0 +1,94 @@
+#include "benchmark.h"
+#include "hwmoninterface.h"
+#include <QThread>
+
+namespace {
+
+// Devices with at least one stale sensor in the latest round
+QStringList staleDevices(const QVector<HWMonSensor>& sensors)
+{
+    QStringList devices;
+    for (const HWMonSensor& sensor : sensors) {
+        if (sensor.stale && !devices.contains(sensor.devicePath)) {
+            devices.append(sensor.devicePath);
+        }
+    }
+    return devices;
+}
+
+} // namespace
+
+// Fault injection for the per-device async readers: one hwmon device is made
+// slow (reads block longer than the deadline) and then hung, and the sample
+// time, the stale flags and the recovery of that device are checked
+void runHWMonReaderBenchmarks(const SyntheticSysfsTree::Options& options)
+{
+    SyntheticSysfsTree tree(options);
+    if (!tree.isValid() || tree.getOptions().hwmonDevices < 2 || tree.getOptions().hwmonSensorsPerDevice < 1 ||
+        tree.getOptions().hwmonFansPerDevice < 1) {
+        fprintf(stderr, "hwmonreaders: needs a synthetic tree with at least 2 hwmon devices\n");
+        return;
+    }
+
+    HWMonInterface hwmon;
+    hwmon.setSysfsRoot(tree.root());
+    hwmon.setSmcAvailable(true);
+    hwmon.initialize();
+    QString slowDevice = tree.root() + "/sys/class/hwmon/hwmon0";
+    QString slowFile = "hwmon0/fan1_input";
+    const int deadlineMs = 10;
+    const int slowMs = 40;
+
+    // The hwmon part of a tick: every temperature, then every fan speed
+    int fanCount = hwmon.getFans().size();
+    auto tick = [&hwmon, fanCount]() {
+        hwmon.getTemperatures();
+        for (int i = 0; i < fanCount; i++) {
+            hwmon.getFanCurrentRPM(i);
+        }
+    };
+
+    runBenchmark("hwmonreaders/sync tick, healthy", 15, 5, tick);
+    hwmon.setAsyncReads(deadlineMs);
+    runBenchmark("hwmonreaders/async tick, healthy", 15, 5, tick);
+    check("hwmonreaders", staleDevices(hwmon.getTemperatures()).isEmpty(), "healthy devices reported stale");
+
+    // Slow: every read of one hwmon0 attribute blocks past the deadline
+    tree.injectDelay(slowFile, slowMs);
+    hwmon.setAsyncReads(0);
+    runBenchmark(QString("hwmonreaders/sync tick, 1 device %1 ms").arg(slowMs), 5, 1, tick);
+    hwmon.setAsyncReads(deadlineMs);
+    BenchmarkResult slow = runBenchmark(QString("hwmonreaders/async tick, 1 device %1 ms").arg(slowMs), 15, 1, tick);
+    check("hwmonreaders", slow.p99Ns < (deadlineMs + 5) * 1.0e6, "a slow device held the sample past the deadline");
+    check("hwmonreaders", staleDevices(hwmon.getTemperatures()) == QStringList(slowDevice),
+          "stale flags not limited to the slow device");
+
+    // Hung: the read does not return for much longer than any tick
+    tree.injectDelay(slowFile, 2000);
+    QThread::msleep(slowMs * 2);
+    hwmon.getTemperatures();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 5; i++) {
+        hwmon.getTemperatures();
+    }
+    check("hwmonreaders", timer.elapsed() < 5 * (deadlineMs + 5), "a hung device held the sample past the deadline");
+    check("hwmonreaders", staleDevices(hwmon.getTemperatures()) == QStringList(slowDevice),
+          "stale flags not limited to the hung device");
+
+    // Recovery once the read returns
+    tree.restore(slowFile);
+    bool recovered = false;
+    for (int i = 0; i < 300 && !recovered; i++) {
+        recovered = staleDevices(hwmon.getTemperatures()).isEmpty();
+    }
+    check("hwmonreaders", recovered, "device still stale after it answered");
+
+    for (const HWMonReaderStatus& status : hwmon.getReaderStatus()) {
+        printf("  %s: answered=%llu missed=%llu last read=%.2f ms\n",
+               status.devicePath.toLocal8Bit().constData(),
+               static_cast<unsigned long long>(status.answered),
+               static_cast<unsigned long long>(status.missed), status.lastReadNs / 1.0e6);
+    }
+    hwmon.setAsyncReads(0);
+}
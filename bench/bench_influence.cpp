@@ -0,0 +1,190 @@
+#include "benchmark.h"
+#include "influenceidentifier.h"
+#include "thermalmodel.h"
+#include <QThread>
+#include <QtMath>
+
+namespace {
+
+const double LOAD = 0.3;                // Light, steady load while identifying
+const double WARMUP_SECONDS = 3000.0;   // A running machine is warm before it starts
+const int SCALE_FANS = 6;               // Mac Pro scale for the fit timing
+const int SCALE_SENSORS = 68;
+
+// Deterministic noise in [-amplitude, amplitude]
+double noise(quint32 *state, double amplitude)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return amplitude * (2.0 * (*state >> 8) / 16777216.0 - 1.0);
+}
+
+QVector<double> settle(const ThermalModel& model, const QVector<FanInfo>& fans, const QVector<double>& positions)
+{
+    ThermalSimulator simulator(model);
+    simulator.setLoad(LOAD);
+    for (int f = 0; f < fans.size(); f++) {
+        simulator.setFanManualMode(f, true);
+        simulator.setFanSpeed(f, fans[f].minRPM + qRound(positions[f] * (fans[f].maxRPM - fans[f].minRPM)));
+    }
+    simulator.step(2.0 * WARMUP_SECONDS);
+
+    QVector<double> temperatures;
+    for (const TempSensor& sensor : simulator.getTemperatures()) {
+        temperatures.append(sensor.temperature / 1000.0);
+    }
+    return temperatures;
+}
+
+} // namespace
+
+// The identification routine against the simulated Mac Pro, one tick per
+// simulated second as the app runs it against the real one. The fitted
+// gains are compared with the simulator's settled response to the same
+// steps, and each fan's suggested input with the sensor its airflow
+// reaches. The least-squares fits are then timed at the size of a real Mac
+// Pro, serially and in parallel across sensors.
+void runInfluenceBenchmarks()
+{
+    QString path = QString(BENCH_MODEL_DIR) + "/macpro5_1.ini";
+    ThermalModel model;
+    QString errorMessage;
+    if (!model.load(path, &errorMessage)) {
+        fprintf(stderr, "influence: %s\n", qPrintable(errorMessage));
+        return;
+    }
+
+    ThermalSimulator simulator(model);
+    QVector<FanInfo> fans = simulator.getFans();
+    InfluenceModel layout;
+    layout.machine = model.name;
+    for (const FanInfo& fan : fans) {
+        layout.fans << fan.label;
+        layout.minRPM << fan.minRPM;
+        layout.maxRPM << fan.maxRPM;
+    }
+    for (const TempSensor& sensor : simulator.getTemperatures()) {
+        layout.sensors << sensor.label;
+    }
+
+    InfluenceIdentifier::Options options;
+    InfluenceIdentifier identifier;
+    simulator.setLoad(LOAD);
+    for (int f = 0; f < fans.size(); f++) {
+        simulator.setFanManualMode(f, true);
+        simulator.setFanSpeed(f, fans[f].minRPM + qRound(options.basePosition * (fans[f].maxRPM - fans[f].minRPM)));
+    }
+    simulator.step(WARMUP_SECONDS);
+
+    identifier.start(layout, options);
+    QVector<double> readings(layout.sensorCount());
+    QVector<int> targets;
+    for (int second = 0; ; second++) {
+        QVector<TempSensor> temps = simulator.getTemperatures();
+        for (int s = 0; s < temps.size(); s++) {
+            readings[s] = temps[s].temperature / 1000.0;
+        }
+        if (!identifier.sample(second, readings, &targets)) {
+            break;
+        }
+        for (int f = 0; f < targets.size(); f++) {
+            simulator.setFanSpeed(f, targets[f]);
+        }
+        simulator.step(1.0);
+    }
+    InfluenceModel fitted = identifier.fit();
+
+    // Reference: settled temperatures before and after each step
+    QVector<double> positions(fans.size(), options.basePosition);
+    QVector<double> base = settle(model, fans, positions);
+    double delta = options.stepPosition - options.basePosition;
+    // Responses under the identifier's threshold come back as no effect
+    double tolerance = InfluenceIdentifier::MIN_RESPONSE_MILLI / 1000.0 / delta;
+    double maxError = 0.0;
+    bool matches = true;
+    printf("influence/identified on %s (%d s, %d fans, %d sensors)\n", qPrintable(model.name),
+           identifier.getTotalSeconds(), fitted.fanCount(), fitted.sensorCount());
+    for (int f = 0; f < fans.size(); f++) {
+        positions[f] = options.stepPosition;
+        QVector<double> stepped = settle(model, fans, positions);
+        positions[f] = options.basePosition;
+
+        QStringList effects;
+        for (int s = 0; s < fitted.sensorCount(); s++) {
+            double expected = (stepped[s] - base[s]) / delta;
+            double gain = fitted.getGain(s, f);
+            double error = qAbs(gain - expected);
+            maxError = qMax(maxError, error);
+            matches = matches && error <= 0.2 * qAbs(expected) + tolerance;
+            if (gain != 0.0) {
+                effects << QString("%1 %2 (%3) C %4 s").arg(fitted.sensors[s]).arg(gain, 0, 'f', 1)
+                               .arg(expected, 0, 'f', 1).arg(qRound(fitted.getTimeConstant(s, f)));
+            }
+        }
+        int suggested = fitted.suggestSensor(f);
+        printf("  %-8s -> %-5s %s\n", qPrintable(fitted.fans[f]),
+               suggested >= 0 ? qPrintable(fitted.sensors[suggested]) : "-", qPrintable(effects.join(", ")));
+    }
+    printf("  max gain error %.2f C\n", maxError);
+    check("influence", matches, "fitted gains differ from the settled step response");
+    check("influence", fitted.suggestSensor(fitted.findFan("PCI")) == fitted.findSensor("Te1P"), "PCI fan not suggested for Te1P");
+    check("influence", fitted.suggestSensor(fitted.findFan("PS")) == fitted.findSensor("Tp0C"), "PS fan not suggested for Tp0C");
+
+    // One known response with sensor noise
+    QVector<double> times;
+    QVector<double> values;
+    quint32 state = 1;
+    for (int t = 0; t < options.stepSeconds; t++) {
+        times.append(t);
+        values.append(50.0 - 6.0 * (1.0 - qExp(-t / 45.0)) + noise(&state, 0.25));
+    }
+    StepResponseFit step = InfluenceIdentifier::fitStep(times, values);
+    check("influence", qAbs(step.response + 6.0) < 0.2 && qAbs(step.timeConstant - 45.0) < 4.5,
+          "step fit does not recover response and time constant");
+
+    // Mac Pro scale: every fan stepped, every sensor first-order with noise
+    InfluenceModel scale;
+    for (int f = 0; f < SCALE_FANS; f++) {
+        scale.fans << QString("Fan%1").arg(f + 1);
+        scale.minRPM << 500;
+        scale.maxRPM << 2800;
+    }
+    for (int s = 0; s < SCALE_SENSORS; s++) {
+        scale.sensors << QString("T%1").arg(s);
+    }
+    InfluenceIdentifier scaled;
+    scaled.start(scale, options);
+    QVector<double> temperatures(SCALE_SENSORS, 40.0);
+    QVector<double> scaleReadings(SCALE_SENSORS);
+    QVector<int> scaleTargets(SCALE_FANS, 0);
+    for (int second = 0; ; second++) {
+        for (int s = 0; s < SCALE_SENSORS; s++) {
+            // Sensor s is cooled 5 C by fan s % 6 running above the middle of its range
+            int fan = s % SCALE_FANS;
+            double target = scaleTargets[fan] > (scale.minRPM[fan] + scale.maxRPM[fan]) / 2 ? 35.0 : 40.0;
+            temperatures[s] += (target - temperatures[s]) * (1.0 - qExp(-1.0 / (20.0 + s)));
+            scaleReadings[s] = temperatures[s] + noise(&state, 0.25);
+        }
+        if (!scaled.sample(second, scaleReadings, &scaleTargets)) {
+            break;
+        }
+    }
+    QString suffix = QString(" %1 fans x %2 sensors").arg(SCALE_FANS).arg(SCALE_SENSORS);
+    BenchmarkResult serial = runBenchmark("influence/fit serial" + suffix, 5, 1, [&]() {
+        fitted = scaled.fit(false);
+    });
+    BenchmarkResult parallel = runBenchmark("influence/fit parallel" + suffix, 5, 1, [&]() {
+        fitted = scaled.fit(true);
+    });
+    printf("  %.1fx with %d threads\n", serial.medianNs / parallel.medianNs, QThread::idealThreadCount());
+
+    bool recovered = true;
+    double expected = -5.0 / delta;
+    for (int s = 0; s < SCALE_SENSORS; s++) {
+        for (int f = 0; f < SCALE_FANS; f++) {
+            double gain = fitted.getGain(s, f);
+            recovered = recovered && (f == s % SCALE_FANS ? qAbs(gain - expected) < 0.1 * qAbs(expected)
+                                                          : gain == 0.0);
+        }
+    }
+    check("influence", recovered, "synthetic gains not recovered at Mac Pro scale");
+}
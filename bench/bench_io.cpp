@@ -0,0 +1,172 @@
+#include "benchmark.h"
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+#include "sensordescriptions.h"
+#include "sensorpipeline.h"
+#include "fancontroller.h"
+#include "readprofiler.h"
+
+namespace {
+
+void benchmarkDescriptions(const QVector<TempSensor>& sensors)
+{
+    const char *const models[] = {"MacPro5,1", "MacBookPro16,1", "iMacPro1,1", "Unknown Mac"};
+    for (const char *model : models) {
+        QString macModel = model;
+        runBenchmark(QString("io/getDescription %1 x%2").arg(model).arg(sensors.size()), 25, 20,
+                     [&sensors, &macModel]() {
+                         for (const TempSensor& sensor : sensors) {
+                             SensorDescriptions::getDescription(sensor.label, macModel);
+                         }
+                     });
+    }
+}
+
+} // namespace
+
+void runIOBenchmarks(const SyntheticSysfsTree::Options& options)
+{
+    SyntheticSysfsTree tree(options);
+    if (!tree.isValid()) {
+        fprintf(stderr, "io: cannot create synthetic sysfs tree\n");
+        return;
+    }
+    printf("io/synthetic tree: %d SMC sensors, %d hwmon devices x %d sensors, %d SMC fans\n",
+           tree.getOptions().smcSensors, tree.getOptions().hwmonDevices,
+           tree.getOptions().hwmonSensorsPerDevice, tree.getOptions().smcFans);
+
+    SMCInterface smc;
+    smc.setSysfsRoot(tree.root());
+    HWMonInterface hwmon;
+    hwmon.setSysfsRoot(tree.root());
+    if (!smc.initialize()) {
+        fprintf(stderr, "io: SMC backend failed to initialize on the synthetic tree\n");
+        return;
+    }
+    hwmon.setSmcAvailable(true);
+    hwmon.initialize();
+
+    // Single sysfs read, the unit every other path is built from
+    QString tempPath = tree.root() + "/sys/devices/platform/applesmc.768/temp1_input";
+    runBenchmark("io/SMCInterface::readSysfsInt", 25, 1000, [&smc, &tempPath]() {
+        smc.readSysfsInt(tempPath);
+    });
+
+    runBenchmark(QString("io/SMCInterface::getTemperatures x%1").arg(smc.getTemperatures().size()),
+                 25, 10, [&smc]() {
+                     smc.getTemperatures();
+                 });
+    runBenchmark(QString("io/HWMonInterface::getTemperatures x%1").arg(hwmon.getTemperatures().size()),
+                 25, 10, [&hwmon]() {
+                     hwmon.getTemperatures();
+                 });
+
+    // Same reads, each timed and accounted per attribute
+    {
+        ReadProfiler profiler;
+        smc.setReadProfiler(&profiler);
+        hwmon.setReadProfiler(&profiler);
+        runBenchmark("io/SMCInterface::getTemperatures profiled", 25, 10, [&smc, &profiler]() {
+            profiler.beginTick();
+            smc.getTemperatures();
+        });
+        runBenchmark("io/HWMonInterface::getTemperatures profiled", 25, 10, [&hwmon, &profiler]() {
+            profiler.beginTick();
+            hwmon.getTemperatures();
+        });
+        for (const QString& line : profiler.summaryLines(5)) {
+            printf("%s\n", line.toLocal8Bit().constData());
+        }
+        smc.setReadProfiler(nullptr);
+        hwmon.setReadProfiler(nullptr);
+    }
+
+    // Same read with one missing and one unparsable attribute per device
+    if (tree.getOptions().hwmonSensorsPerDevice >= 2) {
+        for (int d = 0; d < tree.getOptions().hwmonDevices; d++) {
+            tree.injectFailure(QString("hwmon%1/temp1_input").arg(d));
+            tree.injectGarbage(QString("hwmon%1/temp2_input").arg(d));
+        }
+        runBenchmark(QString("io/HWMonInterface::getTemperatures %1 faults").arg(tree.faultCount()),
+                     25, 10, [&hwmon]() {
+                         hwmon.getTemperatures();
+                     });
+        for (const QString& file : tree.match("hwmon*/temp*_input")) {
+            tree.restore(file);
+        }
+    }
+
+    SensorFilterBank filters;
+    filters.setDefaultSpec(SensorFilterSpec::fromString("median:3 ema:0.5"));
+    VirtualSensorEngine virtualSensors;
+    SensorPipeline pipeline(&smc, &hwmon, &filters, &virtualSensors);
+    QVector<TempSensor> catalog = pipeline.readHardware();
+    virtualSensors.addSensor("CPU Max", "max(TC0C, TC1C, TC2C, TC3C)", catalog);
+    virtualSensors.addSensor("Case", "avg(TA0P, TH1P, TM1P)", catalog);
+
+    benchmarkDescriptions(catalog);
+
+    FanController curve(800, 5200);
+    int temperature = 30000;
+    runBenchmark("io/FanController::calculateFanSpeed", 25, 100000, [&curve, &temperature]() {
+        temperature = temperature >= 95000 ? 30000 : temperature + 37;
+        curve.calculateFanSpeed(temperature, 45, 85);
+    });
+
+    // One MainWindow::updateSensorData tick without the widgets: sample and
+    // filter all sensors, read every fan and let each SMC fan follow a sensor
+    TickLatencyStats latency;
+    QVector<FanInfo> fans = smc.getFans();
+    latency.setFanCount(fans.size());
+    pipeline.setLatencyStats(&latency);
+
+    QVector<FanController> controllers;
+    QVector<int> controlSensors;
+    for (int i = 0; i < fans.size(); i++) {
+        FanController controller(fans[i].minRPM, fans[i].maxRPM);
+        controller.setCurve(45, 85);
+        controller.setHysteresis(1.0, 50);
+        controllers.append(controller);
+        controlSensors.append(catalog[i % catalog.size()].index);
+    }
+    int hwmonFans = hwmon.getFans().size();
+
+    qint64 timestamp = 0;
+    runBenchmark(QString("io/updateSensorData tick x%1 sensors").arg(catalog.size() + virtualSensors.count()),
+                 25, 5, [&]() {
+                     timestamp += 1000;
+                     qint64 sampleStart = monotonicNs();
+                     QVector<TempSensor> temps = pipeline.sample(timestamp);
+                     qint64 sampleEnd = monotonicNs();
+
+                     for (int i = 0; i < fans.size(); i++) {
+                         smc.getFanCurrentRPM(i);
+                         for (const TempSensor& sensor : temps) {
+                             if (sensor.index == controlSensors[i]) {
+                                 int target;
+                                 bool changed = controllers[i].update(sensor.temperature, timestamp, &target);
+                                 qint64 decision = monotonicNs();
+                                 latency.recordDecision(i, sampleEnd, decision);
+                                 if (changed) {
+                                     smc.setFanSpeed(i, target);
+                                     latency.recordWrite(i, TickLatencyStats::BACKEND_SMC,
+                                                         sampleStart, decision, monotonicNs());
+                                 }
+                                 break;
+                             }
+                         }
+                     }
+                     for (int i = 0; i < hwmonFans; i++) {
+                         hwmon.getFanCurrentRPM(i);
+                     }
+
+                     // The temperature panel looks up every description each tick
+                     for (const TempSensor& sensor : temps) {
+                         SensorDescriptions::getDescription(sensor.label, smc.getMacModel());
+                     }
+                 });
+
+    for (const QString& line : latency.summaryLines()) {
+        printf("  %s\n", line.toLocal8Bit().constData());
+    }
+}
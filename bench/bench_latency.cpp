@@ -0,0 +1,39 @@
+#include "benchmark.h"
+#include "latencystats.h"
+
+void runLatencyBenchmarks()
+{
+    volatile qint64 sink = 0;
+    runBenchmark("latency/monotonicNs", 25, 100000, [&sink]() {
+        sink = monotonicNs();
+    });
+
+    LatencyHistogram histogram;
+    quint64 n = 0;
+    runBenchmark("latency/histogram record", 25, 100000, [&histogram, &n]() {
+        // Spread values over several magnitudes
+        histogram.record(static_cast<qint64>((n++ * 2654435761u) % 5000000));
+    });
+
+    // Everything MainWindow adds to one tick of a 6 fan Mac Pro in which
+    // every fan writes: 2 backend samples, 6 decisions and 6 writes
+    TickLatencyStats stats;
+    stats.setFanCount(6);
+    runBenchmark("latency/instrumented tick (6 fans)", 25, 10000, [&stats]() {
+        qint64 start = monotonicNs();
+        qint64 smcDone = monotonicNs();
+        stats.recordSample(TickLatencyStats::BACKEND_SMC, start, smcDone);
+        qint64 sampleEnd = monotonicNs();
+        stats.recordSample(TickLatencyStats::BACKEND_HWMON, smcDone, sampleEnd);
+        for (int fan = 0; fan < 6; fan++) {
+            qint64 decided = monotonicNs();
+            qint64 committed = monotonicNs();
+            stats.recordDecision(fan, sampleEnd, decided);
+            stats.recordWrite(fan, TickLatencyStats::BACKEND_SMC, start, decided, committed);
+        }
+    });
+
+    runBenchmark("latency/export text", 15, 100, [&stats]() {
+        stats.exportText();
+    });
+}
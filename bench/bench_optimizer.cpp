@@ -0,0 +1,289 @@
+#include "benchmark.h"
+#include "acousticoptimizer.h"
+#include "fancontroller.h"
+#include "thermalmodel.h"
+
+namespace {
+
+const double SETTLE_SECONDS = 5000.0;
+const double BASE_POSITION = 0.5;
+const double TICK = 1.0;
+
+// Sensors held below a limit, with the model's sensor labels
+struct LimitSpec {
+    const char *sensor;
+    double limit;           // °C
+};
+
+const LimitSpec LIMITS[] = {
+    {"TCAD", 65.0},
+    {"TCBD", 65.0},
+    {"Tp0C", 55.0},
+    {"Te1P", 45.0},
+};
+const int LIMIT_COUNT = sizeof(LIMITS) / sizeof(LIMITS[0]);
+
+// Light, heavy, then medium load
+struct LoadStep {
+    double seconds;
+    double utilization;
+};
+
+const LoadStep TRACE[] = {
+    {600.0, 0.2},
+    {1200.0, 1.0},
+    {900.0, 0.5},
+};
+
+int rpmAt(const FanInfo& fan, double position)
+{
+    return fan.minRPM + qRound(position * (fan.maxRPM - fan.minRPM));
+}
+
+// Every sensor's temperature once the simulator settles at this load and
+// these fan positions
+QVector<double> settle(const ThermalModel& model, double utilization, const QVector<double>& positions)
+{
+    ThermalSimulator simulator(model);
+    simulator.setLoad(utilization);
+    QVector<FanInfo> fans = simulator.getFans();
+    for (int f = 0; f < fans.size(); f++) {
+        simulator.setFanManualMode(f, true);
+        simulator.setFanSpeed(f, rpmAt(fans[f], positions[f]));
+    }
+    simulator.step(SETTLE_SECONDS);
+
+    QVector<double> temperatures;
+    for (const TempSensor& sensor : simulator.getTemperatures()) {
+        temperatures.append(sensor.temperature / 1000.0);
+    }
+    return temperatures;
+}
+
+// What the identification routine measures on a real machine: each fan's
+// steady-state effect on every sensor, by finite differences around the
+// middle of every fan's range
+InfluenceModel identify(const ThermalModel& model)
+{
+    ThermalSimulator simulator(model);
+    InfluenceModel influence;
+    influence.machine = model.name;
+    for (const FanInfo& fan : simulator.getFans()) {
+        influence.fans << fan.label;
+        influence.minRPM << fan.minRPM;
+        influence.maxRPM << fan.maxRPM;
+    }
+    for (const TempSensor& sensor : simulator.getTemperatures()) {
+        influence.sensors << sensor.label;
+    }
+    influence.resize();
+
+    QVector<double> positions(influence.fanCount(), BASE_POSITION);
+    QVector<double> base = settle(model, 0.5, positions);
+    for (int f = 0; f < influence.fanCount(); f++) {
+        positions[f] = 1.0;
+        QVector<double> bumped = settle(model, 0.5, positions);
+        positions[f] = BASE_POSITION;
+        for (int s = 0; s < influence.sensorCount(); s++) {
+            influence.setGain(s, f, (bumped[s] - base[s]) / (1.0 - BASE_POSITION));
+        }
+    }
+    return influence;
+}
+
+struct RunResult {
+    double meanNoise;       // dB, over all ticks
+    double maxNoise;
+    QVector<double> peak;   // °C per limit
+    int writes;
+};
+
+// Runs the load trace; decide() sets the fan targets for one tick from the
+// sensor readings and returns the number of writes
+RunResult runTrace(const ThermalModel& model, const QVector<int>& limitSensors,
+                   const std::function<int(ThermalSimulator*, const QVector<TempSensor>&)>& decide)
+{
+    ThermalSimulator simulator(model);
+    int fanCount = simulator.getFans().size();
+    for (int f = 0; f < fanCount; f++) {
+        simulator.setFanManualMode(f, true);
+    }
+
+    RunResult result = {0.0, 0.0, QVector<double>(limitSensors.size(), 0.0), 0};
+    QVector<int> speeds(fanCount);
+    int ticks = 0;
+    for (const LoadStep& step : TRACE) {
+        simulator.setLoad(step.utilization);
+        for (double t = 0.0; t < step.seconds; t += TICK) {
+            QVector<TempSensor> temps = simulator.getTemperatures();
+            result.writes += decide(&simulator, temps);
+            simulator.step(TICK);
+
+            for (int f = 0; f < fanCount; f++) {
+                speeds[f] = simulator.getFanCurrentRPM(f);
+            }
+            double noise = AcousticOptimizer::noiseLevel(speeds);
+            result.meanNoise += noise;
+            result.maxNoise = qMax(result.maxNoise, noise);
+            temps = simulator.getTemperatures();
+            for (int l = 0; l < limitSensors.size(); l++) {
+                result.peak[l] = qMax(result.peak[l], temps[limitSensors[l]].temperature / 1000.0);
+            }
+            ticks++;
+        }
+    }
+    result.meanNoise /= qMax(1, ticks);
+    return result;
+}
+
+void printRun(const char *name, const RunResult& result, const InfluenceModel& influence,
+              const QVector<OptimizerLimit>& limits)
+{
+    printf("  %-24s noise mean %5.1f dB  max %5.1f dB  %5d writes\n",
+           name, result.meanNoise, result.maxNoise, result.writes);
+    QStringList peaks;
+    for (int l = 0; l < limits.size(); l++) {
+        peaks << QString("%1 %2/%3 C").arg(influence.sensors[limits[l].sensor])
+                     .arg(result.peak[l], 0, 'f', 1).arg(limits[l].limit, 0, 'f', 0);
+    }
+    printf("  %-24s peak %s\n", "", qPrintable(peaks.join("  ")));
+}
+
+} // namespace
+
+// The acoustic optimizer against the per-fan ramp it replaces, on the
+// simulated Mac Pro: an influence model is identified from the simulator
+// by steady-state steps, then both controllers run the same load trace.
+// The ramp drives every fan from the CPU temperature; the optimizer only
+// spends noise on the fans that reach a limited sensor.
+void runOptimizerBenchmarks()
+{
+    QString path = QString(BENCH_MODEL_DIR) + "/macpro5_1.ini";
+    ThermalModel model;
+    QString errorMessage;
+    if (!model.load(path, &errorMessage)) {
+        fprintf(stderr, "optimizer: %s\n", qPrintable(errorMessage));
+        return;
+    }
+
+    InfluenceModel influence = identify(model);
+    check("optimizer", influence.isValid(), "identified influence model is invalid");
+
+    QVector<OptimizerLimit> limits;
+    QVector<int> limitSensors;
+    for (int l = 0; l < LIMIT_COUNT; l++) {
+        OptimizerLimit limit = {influence.findSensor(LIMITS[l].sensor), LIMITS[l].limit};
+        if (limit.sensor < 0) {
+            fprintf(stderr, "optimizer: model has no sensor %s\n", LIMITS[l].sensor);
+            return;
+        }
+        limits.append(limit);
+        limitSensors.append(limit.sensor);
+    }
+
+    AcousticOptimizer optimizer;
+    optimizer.setModel(influence);
+    optimizer.setLimits(limits);
+    int fanCount = influence.fanCount();
+
+    // One solve at full load with every fan in the middle of its range:
+    // the model's prediction at the solution meets every limit
+    QVector<double> middle(fanCount, BASE_POSITION);
+    QVector<double> loaded = settle(model, 1.0, middle);
+    QVector<double> readings;
+    QVector<int> current;
+    for (const OptimizerLimit& limit : limits) {
+        readings.append(loaded[limit.sensor]);
+    }
+    for (int f = 0; f < fanCount; f++) {
+        current.append(influence.minRPM[f] + qRound(BASE_POSITION * (influence.maxRPM[f] - influence.minRPM[f])));
+    }
+    QVector<int> targets;
+    bool feasible = optimizer.solve(readings, current, &targets);
+    check("optimizer", feasible, "full-load limits reported out of reach");
+    bool withinLimits = true;
+    for (int l = 0; l < limits.size(); l++) {
+        double predicted = readings[l];
+        for (int f = 0; f < fanCount; f++) {
+            double range = influence.maxRPM[f] - influence.minRPM[f];
+            predicted += influence.getGain(limits[l].sensor, f) * (targets[f] - current[f]) / range;
+        }
+        withinLimits = withinLimits && predicted <= limits[l].limit - optimizer.getMargin() + 0.05;
+    }
+    check("optimizer", withinLimits, "solution predicted above a limit");
+
+    QString suffix = QString(" x%1 fans, %2 limits").arg(fanCount).arg(limits.size());
+    BenchmarkResult solveCost = runBenchmark("optimizer/solve" + suffix, 25, 200, [&]() {
+        optimizer.solve(readings, current, &targets);
+    });
+    check("optimizer", solveCost.p99Ns < 1.0e6, "solve p99 above 1 ms");
+    check("optimizer", !allocationCountingAvailable() || solveCost.allocsPerOp == 0.0, "solve allocates");
+
+    // A limit below ambient: every fan that cools it runs flat out
+    QVector<OptimizerLimit> unreachable = limits;
+    unreachable[0].limit = model.ambient;
+    optimizer.setLimits(unreachable);
+    bool atMaximum = !optimizer.solve(readings, current, &targets);
+    for (int f = 0; f < fanCount; f++) {
+        if (influence.getGain(unreachable[0].sensor, f) < 0.0) {
+            atMaximum = atMaximum && targets[f] == influence.maxRPM[f];
+        }
+    }
+    check("optimizer", atMaximum, "unreachable limit did not put its cooling fans at maximum");
+    optimizer.setLimits(limits);
+
+    printf("optimizer/load trace on %s (%.0f s)\n", qPrintable(model.name),
+           TRACE[0].seconds + TRACE[1].seconds + TRACE[2].seconds);
+
+    // Today's setup: every fan on its own ramp from the hottest CPU sensor
+    QVector<FanController> controllers;
+    for (const FanInfo& fan : ThermalSimulator(model).getFans()) {
+        FanController controller(fan.minRPM, fan.maxRPM);
+        controller.setCurve(45, 75);
+        controllers.append(controller);
+    }
+    int rampSensor = limits[0].sensor;
+    double elapsed = 0.0;
+    RunResult ramp = runTrace(model, limitSensors,
+                              [&](ThermalSimulator *simulator, const QVector<TempSensor>& temps) {
+        int writes = 0;
+        qint64 timestampMs = static_cast<qint64>(elapsed * 1000.0);
+        elapsed += TICK;
+        for (int f = 0; f < controllers.size(); f++) {
+            int target;
+            if (controllers[f].update(temps[rampSensor].temperature, timestampMs, &target)) {
+                simulator->setFanSpeed(f, target);
+                writes++;
+            }
+        }
+        return writes;
+    });
+    printRun("per-fan ramp", ramp, influence, limits);
+
+    QVector<int> written(fanCount, -1);
+    QVector<int> solution;
+    int outOfReach = 0;
+    RunResult optimized = runTrace(model, limitSensors,
+                                   [&](ThermalSimulator *simulator, const QVector<TempSensor>& temps) {
+        for (int l = 0; l < limits.size(); l++) {
+            readings[l] = temps[limits[l].sensor].temperature / 1000.0;
+        }
+        for (int f = 0; f < fanCount; f++) {
+            current[f] = simulator->getFanCurrentRPM(f);
+        }
+        if (!optimizer.solve(readings, current, &solution)) {
+            outOfReach++;
+        }
+        int writes = 0;
+        for (int f = 0; f < fanCount; f++) {
+            if (written[f] < 0 || qAbs(solution[f] - written[f]) >= AcousticOptimizer::RPM_DEADBAND) {
+                simulator->setFanSpeed(f, solution[f]);
+                written[f] = solution[f];
+                writes++;
+            }
+        }
+        return writes;
+    });
+    printRun("acoustic optimizer", optimized, influence, limits);
+    printf("  %-24s %d ticks with a limit out of reach (fans at maximum)\n", "", outOfReach);
+}
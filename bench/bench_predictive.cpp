@@ -0,0 +1,379 @@
+#include "benchmark.h"
+#include "acousticoptimizer.h"
+#include "fancontroller.h"
+#include "influenceidentifier.h"
+#include "predictivecontroller.h"
+#include "thermalmodel.h"
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+#ifndef BENCH_TRACE_DIR
+#define BENCH_TRACE_DIR "traces"
+#endif
+
+namespace {
+
+const double IDENTIFY_LOAD = 0.3;       // Light, steady load while identifying
+const double WARMUP_SECONDS = 3000.0;   // Each run starts from a settled machine
+const double MARGIN = 2.0;              // °C below each limit, as the optimizer's default
+const int RPM_DEADBAND = AcousticOptimizer::RPM_DEADBAND;
+
+// PID on each fan's own limit, output as a position in the fan's range.
+// The derivative is off: on 1 s ticks it only turns sensor steps into writes.
+const double PID_P = 0.2;               // Per °C
+const double PID_I = 0.004;             // Per °C second
+const double PID_D = 0.0;               // Per °C per second
+
+struct LimitSpec {
+    const char *sensor;
+    double limit;           // °C
+};
+
+// Tight enough that the recorded builds push the CPUs and the PSU into them
+const LimitSpec LIMITS[] = {
+    {"TCAD", 60.0},
+    {"TCBD", 60.0},
+    {"Tp0C", 52.0},
+    {"Te1P", 45.0},
+};
+const int LIMIT_COUNT = sizeof(LIMITS) / sizeof(LIMITS[0]);
+
+// Added to the limits above: memory shares the CPU fans but stays far below
+// this, and must not hold those fans back
+const LimitSpec COOL_LIMIT = {"TM1P", 80.0};
+
+struct TraceSample {
+    double time;            // Seconds
+    double utilization;     // 0.0-1.0
+};
+
+QVector<TraceSample> loadTrace(const QString& fileName)
+{
+    QVector<TraceSample> trace;
+    QFile file(QString(BENCH_TRACE_DIR) + "/" + fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning("Cannot open trace %s", qPrintable(file.fileName()));
+        return trace;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QStringList fields = line.split(',');
+        if (fields.size() >= 2) {
+            trace.append({fields[0].toDouble(), fields[1].toDouble()});
+        }
+    }
+    return trace;
+}
+
+int rpmAt(const FanInfo& fan, double position)
+{
+    return fan.minRPM + qRound(position * (fan.maxRPM - fan.minRPM));
+}
+
+// The identification routine against the simulator, as the app runs it on
+// the real machine: gains and time constants from fan steps
+InfluenceModel identify(const ThermalModel& model)
+{
+    ThermalSimulator simulator(model);
+    QVector<FanInfo> fans = simulator.getFans();
+    InfluenceModel layout;
+    layout.machine = model.name;
+    for (const FanInfo& fan : fans) {
+        layout.fans << fan.label;
+        layout.minRPM << fan.minRPM;
+        layout.maxRPM << fan.maxRPM;
+    }
+    for (const TempSensor& sensor : simulator.getTemperatures()) {
+        layout.sensors << sensor.label;
+    }
+
+    InfluenceIdentifier::Options options;
+    InfluenceIdentifier identifier;
+    simulator.setLoad(IDENTIFY_LOAD);
+    for (int f = 0; f < fans.size(); f++) {
+        simulator.setFanManualMode(f, true);
+        simulator.setFanSpeed(f, rpmAt(fans[f], options.basePosition));
+    }
+    simulator.step(WARMUP_SECONDS);
+
+    identifier.start(layout, options);
+    QVector<double> readings(layout.sensorCount());
+    QVector<int> targets;
+    for (int second = 0; ; second++) {
+        QVector<TempSensor> temps = simulator.getTemperatures();
+        for (int s = 0; s < temps.size(); s++) {
+            readings[s] = temps[s].temperature / 1000.0;
+        }
+        if (!identifier.sample(second, readings, &targets)) {
+            break;
+        }
+        for (int f = 0; f < targets.size(); f++) {
+            simulator.setFanSpeed(f, targets[f]);
+        }
+        simulator.step(1.0);
+    }
+    return identifier.fit();
+}
+
+struct RunResult {
+    double meanNoise;       // dB, over all ticks
+    QVector<double> peak;   // °C per limit
+    int secondsAbove;       // Ticks with any sensor above its limit
+    int writes;
+};
+
+// Replays a recorded load through the simulator from a settled start, one
+// tick per trace sample; decide() sets the fan targets for one tick from
+// the readings and returns the number of writes
+RunResult replay(const ThermalModel& model, const QVector<TraceSample>& trace, const QVector<OptimizerLimit>& limits,
+                 const std::function<int(ThermalSimulator*, const QVector<TempSensor>&, qint64)>& decide)
+{
+    ThermalSimulator simulator(model);
+    int fanCount = simulator.getFans().size();
+    for (int f = 0; f < fanCount; f++) {
+        simulator.setFanManualMode(f, true);
+    }
+    simulator.setLoad(trace.first().utilization);
+    simulator.step(WARMUP_SECONDS);
+
+    RunResult result = {0.0, QVector<double>(limits.size(), 0.0), 0, 0};
+    QVector<int> speeds(fanCount);
+    for (const TraceSample& sample : trace) {
+        simulator.setLoad(sample.utilization);
+        QVector<TempSensor> temps = simulator.getTemperatures();
+        result.writes += decide(&simulator, temps, qRound64(sample.time * 1000.0));
+        simulator.step(1.0);
+
+        for (int f = 0; f < fanCount; f++) {
+            speeds[f] = simulator.getFanCurrentRPM(f);
+        }
+        result.meanNoise += AcousticOptimizer::noiseLevel(speeds);
+        temps = simulator.getTemperatures();
+        bool above = false;
+        for (int l = 0; l < limits.size(); l++) {
+            double temperature = temps[limits[l].sensor].temperature / 1000.0;
+            result.peak[l] = qMax(result.peak[l], temperature);
+            above = above || temperature > limits[l].limit;
+        }
+        if (above) {
+            result.secondsAbove++;
+        }
+    }
+    result.meanNoise /= qMax(1, trace.size());
+    return result;
+}
+
+void printRun(const char *name, const RunResult& result, const InfluenceModel& influence,
+              const QVector<OptimizerLimit>& limits)
+{
+    QStringList peaks;
+    for (int l = 0; l < limits.size(); l++) {
+        peaks << QString("%1 %2/%3").arg(influence.sensors[limits[l].sensor])
+                     .arg(result.peak[l], 0, 'f', 1).arg(limits[l].limit, 0, 'f', 0);
+    }
+    printf("  %-10s noise %5.1f dB  %4d writes  above a limit %3d s  peak %s C\n",
+           name, result.meanNoise, result.writes, result.secondsAbove, qPrintable(peaks.join("  ")));
+}
+
+// Writes a target unless it is within the deadband of the last one
+int writeTarget(ThermalSimulator *simulator, int fan, int rpm, QVector<int> *written)
+{
+    if ((*written)[fan] >= 0 && qAbs(rpm - (*written)[fan]) < RPM_DEADBAND) {
+        return 0;
+    }
+    simulator->setFanSpeed(fan, rpm);
+    (*written)[fan] = rpm;
+    return 1;
+}
+
+// Predictive control of every fan against every limit
+RunResult replayPredictive(const ThermalModel& model, const InfluenceModel& influence,
+                           const QVector<TraceSample>& trace, const QVector<OptimizerLimit>& limits)
+{
+    PredictiveController predictive;
+    predictive.setModel(influence);
+    predictive.setLimits(limits);
+    predictive.setMargin(MARGIN);
+
+    int fanCount = influence.fanCount();
+    QVector<double> readings(limits.size());
+    QVector<int> current(fanCount);
+    QVector<int> written(fanCount, -1);
+    QVector<int> plan;
+    return replay(model, trace, limits,
+                  [&](ThermalSimulator *simulator, const QVector<TempSensor>& temps, qint64 now) {
+        for (int l = 0; l < limits.size(); l++) {
+            readings[l] = temps[limits[l].sensor].temperature / 1000.0;
+        }
+        for (int f = 0; f < fanCount; f++) {
+            current[f] = simulator->getFanCurrentRPM(f);
+        }
+        predictive.update(readings, current, now, &plan);
+        int writes = 0;
+        for (int f = 0; f < fanCount; f++) {
+            writes += writeTarget(simulator, f, plan[f], &written);
+        }
+        return writes;
+    });
+}
+
+} // namespace
+
+// Predictive control against the linear ramp and a PID loop on recorded
+// build workloads, on the simulated Mac Pro. The influence model, with its
+// time constants, is identified from the simulator the way the app does it.
+// Linear and PID drive each fan from the limited sensor it cools most;
+// predictive control plans all fans against all limits.
+void runPredictiveBenchmarks()
+{
+    QString path = QString(BENCH_MODEL_DIR) + "/macpro5_1.ini";
+    ThermalModel model;
+    QString errorMessage;
+    if (!model.load(path, &errorMessage)) {
+        fprintf(stderr, "predictive: %s\n", qPrintable(errorMessage));
+        return;
+    }
+
+    InfluenceModel influence = identify(model);
+    check("predictive", influence.isValid(), "identified influence model is invalid");
+    QVector<OptimizerLimit> limits;
+    for (int l = 0; l < LIMIT_COUNT; l++) {
+        OptimizerLimit limit = {influence.findSensor(LIMITS[l].sensor), LIMITS[l].limit};
+        if (limit.sensor < 0) {
+            fprintf(stderr, "predictive: model has no sensor %s\n", LIMITS[l].sensor);
+            return;
+        }
+        limits.append(limit);
+    }
+
+    int fanCount = influence.fanCount();
+    QVector<FanInfo> fans = ThermalSimulator(model).getFans();
+    QVector<int> ownLimit(fanCount, 0);
+    for (int f = 0; f < fanCount; f++) {
+        double strongest = 0.0;
+        for (int l = 0; l < limits.size(); l++) {
+            if (-influence.getGain(limits[l].sensor, f) > strongest) {
+                strongest = -influence.getGain(limits[l].sensor, f);
+                ownLimit[f] = l;
+            }
+        }
+    }
+
+    PredictiveController predictive;
+    predictive.setModel(influence);
+    predictive.setLimits(limits);
+    predictive.setMargin(MARGIN);
+
+    // One plan per tick from a settled, loaded machine
+    QVector<double> readings;
+    QVector<int> current;
+    for (const OptimizerLimit& limit : limits) {
+        readings.append(limit.limit - MARGIN + 1.0);
+    }
+    for (int f = 0; f < fanCount; f++) {
+        current.append(rpmAt(fans[f], 0.5));
+    }
+    QVector<int> targets;
+    qint64 timestampMs = 0;
+    QString suffix = QString(" x%1 fans, %2 limits, %3 s horizon").arg(fanCount).arg(limits.size())
+                         .arg(predictive.getHorizon());
+    BenchmarkResult planCost = runBenchmark("predictive/plan" + suffix, 25, 200, [&]() {
+        timestampMs += 1000;
+        predictive.update(readings, current, timestampMs, &targets);
+    });
+    check("predictive", planCost.p99Ns < 1.0e6, "plan p99 above 1 ms");
+    check("predictive", !allocationCountingAvailable() || planCost.allocsPerOp == 0.0, "plan allocates");
+
+    // A limit below ambient: every fan that cools it runs flat out
+    QVector<OptimizerLimit> unreachable = limits;
+    unreachable[0].limit = model.ambient;
+    predictive.setLimits(unreachable);
+    bool atMaximum = !predictive.update(readings, current, timestampMs, &targets);
+    for (int f = 0; f < fanCount; f++) {
+        if (influence.getGain(unreachable[0].sensor, f) < 0.0) {
+            atMaximum = atMaximum && targets[f] == influence.maxRPM[f];
+        }
+    }
+    check("predictive", atMaximum, "unreachable limit did not put its cooling fans at maximum");
+
+    const char *traces[] = {"kernel_build.csv", "incremental_builds.csv"};
+    for (const char *fileName : traces) {
+        QVector<TraceSample> trace = loadTrace(fileName);
+        if (trace.isEmpty()) {
+            continue;
+        }
+        printf("predictive/replay %s on %s (%d s)\n", fileName, qPrintable(model.name), trace.size());
+
+        // Linear: the sensor-based ramp, reaching maximum at the limit
+        QVector<FanController> controllers;
+        for (int f = 0; f < fanCount; f++) {
+            FanController controller(fans[f].minRPM, fans[f].maxRPM);
+            int limit = qRound(limits[ownLimit[f]].limit);
+            controller.setCurve(limit - 20, limit);
+            controllers.append(controller);
+        }
+        RunResult linear = replay(model, trace, limits,
+                                  [&](ThermalSimulator *simulator, const QVector<TempSensor>& temps, qint64 now) {
+            int writes = 0;
+            for (int f = 0; f < fanCount; f++) {
+                int target;
+                if (controllers[f].update(temps[limits[ownLimit[f]].sensor].temperature, now, &target)) {
+                    simulator->setFanSpeed(f, target);
+                    writes++;
+                }
+            }
+            return writes;
+        });
+        printRun("linear", linear, influence, limits);
+
+        // PID towards limit - margin, integrating only while the output is
+        // not pinned the same way
+        QVector<double> integral(fanCount, 0.0);
+        QVector<double> lastError(fanCount, 0.0);
+        QVector<int> written(fanCount, -1);
+        RunResult pid = replay(model, trace, limits,
+                               [&](ThermalSimulator *simulator, const QVector<TempSensor>& temps, qint64) {
+            int writes = 0;
+            for (int f = 0; f < fanCount; f++) {
+                const OptimizerLimit& limit = limits[ownLimit[f]];
+                double error = temps[limit.sensor].temperature / 1000.0 - (limit.limit - MARGIN);
+                double derivative = error - lastError[f];
+                lastError[f] = error;
+                double output = PID_P * error + PID_I * integral[f] + PID_D * derivative;
+                if ((output < 1.0 || error < 0.0) && (output > 0.0 || error > 0.0)) {
+                    integral[f] += error;
+                }
+                output = qBound(0.0, PID_P * error + PID_I * integral[f] + PID_D * derivative, 1.0);
+                writes += writeTarget(simulator, f, rpmAt(fans[f], output), &written);
+            }
+            return writes;
+        });
+        printRun("pid", pid, influence, limits);
+
+        RunResult planned = replayPredictive(model, influence, trace, limits);
+        printRun("predictive", planned, influence, limits);
+        check("predictive", planned.secondsAbove == 0, "predictive control let a sensor above its limit");
+
+        // A sensor far below its limit costs nothing: the CPUs peak where
+        // they did without it
+        QVector<OptimizerLimit> withCool = limits;
+        withCool.append({influence.findSensor(COOL_LIMIT.sensor), COOL_LIMIT.limit});
+        if (withCool.last().sensor < 0) {
+            fprintf(stderr, "predictive: model has no sensor %s\n", COOL_LIMIT.sensor);
+            continue;
+        }
+        RunResult cool = replayPredictive(model, influence, trace, withCool);
+        printRun("+cool TM1P", cool, influence, withCool);
+        bool unchanged = cool.secondsAbove == 0;
+        for (int l = 0; l < limits.size(); l++) {
+            unchanged = unchanged && cool.peak[l] <= planned.peak[l] + 0.5;
+        }
+        check("predictive", unchanged, "a cool limited sensor held back the fans of a hot one");
+    }
+}
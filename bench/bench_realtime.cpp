@@ -0,0 +1,96 @@
+#include "benchmark.h"
+#include "fansampler.h"
+#include "hwmoninterface.h"
+#include <QThread>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int INTERVAL_MS = 5;
+const int RUN_MS = 2000;
+
+// Busy loops on every core, like a parallel build
+class CpuLoad {
+public:
+    explicit CpuLoad(int threads)
+        : running(true)
+    {
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back([this]() {
+                volatile quint64 counter = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    counter = counter + 1;
+                }
+            });
+        }
+    }
+
+    ~CpuLoad()
+    {
+        running = false;
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+private:
+    std::atomic<bool> running;
+    std::vector<std::thread> workers;
+};
+
+void runSampler(FanSampler *sampler, const RealtimeOptions& options, const char *label)
+{
+    sampler->setRealtime(options);
+    sampler->start(INTERVAL_MS);
+    QThread::msleep(RUN_MS);
+    QString state = sampler->getRealtimeState();
+    sampler->stop();
+
+    LatencyHistogram jitter = sampler->getTickJitter();
+    printf("%-48s p50=%8.3f ms  p99=%8.3f ms  max=%8.3f ms  (%llu ticks, %s)\n",
+           (QString("realtime/tick jitter, ") + label).toLocal8Bit().constData(),
+           jitter.percentile(0.50) / 1.0e6, jitter.percentile(0.99) / 1.0e6, jitter.max() / 1.0e6,
+           static_cast<unsigned long long>(jitter.count()),
+           state.isEmpty() ? "QTimer" : ("timerfd, " + state).toLocal8Bit().constData());
+    fflush(stdout);
+}
+
+} // namespace
+
+// Fan sampler tick jitter with and without realtime mode, idle and with every
+// core saturated. SCHED_FIFO and mlockall need root (or CAP_SYS_NICE and
+// CAP_IPC_LOCK); without them the run shows what the fallback achieved.
+void runRealtimeBenchmarks(const SyntheticSysfsTree::Options& options)
+{
+    SyntheticSysfsTree tree(options);
+    if (!tree.isValid()) {
+        fprintf(stderr, "realtime: cannot create synthetic sysfs tree\n");
+        return;
+    }
+
+    // Every PWM fan tracks a target, so each tick reads and writes sysfs
+    HWMonInterface hwmon;
+    hwmon.setSysfsRoot(tree.root());
+    hwmon.setSmcAvailable(true);
+    hwmon.initialize();
+    FanSampler sampler;
+    for (const HWMonFan& fan : hwmon.getFans()) {
+        int id = sampler.addFan(fan.devicePath, fan.fanNumber);
+        sampler.setFanResponse(id, FanCalibrationTable(), fan.minRPM, fan.maxRPM);
+        sampler.setTarget(id, (fan.minRPM + fan.maxRPM) / 2, 128);
+    }
+
+    RealtimeOptions normal;
+    RealtimeOptions fifo;
+    RealtimeOptions::parse("fifo", &fifo);
+    int cores = qMax(1, QThread::idealThreadCount());
+
+    runSampler(&sampler, normal, "idle");
+    {
+        CpuLoad load(cores);
+        runSampler(&sampler, normal, QString("%1 busy threads").arg(cores).toLocal8Bit().constData());
+        runSampler(&sampler, fifo, QString("%1 busy threads, realtime").arg(cores).toLocal8Bit().constData());
+    }
+}
@@ -0,0 +1,65 @@
+#include "benchmark.h"
+#include "controltrace.h"
+#include <QtMath>
+
+namespace {
+
+// One hour at the 1 s GUI tick: 60 sensors following a slow load cycle with
+// per-sensor jitter, two sensor-based fans, as ControlTraceWriter records it
+QByteArray synthesizeTrace(int sensors, int ticks)
+{
+    QByteArray trace = "trace 1 MacPro5%2C1\n";
+    trace += "filter * median%3A3%20ema%3A0.5\n";
+    trace += "virtual *\n";
+    trace += "virtual 5000 CPU%20Max max%28TC0C%2C%20TC1C%29\n";
+    trace += "fan 0 5000 800 5200 45 85 1 50 5 10\n";
+    trace += "fan 1 3 800 5200 40 80 2 50 0 0\n";
+
+    QByteArray catalog = "sensors";
+    for (int i = 0; i < sensors; i++) {
+        QByteArray label = i == 1 ? "TC0C" : i == 2 ? "TC1C" : "T" + QByteArray::number(i);
+        catalog += " " + QByteArray::number(i + 1) + ":" + label + ":applesmc";
+    }
+    trace += catalog + "\n";
+
+    quint32 noise = 12345;
+    for (int t = 0; t < ticks; t++) {
+        double load = 0.5 + 0.5 * qSin(2.0 * M_PI * t / 600.0);
+        trace += "tick " + QByteArray::number(qint64(t) * 1000) + " " + QByteArray::number(load, 'f', 4);
+        for (int i = 0; i < sensors; i++) {
+            noise = noise * 1103515245u + 12345u;
+            int jitter = static_cast<int>((noise >> 16) % 1001) - 500;
+            trace += " " + QByteArray::number(qRound(45000 + 35000 * load) + jitter);
+        }
+        trace += "\n";
+    }
+    return trace;
+}
+
+} // namespace
+
+void runReplayBenchmarks()
+{
+    const int ticks = 3600;
+    ControlTraceReplay replay;
+    QString errorMessage;
+    if (!replay.parse(synthesizeTrace(60, ticks), &errorMessage)) {
+        fprintf(stderr, "replay: %s\n", errorMessage.toLocal8Bit().constData());
+        return;
+    }
+
+    ControlTraceReplay::Result first = replay.run();
+    ControlTraceReplay::Result second = replay.run();
+    bool identical = first.commands.size() == second.commands.size();
+    for (int i = 0; identical && i < first.commands.size(); i++) {
+        identical = first.commands[i].rpm == second.commands[i].rpm &&
+                    first.commands[i].timestampMs == second.commands[i].timestampMs;
+    }
+    printf("replay/1 h trace: %d ticks, %d commands, deterministic: %s\n",
+           first.ticks, first.commands.size(), identical ? "yes" : "NO");
+
+    BenchmarkResult result = runBenchmark("replay/1 h trace x60 sensors", 10, 1, [&replay]() {
+        replay.run();
+    });
+    printf("  %.0fx real time\n", first.durationMs * 1.0e6 / result.medianNs);
+}
@@ -0,0 +1,194 @@
+#include "benchmark.h"
+#include "rpmtracker.h"
+#include <QtMath>
+
+namespace {
+
+// Simulated PWM case fan: nonlinear duty-cycle response, stalls below
+// STALL_PWM, needs START_PWM to spin up from standstill, first-order
+// spin-up/down and about 1% tachometer noise.
+const int FAN_MAX_RPM = 2000;
+const int STALL_PWM = 40;
+const int START_PWM = 60;
+const double FAN_TIME_CONSTANT = 1.2;   // Seconds
+const int SAMPLE_MS = 250;              // FanSampler::DEFAULT_INTERVAL_MS
+const int HOLD_MS = 20000;              // Time each target is held
+
+const int TARGETS[] = {600, 1200, 1800, 900, 400, 1500, 700};
+
+struct SimulatedFan {
+    double rpm = 0.0;
+    int pwm = 0;
+    quint32 noiseState = 12345;
+
+    int steadyRPM() const
+    {
+        bool spinning = rpm > 1.0;
+        if (pwm < STALL_PWM || (!spinning && pwm < START_PWM)) {
+            return 0;
+        }
+        double duty = (pwm - STALL_PWM) / double(255 - STALL_PWM);
+        return qRound(250 + (FAN_MAX_RPM - 250) * qPow(duty, 0.6));
+    }
+
+    void advance(double seconds)
+    {
+        rpm += (steadyRPM() - rpm) * (1.0 - qExp(-seconds / FAN_TIME_CONSTANT));
+    }
+
+    int read()
+    {
+        noiseState = noiseState * 1103515245u + 12345u;
+        double noise = (static_cast<int>((noiseState >> 16) % 201) - 100) / 10000.0;
+        return rpm < 1.0 ? 0 : qRound(rpm * (1.0 + noise));
+    }
+};
+
+// Calibration table as FanCalibrator would measure it on the simulated fan
+FanCalibrationTable measureCalibration()
+{
+    FanCalibrationTable table;
+    SimulatedFan fan;
+    fan.rpm = FAN_MAX_RPM;
+    for (int pwm = 255; pwm >= STALL_PWM; pwm -= 15) {
+        fan.pwm = pwm;
+        table.points.prepend({pwm, fan.steadyRPM()});
+    }
+    table.stallPWM = STALL_PWM - 5;
+    table.startPWM = START_PWM;
+    return table;
+}
+
+struct TrackingResult {
+    double meanConvergenceMs;
+    qint64 maxConvergenceMs;
+    int unconverged;            // Targets that never reached the band
+    double settledError;        // Mean |error| over the second half of each hold, RPM
+    quint64 trims;
+};
+
+TrackingResult track(const FanCalibrationTable& calibration, bool closedLoop)
+{
+    RpmTracker tracker;
+    tracker.setResponse(calibration, 0, FAN_MAX_RPM);
+
+    SimulatedFan fan;
+    qint64 now = 0;
+    TrackingResult result = {0.0, 0, 0, 0.0, 0};
+    qint64 convergenceSum = 0;
+    int converged = 0;
+    double errorSum = 0.0;
+    int errorSamples = 0;
+
+    for (int target : TARGETS) {
+        // What HWMonInterface::setFanSpeed writes before the loop takes over
+        int openLoop = calibration.isValid()
+            ? calibration.pwmForRPM(target, fan.rpm > 1.0)
+            : qBound(0, target * 255 / FAN_MAX_RPM, 255);
+        fan.pwm = openLoop;
+        tracker.setTarget(target, openLoop, now);
+
+        for (int elapsed = 0; elapsed < HOLD_MS; elapsed += SAMPLE_MS) {
+            fan.advance(SAMPLE_MS / 1000.0);
+            now += SAMPLE_MS;
+            int measured = fan.read();
+            if (closedLoop) {
+                int pwm = tracker.update(measured, now);
+                if (pwm >= 0) {
+                    fan.pwm = pwm;
+                }
+            }
+            if (elapsed >= HOLD_MS / 2) {
+                errorSum += qAbs(target - measured);
+                errorSamples++;
+            }
+        }
+
+        RpmTrackingStatus status = tracker.getStatus();
+        if (closedLoop && status.converged) {
+            convergenceSum += status.lastConvergenceMs;
+            converged++;
+        } else {
+            result.unconverged++;
+        }
+    }
+
+    RpmTrackingStatus status = tracker.getStatus();
+    result.meanConvergenceMs = converged > 0 ? double(convergenceSum) / converged : -1.0;
+    result.maxConvergenceMs = status.maxConvergenceMs;
+    result.settledError = errorSamples > 0 ? errorSum / errorSamples : 0.0;
+    result.trims = status.trims;
+    return result;
+}
+
+} // namespace
+
+void runRpmTrackingBenchmarks()
+{
+    FanCalibrationTable calibrated = measureCalibration();
+    FanCalibrationTable linear;     // Invalid table: linear guess over 0-FAN_MAX_RPM
+
+    struct Variant {
+        const char *name;
+        const FanCalibrationTable *table;
+        bool closedLoop;
+    };
+    const Variant variants[] = {
+        {"linear map, open loop", &linear, false},
+        {"linear map, closed loop", &linear, true},
+        {"calibrated, open loop", &calibrated, false},
+        {"calibrated, closed loop", &calibrated, true},
+    };
+
+    printf("rpmtracking/simulated fan (%d targets, %d ms sampling)\n",
+           int(sizeof(TARGETS) / sizeof(TARGETS[0])), SAMPLE_MS);
+    for (const Variant& variant : variants) {
+        TrackingResult result = track(*variant.table, variant.closedLoop);
+        printf("  %-26s settled error %6.1f RPM  convergence mean %6.0f ms  max %6lld ms"
+               "  unconverged %d  trims %llu\n",
+               variant.name, result.settledError, result.meanConvergenceMs,
+               static_cast<long long>(result.maxConvergenceMs), result.unconverged,
+               static_cast<unsigned long long>(result.trims));
+    }
+
+    // A target below the fan's lowest running speed: tracked at that speed
+    // and reported unreachable, without trimming the fan into a stall
+    {
+        RpmTracker tracker;
+        tracker.setResponse(calibrated, 0, FAN_MAX_RPM);
+        SimulatedFan fan;
+        fan.rpm = FAN_MAX_RPM / 2;
+        int target = calibrated.minRPM() / 2;
+        fan.pwm = calibrated.pwmForRPM(target, true);
+        tracker.setTarget(target, fan.pwm, 0);
+        int stalls = 0;
+        bool running = true;
+        for (qint64 now = SAMPLE_MS; now <= 3 * HOLD_MS; now += SAMPLE_MS) {
+            fan.advance(SAMPLE_MS / 1000.0);
+            int pwm = tracker.update(fan.read(), now);
+            if (pwm >= 0) {
+                fan.pwm = pwm;
+            }
+            if (running && fan.rpm < 1.0) {
+                stalls++;
+            }
+            running = fan.rpm >= 1.0;
+        }
+        RpmTrackingStatus status = tracker.getStatus();
+        printf("  %-26s target %d RPM  measured %d RPM  pwm %d  stalls %d  unreachable %s\n",
+               "below the stall speed", target, status.measuredRPM, status.pwm, stalls,
+               status.unreachable ? "yes" : "no");
+        check("rpmtracking", stalls == 0, "target below the stall speed stalled the fan");
+        check("rpmtracking", status.unreachable, "target below the lowest running speed not reported unreachable");
+    }
+
+    // Per-sample cost of the loop itself
+    RpmTracker tracker;
+    tracker.setResponse(calibrated, 0, FAN_MAX_RPM);
+    tracker.setTarget(1200, 120, 0);
+    qint64 now = 0;
+    runBenchmark("rpmtracking/update", 25, 10000, [&tracker, &now]() {
+        now += SAMPLE_MS;
+        tracker.update(1100 + static_cast<int>(now / SAMPLE_MS % 200), now);
+    });
+}
@@ -0,0 +1,55 @@
+#include "benchmark.h"
+#include "sensorfilter.h"
+
+namespace {
+
+QVector<TempSensor> buildSnapshot(int count)
+{
+    QVector<TempSensor> sensors;
+    for (int i = 0; i < count; i++) {
+        TempSensor sensor;
+        sensor.index = i + 1;
+        sensor.label = QString("T%1").arg(i);
+        sensor.temperature = 45000;
+        sensor.deviceName = "applesmc";
+        sensors.append(sensor);
+    }
+    return sensors;
+}
+
+void benchmarkFilter(const QString& name, const SensorFilterSpec& spec, int count)
+{
+    SensorFilterBank bank;
+    bank.setDefaultSpec(spec);
+
+    QVector<TempSensor> raw = buildSnapshot(count);
+    QVector<TempSensor> snapshot = raw;
+    qint64 timestamp = 0;
+    runBenchmark(QString("sensorfilter/%1 x%2").arg(name).arg(count), 25, 200,
+                 [&bank, &raw, &snapshot, &timestamp]() {
+                     // Restore raw readings with +-1 °C jitter, then filter
+                     timestamp += 1000;
+                     for (int i = 0; i < raw.size(); i++) {
+                         snapshot[i].temperature = raw[i].temperature + ((timestamp / 1000 * 7 + i) % 3 - 1) * 1000;
+                     }
+                     bank.apply(snapshot, timestamp);
+                 });
+}
+
+} // namespace
+
+void runSensorFilterBenchmarks()
+{
+    SensorFilterSpec ema;
+    ema.emaAlpha = 0.3;
+
+    SensorFilterSpec full;
+    full.medianWindow = 5;
+    full.emaAlpha = 0.3;
+    full.maxRate = 2.0;
+
+    benchmarkFilter("ema", ema, 68);
+    benchmarkFilter("median5+ema+rate", full, 68);
+    benchmarkFilter("ema", ema, 1000);
+    benchmarkFilter("median5+ema+rate", full, 1000);
+}
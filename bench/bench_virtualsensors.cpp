@@ -0,0 +1,109 @@
+#include "benchmark.h"
+#include "virtualsensors.h"
+#include <QDebug>
+
+namespace {
+
+// Mac Pro sized catalog: 68 SMC sensors plus a few hwmon devices
+QVector<TempSensor> buildCatalog()
+{
+    QVector<TempSensor> catalog;
+    int index = 1;
+
+    auto addSmc = [&catalog, &index](const QString& label) {
+        TempSensor sensor;
+        sensor.index = index++;
+        sensor.label = label;
+        sensor.temperature = 40000;
+        sensor.deviceName = "applesmc";
+        catalog.append(sensor);
+    };
+
+    addSmc("TA0P");
+    for (int i = 0; i < 12; i++) addSmc(QString("TC%1C").arg(i));
+    for (int i = 1; i <= 8; i++) addSmc(QString("TM%1P").arg(i));
+    for (int i = 1; i <= 4; i++) addSmc(QString("TH%1P").arg(i));
+    while (catalog.size() < 68) {
+        addSmc(QString("TX%1P").arg(catalog.size()));
+    }
+
+    index = 1000;
+    auto addHwmon = [&catalog, &index](const QString& device, const QString& label) {
+        TempSensor sensor;
+        sensor.index = index++;
+        sensor.label = label;
+        sensor.temperature = 35000;
+        sensor.deviceName = device;
+        catalog.append(sensor);
+    };
+    for (int i = 1; i <= 6; i++) addHwmon("drivetemp", QString("drivetemp Temp %1").arg(i));
+    addHwmon("nvme", "Composite");
+    addHwmon("amdgpu", "edge");
+    addHwmon("amdgpu", "junction");
+
+    return catalog;
+}
+
+const char *const EXPRESSIONS[] = {
+    "max(TC0C..TC7C) - TA0P",
+    "avg(drivetemp:*)",
+    "(TC0C + TC1C) / 2",
+    "max(TC0C, TC1C, TC2C) * 1.1 - 3",
+    "min(TM1P..TM8P)",
+    "sum(TC0C..TC11C) / 12 - avg(TM1P..TM8P)",
+    "max(amdgpu:junction, amdgpu:edge + 10)",
+    "avg(TH1P..TH4P, nvme:Composite)",
+};
+const int EXPRESSION_COUNT = sizeof(EXPRESSIONS) / sizeof(EXPRESSIONS[0]);
+
+void benchmarkTick(const QVector<TempSensor>& catalog, int programCount)
+{
+    VirtualSensorEngine engine;
+    for (int i = 0; i < programCount; i++) {
+        QString errorMessage;
+        if (engine.addSensor(QString("V%1").arg(i), EXPRESSIONS[i % EXPRESSION_COUNT],
+                             catalog, -1, &errorMessage) < 0) {
+            qFatal("Benchmark expression failed to compile: %s", qPrintable(errorMessage));
+        }
+    }
+
+    // Vary readings between ticks so nothing folds away
+    QVector<TempSensor> snapshot = catalog;
+    int tick = 0;
+    BenchmarkResult result = runBenchmark(
+        QString("virtualsensors/evaluate %1 expressions").arg(programCount), 25, 20,
+        [&engine, &snapshot, &tick]() {
+            tick++;
+            for (int i = 0; i < snapshot.size(); i++) {
+                snapshot[i].temperature = 40000 + ((tick * 37 + i * 101) % 2000);
+            }
+            engine.evaluate(snapshot);
+        });
+
+    printf("%-48s %12.1f ns/expression, %.3f ms/tick\n", "",
+           result.medianNs / programCount, result.medianNs / 1e6);
+}
+
+} // namespace
+
+void runVirtualSensorBenchmarks()
+{
+    QVector<TempSensor> catalog = buildCatalog();
+
+    int n = 0;
+    runBenchmark("virtualsensors/compile", 15, 200, [&catalog, &n]() {
+        VirtualSensorEngine engine;
+        engine.addSensor("V", EXPRESSIONS[n++ % EXPRESSION_COUNT], catalog);
+    });
+
+    // Hostile nesting is rejected, not recursed into until the stack overflows
+    VirtualSensorEngine engine;
+    QString deep = QString(100000, '(') + "TC0C" + QString(100000, ')');
+    check("virtualsensors", engine.addSensor("V", deep, catalog) < 0, "deeply nested expression compiled");
+    check("virtualsensors", engine.addSensor("V", QString(100000, '-') + "TC0C", catalog) < 0,
+          "deeply negated expression compiled");
+
+    benchmarkTick(catalog, 100);
+    benchmarkTick(catalog, 1000);
+    benchmarkTick(catalog, 5000);
+}
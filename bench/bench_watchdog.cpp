@@ -0,0 +1,165 @@
+#include "benchmark.h"
+#include "fanwatchdog.h"
+#include "latencystats.h"
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+#include <QFile>
+#include <QThread>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// One file and the value it holds once its fan is in the safe state
+struct SafeCheck {
+    QString path;
+    int value;
+};
+
+int readValue(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    bool ok = false;
+    int value = file.readLine().trimmed().toInt(&ok);
+    return ok ? value : -1;
+}
+
+bool allSafe(const QVector<SafeCheck>& checks)
+{
+    for (const SafeCheck& check : checks) {
+        if (readValue(check.path) != check.value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Polls the fan files until all are safe; ms since startNs, or -1 after limitMs
+double waitForSafeState(const QVector<SafeCheck>& checks, qint64 startNs, int limitMs)
+{
+    while (monotonicNs() - startNs < limitMs * 1000000LL) {
+        if (allSafe(checks)) {
+            return (monotonicNs() - startNs) / 1.0e6;
+        }
+        usleep(200);
+    }
+    return -1.0;
+}
+
+// Every fan in manual mode at a low speed, as a control loop would leave them
+void setManual(SMCInterface *smc, HWMonInterface *hwmon)
+{
+    for (int i = 0; i < smc->getFans().size(); i++) {
+        smc->setFanManualMode(i, true);
+        smc->setFanSpeed(i, smc->getFans()[i].minRPM);
+    }
+    for (int i = 0; i < hwmon->getFans().size(); i++) {
+        hwmon->setFanManualMode(i, true);
+        hwmon->setFanPWM(i, 60);
+    }
+}
+
+// Files that show the safe state of every fan for an action
+QVector<SafeCheck> safeChecks(const SMCInterface& smc, const HWMonInterface& hwmon, FanWatchdog::Action action)
+{
+    QVector<SafeCheck> checks;
+    for (const FanInfo& fan : smc.getFans()) {
+        if (action == FanWatchdog::ACTION_AUTO) {
+            checks.append({fan.sysfsPath + "_manual", 0});
+        } else {
+            checks.append({fan.sysfsPath + "_manual", 1});
+            checks.append({fan.sysfsPath + "_output", fan.maxRPM});
+        }
+    }
+    for (const HWMonFan& fan : hwmon.getFans()) {
+        QString pwm = fan.devicePath + "/pwm" + QString::number(fan.fanNumber);
+        if (action == FanWatchdog::ACTION_AUTO) {
+            checks.append({pwm + "_enable", 2});
+        } else {
+            checks.append({pwm + "_enable", 1});
+            checks.append({pwm, 255});
+        }
+    }
+    return checks;
+}
+
+} // namespace
+
+// Failsafe checks: the control loop stops sending heartbeats (hang), and the
+// control process is killed outright (crash). Reports the time from the
+// failure to every fan of the synthetic tree being in the safe state.
+void runWatchdogBenchmarks(const SyntheticSysfsTree::Options& options)
+{
+    SyntheticSysfsTree tree(options);
+    if (!tree.isValid()) {
+        fprintf(stderr, "watchdog: cannot create synthetic sysfs tree\n");
+        return;
+    }
+
+    SMCInterface smc;
+    smc.setSysfsRoot(tree.root());
+    HWMonInterface hwmon;
+    hwmon.setSysfsRoot(tree.root());
+    hwmon.setSmcAvailable(smc.initialize());
+    hwmon.initialize();
+
+    FanWatchdog watchdog;
+    for (const FanInfo& fan : smc.getFans()) {
+        watchdog.addSMCFan(fan.sysfsPath, fan.maxRPM);
+    }
+    for (const HWMonFan& fan : hwmon.getFans()) {
+        watchdog.addHWMonFan(fan.devicePath, fan.fanNumber);
+    }
+    const int timeoutMs = 200;
+    QVector<SafeCheck> autoChecks = safeChecks(smc, hwmon, FanWatchdog::ACTION_AUTO);
+    QVector<SafeCheck> maxChecks = safeChecks(smc, hwmon, FanWatchdog::ACTION_MAX);
+
+    // Clean shutdown: heartbeats, then stop(); fans must stay as they are
+    setManual(&smc, &hwmon);
+    watchdog.start(timeoutMs);
+    for (int i = 0; i < 5; i++) {
+        watchdog.heartbeat();
+        QThread::msleep(timeoutMs / 4);
+    }
+    check("watchdog", !allSafe(autoChecks), "watchdog tripped while heartbeats arrived");
+    watchdog.stop();
+    QThread::msleep(timeoutMs * 2);
+    check("watchdog", !allSafe(autoChecks), "watchdog touched the fans after a clean stop");
+
+    // Hang: the process lives on but the loop stops calling heartbeat()
+    watchdog.setAction(FanWatchdog::ACTION_AUTO);
+    watchdog.start(timeoutMs);
+    watchdog.heartbeat();
+    qint64 stalled = monotonicNs();
+    double hangMs = waitForSafeState(autoChecks, stalled, timeoutMs * 10);
+    printf("%-48s %8.1f ms (timeout %d ms, %d fans)\n", "watchdog/stalled loop to safe state (auto)", hangMs,
+           timeoutMs, watchdog.getFanCount());
+    check("watchdog", hangMs >= 0 && hangMs < timeoutMs + 100, "stalled loop not caught within timeout + 100 ms");
+    watchdog.stop();
+
+    // Crash: a control process with its own watchdog is killed with SIGKILL
+    setManual(&smc, &hwmon);
+    watchdog.setAction(FanWatchdog::ACTION_MAX);
+    pid_t control = fork();
+    if (control == 0) {
+        watchdog.start(60000);      // Only the death of this process can trip it
+        for (;;) {
+            watchdog.heartbeat();
+            usleep(10000);
+        }
+    }
+    QThread::msleep(100);
+    check("watchdog", !allSafe(maxChecks), "fans in the safe state before the control process died");
+    qint64 killed = monotonicNs();
+    kill(control, SIGKILL);
+    double crashMs = waitForSafeState(maxChecks, killed, 1000);
+    waitpid(control, nullptr, 0);
+    printf("%-48s %8.1f ms (%d fans)\n", "watchdog/killed process to safe state (max)", crashMs,
+           watchdog.getFanCount());
+    check("watchdog", crashMs >= 0 && crashMs < 100, "killed control process not caught within 100 ms");
+    fflush(stdout);
+}
@@ -0,0 +1,104 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+#include "synthetictree.h"
+#include <QString>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+// Allocation counter (alloccounter.cpp); counts malloc/calloc/realloc calls
+// from every library, including Qt's container allocations. Always 0 where
+// the C library cannot be interposed.
+quint64 allocationCount();
+bool allocationCountingAvailable();
+
+// Minimal timing harness: runs fn `iterations` times per sample, repeats for
+// `samples` samples and reports the median and 99th percentile of the
+// per-call time across samples, plus heap allocations per call.
+struct BenchmarkResult {
+    QString name;
+    double medianNs;
+    double p99Ns;
+    double minNs;
+    double allocsPerOp;
+};
+
+inline BenchmarkResult runBenchmark(const QString& name, int samples, int iterations,
+                                    const std::function<void()>& fn)
+{
+    // Warm up caches and branch predictors
+    for (int i = 0; i < iterations; i++) {
+        fn();
+    }
+
+    QVector<double> perCall;
+    perCall.reserve(samples);
+    QElapsedTimer timer;
+    quint64 allocationsBefore = allocationCount();
+    for (int s = 0; s < samples; s++) {
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            fn();
+        }
+        perCall.append(static_cast<double>(timer.nsecsElapsed()) / iterations);
+    }
+    quint64 allocations = allocationCount() - allocationsBefore;
+    std::sort(perCall.begin(), perCall.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.medianNs = perCall[perCall.size() / 2];
+    result.p99Ns = perCall[qMin(perCall.size() - 1, (perCall.size() * 99 + 99) / 100 - 1)];
+    result.minNs = perCall.first();
+    result.allocsPerOp = static_cast<double>(allocations) / (static_cast<double>(samples) * iterations);
+
+    if (allocationCountingAvailable()) {
+        printf("%-48s %12.1f ns/op (median) %12.1f ns/op (p99) %8.2f allocs/op\n",
+               name.toLocal8Bit().constData(), result.medianNs, result.p99Ns, result.allocsPerOp);
+    } else {
+        printf("%-48s %12.1f ns/op (median) %12.1f ns/op (p99)\n",
+               name.toLocal8Bit().constData(), result.medianNs, result.p99Ns);
+    }
+    fflush(stdout);
+    return result;
+}
+
+// A failed expectation of a benchmark group, reported on stderr as
+// "<group>: FAILED: <what>" and counted; main() exits non-zero after any
+inline int& benchmarkFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void check(const char *group, bool ok, const char *what)
+{
+    if (!ok) {
+        fprintf(stderr, "%s: FAILED: %s\n", group, what);
+        benchmarkFailures()++;
+    }
+}
+
+// Benchmark groups, selected by name on the command line
+void runVirtualSensorBenchmarks();
+void runSensorFilterBenchmarks();
+void runFeedForwardBenchmarks();
+void runLatencyBenchmarks();
+void runRpmTrackingBenchmarks();
+void runIOBenchmarks(const SyntheticSysfsTree::Options& options);
+void runReplayBenchmarks();
+void runDiscoveryBenchmarks(const SyntheticSysfsTree::Options& options);
+void runHWMonReaderBenchmarks(const SyntheticSysfsTree::Options& options);
+void runCriticalBenchmarks(const SyntheticSysfsTree::Options& options);
+void runFanBackendBenchmarks(const SyntheticSysfsTree::Options& options);
+void runOptimizerBenchmarks();
+void runInfluenceBenchmarks();
+void runPredictiveBenchmarks();
+void runWatchdogBenchmarks(const SyntheticSysfsTree::Options& options);
+void runRealtimeBenchmarks(const SyntheticSysfsTree::Options& options);
+
+#endif // BENCHMARK_H
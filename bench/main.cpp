@@ -0,0 +1,117 @@
+#include "benchmark.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <cstdio>
+#include <cstdlib>
+
+// Backend classes log discovery details with qDebug; keep benchmark output readable
+static void quietMessageHandler(QtMsgType type, const QMessageLogContext& /*context*/, const QString& msg)
+{
+    if (type == QtDebugMsg) {
+        return;
+    }
+    fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+    if (type == QtFatalMsg)
+        abort();
+}
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(quietMessageHandler);
+
+    QCoreApplication app(argc, argv);
+
+    // --smc-sensors=N, --hwmon-devices=N and --hwmon-sensors=N size the synthetic
+    // sysfs tree of the io, discovery, hwmonreaders, fanbackend, critical, watchdog and realtime groups; any other argument is a group filter: only run
+    // groups whose name contains one of them
+    SyntheticSysfsTree::Options treeOptions;
+    QStringList filters;
+    for (const QString& arg : app.arguments().mid(1)) {
+        int *option = nullptr;
+        if (arg.startsWith("--smc-sensors=")) {
+            option = &treeOptions.smcSensors;
+        } else if (arg.startsWith("--hwmon-devices=")) {
+            option = &treeOptions.hwmonDevices;
+        } else if (arg.startsWith("--hwmon-sensors=")) {
+            option = &treeOptions.hwmonSensorsPerDevice;
+        }
+        if (!option) {
+            filters.append(arg);
+            continue;
+        }
+        bool ok = false;
+        int value = arg.mid(arg.indexOf('=') + 1).toInt(&ok);
+        if (!ok || value < 0) {
+            fprintf(stderr, "Invalid value in %s\n", arg.toLocal8Bit().constData());
+            return 1;
+        }
+        *option = value;
+    }
+    auto selected = [&filters](const QString& group) {
+        if (filters.isEmpty()) {
+            return true;
+        }
+        for (const QString& filter : filters) {
+            if (group.contains(filter, Qt::CaseInsensitive)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if (selected("virtualsensors")) {
+        runVirtualSensorBenchmarks();
+    }
+    if (selected("sensorfilter")) {
+        runSensorFilterBenchmarks();
+    }
+    if (selected("feedforward")) {
+        runFeedForwardBenchmarks();
+    }
+    if (selected("latency")) {
+        runLatencyBenchmarks();
+    }
+    if (selected("rpmtracking")) {
+        runRpmTrackingBenchmarks();
+    }
+    if (selected("io")) {
+        runIOBenchmarks(treeOptions);
+    }
+    if (selected("replay")) {
+        runReplayBenchmarks();
+    }
+    if (selected("discovery")) {
+        runDiscoveryBenchmarks(treeOptions);
+    }
+    if (selected("hwmonreaders")) {
+        runHWMonReaderBenchmarks(treeOptions);
+    }
+    if (selected("fanbackend")) {
+        runFanBackendBenchmarks(treeOptions);
+    }
+    if (selected("optimizer")) {
+        runOptimizerBenchmarks();
+    }
+    if (selected("influence")) {
+        runInfluenceBenchmarks();
+    }
+    if (selected("predictive")) {
+        runPredictiveBenchmarks();
+    }
+    if (selected("critical")) {
+        runCriticalBenchmarks(treeOptions);
+    }
+    if (selected("watchdog")) {
+        runWatchdogBenchmarks(treeOptions);
+    }
+    // Last: realtime mode locks the process memory for the rest of the run
+    if (selected("realtime")) {
+        runRealtimeBenchmarks(treeOptions);
+    }
+
+    if (benchmarkFailures() > 0) {
+        fprintf(stderr, "%d check(s) FAILED\n", benchmarkFailures());
+        return 1;
+    }
+    return 0;
+}
@@ -1,4 +1,4 @@
-QT       += core gui widgets
+QT       += core gui widgets network concurrent
 CONFIG   += c++11
 TARGET   = macsfancontrol
 TEMPLATE = app
@@ -9,18 +9,85 @@ SOURCES += \
     src/mainwindow.cpp \
     src/smcinterface.cpp \
     src/hwmoninterface.cpp \
+    src/hwmonscanner.cpp \
+    src/hwmonreaders.cpp \
+    src/readprofiler.cpp \
     src/fancontrolwidget.cpp \
     src/temperaturepanel.cpp \
-    src/sensordescriptions.cpp
+    src/sensordescriptions.cpp \
+    src/virtualsensors.cpp \
+    src/sensorfilter.cpp \
+    src/fancontroller.cpp \
+    src/cpuloadmonitor.cpp \
+    src/latencystats.cpp \
+    src/metricsserver.cpp \
+    src/fancalibration.cpp \
+    src/rpmtracker.cpp \
+    src/fansampler.cpp \
+    src/realtime.cpp \
+    src/fanwatchdog.cpp \
+    src/criticalguard.cpp \
+    src/configwatcher.cpp \
+    src/fanbackend.cpp \
+    src/fanzone.cpp \
+    src/influencemodel.cpp \
+    src/acousticoptimizer.cpp \
+    src/influenceidentifier.cpp \
+    src/predictivecontroller.cpp \
+    src/sensorpipeline.cpp \
+    src/controltrace.cpp \
+    src/discoverymanifest.cpp \
+    src/backenddiscovery.cpp
 
 # Header files
 HEADERS += \
     src/mainwindow.h \
     src/smcinterface.h \
     src/hwmoninterface.h \
+    src/hwmonscanner.h \
+    src/hwmonreaders.h \
+    src/readprofiler.h \
     src/fancontrolwidget.h \
     src/temperaturepanel.h \
-    src/sensordescriptions.h
+    src/sensordescriptions.h \
+    src/virtualsensors.h \
+    src/sensorfilter.h \
+    src/fancontroller.h \
+    src/cpuloadmonitor.h \
+    src/latencystats.h \
+    src/metricsserver.h \
+    src/fancalibration.h \
+    src/rpmtracker.h \
+    src/fansampler.h \
+    src/realtime.h \
+    src/fanwatchdog.h \
+    src/criticalguard.h \
+    src/configwatcher.h \
+    src/fanbackend.h \
+    src/fanzone.h \
+    src/influencemodel.h \
+    src/acousticoptimizer.h \
+    src/influenceidentifier.h \
+    src/predictivecontroller.h \
+    src/sensorpipeline.h \
+    src/controltrace.h \
+    src/discoverymanifest.h \
+    src/backenddiscovery.h
+
+# Benchmarks: `make bench` builds and runs bench/bench.pro in a subdirectory
+bench.commands = $(MKDIR) $$OUT_PWD/bench && cd $$OUT_PWD/bench && $$QMAKE_QMAKE $$PWD/bench/bench.pro && $(MAKE) && ./macsfancontrol-bench
+# `make sysfsgen` builds the synthetic sysfs tree generator in tools/sysfsgen
+sysfsgen.commands = $(MKDIR) $$OUT_PWD/tools/sysfsgen && cd $$OUT_PWD/tools/sysfsgen && $$QMAKE_QMAKE $$PWD/tools/sysfsgen/sysfsgen.pro && $(MAKE)
+# `make replay` builds the control trace replayer in tools/replay
+replay.commands = $(MKDIR) $$OUT_PWD/tools/replay && cd $$OUT_PWD/tools/replay && $$QMAKE_QMAKE $$PWD/tools/replay/replay.pro && $(MAKE)
+# `make thermalsim` builds the thermal model controller sweep in tools/thermalsim
+thermalsim.commands = $(MKDIR) $$OUT_PWD/tools/thermalsim && cd $$OUT_PWD/tools/thermalsim && $$QMAKE_QMAKE $$PWD/tools/thermalsim/thermalsim.pro && $(MAKE)
+# `make macsfanctl` builds the command-line client in tools/macsfanctl
+macsfanctl.commands = $(MKDIR) $$OUT_PWD/tools/macsfanctl && cd $$OUT_PWD/tools/macsfanctl && $$QMAKE_QMAKE $$PWD/tools/macsfanctl/macsfanctl.pro && $(MAKE)
+
+toolsphony.target = .PHONY
+toolsphony.depends = bench sysfsgen replay thermalsim macsfanctl
+QMAKE_EXTRA_TARGETS += bench sysfsgen replay thermalsim macsfanctl toolsphony
 
 # Installation
 target.path = /usr/local/bin
@@ -0,0 +1,225 @@
+#include "acousticoptimizer.h"
+#include <QtGlobal>
+#include <cmath>
+
+namespace {
+
+// Bisection steps per multiplier: the bracket shrinks to ~1e-12 of its width
+const int BISECTION_STEPS = 40;
+// A sweep that moves no multiplier by more than this has converged
+const double CONVERGED = 1e-6;
+// Below this a weight would make a fan free; keeps the stationarity solvable
+const double MIN_WEIGHT = 1e-3;
+
+} // namespace
+
+AcousticOptimizer::AcousticOptimizer()
+    : margin(DEFAULT_MARGIN)
+{
+}
+
+void AcousticOptimizer::setModel(const InfluenceModel& newModel)
+{
+    model = newModel;
+    limits.clear();
+    weights.fill(1.0, model.fanCount());
+    prepare();
+}
+
+void AcousticOptimizer::setLimits(const QVector<OptimizerLimit>& newLimits)
+{
+    limits.clear();
+    for (const OptimizerLimit& limit : newLimits) {
+        if (limit.sensor >= 0 && limit.sensor < model.sensorCount()) {
+            limits.append(limit);
+        }
+    }
+    prepare();
+}
+
+void AcousticOptimizer::setNoiseWeights(const QVector<double>& newWeights)
+{
+    for (int i = 0; i < weights.size() && i < newWeights.size(); i++) {
+        weights[i] = qMax(MIN_WEIGHT, newWeights[i]);
+    }
+}
+
+void AcousticOptimizer::prepare()
+{
+    int fanTotal = model.fanCount();
+    cooling.fill(0.0, limits.size() * fanTotal);
+    for (int l = 0; l < limits.size(); l++) {
+        for (int f = 0; f < fanTotal; f++) {
+            cooling[l * fanTotal + f] = -model.getGain(limits[l].sensor, f);
+        }
+    }
+    required.fill(0.0, limits.size());
+    multiplier.fill(0.0, limits.size());
+    demand.fill(0.0, fanTotal);
+    position.fill(0.0, fanTotal);
+}
+
+// Minimizes weight * rpm^2 - fanDemand * position over the fan's range. RPM
+// is in thousands so the weights stay near 1.0 whatever the fan.
+double AcousticOptimizer::positionFor(int fan, double fanDemand) const
+{
+    double minimum = model.minRPM[fan] / 1000.0;
+    double range = (model.maxRPM[fan] - model.minRPM[fan]) / 1000.0;
+    if (range <= 0.0) {
+        return 0.0;
+    }
+    double rpm = fanDemand / (2.0 * weights[fan] * range);
+    return qBound(0.0, (rpm - minimum) / range, 1.0);
+}
+
+// How far the current positions over-cool (positive) or under-cool one limit
+double AcousticOptimizer::slack(int limit) const
+{
+    int fanTotal = model.fanCount();
+    const double *row = cooling.constData() + limit * fanTotal;
+    double sum = 0.0;
+    for (int f = 0; f < fanTotal; f++) {
+        sum += row[f] * position[f];
+    }
+    return sum - required[limit];
+}
+
+bool AcousticOptimizer::solve(const QVector<double>& readings, const QVector<int>& current, QVector<int> *targets)
+{
+    int fanTotal = model.fanCount();
+    targets->resize(fanTotal);
+    if (fanTotal == 0) {
+        return true;
+    }
+
+    // Cooling each limit needs from the fans, counted from all fans at
+    // minimum. A limit whose sensor has no reading, or that even every
+    // cooling fan at maximum cannot meet, takes no part in the ascent.
+    bool feasible = true;
+    for (int l = 0; l < limits.size(); l++) {
+        const double *row = cooling.constData() + l * fanTotal;
+        double reading = readings.value(l, qQNaN());
+        if (qIsNaN(reading)) {
+            required[l] = qQNaN();
+            continue;
+        }
+        double need = reading - (limits[l].limit - margin);
+        double reachable = 0.0;
+        for (int f = 0; f < fanTotal; f++) {
+            int range = model.maxRPM[f] - model.minRPM[f];
+            double now = range > 0 ? static_cast<double>(current.value(f, model.minRPM[f]) - model.minRPM[f]) / range : 0.0;
+            need += row[f] * qBound(0.0, now, 1.0);
+            reachable += qMax(0.0, row[f]);
+        }
+        required[l] = need;
+        if (reachable < need) {
+            feasible = false;
+        }
+    }
+
+    // Dual coordinate ascent: each multiplier in turn is set so that its
+    // limit is just met given the others, found by bisection since the
+    // limit's slack only grows with its own multiplier
+    for (int l = 0; l < multiplier.size(); l++) {
+        multiplier[l] = 0.0;
+    }
+    for (int f = 0; f < fanTotal; f++) {
+        demand[f] = 0.0;
+        position[f] = positionFor(f, 0.0);
+    }
+    auto active = [&](int l) {
+        double reachable = 0.0;
+        const double *row = cooling.constData() + l * fanTotal;
+        for (int f = 0; f < fanTotal; f++) {
+            reachable += qMax(0.0, row[f]);
+        }
+        return !qIsNaN(required[l]) && reachable >= required[l];
+    };
+    auto place = [&](int l, double value) {
+        const double *row = cooling.constData() + l * fanTotal;
+        for (int f = 0; f < fanTotal; f++) {
+            position[f] = positionFor(f, demand[f] + value * row[f]);
+        }
+    };
+
+    for (int sweep = 0; sweep < MAX_SWEEPS; sweep++) {
+        double moved = 0.0;
+        for (int l = 0; l < limits.size(); l++) {
+            if (!active(l)) {
+                continue;
+            }
+            const double *row = cooling.constData() + l * fanTotal;
+            double old = multiplier[l];
+            for (int f = 0; f < fanTotal; f++) {
+                demand[f] -= old * row[f];
+            }
+
+            double value = 0.0;
+            place(l, 0.0);
+            if (slack(l) < 0.0) {
+                double low = 0.0;
+                double high = 1.0;
+                place(l, high);
+                while (slack(l) < 0.0 && high < 1e12) {
+                    low = high;
+                    high *= 4.0;
+                    place(l, high);
+                }
+                for (int step = 0; step < BISECTION_STEPS; step++) {
+                    double middle = 0.5 * (low + high);
+                    place(l, middle);
+                    if (slack(l) < 0.0) {
+                        low = middle;
+                    } else {
+                        high = middle;
+                    }
+                }
+                value = high;
+            }
+
+            multiplier[l] = value;
+            for (int f = 0; f < fanTotal; f++) {
+                demand[f] += value * row[f];
+            }
+            moved = qMax(moved, qAbs(value - old) / qMax(1.0, value));
+        }
+        for (int f = 0; f < fanTotal; f++) {
+            position[f] = positionFor(f, demand[f]);
+        }
+        if (moved < CONVERGED) {
+            break;
+        }
+    }
+
+    // Limits out of reach get everything that helps them
+    if (!feasible) {
+        for (int l = 0; l < limits.size(); l++) {
+            if (qIsNaN(required[l]) || active(l)) {
+                continue;
+            }
+            const double *row = cooling.constData() + l * fanTotal;
+            for (int f = 0; f < fanTotal; f++) {
+                if (row[f] > 0.0) {
+                    position[f] = 1.0;
+                }
+            }
+        }
+    }
+
+    for (int f = 0; f < fanTotal; f++) {
+        (*targets)[f] = model.minRPM[f] + qRound(position[f] * (model.maxRPM[f] - model.minRPM[f]));
+    }
+    return feasible;
+}
+
+double AcousticOptimizer::noiseLevel(const QVector<int>& rpms)
+{
+    // Sum of powers: each fan's power goes with (rpm / 1000)^5
+    double power = 0.0;
+    for (int rpm : rpms) {
+        if (rpm > 0) {
+            power += std::pow(rpm / 1000.0, 5.0);
+        }
+    }
+    return power > 0.0 ? 10.0 * std::log10(power) : 0.0;
+}
@@ -0,0 +1,74 @@
+#ifndef ACOUSTICOPTIMIZER_H
+#define ACOUSTICOPTIMIZER_H
+
+#include <QString>
+#include <QVector>
+#include "influencemodel.h"
+
+// Upper limit on one sensor of the influence model
+struct OptimizerLimit {
+    int sensor;             // Row in the InfluenceModel
+    double limit;           // °C
+};
+
+// Chooses the quietest combination of fan speeds that keeps every limited
+// sensor below its limit, from an InfluenceModel. Noise is the weighted sum
+// of squared RPM over all fans: it grows steeply with speed, so cooling is
+// spread over the fans that reach a sensor instead of one fan running
+// flat out, and fans that do not help stay at minimum.
+//
+// Each sensor is predicted from its current reading and the model's gains:
+// a limited sensor needs
+//
+//   reading + sum of gain[fan] * (position[fan] - current position[fan]) <= limit - margin
+//
+// Re-solved every control period, the reading closes the loop around the
+// model's errors. The problem is a small convex QP with box bounds; it is
+// solved by coordinate ascent on its dual, one multiplier per limit, so a
+// solve is a few thousand multiply-adds and never allocates.
+class AcousticOptimizer {
+public:
+    static const int MAX_SWEEPS = 60;
+    static const int DEFAULT_MARGIN = 2;       // °C below each limit
+    static const int RPM_DEADBAND = 50;        // Smaller target changes are not written
+
+    AcousticOptimizer();
+
+    // Resets limits and weights; weights default to 1.0 per fan
+    void setModel(const InfluenceModel& model);
+    const InfluenceModel& getModel() const { return model; }
+    void setLimits(const QVector<OptimizerLimit>& limits);
+    const QVector<OptimizerLimit>& getLimits() const { return limits; }
+    void setNoiseWeights(const QVector<double>& weights);
+    const QVector<double>& getNoiseWeights() const { return weights; }
+    void setMargin(double celsius) { margin = celsius; }
+    double getMargin() const { return margin; }
+
+    // readings: °C per limit, in setLimits() order; current: RPM per model
+    // fan. Returns false, with every fan that cools a violated sensor at
+    // maximum, when no combination meets all limits.
+    bool solve(const QVector<double>& readings, const QVector<int>& current, QVector<int> *targets);
+
+    // Combined noise of a set of fan speeds in dB, with each fan's level
+    // rising 50 dB per decade of RPM (fan law), relative to one fan at 1000 RPM
+    static double noiseLevel(const QVector<int>& rpms);
+
+private:
+    InfluenceModel model;
+    QVector<OptimizerLimit> limits;
+    QVector<double> weights;
+    double margin;
+
+    // Solve scratch, sized by setModel()/setLimits()
+    QVector<double> cooling;        // limits x fans: -gain, °C per full range
+    QVector<double> required;       // Per limit: cooling sum the fans must reach
+    QVector<double> multiplier;     // Per limit: dual variable
+    QVector<double> demand;         // Per fan: sum of multiplier * cooling
+    QVector<double> position;       // Per fan: 0.0-1.0
+
+    void prepare();
+    double positionFor(int fan, double fanDemand) const;
+    double slack(int limit) const;
+};
+
+#endif // ACOUSTICOPTIMIZER_H
@@ -0,0 +1,107 @@
+#include "backenddiscovery.h"
+#include <QDebug>
+#include <QtConcurrent>
+
+static SMCDiscovery probeSMC(const QString& sysfsRoot)
+{
+    // A private instance: nothing on the GUI thread sees it until commit
+    SMCInterface probe;
+    probe.setSysfsRoot(sysfsRoot);
+
+    SMCDiscovery result;
+    result.available = probe.initialize();
+    result.basePath = probe.getBasePath();
+    result.macModel = probe.getMacModel();
+    if (result.available) {
+        result.fans = probe.getFans();
+        result.sensors = probe.getSensors();
+    }
+    return result;
+}
+
+BackendDiscovery::BackendDiscovery(SMCInterface *smc, HWMonInterface *hwmon, QObject *parent)
+    : QObject(parent),
+      smc(smc),
+      hwmon(hwmon)
+{
+}
+
+BackendDiscovery::~BackendDiscovery()
+{
+    // Tasks only touch their own data, but must not outlive the watchers
+    pool.waitForDone();
+    qDeleteAll(deviceWatchers);
+}
+
+void BackendDiscovery::start()
+{
+    timer.start();
+
+    // hwmon skips applesmc's own hwmon device when the SMC backend is used;
+    // the cheap path probe decides that before any task runs
+    bool smcPresent = !smc->probeBasePath().isEmpty();
+    hwmon->setSmcAvailable(smcPresent);
+    QStringList devices = hwmon->listDevices();
+
+    // Discovery is sysfs reads that block in drivers, not CPU work: one
+    // thread per task, so one slow device does not hold up the others
+    pool.setMaxThreadCount(qBound(1, devices.size() + 1, 64));
+    pendingDevices = devices.size();
+
+    connect(&smcWatcher, &QFutureWatcher<SMCDiscovery>::finished, this, &BackendDiscovery::commitReady);
+    smcWatcher.setFuture(QtConcurrent::run(&pool, probeSMC, smc->getSysfsRoot()));
+
+    for (const QString& path : devices) {
+        QFutureWatcher<HWMonDeviceScan> *watcher = new QFutureWatcher<HWMonDeviceScan>();
+        connect(watcher, &QFutureWatcher<HWMonDeviceScan>::finished, this, &BackendDiscovery::commitReady);
+        deviceWatchers.append(watcher);
+        deviceCommitted.append(false);
+        watcher->setFuture(QtConcurrent::run(&pool, &HWMonInterface::scanDevice, path, smcPresent));
+    }
+
+    qDebug() << QString("Discovering SMC and %1 hwmon devices on %2 threads")
+                    .arg(devices.size())
+                    .arg(pool.maxThreadCount());
+}
+
+void BackendDiscovery::commitReady()
+{
+    if (done) {
+        return;
+    }
+
+    if (!smcCommitted) {
+        if (!smcWatcher.isFinished()) {
+            return;
+        }
+        SMCDiscovery result = smcWatcher.result();
+        smcAvailable = result.available &&
+                       smc->initializeFromTopology(result.basePath, result.macModel, result.fans, result.sensors);
+        smcCommitted = true;
+        emit smcReady(smcAvailable);
+    }
+
+    // Every device that is done, whichever finished first
+    for (int i = 0; i < deviceWatchers.size(); i++) {
+        if (deviceCommitted[i] || !deviceWatchers[i]->isFinished()) {
+            continue;
+        }
+        int first = hwmon->getFans().size();
+        hwmon->addDevice(deviceWatchers[i]->result());
+        deviceCommitted[i] = true;
+        pendingDevices--;
+
+        int count = hwmon->getFans().size() - first;
+        if (count > 0) {
+            emit hwmonFansAdded(first, count);
+        }
+    }
+    if (pendingDevices > 0) {
+        return;
+    }
+
+    hwmonAvailable = hwmon->finishInitialization();
+    done = true;
+    elapsedNs = timer.nsecsElapsed();
+    emit discoveryFinished();
+}
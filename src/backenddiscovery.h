@@ -0,0 +1,65 @@
+#ifndef BACKENDDISCOVERY_H
+#define BACKENDDISCOVERY_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <QVector>
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+
+// Topology the SMC probe found on a worker thread
+struct SMCDiscovery {
+    bool available;
+    QString basePath;
+    QString macModel;
+    QVector<FanInfo> fans;
+    QVector<TempSensor> sensors;
+};
+
+// Full hardware discovery on a private thread pool: one task probes the
+// SMC, one task scans each hwmon device. Results are committed to the
+// backends on the owning (GUI) thread, the SMC first and then each hwmon
+// device as soon as its scan finishes, so a slow driver holds back only
+// its own fans and sensors. hwmon fan and sensor numbering therefore
+// follows completion order; saved settings are matched by fan identity
+// and sensor label, not by number.
+class BackendDiscovery : public QObject {
+    Q_OBJECT
+
+public:
+    BackendDiscovery(SMCInterface *smc, HWMonInterface *hwmon, QObject *parent = nullptr);
+    ~BackendDiscovery();
+
+    void start();
+
+    bool isFinished() const { return done; }
+    bool isSmcAvailable() const { return smcAvailable; }
+    bool isHWMonAvailable() const { return hwmonAvailable; }
+    qint64 getElapsedNs() const { return elapsedNs; }   // start() to discoveryFinished()
+
+signals:
+    void smcReady(bool available);
+    void hwmonFansAdded(int first, int count);     // Indices into hwmon->getFans()
+    void discoveryFinished();
+
+private:
+    SMCInterface *smc;
+    HWMonInterface *hwmon;
+    QThreadPool pool;
+    QElapsedTimer timer;
+    QFutureWatcher<SMCDiscovery> smcWatcher;
+    QVector<QFutureWatcher<HWMonDeviceScan>*> deviceWatchers;
+    bool smcCommitted = false;
+    QVector<bool> deviceCommitted;  // Per device watcher: added to hwmon
+    int pendingDevices = 0;         // Devices not yet added
+    bool done = false;
+    bool smcAvailable = false;
+    bool hwmonAvailable = false;
+    qint64 elapsedNs = -1;
+
+    void commitReady();
+};
+
+#endif // BACKENDDISCOVERY_H
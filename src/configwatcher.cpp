@@ -0,0 +1,96 @@
+#include "configwatcher.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Directory events that can change what the file path reads
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+ConfigFileWatcher::ConfigFileWatcher(QObject *parent)
+    : QObject(parent),
+      inotifyFd(-1),
+      notifier(nullptr),
+      debounce(new QTimer(this))
+{
+    debounce->setSingleShot(true);
+    debounce->setInterval(DEBOUNCE_MS);
+    connect(debounce, &QTimer::timeout, this, &ConfigFileWatcher::changed);
+}
+
+ConfigFileWatcher::~ConfigFileWatcher()
+{
+    unwatch();
+}
+
+bool ConfigFileWatcher::watch(const QString& filePath, QString *errorMessage)
+{
+    unwatch();
+
+    QFileInfo info(filePath);
+    QString directory = info.absolutePath();
+    if (!QDir().mkpath(directory)) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot create %1").arg(directory);
+        }
+        return false;
+    }
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0 || inotify_add_watch(inotifyFd, QFile::encodeName(directory).constData(), WATCH_MASK) < 0) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot watch %1: %2").arg(directory).arg(strerror(errno));
+        }
+        unwatch();
+        return false;
+    }
+
+    path = info.absoluteFilePath();
+    fileName = QFile::encodeName(info.fileName());
+    notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+    // By name: Qt 5.15 overloads activated(), which breaks the pointer syntax
+    connect(notifier, SIGNAL(activated(int)), this, SLOT(readEvents()));
+    qDebug() << "Watching" << path << "for changes";
+    return true;
+}
+
+void ConfigFileWatcher::readEvents()
+{
+    // Events are variable length; the buffer must be aligned for the header
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;      // EAGAIN: drained
+        }
+        for (char *cursor = buffer; cursor < buffer + length;) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(cursor);
+            cursor += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                debounce->start();      // Lost events; reload to be safe
+            } else if (event->mask & IN_IGNORED) {
+                qWarning() << "Config directory of" << path << "is gone, no longer watching it";
+            } else if (event->len > 0 && fileName == event->name) {
+                debounce->start();
+            }
+        }
+    }
+}
+
+void ConfigFileWatcher::unwatch()
+{
+    delete notifier;
+    notifier = nullptr;
+    if (inotifyFd >= 0) {
+        ::close(inotifyFd);
+        inotifyFd = -1;
+    }
+    debounce->stop();
+}
@@ -0,0 +1,44 @@
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+class QSocketNotifier;
+class QTimer;
+
+// Watches one config file with inotify on its directory, so the file being
+// created, deleted or replaced by a rename (how most editors save) is seen
+// as well as writes in place. changed() is emitted once per burst of
+// events, after DEBOUNCE_MS without another one.
+class ConfigFileWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    static const int DEBOUNCE_MS = 200;
+
+    explicit ConfigFileWatcher(QObject *parent = nullptr);
+    ~ConfigFileWatcher();
+
+    // Creates the directory if missing, so a file added later is seen
+    bool watch(const QString& filePath, QString *errorMessage = nullptr);
+    QString getPath() const { return path; }
+
+signals:
+    void changed();
+
+private slots:
+    void readEvents();
+
+private:
+    int inotifyFd;
+    QString path;
+    QByteArray fileName;        // Directory entry name the events are matched against
+    QSocketNotifier *notifier;
+    QTimer *debounce;
+
+    void unwatch();
+};
+
+#endif // CONFIGWATCHER_H
@@ -0,0 +1,493 @@
+#include "controltrace.h"
+#include <QSet>
+
+static const int TRACE_VERSION = 1;
+
+namespace {
+
+QByteArray encode(const QString& text)
+{
+    return text.toUtf8().toPercentEncoding();
+}
+
+QString decode(const QByteArray& field)
+{
+    return QString::fromUtf8(QByteArray::fromPercentEncoding(field));
+}
+
+QByteArray writeKey(qint64 timestampMs, int fan, int rpm)
+{
+    return QByteArray::number(timestampMs) + '/' + QByteArray::number(fan) + '/' + QByteArray::number(rpm);
+}
+
+} // namespace
+
+TraceFanConfig::TraceFanConfig()
+    : sensorIndex(-1),
+      minRPM(0),
+      maxRPM(0),
+      minTemp(40),
+      maxTemp(80),
+      hysteresis(2.0),
+      rpmDeadband(25),
+      leadSeconds(0.0),
+      cpuLoadBoost(0.0)
+{
+}
+
+bool TraceFanConfig::operator==(const TraceFanConfig& other) const
+{
+    return sensorIndex == other.sensorIndex && minRPM == other.minRPM && maxRPM == other.maxRPM &&
+           minTemp == other.minTemp && maxTemp == other.maxTemp && hysteresis == other.hysteresis &&
+           rpmDeadband == other.rpmDeadband && leadSeconds == other.leadSeconds &&
+           cpuLoadBoost == other.cpuLoadBoost;
+}
+
+TraceFanConfig TraceFanConfig::fromController(const FanController& controller, int sensorIndex)
+{
+    TraceFanConfig config;
+    config.sensorIndex = sensorIndex;
+    config.minRPM = controller.getMinRPM();
+    config.maxRPM = controller.getMaxRPM();
+    config.minTemp = controller.getMinTemp();
+    config.maxTemp = controller.getMaxTemp();
+    config.hysteresis = controller.getTempHysteresis();
+    config.rpmDeadband = controller.getRPMDeadband();
+    config.leadSeconds = controller.getFeedForwardLead();
+    config.cpuLoadBoost = controller.getCpuLoadBoost();
+    return config;
+}
+
+void TraceFanConfig::applyTo(FanController& controller) const
+{
+    controller.setRPMRange(minRPM, maxRPM);
+    controller.setCurve(minTemp, maxTemp);
+    controller.setHysteresis(hysteresis, rpmDeadband);
+    controller.setFeedForward(leadSeconds, cpuLoadBoost);
+}
+
+// --- Recording ---
+
+ControlTraceWriter::~ControlTraceWriter()
+{
+    stop();
+}
+
+bool ControlTraceWriter::start(const QString& path, const QString& macModel, QString *errorMessage)
+{
+    stop();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot write %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+
+    catalog.clear();
+    fanConfigs.clear();
+    ticks = 0;
+    writeLine("trace " + QByteArray::number(TRACE_VERSION) + " " + encode(macModel));
+    return true;
+}
+
+void ControlTraceWriter::stop()
+{
+    if (file.isOpen()) {
+        file.close();
+    }
+}
+
+void ControlTraceWriter::writeLine(const QByteArray& line)
+{
+    file.write(line);
+    file.write("\n");
+}
+
+void ControlTraceWriter::recordFilters(const SensorFilterBank& filters)
+{
+    if (!isRecording()) {
+        return;
+    }
+
+    // "filter *" replaces the whole configuration
+    writeLine("filter * " + encode(filters.getDefaultSpec().toString()));
+    QMap<QString, SensorFilterSpec> specs = filters.getSpecs();
+    for (auto it = specs.constBegin(); it != specs.constEnd(); ++it) {
+        writeLine("filter " + encode(it.key()) + " " + encode(it.value().toString()));
+    }
+}
+
+void ControlTraceWriter::recordVirtualSensors(const VirtualSensorEngine& engine)
+{
+    if (!isRecording()) {
+        return;
+    }
+
+    // "virtual *" drops all previously recorded definitions
+    writeLine("virtual *");
+    for (const VirtualSensorProgram& program : engine.getPrograms()) {
+        writeLine("virtual " + QByteArray::number(program.index) + " " + encode(program.name) +
+                  " " + encode(program.expression));
+    }
+}
+
+void ControlTraceWriter::recordFans(const QVector<TraceFanConfig>& fans)
+{
+    if (!isRecording()) {
+        return;
+    }
+
+    for (int i = 0; i < fans.size(); i++) {
+        if (i < fanConfigs.size() && fanConfigs[i] == fans[i]) {
+            continue;
+        }
+        const TraceFanConfig& fan = fans[i];
+        writeLine("fan " + QByteArray::number(i) + " " + QByteArray::number(fan.sensorIndex) + " " +
+                  QByteArray::number(fan.minRPM) + " " + QByteArray::number(fan.maxRPM) + " " +
+                  QByteArray::number(fan.minTemp) + " " + QByteArray::number(fan.maxTemp) + " " +
+                  QByteArray::number(fan.hysteresis) + " " + QByteArray::number(fan.rpmDeadband) + " " +
+                  QByteArray::number(fan.leadSeconds) + " " + QByteArray::number(fan.cpuLoadBoost));
+    }
+    fanConfigs = fans;
+}
+
+void ControlTraceWriter::recordTick(qint64 timestampMs, const QVector<TempSensor>& raw, double cpuLoad)
+{
+    if (!isRecording()) {
+        return;
+    }
+
+    // Catalog line whenever the sensor layout changes
+    bool layoutChanged = (raw.size() != catalog.size());
+    for (int i = 0; !layoutChanged && i < raw.size(); i++) {
+        layoutChanged = (raw[i].index != catalog[i]);
+    }
+    if (layoutChanged) {
+        QByteArray line = "sensors";
+        catalog.resize(raw.size());
+        for (int i = 0; i < raw.size(); i++) {
+            catalog[i] = raw[i].index;
+            line += " " + QByteArray::number(raw[i].index) + ":" + encode(raw[i].label) + ":" +
+                    encode(raw[i].deviceName);
+        }
+        writeLine(line);
+    }
+
+    QByteArray line = "tick " + QByteArray::number(timestampMs) + " " +
+                      QByteArray::number(cpuLoad < 0.0 ? -1.0 : cpuLoad, 'f', 4);
+    for (const TempSensor& sensor : raw) {
+        line += " " + QByteArray::number(sensor.temperature);
+    }
+    writeLine(line);
+    ticks++;
+}
+
+void ControlTraceWriter::recordSpeeds(qint64 timestampMs, const QVector<int>& rpms)
+{
+    if (!isRecording()) {
+        return;
+    }
+
+    QByteArray line = "speeds " + QByteArray::number(timestampMs);
+    for (int rpm : rpms) {
+        line += " " + QByteArray::number(rpm);
+    }
+    writeLine(line);
+    file.flush();       // Once per tick; keeps the trace usable after a crash
+}
+
+void ControlTraceWriter::recordWrite(qint64 timestampMs, int fan, int rpm)
+{
+    if (!isRecording()) {
+        return;
+    }
+    writeLine("write " + QByteArray::number(timestampMs) + " " + QByteArray::number(fan) + " " +
+              QByteArray::number(rpm));
+}
+
+// --- Replay ---
+
+bool ControlTraceReplay::load(const QString& path, QString *errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot read %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+    return parse(file.readAll(), errorMessage);
+}
+
+bool ControlTraceReplay::parse(const QByteArray& data, QString *errorMessage)
+{
+    entries.clear();
+    recordedFans.clear();
+    macModel.clear();
+
+    bool sawHeader = false;
+    bool sawTick = false;
+    const QList<QByteArray> lines = data.split('\n');
+    for (int n = 0; n < lines.size(); n++) {
+        const QByteArray line = lines[n].trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        auto fail = [errorMessage, n](const QString& message) {
+            if (errorMessage) {
+                *errorMessage = QString("Line %1: %2").arg(n + 1).arg(message);
+            }
+            return false;
+        };
+
+        const QList<QByteArray> fields = line.split(' ');
+        const QByteArray& type = fields[0];
+        bool ok = true;
+
+        if (!sawHeader) {
+            if (type != "trace" || fields.size() < 2 || fields[1].toInt() != TRACE_VERSION) {
+                return fail("not a version 1 control trace");
+            }
+            macModel = fields.size() > 2 ? decode(fields[2]) : QString();
+            sawHeader = true;
+            continue;
+        }
+
+        Entry entry;
+        entry.timestampMs = 0;
+        entry.id = -1;
+        entry.cpuLoad = -1.0;
+
+        if (type == "filter" && fields.size() == 3) {
+            entry.type = ENTRY_FILTER;
+            entry.label = fields[1] == "*" ? QString() : decode(fields[1]);
+            entry.text = decode(fields[2]);
+            SensorFilterSpec::fromString(entry.text, &ok);
+        } else if (type == "virtual" && (fields.size() == 2 || fields.size() == 4)) {
+            entry.type = ENTRY_VIRTUAL;
+            if (fields[1] != "*") {
+                entry.id = fields[1].toInt(&ok);
+                entry.label = decode(fields[2]);
+                entry.text = decode(fields[3]);
+            }
+        } else if (type == "sensors") {
+            entry.type = ENTRY_SENSORS;
+            for (int i = 1; ok && i < fields.size(); i++) {
+                const QList<QByteArray> parts = fields[i].split(':');
+                if (parts.size() != 3) {
+                    return fail("malformed sensor " + QString::fromUtf8(fields[i]));
+                }
+                TempSensor sensor;
+                sensor.index = parts[0].toInt(&ok);
+                sensor.label = decode(parts[1]);
+                sensor.deviceName = decode(parts[2]);
+                sensor.temperature = -1;
+                entry.catalog.append(sensor);
+            }
+        } else if (type == "fan" && fields.size() == 11) {
+            entry.type = ENTRY_FAN;
+            bool fieldOk[11];
+            entry.id = fields[1].toInt(&fieldOk[1]);
+            entry.fan.sensorIndex = fields[2].toInt(&fieldOk[2]);
+            entry.fan.minRPM = fields[3].toInt(&fieldOk[3]);
+            entry.fan.maxRPM = fields[4].toInt(&fieldOk[4]);
+            entry.fan.minTemp = fields[5].toInt(&fieldOk[5]);
+            entry.fan.maxTemp = fields[6].toInt(&fieldOk[6]);
+            entry.fan.hysteresis = fields[7].toDouble(&fieldOk[7]);
+            entry.fan.rpmDeadband = fields[8].toInt(&fieldOk[8]);
+            entry.fan.leadSeconds = fields[9].toDouble(&fieldOk[9]);
+            entry.fan.cpuLoadBoost = fields[10].toDouble(&fieldOk[10]);
+            for (int i = 1; i < 11; i++) {
+                ok = ok && fieldOk[i];
+            }
+            ok = ok && entry.id >= 0;
+        } else if (type == "tick" && fields.size() >= 3) {
+            entry.type = ENTRY_TICK;
+            entry.timestampMs = fields[1].toLongLong(&ok);
+            entry.cpuLoad = ok ? fields[2].toDouble(&ok) : 0.0;
+            entry.values.reserve(fields.size() - 3);
+            for (int i = 3; ok && i < fields.size(); i++) {
+                entry.values.append(fields[i].toInt(&ok));
+            }
+        } else if (type == "write" && fields.size() == 4) {
+            entry.type = ENTRY_WRITE;
+            entry.timestampMs = fields[1].toLongLong(&ok);
+            entry.id = ok ? fields[2].toInt(&ok) : -1;
+            entry.values.append(ok ? fields[3].toInt(&ok) : 0);
+        } else if (type == "speeds") {
+            continue;       // Informational
+        } else {
+            return fail("unexpected " + QString::fromUtf8(type) + " line");
+        }
+
+        if (!ok) {
+            return fail("invalid value in " + QString::fromUtf8(type) + " line");
+        }
+
+        // Fan configuration before the first tick is what the recording started with
+        if (entry.type == ENTRY_FAN && !sawTick) {
+            recordedFans.resize(qMax(recordedFans.size(), entry.id + 1));
+            recordedFans[entry.id] = entry.fan;
+        }
+        sawTick = sawTick || entry.type == ENTRY_TICK;
+        entries.append(entry);
+    }
+
+    if (!sawHeader) {
+        if (errorMessage) {
+            *errorMessage = "Empty trace";
+        }
+        return false;
+    }
+    return true;
+}
+
+void ControlTraceReplay::overrideFan(int fan, const TraceFanConfig& config)
+{
+    fanOverrides[fan] = config;
+}
+
+void ControlTraceReplay::overrideFilter(const SensorFilterSpec& spec)
+{
+    hasFilterOverride = true;
+    filterOverride = spec;
+}
+
+int ControlTraceReplay::getTickCount() const
+{
+    int count = 0;
+    for (const Entry& entry : entries) {
+        count += (entry.type == ENTRY_TICK);
+    }
+    return count;
+}
+
+ControlTraceReplay::Result ControlTraceReplay::run() const
+{
+    Result result;
+    result.ticks = 0;
+    result.durationMs = 0;
+    result.recordedWrites = 0;
+    result.matchingWrites = 0;
+
+    SensorFilterBank filters;
+    if (hasFilterOverride) {
+        filters.setDefaultSpec(filterOverride);
+    }
+    VirtualSensorEngine virtualSensors;
+    QVector<TempSensor> catalog;
+    struct VirtualDefinition {
+        int index;
+        QString name;
+        QString expression;
+    };
+    QVector<VirtualDefinition> definitions;
+    bool recompile = false;
+
+    QVector<FanController> controllers;
+    QVector<TraceFanConfig> configs;
+    QVector<TempSensor> snapshot;
+    QSet<QByteArray> recorded;
+    qint64 firstTick = -1;
+
+    for (const Entry& entry : entries) {
+        switch (entry.type) {
+        case ENTRY_FILTER:
+            if (hasFilterOverride) {
+                break;
+            }
+            if (entry.label.isEmpty()) {
+                for (const QString& label : filters.getSpecs().keys()) {
+                    filters.removeSpec(label);
+                }
+                filters.setDefaultSpec(SensorFilterSpec::fromString(entry.text));
+            } else {
+                filters.setSpec(entry.label, SensorFilterSpec::fromString(entry.text));
+            }
+            break;
+
+        case ENTRY_VIRTUAL:
+            if (entry.id < 0) {
+                definitions.clear();
+            } else {
+                definitions.append({entry.id, entry.label, entry.text});
+            }
+            recompile = true;
+            break;
+
+        case ENTRY_SENSORS:
+            catalog = entry.catalog;
+            recompile = true;
+            break;
+
+        case ENTRY_FAN:
+            if (entry.id >= controllers.size()) {
+                controllers.resize(entry.id + 1);
+                configs.resize(entry.id + 1);
+            }
+            configs[entry.id] = fanOverrides.value(entry.id, entry.fan);
+            configs[entry.id].applyTo(controllers[entry.id]);
+            break;
+
+        case ENTRY_TICK: {
+            if (entry.values.size() != catalog.size()) {
+                break;      // Readings without a matching catalog
+            }
+            if (recompile) {
+                virtualSensors.clear();
+                for (const VirtualDefinition& definition : definitions) {
+                    virtualSensors.addSensor(definition.name, definition.expression, catalog,
+                                             definition.index);
+                }
+                recompile = false;
+            }
+
+            snapshot = catalog;
+            for (int i = 0; i < snapshot.size(); i++) {
+                snapshot[i].temperature = entry.values[i];
+            }
+            filters.apply(snapshot, entry.timestampMs);
+            virtualSensors.evaluate(snapshot);
+            virtualSensors.appendTo(snapshot);
+
+            for (int fan = 0; fan < controllers.size(); fan++) {
+                if (configs[fan].sensorIndex < 0) {
+                    continue;
+                }
+                for (const TempSensor& sensor : snapshot) {
+                    if (sensor.index == configs[fan].sensorIndex) {
+                        int target;
+                        controllers[fan].setCpuLoad(entry.cpuLoad);
+                        if (controllers[fan].update(sensor.temperature, entry.timestampMs, &target)) {
+                            result.commands.append({entry.timestampMs, fan, target});
+                        }
+                        break;
+                    }
+                }
+            }
+
+            if (firstTick < 0) {
+                firstTick = entry.timestampMs;
+            }
+            result.durationMs = entry.timestampMs - firstTick;
+            result.ticks++;
+            break;
+        }
+
+        case ENTRY_WRITE:
+            recorded.insert(writeKey(entry.timestampMs, entry.id, entry.values.first()));
+            result.recordedWrites++;
+            break;
+        }
+    }
+
+    for (const TraceCommand& command : result.commands) {
+        if (recorded.contains(writeKey(command.timestampMs, command.fan, command.rpm))) {
+            result.matchingWrites++;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,139 @@
+#ifndef CONTROLTRACE_H
+#define CONTROLTRACE_H
+
+#include <QFile>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "smcinterface.h"
+#include "sensorfilter.h"
+#include "virtualsensors.h"
+#include "fancontroller.h"
+
+// Control settings of one fan as recorded in a trace
+struct TraceFanConfig {
+    int sensorIndex;        // Sensor the fan follows, -1 = not sensor-based
+    int minRPM;
+    int maxRPM;
+    int minTemp;            // Curve start, °C
+    int maxTemp;            // Curve end, °C
+    double hysteresis;      // °C
+    int rpmDeadband;
+    double leadSeconds;     // Feed-forward lead
+    double cpuLoadBoost;    // °C at 100% CPU load
+
+    TraceFanConfig();
+    bool operator==(const TraceFanConfig& other) const;
+    bool operator!=(const TraceFanConfig& other) const { return !(*this == other); }
+
+    static TraceFanConfig fromController(const FanController& controller, int sensorIndex);
+    void applyTo(FanController& controller) const;
+};
+
+// A fan target the controller decided on
+struct TraceCommand {
+    qint64 timestampMs;
+    int fan;
+    int rpm;
+};
+
+// Records what the control loop saw and did, one line per event, so it can
+// be replayed offline:
+//
+//   trace 1 <mac model>
+//   filter <label|*> <spec>                  sensor filter configuration
+//   virtual <index> <name> <expression>      virtual sensor definitions
+//   sensors <index>:<label>:<device> ...     raw sensor catalog
+//   fan <id> <sensor> <minRPM> <maxRPM> <minTemp> <maxTemp> <hysteresis> <deadband> <lead> <boost>
+//   tick <ms> <cpu load> <temperature> ...   raw readings in catalog order
+//   speeds <ms> <rpm> ...                    measured fan speeds
+//   write <ms> <fan> <rpm>                   targets the live controller issued
+//
+// Text fields are percent-encoded. Configuration lines are repeated
+// whenever they change during the recording.
+class ControlTraceWriter {
+public:
+    ~ControlTraceWriter();
+
+    bool start(const QString& path, const QString& macModel, QString *errorMessage = nullptr);
+    void stop();
+    bool isRecording() const { return file.isOpen(); }
+    QString getPath() const { return file.fileName(); }
+    quint64 getTickCount() const { return ticks; }
+
+    void recordFilters(const SensorFilterBank& filters);
+    void recordVirtualSensors(const VirtualSensorEngine& engine);
+    void recordFans(const QVector<TraceFanConfig>& fans);   // Only written when changed
+    void recordTick(qint64 timestampMs, const QVector<TempSensor>& raw, double cpuLoad);
+    void recordSpeeds(qint64 timestampMs, const QVector<int>& rpms);
+    void recordWrite(qint64 timestampMs, int fan, int rpm);
+
+private:
+    QFile file;
+    QVector<int> catalog;               // Sensor indices of the last catalog line
+    QVector<TraceFanConfig> fanConfigs; // Last recorded fan lines
+    quint64 ticks = 0;
+
+    void writeLine(const QByteArray& line);
+};
+
+// Feeds a recorded trace through the sensor filters, virtual sensors and fan
+// controllers on the trace's own clock. No sysfs access and no wall-clock
+// time, so the same trace and settings always produce the same commands.
+class ControlTraceReplay {
+public:
+    bool load(const QString& path, QString *errorMessage = nullptr);
+    bool parse(const QByteArray& data, QString *errorMessage = nullptr);
+
+    // Settings that take precedence over the recorded ones, for tuning
+    void overrideFan(int fan, const TraceFanConfig& config);
+    void overrideFilter(const SensorFilterSpec& spec);
+    const QVector<TraceFanConfig>& getRecordedFans() const { return recordedFans; }
+
+    struct Result {
+        QVector<TraceCommand> commands;     // Targets this configuration would issue
+        int ticks;
+        qint64 durationMs;                  // Trace time covered
+        int recordedWrites;
+        int matchingWrites;                 // Recorded writes reproduced exactly
+    };
+
+    // Deterministic: identical inputs give identical results
+    Result run() const;
+
+    QString getMacModel() const { return macModel; }
+    int getTickCount() const;
+
+private:
+    enum EntryType {
+        ENTRY_FILTER,
+        ENTRY_VIRTUAL,
+        ENTRY_SENSORS,
+        ENTRY_FAN,
+        ENTRY_TICK,
+        ENTRY_WRITE
+    };
+
+    // One parsed line; fields not used by its type stay empty
+    struct Entry {
+        EntryType type;
+        qint64 timestampMs;
+        int id;                         // Fan id or virtual sensor index
+        QString label;                  // Filter label, virtual sensor name
+        QString text;                   // Filter spec, virtual sensor expression
+        double cpuLoad;
+        QVector<int> values;            // Temperatures or rpm
+        QVector<TempSensor> catalog;
+        TraceFanConfig fan;
+    };
+
+    QString macModel;
+    QVector<Entry> entries;
+    QVector<TraceFanConfig> recordedFans;   // Fan configs at the first tick
+    QMap<int, TraceFanConfig> fanOverrides;
+    bool hasFilterOverride = false;
+    SensorFilterSpec filterOverride;
+};
+
+#endif // CONTROLTRACE_H
@@ -0,0 +1,55 @@
+#include "cpuloadmonitor.h"
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+CpuLoadMonitor::CpuLoadMonitor(const QString& statPath)
+    : statPath(statPath),
+      lastBusy(0),
+      lastTotal(0),
+      hasPrevious(false)
+{
+}
+
+double CpuLoadMonitor::sample()
+{
+    QFile file(statPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1.0;
+    }
+
+    // First line: "cpu  user nice system idle iowait irq softirq steal ..."
+    QByteArray line = file.readLine();
+    file.close();
+
+    QList<QByteArray> fields = line.simplified().split(' ');
+    if (fields.size() < 5 || fields[0] != "cpu") {
+        return -1.0;
+    }
+
+    quint64 total = 0;
+    quint64 idle = 0;
+    for (int i = 1; i < fields.size(); i++) {
+        quint64 value = fields[i].toULongLong();
+        // guest and guest_nice (fields 9 and 10) are already counted in user/nice
+        if (i <= 8) {
+            total += value;
+        }
+        if (i == 4 || i == 5) {     // idle, iowait
+            idle += value;
+        }
+    }
+    quint64 busy = total - idle;
+
+    double utilization = -1.0;
+    if (hasPrevious && total > lastTotal) {
+        // iowait may go backwards on some kernels; compute signed and clamp
+        double busyDelta = static_cast<double>(busy) - static_cast<double>(lastBusy);
+        utilization = qBound(0.0, busyDelta / (total - lastTotal), 1.0);
+    }
+
+    lastBusy = busy;
+    lastTotal = total;
+    hasPrevious = true;
+    return utilization;
+}
@@ -0,0 +1,22 @@
+#ifndef CPULOADMONITOR_H
+#define CPULOADMONITOR_H
+
+#include <QString>
+#include <QtGlobal>
+
+// Aggregate CPU utilization from /proc/stat, measured between calls to sample()
+class CpuLoadMonitor {
+public:
+    explicit CpuLoadMonitor(const QString& statPath = "/proc/stat");
+
+    // Utilization (0.0-1.0) since the previous call, or -1 if unavailable
+    double sample();
+
+private:
+    QString statPath;
+    quint64 lastBusy;
+    quint64 lastTotal;
+    bool hasPrevious;
+};
+
+#endif // CPULOADMONITOR_H
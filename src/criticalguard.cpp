@@ -0,0 +1,311 @@
+#include "criticalguard.h"
+#include "fansampler.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+// While the emergency lasts, fans are set to maximum again this often
+static const qint64 REASSERT_INTERVAL_NS = 1000000000LL;
+
+namespace {
+
+bool readMillidegrees(int fd, int *value)
+{
+    if (fd < 0) {
+        return false;
+    }
+    char buffer[32];
+    ssize_t length = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (length <= 0) {
+        return false;
+    }
+    buffer[length] = '\0';
+    char *end = nullptr;
+    errno = 0;
+    long parsed = strtol(buffer, &end, 10);
+    if (end == buffer || errno != 0) {
+        return false;
+    }
+    *value = static_cast<int>(parsed);
+    return true;
+}
+
+} // namespace
+
+CriticalSensorGuard::CriticalSensorGuard(QObject *parent)
+    : QObject(parent),
+      sampler(nullptr),
+      thread(new QThread(this)),
+      intervalMs(DEFAULT_INTERVAL_MS),
+      stopRequested(false),
+      emergency(false),
+      lastMaximumNs(0),
+      writeFailed(false),
+      tripCount(0)
+{
+    thread->setObjectName("CriticalSensorGuard");
+
+    // Runs on the guard thread and returns once stop() is called
+    connect(thread, &QThread::started, this, [this]() { run(); }, Qt::DirectConnection);
+}
+
+CriticalSensorGuard::~CriticalSensorGuard()
+{
+    stop();
+}
+
+void CriticalSensorGuard::addSensor(const CriticalSensor& sensor)
+{
+    WatchedSensor watched;
+    watched.sensor = sensor;
+    watched.fd = -1;
+    watched.over = false;
+    sensors.append(watched);
+}
+
+void CriticalSensorGuard::addSMCFan(const QString& fanPath, int maxRPM)
+{
+    QByteArray base = fanPath.toLocal8Bit();
+    Fan fan;
+    fan.primary = {{base + "_manual", "1", -1}, {base + "_output", QByteArray::number(maxRPM), -1}};
+    fans.append(fan);
+}
+
+void CriticalSensorGuard::addHWMonFan(const QString& devicePath, int fanNumber)
+{
+    QByteArray pwm = (devicePath + "/pwm" + QString::number(fanNumber)).toLocal8Bit();
+    Fan fan;
+    fan.primary = {{pwm + "_enable", "1", -1}, {pwm, "255", -1}};
+    // Drivers that refuse the mode change may still take the duty cycle
+    fan.fallback = {{pwm, "255", -1}};
+    fans.append(fan);
+}
+
+void CriticalSensorGuard::clear()
+{
+    sensors.clear();
+    fans.clear();
+}
+
+bool CriticalSensorGuard::start(int interval)
+{
+    if (thread->isRunning() || interval <= 0 || sensors.isEmpty() || fans.isEmpty()) {
+        return false;
+    }
+    intervalMs = interval;
+    stopRequested = false;
+    emergency = false;
+    for (WatchedSensor& watched : sensors) {
+        watched.over = false;
+    }
+    {
+        QMutexLocker locker(&mutex);
+        trippedLabel.clear();
+    }
+    thread->start();
+    qDebug() << "Critical sensor guard started," << intervalMs << "ms interval,"
+             << sensors.size() << "sensors," << fans.size() << "fans";
+    return true;
+}
+
+void CriticalSensorGuard::stop()
+{
+    if (!thread->isRunning()) {
+        return;
+    }
+    stopRequested = true;
+    periodic.interrupt();
+    thread->quit();
+    thread->wait();
+    // Fans stay as they are; the caller decides who drives them next
+    emergency = false;
+}
+
+bool CriticalSensorGuard::isRunning() const
+{
+    return thread->isRunning();
+}
+
+QString CriticalSensorGuard::getTrippedLabel() const
+{
+    QMutexLocker locker(&mutex);
+    return trippedLabel;
+}
+
+quint64 CriticalSensorGuard::getTripCount() const
+{
+    QMutexLocker locker(&mutex);
+    return tripCount;
+}
+
+LatencyHistogram CriticalSensorGuard::getTripLatency() const
+{
+    QMutexLocker locker(&mutex);
+    return tripLatency;
+}
+
+LatencyHistogram CriticalSensorGuard::getTickCost() const
+{
+    QMutexLocker locker(&mutex);
+    return tickCost;
+}
+
+void CriticalSensorGuard::run()
+{
+    if (realtime.enabled) {
+        QString state;
+        applyRealtime(realtime, &state);
+        qDebug() << "Critical sensor guard scheduling:" << state;
+    }
+
+    openFiles();
+    if (periodic.start(intervalMs * 1000000LL)) {
+        while (!stopRequested) {
+            if (periodic.wait(nullptr) == 0) {
+                continue;       // Interrupted by stop()
+            }
+            tick();
+        }
+        periodic.stop();
+    } else {
+        qWarning() << "Critical sensor guard cannot arm its timer, not watching";
+    }
+    closeFiles();
+}
+
+void CriticalSensorGuard::tick()
+{
+    qint64 readStart = monotonicNs();
+    bool anyOver = false;
+
+    for (WatchedSensor& watched : sensors) {
+        int temperature;
+        if (!readMillidegrees(watched.fd, &temperature)) {
+            // A failed read neither trips nor releases
+            anyOver = anyOver || watched.over;
+            continue;
+        }
+
+        if (temperature >= watched.sensor.limit) {
+            watched.over = true;
+            if (!emergency) {
+                // Straight to the fans, before the remaining sensors are read
+                emergency = true;
+                writeMaximum();
+                qint64 done = monotonicNs();
+                lastMaximumNs = done;
+
+                // A trim the sampler had under way may land after the first pass
+                if (sampler) {
+                    sampler->clearAllTargets();
+                    writeMaximum();
+                }
+                {
+                    QMutexLocker locker(&mutex);
+                    trippedLabel = watched.sensor.label;
+                    tripCount++;
+                    tripLatency.record(done - readStart);
+                }
+                qWarning() << "Critical sensor" << watched.sensor.label << "at" << temperature / 1000.0
+                           << "°C: fans to maximum in" << (done - readStart) / 1.0e6 << "ms";
+                emit emergencyChanged(true, watched.sensor.label, temperature);
+            }
+        } else if (temperature < watched.sensor.release) {
+            watched.over = false;
+        }
+        anyOver = anyOver || watched.over;
+    }
+
+    qint64 now = monotonicNs();
+    if (emergency && !anyOver) {
+        emergency = false;
+        QString label = getTrippedLabel();
+        qDebug() << "Critical sensors back below their release temperature, handing back control";
+        emit emergencyChanged(false, label, 0);
+    } else if (emergency && now - lastMaximumNs >= REASSERT_INTERVAL_NS) {
+        writeMaximum();
+        lastMaximumNs = now;
+    }
+
+    QMutexLocker locker(&mutex);
+    tickCost.record(now - readStart);
+}
+
+bool CriticalSensorGuard::writeAll(QVector<Write>& writes)
+{
+    bool ok = true;
+    for (Write& entry : writes) {
+        ssize_t length;
+        if (entry.fd >= 0) {
+            length = pwrite(entry.fd, entry.value.constData(), entry.value.size(), 0);
+        } else {
+            int fd = open(entry.path.constData(), O_WRONLY | O_CLOEXEC);
+            if (fd < 0) {
+                ok = false;
+                continue;
+            }
+            length = write(fd, entry.value.constData(), entry.value.size());
+            close(fd);
+        }
+        ok = length == entry.value.size() && ok;
+    }
+    return ok;
+}
+
+bool CriticalSensorGuard::writeMaximum()
+{
+    int failed = 0;
+    for (Fan& fan : fans) {
+        if (!writeAll(fan.primary) && (fan.fallback.isEmpty() || !writeAll(fan.fallback))) {
+            failed++;
+        }
+    }
+    if (failed > 0 && !writeFailed) {
+        qWarning() << "Critical sensor guard cannot set" << failed << "fans to maximum";
+    }
+    writeFailed = failed > 0;
+    return failed == 0;
+}
+
+void CriticalSensorGuard::openFiles()
+{
+    for (WatchedSensor& watched : sensors) {
+        watched.fd = open(watched.sensor.inputPath.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+        if (watched.fd < 0) {
+            qWarning() << "Critical sensor guard cannot read" << watched.sensor.inputPath;
+        }
+    }
+    for (Fan& fan : fans) {
+        for (Write& entry : fan.primary) {
+            entry.fd = open(entry.path.constData(), O_WRONLY | O_CLOEXEC);
+        }
+        for (Write& entry : fan.fallback) {
+            entry.fd = open(entry.path.constData(), O_WRONLY | O_CLOEXEC);
+        }
+    }
+}
+
+void CriticalSensorGuard::closeFiles()
+{
+    auto closeFd = [](int *fd) {
+        if (*fd >= 0) {
+            close(*fd);
+        }
+        *fd = -1;
+    };
+    for (WatchedSensor& watched : sensors) {
+        closeFd(&watched.fd);
+    }
+    for (Fan& fan : fans) {
+        for (Write& entry : fan.primary) {
+            closeFd(&entry.fd);
+        }
+        for (Write& entry : fan.fallback) {
+            closeFd(&entry.fd);
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef CRITICALGUARD_H
+#define CRITICALGUARD_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "latencystats.h"
+#include "realtime.h"
+
+class QThread;
+class FanSampler;
+
+// A sensor watched for thermal emergencies
+struct CriticalSensor {
+    QString label;          // Sensor label, as in the temperature panel
+    QString inputPath;      // temp*_input file
+    int limit;              // Millidegrees Celsius; at or above, fans go to maximum
+    int release;            // Millidegrees Celsius; all sensors below it hand control back
+};
+
+// Thermal emergency fast path. A few user-designated sensors are read at a
+// high rate (20 Hz by default) on a dedicated thread, apart from the GUI
+// tick, filters, history and UI. When one reaches its limit every
+// registered fan is driven straight to maximum speed; once all are below
+// their release temperature, emergencyChanged(false) tells the normal
+// control loop to take over again.
+//
+// Sensor and fan files are opened once at start() and accessed with
+// pread()/pwrite(), so a tick is a handful of system calls. While the
+// emergency lasts, the maximum is written again every second in case a
+// write from the normal loop, already under way at the trip, landed later.
+class CriticalSensorGuard : public QObject {
+    Q_OBJECT
+
+public:
+    static const int DEFAULT_INTERVAL_MS = 50;
+    static const int DEFAULT_RELEASE_MARGIN = 5000;     // Millidegrees below the limit
+
+    explicit CriticalSensorGuard(QObject *parent = nullptr);
+    ~CriticalSensorGuard();
+
+    // Sensors and fans are registered while the guard is stopped; fanPath
+    // is the SMC fan's base path ("…/fanN"), devicePath the hwmon device
+    void addSensor(const CriticalSensor& sensor);
+    void addSMCFan(const QString& fanPath, int maxRPM);
+    void addHWMonFan(const QString& devicePath, int fanNumber);
+    void clear();
+    int getSensorCount() const { return sensors.size(); }
+    int getFanCount() const { return fans.size(); }
+
+    // Its RPM targets are dropped on a trip, so it does not trim fans back down
+    void setSampler(FanSampler *sampler) { this->sampler = sampler; }
+    void setRealtime(const RealtimeOptions& options) { realtime = options; }
+
+    bool start(int intervalMs = DEFAULT_INTERVAL_MS);
+    void stop();
+    bool isRunning() const;
+    int getIntervalMs() const { return intervalMs; }
+
+    bool isEmergency() const { return emergency; }
+    QString getTrippedLabel() const;    // Sensor that caused the current emergency
+    quint64 getTripCount() const;
+
+    // From the start of the read that saw a limit crossed to the last fan
+    // write of the first maximum pass, per trip
+    LatencyHistogram getTripLatency() const;
+    // Duration of every tick, sensor reads and any fan writes
+    LatencyHistogram getTickCost() const;
+
+signals:
+    // Queued to the receiver's thread; temperature in millidegrees Celsius
+    void emergencyChanged(bool active, const QString& label, int temperature);
+
+private:
+    struct Write {
+        QByteArray path;
+        QByteArray value;
+        int fd;             // Open while running, -1 otherwise
+    };
+
+    // Maximum speed of one fan: primary writes, and writes tried instead
+    // if any of those fails
+    struct Fan {
+        QVector<Write> primary;
+        QVector<Write> fallback;
+    };
+
+    struct WatchedSensor {
+        CriticalSensor sensor;
+        int fd;
+        bool over;          // Above its release temperature since the trip
+    };
+
+    QVector<WatchedSensor> sensors;
+    QVector<Fan> fans;
+    FanSampler *sampler;
+    RealtimeOptions realtime;
+    QThread *thread;
+    int intervalMs;
+    PeriodicTimer periodic;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> emergency;
+    qint64 lastMaximumNs;       // Guard thread only: last maximum pass
+    bool writeFailed;           // Guard thread only: already warned
+
+    mutable QMutex mutex;       // Guards the fields below
+    QString trippedLabel;
+    quint64 tripCount;
+    LatencyHistogram tripLatency;
+    LatencyHistogram tickCost;
+
+    void run();
+    void tick();
+    bool writeMaximum();
+    void openFiles();
+    void closeFiles();
+    static bool writeAll(QVector<Write>& writes);
+
+    CriticalSensorGuard(const CriticalSensorGuard&) = delete;
+    CriticalSensorGuard& operator=(const CriticalSensorGuard&) = delete;
+};
+
+#endif // CRITICALGUARD_H
@@ -0,0 +1,337 @@
+#include "discoverymanifest.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QSysInfo>
+
+// Bump when the stored fields change; older manifests are then ignored
+static const int MANIFEST_VERSION = 1;
+
+static QString readFirstLine(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+    return QString::fromLocal8Bit(file.readLine()).trimmed();
+}
+
+bool DiscoveryManifest::Key::operator==(const Key& other) const
+{
+    return sysfsRoot == other.sysfsRoot &&
+           productName == other.productName &&
+           kernelVersion == other.kernelVersion &&
+           smcBasePath == other.smcBasePath &&
+           hwmonDevices == other.hwmonDevices;
+}
+
+DiscoveryManifest::Key DiscoveryManifest::currentKey(const QString& sysfsRoot, const QString& smcBasePath)
+{
+    Key key;
+    key.sysfsRoot = sysfsRoot;
+    key.productName = readFirstLine(sysfsRoot + "/sys/devices/virtual/dmi/id/product_name");
+    key.kernelVersion = QSysInfo::kernelVersion();
+    key.smcBasePath = smcBasePath;
+
+    // hwmonN numbering follows driver probe order, so the link target (the
+    // parent device) and driver name identify what sits behind each number
+    QString hwmonRoot = sysfsRoot + "/sys/class/hwmon";
+    QStringList devices = QDir(hwmonRoot).entryList(QStringList() << "hwmon*", QDir::Dirs);
+    for (const QString& device : devices) {
+        QString path = hwmonRoot + "/" + device;
+        key.hwmonDevices << QString("%1 %2 %3").arg(device, readFirstLine(path + "/name"),
+                                                    QFileInfo(path).symLinkTarget());
+    }
+    return key;
+}
+
+QString DiscoveryManifest::deviceIdentity(const QString& devicePath)
+{
+    QString name = readFirstLine(devicePath + "/name");
+    QString target = QFileInfo(devicePath).symLinkTarget();
+    int devices = target.indexOf("/devices/");
+    if (devices < 0) {
+        return name;
+    }
+
+    // "…/devices/platform/nct6775.656/hwmon/hwmon2" -> "devices/platform/nct6775.656"
+    QString parent = target.mid(devices + 1).section('/', 0, -2);
+    if (parent.endsWith("/hwmon")) {
+        parent.chop(6);
+    }
+    return name + "@" + parent;
+}
+
+QString DiscoveryManifest::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+           "/macsfancontrol/discovery.ini";
+}
+
+bool DiscoveryManifest::load(const QString& path, QString *errorMessage)
+{
+    if (!QFileInfo(path).isReadable()) {
+        if (errorMessage) {
+            *errorMessage = "No discovery manifest at " + path;
+        }
+        return false;
+    }
+
+    QSettings settings(path, QSettings::IniFormat);
+    if (settings.status() != QSettings::NoError ||
+        settings.value("manifest/version", 0).toInt() != MANIFEST_VERSION) {
+        if (errorMessage) {
+            *errorMessage = "Unsupported discovery manifest " + path;
+        }
+        return false;
+    }
+
+    settings.beginGroup("key");
+    key.sysfsRoot = settings.value("sysfsRoot").toString();
+    key.productName = settings.value("productName").toString();
+    key.kernelVersion = settings.value("kernelVersion").toString();
+    key.smcBasePath = settings.value("smcBasePath").toString();
+    key.hwmonDevices = settings.value("hwmonDevices").toStringList();
+    settings.endGroup();
+
+    settings.beginGroup("smc");
+    smcAvailable = settings.value("available", false).toBool();
+    macModel = settings.value("macModel").toString();
+    smcFans.clear();
+    int count = settings.value("fanCount", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        FanInfo fan;
+        fan.index = settings.value("index").toInt();
+        fan.label = settings.value("label").toString();
+        fan.minRPM = settings.value("min").toInt();
+        fan.maxRPM = settings.value("max").toInt();
+        fan.sysfsPath = settings.value("path").toString();
+        fan.currentRPM = 0;
+        fan.targetRPM = 0;
+        fan.isManual = false;
+        smcFans.append(fan);
+        settings.endGroup();
+    }
+    smcSensors.clear();
+    count = settings.value("sensorCount", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        TempSensor sensor;
+        sensor.index = settings.value("index").toInt();
+        sensor.label = settings.value("label").toString();
+        sensor.sysfsPath = settings.value("path").toString();
+        sensor.deviceName = "applesmc";
+        sensor.temperature = 0;
+        smcSensors.append(sensor);
+        settings.endGroup();
+    }
+    settings.endGroup();
+
+    settings.beginGroup("hwmon");
+    hwmonFans.clear();
+    count = settings.value("fanCount", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        HWMonFan fan;
+        fan.deviceName = settings.value("device").toString();
+        fan.devicePath = settings.value("path").toString();
+        fan.fanNumber = settings.value("number").toInt();
+        fan.label = settings.value("label").toString();
+        fan.minRPM = settings.value("min").toInt();
+        fan.maxRPM = settings.value("max").toInt();
+        fan.supportsManualControl = settings.value("pwm", false).toBool();
+        fan.currentRPM = 0;
+        fan.currentPWM = 0;
+        fan.isManual = false;
+        hwmonFans.append(fan);
+        settings.endGroup();
+    }
+    hwmonSensors.clear();
+    count = settings.value("sensorCount", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        HWMonSensor sensor;
+        sensor.deviceName = settings.value("device").toString();
+        sensor.devicePath = settings.value("path").toString();
+        sensor.label = settings.value("label").toString();
+        sensor.index = settings.value("index").toInt();
+        sensor.temperature = 0;
+        sensor.stale = false;
+        hwmonSensors.append(sensor);
+        settings.endGroup();
+    }
+    settings.endGroup();
+
+    return true;
+}
+
+bool DiscoveryManifest::save(const QString& path, QString *errorMessage) const
+{
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        if (errorMessage) {
+            *errorMessage = "Cannot create directory for " + path;
+        }
+        return false;
+    }
+
+    QSettings settings(path, QSettings::IniFormat);
+    settings.clear();
+    settings.setValue("manifest/version", MANIFEST_VERSION);
+
+    settings.beginGroup("key");
+    settings.setValue("sysfsRoot", key.sysfsRoot);
+    settings.setValue("productName", key.productName);
+    settings.setValue("kernelVersion", key.kernelVersion);
+    settings.setValue("smcBasePath", key.smcBasePath);
+    settings.setValue("hwmonDevices", key.hwmonDevices);
+    settings.endGroup();
+
+    settings.beginGroup("smc");
+    settings.setValue("available", smcAvailable);
+    settings.setValue("macModel", macModel);
+    settings.setValue("fanCount", smcFans.size());
+    for (int i = 0; i < smcFans.size(); i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        settings.setValue("index", smcFans[i].index);
+        settings.setValue("label", smcFans[i].label);
+        settings.setValue("min", smcFans[i].minRPM);
+        settings.setValue("max", smcFans[i].maxRPM);
+        settings.setValue("path", smcFans[i].sysfsPath);
+        settings.endGroup();
+    }
+    settings.setValue("sensorCount", smcSensors.size());
+    for (int i = 0; i < smcSensors.size(); i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        settings.setValue("index", smcSensors[i].index);
+        settings.setValue("label", smcSensors[i].label);
+        settings.setValue("path", smcSensors[i].sysfsPath);
+        settings.endGroup();
+    }
+    settings.endGroup();
+
+    settings.beginGroup("hwmon");
+    settings.setValue("fanCount", hwmonFans.size());
+    for (int i = 0; i < hwmonFans.size(); i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        settings.setValue("device", hwmonFans[i].deviceName);
+        settings.setValue("path", hwmonFans[i].devicePath);
+        settings.setValue("number", hwmonFans[i].fanNumber);
+        settings.setValue("label", hwmonFans[i].label);
+        settings.setValue("min", hwmonFans[i].minRPM);
+        settings.setValue("max", hwmonFans[i].maxRPM);
+        settings.setValue("pwm", hwmonFans[i].supportsManualControl);
+        settings.endGroup();
+    }
+    settings.setValue("sensorCount", hwmonSensors.size());
+    for (int i = 0; i < hwmonSensors.size(); i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        settings.setValue("device", hwmonSensors[i].deviceName);
+        settings.setValue("path", hwmonSensors[i].devicePath);
+        settings.setValue("label", hwmonSensors[i].label);
+        settings.setValue("index", hwmonSensors[i].index);
+        settings.endGroup();
+    }
+    settings.endGroup();
+
+    settings.sync();
+    if (settings.status() != QSettings::NoError) {
+        if (errorMessage) {
+            *errorMessage = "Cannot write discovery manifest " + path;
+        }
+        return false;
+    }
+    return true;
+}
+
+void DiscoveryManifest::capture(const Key& currentKey, bool smcUp, const SMCInterface& smc,
+                                const HWMonInterface& hwmon)
+{
+    key = currentKey;
+    smcAvailable = smcUp;
+    macModel = smc.getMacModel();
+    smcFans = smcUp ? smc.getFans() : QVector<FanInfo>();
+    smcSensors = smcUp ? smc.getSensors() : QVector<TempSensor>();
+    hwmonFans = hwmon.getFans();
+    hwmonSensors = hwmon.getSensors();
+}
+
+bool DiscoveryManifest::restore(SMCInterface *smc, HWMonInterface *hwmon, bool *hwmonAvailable) const
+{
+    bool smcUp = smcAvailable && smc->initializeFromTopology(key.smcBasePath, macModel, smcFans, smcSensors);
+    hwmon->setSmcAvailable(smcUp);
+    bool hwmonUp = hwmon->initializeFromTopology(hwmonFans, hwmonSensors);
+    if (hwmonAvailable) {
+        *hwmonAvailable = hwmonUp;
+    }
+    return smcUp;
+}
+
+bool DiscoveryManifest::restoreBackends(SMCInterface *smc, HWMonInterface *hwmon, const QString& path,
+                                        Result *result)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    *result = {false, false, false, 0};
+    if (path.isEmpty()) {
+        return false;
+    }
+
+    DiscoveryManifest manifest;
+    QString errorMessage;
+    if (!manifest.load(path, &errorMessage)) {
+        qDebug() << errorMessage;
+        return false;
+    }
+    if (manifest.getKey() != currentKey(smc->getSysfsRoot(), smc->probeBasePath())) {
+        qDebug() << "Discovery manifest is stale, rescanning hardware";
+        return false;
+    }
+
+    result->smcAvailable = manifest.restore(smc, hwmon, &result->hwmonAvailable);
+    result->warm = true;
+    result->elapsedNs = timer.nsecsElapsed();
+    return true;
+}
+
+void DiscoveryManifest::saveBackends(const QString& path, bool smcAvailable, const SMCInterface& smc,
+                                     const HWMonInterface& hwmon)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+
+    DiscoveryManifest manifest;
+    manifest.capture(currentKey(smc.getSysfsRoot(), smcAvailable ? smc.getBasePath() : QString()),
+                     smcAvailable, smc, hwmon);
+    QString errorMessage;
+    if (!manifest.save(path, &errorMessage)) {
+        qWarning() << errorMessage;
+    }
+}
+
+DiscoveryManifest::Result DiscoveryManifest::initializeBackends(SMCInterface *smc, HWMonInterface *hwmon,
+                                                                 const QString& path)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Result result;
+    if (restoreBackends(smc, hwmon, path, &result)) {
+        return result;
+    }
+
+    result.smcAvailable = smc->initialize();
+    hwmon->setSmcAvailable(result.smcAvailable);
+    result.hwmonAvailable = hwmon->initialize();
+    if (result.smcAvailable || result.hwmonAvailable) {
+        saveBackends(path, result.smcAvailable, *smc, *hwmon);
+    }
+    result.elapsedNs = timer.nsecsElapsed();
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef DISCOVERYMANIFEST_H
+#define DISCOVERYMANIFEST_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+
+// Hardware topology found by a full discovery (paths, labels, RPM limits,
+// PWM capability), persisted so later launches can skip probing every
+// fan and temperature attribute. A manifest is only used while its key
+// still matches the machine; anything that can change the topology (a
+// different Mac, a kernel update, hwmon devices added, removed or
+// renumbered) forces a full discovery, which refreshes the manifest.
+class DiscoveryManifest {
+public:
+    // Cheap to compute: one DMI read, uname and one listing of
+    // /sys/class/hwmon with a name read and readlink per device
+    struct Key {
+        QString sysfsRoot;
+        QString productName;        // DMI product_name
+        QString kernelVersion;
+        QString smcBasePath;        // Empty = no applesmc
+        QStringList hwmonDevices;   // "hwmonN name target" per device
+
+        bool operator==(const Key& other) const;
+        bool operator!=(const Key& other) const { return !(*this == other); }
+    };
+
+    static Key currentKey(const QString& sysfsRoot, const QString& smcBasePath);
+
+    // "name@devices/…" for an hwmon device directory: its driver name and
+    // the parent device its class link points into, which stays the same
+    // when hwmonN is renumbered and differs between two chips of one driver.
+    // Just the name when the directory is not a link into /devices.
+    static QString deviceIdentity(const QString& devicePath);
+
+    // ~/.cache/macsfancontrol/discovery.ini
+    static QString defaultPath();
+
+    bool load(const QString& path, QString *errorMessage = nullptr);
+    bool save(const QString& path, QString *errorMessage = nullptr) const;
+
+    // Snapshot of initialized backends, and the reverse. restore() only
+    // re-reads runtime state (fan speeds, modes), not the topology; it
+    // returns whether the SMC came up and reports the same for hwmon.
+    void capture(const Key& key, bool smcAvailable, const SMCInterface& smc, const HWMonInterface& hwmon);
+    bool restore(SMCInterface *smc, HWMonInterface *hwmon, bool *hwmonAvailable) const;
+
+    const Key& getKey() const { return key; }
+
+    struct Result {
+        bool smcAvailable;
+        bool hwmonAvailable;
+        bool warm;              // Topology came from the manifest
+        qint64 elapsedNs;       // Key check plus discovery or restore
+    };
+
+    // Initializes both backends, from the manifest at path when it matches
+    // the machine, otherwise by full discovery that rewrites the manifest.
+    // An empty path always runs full discovery and saves nothing.
+    static Result initializeBackends(SMCInterface *smc, HWMonInterface *hwmon, const QString& path);
+
+    // The two halves of initializeBackends(), for callers that run full
+    // discovery themselves (see BackendDiscovery): restore when the manifest
+    // at path matches the machine, and rewrite it after a full discovery
+    static bool restoreBackends(SMCInterface *smc, HWMonInterface *hwmon, const QString& path, Result *result);
+    static void saveBackends(const QString& path, bool smcAvailable, const SMCInterface& smc,
+                             const HWMonInterface& hwmon);
+
+private:
+    Key key;
+    bool smcAvailable = false;
+    QString macModel;
+    QVector<FanInfo> smcFans;
+    QVector<TempSensor> smcSensors;
+    QVector<HWMonFan> hwmonFans;
+    QVector<HWMonSensor> hwmonSensors;
+};
+
+#endif // DISCOVERYMANIFEST_H
@@ -0,0 +1,191 @@
+#include "fanbackend.h"
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+
+namespace {
+
+// Per-fan operations, applied to whichever adapter drives the fan
+struct SetManual {
+    bool manual;
+    template <typename Backend>
+    int operator()(Backend& backend, int index) const { return backend.setManual(index, manual); }
+};
+
+struct SetSpeed {
+    int rpm;
+    template <typename Backend>
+    int operator()(Backend& backend, int index) const { return backend.setSpeed(index, rpm); }
+};
+
+struct GetPWM {
+    template <typename Backend>
+    int operator()(Backend& backend, int index) const { return backend.getPWM(index); }
+};
+
+} // namespace
+
+void SMCFanBackend::readSpeeds(const QVector<int>& indices, QVector<int> *rpms)
+{
+    for (int i = 0; i < indices.size(); i++) {
+        (*rpms)[i] = smc->getFanCurrentRPM(indices[i]);
+    }
+}
+
+bool SMCFanBackend::setManual(int index, bool manual)
+{
+    return smc->setFanManualMode(index, manual);
+}
+
+bool SMCFanBackend::setSpeed(int index, int rpm)
+{
+    return smc->setFanSpeed(index, rpm);
+}
+
+void HWMonFanBackend::readSpeeds(const QVector<int>& indices, QVector<int> *rpms)
+{
+    hwmon->getFanCurrentRPMs(indices, rpms);
+}
+
+bool HWMonFanBackend::setManual(int index, bool manual)
+{
+    return hwmon->setFanManualMode(index, manual);
+}
+
+bool HWMonFanBackend::setSpeed(int index, int rpm)
+{
+    return hwmon->setFanSpeed(index, rpm);
+}
+
+int HWMonFanBackend::getPWM(int index)
+{
+    // Cached by the setSpeed() just before; no need to read pwm* back
+    return hwmon->getFanLastPWM(index);
+}
+
+FanBackends::FanBackends(SMCInterface *smcInterface, HWMonInterface *hwmonInterface)
+    : smc(SMCFanBackend(smcInterface)),
+      hwmon(HWMonFanBackend(hwmonInterface))
+{
+}
+
+int FanBackends::addFan(FanSource source, int sourceIndex)
+{
+    Slot slot = {source, sourceIndex};
+    fans.append(slot);
+    int fan = fans.size() - 1;
+
+    switch (source) {
+    case FAN_SOURCE_SMC:
+        smc.fans.append(fan);
+        smc.indices.append(sourceIndex);
+        smc.rpms.append(-1);
+        break;
+    case FAN_SOURCE_HWMON:
+        hwmon.fans.append(fan);
+        hwmon.indices.append(sourceIndex);
+        hwmon.rpms.append(-1);
+        break;
+    }
+    return fan;
+}
+
+TickLatencyStats::Backend FanBackends::getLatencyBackend(int fan) const
+{
+    switch (fans[fan].source) {
+    case FAN_SOURCE_SMC:
+        return SMCFanBackend::LATENCY;
+    case FAN_SOURCE_HWMON:
+        return HWMonFanBackend::LATENCY;
+    }
+    return TickLatencyStats::BACKEND_SMC;
+}
+
+template <typename Op>
+int FanBackends::dispatch(int fan, const Op& op)
+{
+    const Slot& slot = fans[fan];
+    switch (slot.source) {
+    case FAN_SOURCE_SMC:
+        return op(smc.backend, slot.sourceIndex);
+    case FAN_SOURCE_HWMON:
+        return op(hwmon.backend, slot.sourceIndex);
+    }
+    return -1;
+}
+
+template <typename Backend>
+void FanBackends::readGroup(Group<Backend>& group, QVector<int> *rpms)
+{
+    group.backend.readSpeeds(group.indices, &group.rpms);
+    for (int i = 0; i < group.fans.size(); i++) {
+        (*rpms)[group.fans[i]] = group.rpms[i];
+    }
+}
+
+template <typename Backend>
+void FanBackends::writeGroup(Group<Backend>& group, QVector<FanSpeedWrite> *writes)
+{
+    FanSpeedWrite *batch = writes->data();
+    for (int w : group.pending) {
+        FanSpeedWrite& write = batch[w];
+        write.ok = group.backend.setSpeed(fans[write.fan].sourceIndex, write.rpm);
+        write.committedNs = monotonicNs();
+    }
+}
+
+template <typename Backend>
+void FanBackends::setGroupManual(Group<Backend>& group, bool manual)
+{
+    for (int index : group.indices) {
+        group.backend.setManual(index, manual);
+    }
+}
+
+void FanBackends::readSpeeds(QVector<int> *rpms)
+{
+    rpms->resize(fans.size());
+    readGroup(smc, rpms);
+    readGroup(hwmon, rpms);
+}
+
+void FanBackends::setSpeeds(QVector<FanSpeedWrite> *writes)
+{
+    // Split the batch once; each group then loops over its own writes only
+    smc.pending.resize(0);
+    hwmon.pending.resize(0);
+    for (int w = 0; w < writes->size(); w++) {
+        switch (fans[writes->at(w).fan].source) {
+        case FAN_SOURCE_SMC:
+            smc.pending.append(w);
+            break;
+        case FAN_SOURCE_HWMON:
+            hwmon.pending.append(w);
+            break;
+        }
+    }
+    writeGroup(smc, writes);
+    writeGroup(hwmon, writes);
+}
+
+void FanBackends::setAllManual(bool manual)
+{
+    setGroupManual(smc, manual);
+    setGroupManual(hwmon, manual);
+}
+
+bool FanBackends::setManual(int fan, bool manual)
+{
+    SetManual op = {manual};
+    return dispatch(fan, op) > 0;
+}
+
+bool FanBackends::setSpeed(int fan, int rpm)
+{
+    SetSpeed op = {rpm};
+    return dispatch(fan, op) > 0;
+}
+
+int FanBackends::getPWM(int fan)
+{
+    return dispatch(fan, GetPWM());
+}
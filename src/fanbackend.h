@@ -0,0 +1,127 @@
+#ifndef FANBACKEND_H
+#define FANBACKEND_H
+
+#include <QVector>
+#include "latencystats.h"
+
+class SMCInterface;
+class HWMonInterface;
+
+enum FanSource {
+    FAN_SOURCE_SMC = 0,
+    FAN_SOURCE_HWMON = 1
+};
+
+// Adapters from one backend's interface to the fan operations FanBackends
+// needs. Every adapter has the same members and is only ever called through
+// its own type, so there are no virtual calls and the compiler sees each
+// backend's loop in full:
+//
+//   static const FanSource SOURCE;
+//   static const TickLatencyStats::Backend LATENCY;
+//   void readSpeeds(const QVector<int>& indices, QVector<int> *rpms);
+//   bool setManual(int index, bool manual);
+//   bool setSpeed(int index, int rpm);
+//   int getPWM(int index);     // Duty cycle behind the last target, -1 = none;
+//                              // cached, not read back from the hardware
+//
+// A new backend (thinkpad_acpi, dell-smm) is another adapter plus a group
+// in FanBackends.
+class SMCFanBackend {
+public:
+    static const FanSource SOURCE = FAN_SOURCE_SMC;
+    static const TickLatencyStats::Backend LATENCY = TickLatencyStats::BACKEND_SMC;
+
+    explicit SMCFanBackend(SMCInterface *smc) : smc(smc) {}
+
+    void readSpeeds(const QVector<int>& indices, QVector<int> *rpms);
+    bool setManual(int index, bool manual);
+    bool setSpeed(int index, int rpm);
+    int getPWM(int) { return -1; }     // The SMC tracks RPM targets itself
+
+private:
+    SMCInterface *smc;
+};
+
+class HWMonFanBackend {
+public:
+    static const FanSource SOURCE = FAN_SOURCE_HWMON;
+    static const TickLatencyStats::Backend LATENCY = TickLatencyStats::BACKEND_HWMON;
+
+    explicit HWMonFanBackend(HWMonInterface *hwmon) : hwmon(hwmon) {}
+
+    void readSpeeds(const QVector<int>& indices, QVector<int> *rpms);
+    bool setManual(int index, bool manual);
+    bool setSpeed(int index, int rpm);
+    int getPWM(int index);
+
+private:
+    HWMonInterface *hwmon;
+};
+
+// One fan target decided by a tick, written by FanBackends::setSpeeds()
+struct FanSpeedWrite {
+    int fan;                // FanBackends fan number
+    int rpm;
+    qint64 decidedNs;       // monotonicNs() when the controller chose rpm
+    qint64 committedNs;     // Set by setSpeeds(): monotonicNs() after the write
+    bool ok;                // Set by setSpeeds()
+};
+
+// Every fan of every backend, numbered in the order added (the fan widget
+// order). Fans are kept grouped per backend, so the per-tick operations run
+// one tight loop per backend instead of testing each fan's source, and
+// the per-fan operations dispatch in a single place.
+class FanBackends {
+public:
+    FanBackends(SMCInterface *smc, HWMonInterface *hwmon);
+
+    // Returns the new fan's number
+    int addFan(FanSource source, int sourceIndex);
+    int count() const { return fans.size(); }
+    FanSource getSource(int fan) const { return fans[fan].source; }
+    int getSourceIndex(int fan) const { return fans[fan].sourceIndex; }
+    TickLatencyStats::Backend getLatencyBackend(int fan) const;
+
+    // Speed of every fan, indexed by fan number; -1 = unreadable
+    void readSpeeds(QVector<int> *rpms);
+    // In order within each backend, one backend after another
+    void setSpeeds(QVector<FanSpeedWrite> *writes);
+    void setAllManual(bool manual);
+
+    bool setManual(int fan, bool manual);
+    bool setSpeed(int fan, int rpm);
+    int getPWM(int fan);
+
+private:
+    template <typename Backend>
+    struct Group {
+        Backend backend;
+        QVector<int> fans;          // Fan number of each member
+        QVector<int> indices;       // Index within the backend, same order
+        QVector<int> rpms;          // readSpeeds() scratch, same order
+        QVector<int> pending;       // setSpeeds() scratch: this group's positions in the batch
+
+        explicit Group(const Backend& backend) : backend(backend) {}
+    };
+
+    struct Slot {
+        FanSource source;
+        int sourceIndex;
+    };
+
+    QVector<Slot> fans;
+    Group<SMCFanBackend> smc;
+    Group<HWMonFanBackend> hwmon;
+
+    template <typename Backend>
+    static void readGroup(Group<Backend>& group, QVector<int> *rpms);
+    template <typename Backend>
+    void writeGroup(Group<Backend>& group, QVector<FanSpeedWrite> *writes);
+    template <typename Backend>
+    static void setGroupManual(Group<Backend>& group, bool manual);
+    template <typename Op>
+    int dispatch(int fan, const Op& op);
+};
+
+#endif // FANBACKEND_H
@@ -0,0 +1,311 @@
+#include "fancalibration.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFuture>
+#include <QMap>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+
+int FanCalibrationTable::pwmForRPM(int rpm, bool running) const
+{
+    if (!isValid()) {
+        return -1;
+    }
+    if (rpm <= 0) {
+        return 0;
+    }
+
+    // A stopped fan needs the start threshold; a running one only stalls
+    // below the lowest measured point
+    int floor = points.first().pwm;
+    if (!running) {
+        floor = qMax(floor, startPWM);
+    }
+
+    if (rpm <= points.first().rpm) {
+        return floor;
+    }
+    if (rpm >= points.last().rpm) {
+        return points.last().pwm;
+    }
+
+    for (int i = 0; i + 1 < points.size(); i++) {
+        const FanCalibrationPoint& low = points[i];
+        const FanCalibrationPoint& high = points[i + 1];
+        if (rpm > low.rpm && rpm <= high.rpm) {
+            // Round up so the fan reaches at least the requested speed
+            int span = high.rpm - low.rpm;
+            int pwm = low.pwm + ((rpm - low.rpm) * (high.pwm - low.pwm) + span - 1) / span;
+            return qMax(pwm, floor);
+        }
+    }
+    return points.last().pwm;
+}
+
+QString FanCalibrationTable::toString() const
+{
+    QStringList parts;
+    parts << QString("stall:%1").arg(stallPWM);
+    parts << QString("start:%1").arg(startPWM);
+    for (const FanCalibrationPoint& point : points) {
+        parts << QString("%1:%2").arg(point.pwm).arg(point.rpm);
+    }
+    return parts.join(' ');
+}
+
+FanCalibrationTable FanCalibrationTable::fromString(const QString& text, bool *ok)
+{
+    FanCalibrationTable table;
+    bool valid = true;
+
+    const QStringList parts = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        int colon = part.indexOf(':');
+        bool numberOk = false;
+        int value = part.mid(colon + 1).toInt(&numberOk);
+        if (colon < 0 || !numberOk) {
+            valid = false;
+            continue;
+        }
+
+        QString key = part.left(colon);
+        if (key == "stall") {
+            table.stallPWM = value;
+        } else if (key == "start") {
+            table.startPWM = value;
+        } else {
+            bool pwmOk = false;
+            int pwm = key.toInt(&pwmOk);
+            if (pwmOk && pwm >= 0 && pwm <= 255 && value >= 0) {
+                table.points.append({pwm, value});
+            } else {
+                valid = false;
+            }
+        }
+    }
+
+    // Keep the lookup invariants even for hand-edited settings
+    std::sort(table.points.begin(), table.points.end(),
+              [](const FanCalibrationPoint& a, const FanCalibrationPoint& b) { return a.pwm < b.pwm; });
+    for (int i = 1; i < table.points.size(); i++) {
+        table.points[i].rpm = qMax(table.points[i].rpm, table.points[i - 1].rpm);
+    }
+
+    if (ok) {
+        *ok = valid && table.isValid();
+    }
+    return table;
+}
+
+namespace {
+
+int readInt(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    bool ok = false;
+    int value = file.readLine().trimmed().toInt(&ok);
+    return ok ? value : -1;
+}
+
+bool writeInt(const QString& path, int value)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(QByteArray::number(value)) > 0;
+}
+
+bool isCancelled(const FanCalibrator::Options& options)
+{
+    return options.cancel && options.cancel->load();
+}
+
+bool closeEnough(int a, int b)
+{
+    // Tachometers jitter by a few percent even at a fixed duty cycle
+    return qAbs(a - b) <= qMax(30, qMax(a, b) / 50);
+}
+
+// Wait for the fan to settle after a PWM change; returns the settled RPM or
+// -1 if the tachometer cannot be read. A cancel cuts the wait short at the
+// next poll; the caller checks for it before using the reading.
+int settledRPM(const QString& inputPath, const FanCalibrator::Options& options)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < options.minSettleMs && !isCancelled(options)) {
+        QThread::msleep(qMin<qint64>(options.pollIntervalMs, options.minSettleMs - timer.elapsed()));
+    }
+
+    int previous = -1;
+    int beforePrevious = -1;
+    while (true) {
+        int rpm = readInt(inputPath);
+        if (rpm < 0 || isCancelled(options)) {
+            return rpm;
+        }
+        if (previous >= 0 && beforePrevious >= 0 &&
+            closeEnough(rpm, previous) && closeEnough(previous, beforePrevious)) {
+            return rpm;
+        }
+        if (timer.elapsed() >= options.maxSettleMs) {
+            return rpm;
+        }
+        beforePrevious = previous;
+        previous = rpm;
+        QThread::msleep(options.pollIntervalMs);
+    }
+}
+
+} // namespace
+
+FanCalibrationResult FanCalibrator::calibrate(const FanCalibrationTarget& target, const Options& options)
+{
+    FanCalibrationResult result;
+    result.target = target;
+
+    QString number = QString::number(target.fanNumber);
+    QString pwmPath = target.devicePath + "/pwm" + number;
+    QString enablePath = pwmPath + "_enable";
+    QString inputPath = target.devicePath + "/fan" + number + "_input";
+
+    int savedPWM = readInt(pwmPath);
+    int savedEnable = readInt(enablePath);
+    if (savedPWM < 0) {
+        result.errorMessage = "No PWM control at " + pwmPath;
+        return result;
+    }
+    if (!writeInt(enablePath, 1)) {
+        result.errorMessage = "Cannot switch " + enablePath + " to manual";
+        return result;
+    }
+
+    auto cancelled = [&options]() { return isCancelled(options); };
+    qDebug() << "Calibrating" << target.deviceName << "fan" << target.fanNumber;
+
+    // Downward sweep: response curve and stall point
+    QVector<FanCalibrationPoint> measured;
+    int stallPWM = -1;
+    int stoppedSteps = 0;
+    for (int pwm = 255; !cancelled(); pwm = qMax(0, pwm - options.sweepStep)) {
+        int rpm = writeInt(pwmPath, pwm) ? settledRPM(inputPath, options) : -1;
+        if (cancelled()) {
+            break;
+        }
+        if (rpm < 0) {
+            result.errorMessage = "Cannot drive " + pwmPath + " or read " + inputPath;
+            break;
+        }
+
+        if (rpm > 0) {
+            measured.append({pwm, rpm});
+            stoppedSteps = 0;
+        } else {
+            if (stallPWM < 0) {
+                stallPWM = pwm;
+            }
+            // Two stopped steps in a row: nothing left to measure below
+            if (++stoppedSteps >= 2) {
+                break;
+            }
+        }
+        if (pwm == 0) {
+            break;
+        }
+    }
+
+    // Upward search from standstill: start threshold
+    int startPWM = 0;
+    if (stallPWM >= 0 && result.errorMessage.isEmpty()) {
+        startPWM = 255;
+        for (int pwm = stallPWM + options.startSearchStep; pwm <= 255 && !cancelled();
+             pwm += options.startSearchStep) {
+            int rpm = writeInt(pwmPath, pwm) ? settledRPM(inputPath, options) : -1;
+            if (cancelled()) {
+                break;
+            }
+            if (rpm < 0) {
+                result.errorMessage = "Cannot drive " + pwmPath + " or read " + inputPath;
+                break;
+            }
+            if (rpm > 0) {
+                startPWM = pwm;
+                break;
+            }
+        }
+    }
+
+    // Hand the fan back the way we found it, unless a thermal emergency
+    // stopped the sweep: the guard holds it at full speed, and restoring a
+    // low PWM value would only fight that until its next pass
+    bool tripped = cancelled() && options.tripped && options.tripped->load();
+    if (!tripped) {
+        writeInt(pwmPath, savedPWM);
+        if (savedEnable >= 0) {
+            writeInt(enablePath, savedEnable);
+        }
+    }
+
+    if (cancelled() && result.errorMessage.isEmpty()) {
+        result.errorMessage = "Cancelled";
+    }
+    if (!result.errorMessage.isEmpty()) {
+        return result;
+    }
+
+    std::sort(measured.begin(), measured.end(),
+              [](const FanCalibrationPoint& a, const FanCalibrationPoint& b) { return a.pwm < b.pwm; });
+    for (int i = 1; i < measured.size(); i++) {
+        measured[i].rpm = qMax(measured[i].rpm, measured[i - 1].rpm);
+    }
+
+    result.table.points = measured;
+    result.table.stallPWM = stallPWM;
+    result.table.startPWM = startPWM;
+    if (!result.table.isValid()) {
+        result.errorMessage = "Fan did not report a speed at enough PWM steps";
+    }
+
+    qDebug() << "Calibrated" << target.deviceName << "fan" << target.fanNumber << ":"
+             << result.table.toString();
+    return result;
+}
+
+QVector<FanCalibrationResult> FanCalibrator::calibrateAll(const QVector<FanCalibrationTarget>& targets,
+                                                          const Options& options)
+{
+    // One job per hwmon device; fans sharing a controller go one at a time
+    QMap<QString, QVector<int>> byDevice;
+    for (int i = 0; i < targets.size(); i++) {
+        byDevice[targets[i].devicePath].append(i);
+    }
+
+    // Jobs mostly sleep, so give each device its own thread
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, byDevice.size()));
+
+    // Each job writes only its own fans' slots
+    QVector<FanCalibrationResult> results(targets.size());
+    FanCalibrationResult *slot = results.data();
+    QList<QFuture<void>> jobs;
+    for (const QVector<int>& device : byDevice) {
+        jobs.append(QtConcurrent::run(&pool, [&targets, &options, slot, device]() {
+            for (int i : device) {
+                slot[i] = calibrate(targets[i], options);
+            }
+        }));
+    }
+    for (QFuture<void>& job : jobs) {
+        job.waitForFinished();
+    }
+    return results;
+}
@@ -0,0 +1,82 @@
+#ifndef FANCALIBRATION_H
+#define FANCALIBRATION_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// One settled measurement
+struct FanCalibrationPoint {
+    int pwm;                // 0-255
+    int rpm;                // Settled speed at that duty cycle
+};
+
+// Measured PWM -> RPM response of one hwmon fan. Points cover the running
+// range only, sorted by PWM with RPM forced non-decreasing, so the inverse
+// lookup used by HWMonInterface::setFanSpeed is well defined.
+struct FanCalibrationTable {
+    QVector<FanCalibrationPoint> points;
+    int stallPWM;           // Highest PWM at which a running fan stopped (-1 = never stalls)
+    int startPWM;           // Lowest PWM that spins a stopped fan up
+
+    FanCalibrationTable() : stallPWM(-1), startPWM(0) {}
+
+    bool isValid() const { return points.size() >= 2; }
+    int minRPM() const { return points.isEmpty() ? 0 : points.first().rpm; }
+    int maxRPM() const { return points.isEmpty() ? 0 : points.last().rpm; }
+
+    // Smallest PWM expected to reach rpm, never below the start threshold
+    // when the fan is stopped or below the lowest running point when it is
+    // spinning. Returns -1 if the table is not valid.
+    int pwmForRPM(int rpm, bool running) const;
+
+    // Text form used in settings, e.g. "stall:60 start:75 75:610 90:820 ..."
+    QString toString() const;
+    static FanCalibrationTable fromString(const QString& text, bool *ok = nullptr);
+};
+
+// A fan to calibrate, identified the way it is stored in settings
+struct FanCalibrationTarget {
+    QString devicePath;     // e.g., "/sys/class/hwmon/hwmon2"
+    QString deviceName;     // e.g., "nct6775"
+    int fanNumber;          // 1 for fan1/pwm1
+};
+
+struct FanCalibrationResult {
+    FanCalibrationTarget target;
+    FanCalibrationTable table;
+    QString errorMessage;   // Empty on success
+};
+
+// Steps a fan through its PWM range and records the settled RPM at each step:
+// a downward sweep finds the response curve and the stall point, then an
+// upward search from the stall point finds the start threshold. The fan's
+// previous pwm/pwm_enable values are restored afterwards, except after a
+// cancel caused by a thermal emergency.
+//
+// Fans on the same hwmon device are calibrated one after another; separate
+// devices run in parallel.
+class FanCalibrator {
+public:
+    struct Options {
+        int sweepStep;              // PWM decrement of the downward sweep
+        int startSearchStep;        // PWM increment of the start threshold search
+        int pollIntervalMs;         // Time between RPM reads while settling
+        int minSettleMs;            // Minimum wait after each PWM change
+        int maxSettleMs;            // Give up waiting for a stable reading
+        std::atomic<bool> *cancel;  // Optional, checked at every RPM poll
+        std::atomic<bool> *tripped; // Optional, set before cancel when a thermal emergency
+                                    // stops the sweep: the fans are left to the guard
+
+        Options()
+            : sweepStep(15), startSearchStep(5), pollIntervalMs(250),
+              minSettleMs(1000), maxSettleMs(8000), cancel(nullptr), tripped(nullptr) {}
+    };
+
+    static FanCalibrationResult calibrate(const FanCalibrationTarget& target,
+                                          const Options& options = Options());
+    static QVector<FanCalibrationResult> calibrateAll(const QVector<FanCalibrationTarget>& targets,
+                                                      const Options& options = Options());
+};
+
+#endif // FANCALIBRATION_H
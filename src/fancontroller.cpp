@@ -0,0 +1,148 @@
+#include "fancontroller.h"
+#include <QtGlobal>
+
+// Time constant of the slope smoothing, in seconds
+static const double SLOPE_TIME_CONSTANT = 5.0;
+
+FanController::FanController(int minRPM, int maxRPM)
+    : minRPM(minRPM),
+      maxRPM(maxRPM),
+      minTemp(40),
+      maxTemp(80),
+      tempBand(2.0),
+      rpmDeadband(qMax(25, (maxRPM - minRPM) / 100)),
+      leadSeconds(0.0),
+      cpuLoadBoost(0.0),
+      cpuLoad(-1.0),
+      slope(0.0),
+      lastTemperature(0),
+      lastTimestamp(-1),
+      hasTarget(false),
+      currentTarget(0),
+      appliedTemp(0),
+      updates(0),
+      held(0)
+{
+}
+
+void FanController::setRPMRange(int min, int max)
+{
+    minRPM = min;
+    maxRPM = max;
+    reset();
+}
+
+void FanController::setCurve(int min, int max)
+{
+    minTemp = min;
+    maxTemp = max;
+    reset();
+}
+
+void FanController::setHysteresis(double band, int deadband)
+{
+    tempBand = qMax(0.0, band);
+    rpmDeadband = qMax(0, deadband);
+}
+
+void FanController::setFeedForward(double lead, double boost)
+{
+    leadSeconds = qMax(0.0, lead);
+    cpuLoadBoost = qMax(0.0, boost);
+}
+
+void FanController::setCpuLoad(double utilization)
+{
+    cpuLoad = utilization;
+}
+
+void FanController::updateSlope(int temperature, qint64 timestampMs)
+{
+    if (lastTimestamp < 0 || timestampMs < lastTimestamp) {
+        // First sample, or the clock went backwards: restart the estimate
+        slope = 0.0;
+        lastTemperature = temperature;
+        lastTimestamp = timestampMs;
+        return;
+    }
+    if (timestampMs == lastTimestamp) {
+        return;
+    }
+
+    double dt = (timestampMs - lastTimestamp) / 1000.0;
+    double rawSlope = (temperature - lastTemperature) / 1000.0 / dt;
+    slope += (dt / (SLOPE_TIME_CONSTANT + dt)) * (rawSlope - slope);
+
+    lastTemperature = temperature;
+    lastTimestamp = timestampMs;
+}
+
+int FanController::calculateFanSpeed(int currentTemp, int minTemp, int maxTemp) const
+{
+    // Ensure min < max
+    if (minTemp >= maxTemp) {
+        return minRPM;  // Safe fallback
+    }
+
+    // Clamp current temperature to range
+    if (currentTemp <= minTemp) {
+        return minRPM;
+    } else if (currentTemp >= maxTemp) {
+        return maxRPM;
+    }
+
+    // Linear interpolation between min and max
+    double tempRatio = static_cast<double>(currentTemp - minTemp) / (maxTemp - minTemp);
+    int targetRPM = minRPM + static_cast<int>(tempRatio * (maxRPM - minRPM));
+
+    return targetRPM;
+}
+
+bool FanController::update(int temperature, qint64 timestampMs, int *targetRPM)
+{
+    updates++;
+    updateSlope(temperature, timestampMs);
+
+    // Only anticipate heating; cooling is left to the hysteresis band
+    if (leadSeconds > 0.0 && slope > 0.0) {
+        temperature += static_cast<int>(leadSeconds * slope * 1000.0);
+    }
+    if (cpuLoadBoost > 0.0 && cpuLoad > 0.0) {
+        temperature += static_cast<int>(cpuLoadBoost * qMin(cpuLoad, 1.0) * 1000.0);
+    }
+
+    if (hasTarget) {
+        bool rising = temperature > appliedTemp;
+        bool fellThroughBand = temperature <= appliedTemp - static_cast<int>(tempBand * 1000.0);
+        if (!rising && !fellThroughBand) {
+            held++;
+            return false;
+        }
+    }
+
+    int rpm = calculateFanSpeed(temperature / 1000, minTemp, maxTemp);
+
+    // Small corrections are not worth a write; appliedTemp is left alone so a
+    // slow drift still accumulates until it clears the deadband
+    if (hasTarget && qAbs(rpm - currentTarget) < rpmDeadband &&
+        rpm != minRPM && rpm != maxRPM) {
+        held++;
+        return false;
+    }
+    if (hasTarget && rpm == currentTarget) {
+        appliedTemp = temperature;
+        held++;
+        return false;
+    }
+
+    hasTarget = true;
+    currentTarget = rpm;
+    appliedTemp = temperature;
+    *targetRPM = rpm;
+    return true;
+}
+
+void FanController::reset()
+{
+    hasTarget = false;
+}
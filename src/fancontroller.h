@@ -0,0 +1,92 @@
+#ifndef FANCONTROLLER_H
+#define FANCONTROLLER_H
+
+#include <QtGlobal>
+
+// How a fan is driven; stored as an int in saved sessions and presets
+enum FanMode {
+    MODE_AUTO = 0,
+    MODE_MANUAL = 1,
+    MODE_SENSOR_BASED = 2
+};
+
+// Sensor-based control law for one fan, kept free of any UI so it can be
+// driven from the widget, benchmarks or offline tools alike.
+//
+// The target follows a linear ramp between minTemp and maxTemp. Two
+// hysteresis mechanisms keep sensor jitter from turning into fan writes:
+//  - a temperature band: rising temperatures are acted on immediately, but a
+//    falling temperature must drop a full band below the reading the current
+//    target was computed from before the fan slows down again
+//  - an RPM deadband: new targets closer than this to the current one are
+//    not reported
+//
+// Optional feed-forward ramps the fan ahead of the temperature: the ramp is
+// evaluated at the temperature predicted `lead` seconds ahead from the
+// smoothed rising slope, plus a boost proportional to CPU utilization.
+class FanController {
+public:
+    FanController(int minRPM = 0, int maxRPM = 0);
+
+    void setRPMRange(int minRPM, int maxRPM);
+    int getMinRPM() const { return minRPM; }
+    int getMaxRPM() const { return maxRPM; }
+    void setCurve(int minTemp, int maxTemp);        // °C
+    int getMinTemp() const { return minTemp; }
+    int getMaxTemp() const { return maxTemp; }
+    void setHysteresis(double tempBand, int rpmDeadband);
+    double getTempHysteresis() const { return tempBand; }
+    int getRPMDeadband() const { return rpmDeadband; }
+
+    // Feed-forward: lead in seconds (0 = off), and °C added at 100% CPU load
+    // (0 = off)
+    void setFeedForward(double leadSeconds, double cpuLoadBoost);
+    double getFeedForwardLead() const { return leadSeconds; }
+    double getCpuLoadBoost() const { return cpuLoadBoost; }
+    void setCpuLoad(double utilization);            // 0.0-1.0, negative = unknown
+    double getSlope() const { return slope; }       // Smoothed °C per second
+
+    // Linear ramp (temperatures in °C)
+    int calculateFanSpeed(int currentTemp, int minTemp, int maxTemp) const;
+
+    // Feed one reading (millidegrees) taken at timestampMs on a monotonic
+    // clock. Returns true and sets targetRPM when a new target should be
+    // written; false when hysteresis holds the old one.
+    bool update(int temperature, qint64 timestampMs, int *targetRPM);
+
+    // Forget the current target so the next update always reports one
+    void reset();
+    int getTarget() const { return hasTarget ? currentTarget : -1; }   // Last reported target (-1 = none)
+
+    // Counters since construction
+    quint64 getUpdateCount() const { return updates; }
+    quint64 getHeldCount() const { return held; }
+
+private:
+    int minRPM;
+    int maxRPM;
+    int minTemp;
+    int maxTemp;
+    double tempBand;
+    int rpmDeadband;
+
+    double leadSeconds;
+    double cpuLoadBoost;
+    double cpuLoad;
+
+    // Slope estimator state
+    double slope;
+    int lastTemperature;
+    qint64 lastTimestamp;
+
+    bool hasTarget;
+    int currentTarget;
+    int appliedTemp;        // Effective temperature the current target was computed from (millidegrees)
+
+    quint64 updates;
+    quint64 held;
+
+    void updateSlope(int temperature, qint64 timestampMs);
+};
+
+#endif // FANCONTROLLER_H
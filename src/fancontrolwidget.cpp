@@ -6,13 +6,20 @@
 #include <QFrame>
 #include <QGroupBox>
 
+// Sensor combo box item data besides the sensor index (Qt::UserRole)
+static const int SENSOR_LABEL_ROLE = Qt::UserRole + 1;
+static const int SENSOR_TEMPERATURE_ROLE = Qt::UserRole + 2;
+
 FanControlWidget::FanControlWidget(const FanInfo& fanInfo, QWidget *parent)
     : QWidget(parent),
       fanIndex(fanInfo.index - 1),  // Convert to 0-based index
+      fanLabel(fanInfo.label),
+      following(false),
       minRPM(fanInfo.minRPM),
       maxRPM(fanInfo.maxRPM),
       currentMode(MODE_AUTO),
-      selectedSensorIndex(-1)
+      selectedSensorIndex(-1),
+      controller(fanInfo.minRPM, fanInfo.maxRPM)
 {
     setupUI(fanInfo);
 }
@@ -46,6 +53,12 @@ void FanControlWidget::setupUI(const FanInfo& fanInfo)
 
     frameLayout->addLayout(topRow);
 
+    // Zone this fan leads or follows
+    labelZone = new QLabel(this);
+    labelZone->setStyleSheet("font-size: 11px; color: #666;");
+    labelZone->setVisible(false);
+    frameLayout->addWidget(labelZone);
+
     // Mode selection row
     QHBoxLayout *modeRow = new QHBoxLayout();
     radioAuto = new QRadioButton("Auto", this);
@@ -121,6 +134,37 @@ void FanControlWidget::setupUI(const FanInfo& fanInfo)
     spinMaxTemp->setSuffix("°C");
     tempGrid->addWidget(spinMaxTemp, 0, 3);
 
+    // Temperature must fall this far before the fan slows down again
+    tempGrid->addWidget(new QLabel("Hysteresis:", this), 1, 0);
+    spinHysteresis = new QDoubleSpinBox(this);
+    spinHysteresis->setRange(0.0, 10.0);
+    spinHysteresis->setSingleStep(0.5);
+    spinHysteresis->setDecimals(1);
+    spinHysteresis->setValue(controller.getTempHysteresis());
+    spinHysteresis->setSuffix("°C");
+    tempGrid->addWidget(spinHysteresis, 1, 1);
+
+    // Feed-forward: react to how fast the sensor is rising, not just its value
+    tempGrid->addWidget(new QLabel("Lead:", this), 1, 2);
+    spinLead = new QDoubleSpinBox(this);
+    spinLead->setRange(0.0, 30.0);
+    spinLead->setSingleStep(1.0);
+    spinLead->setDecimals(0);
+    spinLead->setValue(0.0);
+    spinLead->setSuffix(" s");
+    spinLead->setSpecialValueText("Off");
+    spinLead->setToolTip("Ramp the fan for the temperature expected this many seconds ahead");
+    tempGrid->addWidget(spinLead, 1, 3);
+
+    tempGrid->addWidget(new QLabel("CPU Boost:", this), 2, 0);
+    spinCpuBoost = new QSpinBox(this);
+    spinCpuBoost->setRange(0, 30);
+    spinCpuBoost->setValue(0);
+    spinCpuBoost->setSuffix("°C");
+    spinCpuBoost->setSpecialValueText("Off");
+    spinCpuBoost->setToolTip("Degrees added to the reading at 100% CPU utilization");
+    tempGrid->addWidget(spinCpuBoost, 2, 1);
+
     sensorLayout->addLayout(tempGrid);
 
     // Current temperature display
@@ -165,6 +209,12 @@ void FanControlWidget::setupUI(const FanInfo& fanInfo)
             this, &FanControlWidget::onSensorSettingsChanged);
     connect(spinMaxTemp, QOverload<int>::of(&QSpinBox::valueChanged),
             this, &FanControlWidget::onSensorSettingsChanged);
+    connect(spinHysteresis, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &FanControlWidget::onSensorSettingsChanged);
+    connect(spinLead, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &FanControlWidget::onSensorSettingsChanged);
+    connect(spinCpuBoost, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &FanControlWidget::onSensorSettingsChanged);
 
     // Update initial mode indicator
     updateModeIndicator(currentMode);
@@ -210,12 +260,9 @@ void FanControlWidget::setSensorList(const QVector<TempSensor>& sensors)
     comboSensor->addItem("(Select sensor)", -1);
 
     for (const TempSensor& sensor : sensors) {
-        QString description = getSensorDescription(sensor.label);
-        QString displayText = QString("%1 - %2 (%3°C)")
-            .arg(sensor.label)
-            .arg(description)
-            .arg(sensor.temperature / 1000.0, 0, 'f', 1);
-        comboSensor->addItem(displayText, sensor.index);
+        comboSensor->addItem(sensorItemText(sensor.label, sensor.temperature), sensor.index);
+        comboSensor->setItemData(comboSensor->count() - 1, sensor.label, SENSOR_LABEL_ROLE);
+        comboSensor->setItemData(comboSensor->count() - 1, sensor.temperature, SENSOR_TEMPERATURE_ROLE);
     }
 
     // Restore the previous selection if it still exists
@@ -232,20 +279,54 @@ void FanControlWidget::setSensorList(const QVector<TempSensor>& sensors)
     comboSensor->blockSignals(false);
 }
 
-void FanControlWidget::updateSensorBasedSpeed(int currentTemp)
+QString FanControlWidget::getSelectedSensorLabel() const
+{
+    for (int i = 0; i < comboSensor->count(); i++) {
+        if (selectedSensorIndex >= 0 && comboSensor->itemData(i).toInt() == selectedSensorIndex) {
+            return comboSensor->itemData(i, SENSOR_LABEL_ROLE).toString();
+        }
+    }
+    return QString();
+}
+
+void FanControlWidget::refreshSensorDescriptions(const QSet<QString>& labels)
+{
+    for (int i = 0; i < comboSensor->count(); i++) {
+        QString label = comboSensor->itemData(i, SENSOR_LABEL_ROLE).toString();
+        if (labels.contains(label)) {
+            comboSensor->setItemText(i, sensorItemText(label, comboSensor->itemData(i, SENSOR_TEMPERATURE_ROLE).toInt()));
+        }
+    }
+}
+
+QString FanControlWidget::sensorItemText(const QString& label, int temperature)
+{
+    return QString("%1 - %2 (%3°C)")
+        .arg(label)
+        .arg(getSensorDescription(label))
+        .arg(temperature / 1000.0, 0, 'f', 1);
+}
+
+bool FanControlWidget::updateSensorBasedSpeed(int currentTemp, qint64 timestampMs, double cpuLoad)
 {
     if (currentMode != MODE_SENSOR_BASED) {
-        return;
+        return false;
     }
 
     // Update current temperature display
     labelCurrentTemp->setText(QString("%1°C").arg(currentTemp / 1000.0, 0, 'f', 1));
 
-    // Calculate and emit new fan speed
-    int targetSpeed = calculateFanSpeed(currentTemp / 1000, spinMinTemp->value(), spinMaxTemp->value());
+    // Calculate new fan speed; hysteresis may keep the current one
+    int targetSpeed;
+    controller.setCpuLoad(cpuLoad);
+    if (!controller.update(currentTemp, timestampMs, &targetSpeed)) {
+        return false;
+    }
+
     sliderRPM->setValue(targetSpeed);
     labelTargetRPM->setText(QString("%1 RPM").arg(targetSpeed));
     emit targetRPMChanged(fanIndex, targetSpeed);
+    return true;
 }
 
 void FanControlWidget::onModeChanged(int mode)
@@ -273,14 +354,22 @@ void FanControlWidget::onSliderChanged(int value)
     // Update target label
     labelTargetRPM->setText(QString("%1 RPM").arg(value));
 
-    // Only emit signal if in manual mode (not auto, not sensor-based)
-    if (currentMode == MODE_MANUAL) {
+    // Only emit signal if in manual mode (not auto, not sensor-based); a
+    // follower's slider is moved by the zone, an external controller's by it
+    if (currentMode == MODE_MANUAL && !following && controlledBy.isEmpty()) {
         emit targetRPMChanged(fanIndex, value);
     }
 }
 
 void FanControlWidget::onSensorSettingsChanged()
 {
+    // The controller follows the spin boxes even before a sensor is picked,
+    // so it never runs on its default curve. New curve: the next reading
+    // always produces a target.
+    controller.setCurve(spinMinTemp->value(), spinMaxTemp->value());
+    controller.setHysteresis(spinHysteresis->value(), controller.getRPMDeadband());
+    controller.setFeedForward(spinLead->value(), spinCpuBoost->value());
+
     if (currentMode != MODE_SENSOR_BASED) {
         return;
     }
@@ -297,14 +386,49 @@ void FanControlWidget::onSensorSettingsChanged()
                                  spinMinTemp->value(), spinMaxTemp->value());
 }
 
+void FanControlWidget::setZone(const QString& zoneName, const QString& leadLabel)
+{
+    following = !zoneName.isEmpty() && !leadLabel.isEmpty();
+    if (zoneName.isEmpty()) {
+        zoneText.clear();
+    } else if (following) {
+        zoneText = QString("Zone %1: follows %2").arg(zoneName, leadLabel);
+    } else {
+        zoneText = QString("Zone %1: controls every fan of the zone").arg(zoneName);
+    }
+    updateZoneLabel();
+    updateControlsVisibility();
+}
+
+void FanControlWidget::setControlledBy(const QString& owner)
+{
+    controlledBy = owner;
+    updateZoneLabel();
+    updateControlsVisibility();
+}
+
+void FanControlWidget::updateZoneLabel()
+{
+    labelZone->setText(controlledBy.isEmpty() ? zoneText : QString("Controlled by the %1").arg(controlledBy));
+    labelZone->setVisible(!labelZone->text().isEmpty());
+}
+
 void FanControlWidget::updateControlsVisibility()
 {
+    // The lead's controls stand for the whole zone; an external controller's for its fans
+    bool locked = following || !controlledBy.isEmpty();
+    radioAuto->setVisible(!locked);
+    radioManual->setVisible(!locked);
+    radioSensorBased->setVisible(!locked);
+    sliderRPM->setVisible(!locked);
+    labelRange->setVisible(!locked);
+
     // Show/hide controls based on mode
     sliderRPM->setEnabled(currentMode == MODE_MANUAL);
-    sensorControls->setVisible(currentMode == MODE_SENSOR_BASED);
+    sensorControls->setVisible(currentMode == MODE_SENSOR_BASED && !locked);
 
     // Target RPM label visibility
-    bool showTarget = (currentMode == MODE_MANUAL || currentMode == MODE_SENSOR_BASED);
+    bool showTarget = (currentMode == MODE_MANUAL || currentMode == MODE_SENSOR_BASED || !controlledBy.isEmpty());
     labelTargetRPM->setVisible(showTarget);
 }
 
@@ -326,27 +450,6 @@ void FanControlWidget::updateModeIndicator(FanMode mode)
     }
 }
 
-int FanControlWidget::calculateFanSpeed(int currentTemp, int minTemp, int maxTemp)
-{
-    // Ensure min < max
-    if (minTemp >= maxTemp) {
-        return minRPM;  // Safe fallback
-    }
-
-    // Clamp current temperature to range
-    if (currentTemp <= minTemp) {
-        return minRPM;
-    } else if (currentTemp >= maxTemp) {
-        return maxRPM;
-    }
-
-    // Linear interpolation between min and max
-    double tempRatio = static_cast<double>(currentTemp - minTemp) / (maxTemp - minTemp);
-    int targetRPM = minRPM + static_cast<int>(tempRatio * (maxRPM - minRPM));
-
-    return targetRPM;
-}
-
 void FanControlWidget::setMode(FanMode mode)
 {
     currentMode = mode;
@@ -377,6 +480,19 @@ void FanControlWidget::setTargetRPM(int rpm)
     labelTargetRPM->setText(QString("%1 RPM").arg(rpm));
 }
 
+void FanControlWidget::setHysteresis(double celsius)
+{
+    spinHysteresis->setValue(celsius);
+    controller.setHysteresis(celsius, controller.getRPMDeadband());
+}
+
+void FanControlWidget::setFeedForward(double leadSeconds, int cpuLoadBoost)
+{
+    spinLead->setValue(leadSeconds);
+    spinCpuBoost->setValue(cpuLoadBoost);
+    controller.setFeedForward(leadSeconds, cpuLoadBoost);
+}
+
 void FanControlWidget::setSensorBasedSettings(int sensorIndex, int minTemp, int maxTemp)
 {
     selectedSensorIndex = sensorIndex;
@@ -8,13 +8,10 @@
 #include <QButtonGroup>
 #include <QComboBox>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QSet>
 #include "smcinterface.h"
-
-enum FanMode {
-    MODE_AUTO = 0,
-    MODE_MANUAL = 1,
-    MODE_SENSOR_BASED = 2
-};
+#include "fancontroller.h"
 
 class FanControlWidget : public QWidget {
     Q_OBJECT
@@ -25,20 +22,45 @@ public:
     void setCurrentRPM(int rpm);
     void updateFanInfo(const FanInfo& info);
     void setSensorList(const QVector<TempSensor>& sensors);
-    void updateSensorBasedSpeed(int currentTemp);
+    // Re-label these sensors' entries in place, keeping the selection
+    void refreshSensorDescriptions(const QSet<QString>& labels);
+    bool updateSensorBasedSpeed(int currentTemp, qint64 timestampMs, double cpuLoad = -1.0);
     void setMacModel(const QString& model) { macModel = model; }
+    QString getLabel() const { return fanLabel; }
+    int getMinRPM() const { return minRPM; }
+    int getMaxRPM() const { return maxRPM; }
+
+    // Zone membership (empty zoneName = none). A fan led by another one
+    // (leadLabel set) only shows its speed and target; its mode and target
+    // are set from the lead's and it emits no requests of its own.
+    void setZone(const QString& zoneName, const QString& leadLabel);
+    bool isFollowing() const { return following; }
+
+    // Fan driven by a controller outside the widget, e.g. the acoustic
+    // optimizer (empty = none). Shown like a follower, with owner's name.
+    void setControlledBy(const QString& owner);
+    QString getControlledBy() const { return controlledBy; }
 
     // Settings getters
     FanMode getCurrentMode() const { return currentMode; }
     int getTargetRPM() const { return sliderRPM->value(); }
     int getSelectedSensorIndex() const { return selectedSensorIndex; }
+    QString getSelectedSensorLabel() const;     // Empty when none is selected
     int getMinTemp() const { return spinMinTemp->value(); }
     int getMaxTemp() const { return spinMaxTemp->value(); }
+    double getHysteresis() const { return spinHysteresis->value(); }
+    double getFeedForwardLead() const { return spinLead->value(); }
+    int getCpuLoadBoost() const { return spinCpuBoost->value(); }
+    const FanController& getController() const { return controller; }
+    // Forget the current target, so the next sensor update writes one
+    void resetController() { controller.reset(); }
 
     // Settings setters
     void setMode(FanMode mode);
     void setTargetRPM(int rpm);
     void setSensorBasedSettings(int sensorIndex, int minTemp, int maxTemp);
+    void setHysteresis(double celsius);
+    void setFeedForward(double leadSeconds, int cpuLoadBoost);
 
 signals:
     void manualModeRequested(int fanIndex, bool enable);
@@ -52,14 +74,20 @@ private slots:
 
 private:
     int fanIndex;
+    QString fanLabel;
+    bool following;
+    QString zoneText;       // Zone membership line, when not controlled externally
+    QString controlledBy;
     int minRPM;
     int maxRPM;
     FanMode currentMode;
     int selectedSensorIndex;
     QString macModel;
+    FanController controller;
 
     // UI elements
     QLabel *labelName;
+    QLabel *labelZone;
     QLabel *labelCurrentRPM;
     QLabel *labelTargetRPM;
     QLabel *labelRange;
@@ -75,13 +103,17 @@ private:
     QComboBox *comboSensor;
     QSpinBox *spinMinTemp;
     QSpinBox *spinMaxTemp;
+    QDoubleSpinBox *spinHysteresis;
+    QDoubleSpinBox *spinLead;
+    QSpinBox *spinCpuBoost;
     QLabel *labelCurrentTemp;
 
     void setupUI(const FanInfo& fanInfo);
     void updateModeIndicator(FanMode mode);
     void updateControlsVisibility();
-    int calculateFanSpeed(int currentTemp, int minTemp, int maxTemp);
+    void updateZoneLabel();
     QString getSensorDescription(const QString& label);
+    QString sensorItemText(const QString& label, int temperature);
 };
 
 #endif // FANCONTROLWIDGET_H
@@ -0,0 +1,374 @@
+#include "fansampler.h"
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+int readInt(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    bool ok = false;
+    int value = file.readLine().trimmed().toInt(&ok);
+    return ok ? value : -1;
+}
+
+bool writeInt(const QString& path, int value)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(QByteArray::number(value)) > 0;
+}
+
+// Realtime mode: the same through a descriptor opened once, without
+// allocating. sysfs re-reads an attribute on every read from offset 0.
+int readInt(int fd)
+{
+    char buffer[32];
+    ssize_t length = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (length <= 0) {
+        return -1;
+    }
+    buffer[length] = '\0';
+    char *end = nullptr;
+    errno = 0;
+    long value = strtol(buffer, &end, 10);
+    return end != buffer && errno == 0 ? static_cast<int>(value) : -1;
+}
+
+bool writeInt(int fd, int value)
+{
+    char buffer[16];
+    int length = snprintf(buffer, sizeof(buffer), "%d", value);
+    return pwrite(fd, buffer, length, 0) == length;
+}
+
+} // namespace
+
+FanSampler::FanSampler(QObject *parent)
+    : QObject(parent),
+      thread(new QThread(this)),
+      timer(new QTimer),
+      intervalMs(DEFAULT_INTERVAL_MS),
+      stopRequested(false),
+      lastTickNs(0),
+      appliedGeneration(0),
+      requestHead(0),
+      requestTail(0),
+      clearGeneration(0),
+      ticking(false),
+      backSnapshot(0),
+      middleSnapshot(1),
+      frontSnapshot(2)
+{
+    clock.start();
+    thread->setObjectName("FanSampler");
+
+    // The timer and its slot run on the sampler thread
+    timer->setTimerType(Qt::PreciseTimer);
+    timer->moveToThread(thread);
+    connect(timer, &QTimer::timeout, timer, [this]() {
+        qint64 now = monotonicNs();
+        qint64 jitter = lastTickNs > 0 ? qAbs(now - lastTickNs - intervalMs * 1000000LL) : -1;
+        lastTickNs = now;
+        tick(jitter);
+    });
+    connect(thread, &QThread::started, timer, [this]() {
+        if (realtime.enabled) {
+            runRealtime();      // Returns once stop() is called
+        } else {
+            timer->start(intervalMs);
+        }
+    });
+}
+
+FanSampler::~FanSampler()
+{
+    stop();
+    delete timer;
+}
+
+bool FanSampler::pause()
+{
+    bool running = thread->isRunning();
+    stop();
+    return running;
+}
+
+void FanSampler::resume(bool running)
+{
+    if (!running) {
+        return;
+    }
+    stopRequested = false;
+    lastTickNs = 0;
+    thread->start();
+}
+
+int FanSampler::addFan(const QString& devicePath, int fanNumber)
+{
+    // The fan list and the snapshots grow while no tick uses them
+    bool running = pause();
+
+    TrackedFan fan;
+    fan.inputPath = devicePath + "/fan" + QString::number(fanNumber) + "_input";
+    fan.pwmPath = devicePath + "/pwm" + QString::number(fanNumber);
+    fan.writeFailed = false;
+    fan.inputFd = -1;
+    fan.pwmFd = -1;
+    fans.append(fan);
+    {
+        QMutexLocker locker(&mutex);
+        for (Snapshot& snapshot : snapshots) {
+            snapshot.status.resize(fans.size());
+        }
+    }
+
+    resume(running);
+    return fans.size() - 1;
+}
+
+void FanSampler::setFanResponse(int id, const FanCalibrationTable& calibration, int minRPM, int maxRPM)
+{
+    if (id < 0 || id >= fans.size()) {
+        return;
+    }
+    // Copying the table allocates; the tick must not wait for that
+    bool running = pause();
+    fans[id].tracker.setResponse(calibration, minRPM, maxRPM);
+    resume(running);
+}
+
+void FanSampler::pushRequest(const Request& request)
+{
+    quint32 tail = requestTail.load(std::memory_order_relaxed);
+    if (tail - requestHead.load(std::memory_order_acquire) >= static_cast<quint32>(REQUEST_CAPACITY)) {
+        // Only if the tick is wedged; the next write of the fan asks again
+        qWarning() << "Fan sampler request queue full, target for fan" << request.id << "dropped";
+        return;
+    }
+    requests[tail % REQUEST_CAPACITY] = request;
+    requestTail.store(tail + 1, std::memory_order_release);
+}
+
+void FanSampler::setTarget(int id, int rpm, int openLoopPWM)
+{
+    pushRequest({id, rpm, openLoopPWM, clock.elapsed(), clearGeneration.load()});
+}
+
+void FanSampler::clearTarget(int id)
+{
+    pushRequest({id, -1, 0, clock.elapsed(), clearGeneration.load()});
+}
+
+void FanSampler::clearAllTargets()
+{
+    // A tick that started before the bump may still write one trim; wait
+    // for it, every later one clears the trackers before writing anything
+    clearGeneration.fetch_add(1);
+    while (ticking.load()) {
+        QThread::usleep(100);
+    }
+}
+
+QVector<RpmTrackingStatus> FanSampler::getStatus() const
+{
+    QMutexLocker locker(&mutex);
+    // Element copies, so the buffer is never shared with the caller and the
+    // tick's writes to it do not detach
+    const QVector<RpmTrackingStatus>& latest = takeSnapshot().status;
+    QVector<RpmTrackingStatus> status;
+    status.reserve(latest.size());
+    for (const RpmTrackingStatus& fan : latest) {
+        status.append(fan);
+    }
+    return status;
+}
+
+const FanSampler::Snapshot& FanSampler::takeSnapshot() const
+{
+    if (middleSnapshot.load() & SNAPSHOT_FRESH) {
+        frontSnapshot = middleSnapshot.exchange(frontSnapshot) & ~SNAPSHOT_FRESH;
+    }
+    return snapshots[frontSnapshot];
+}
+
+void FanSampler::publish()
+{
+    Snapshot& snapshot = snapshots[backSnapshot];
+    for (int i = 0; i < fans.size(); i++) {
+        snapshot.status[i] = fans[i].tracker.getStatus();
+    }
+    snapshot.tickJitter = tickJitter;   // Same size every time, no allocation
+    backSnapshot = middleSnapshot.exchange(backSnapshot | SNAPSHOT_FRESH) & ~SNAPSHOT_FRESH;
+}
+
+void FanSampler::start(int interval)
+{
+    if (thread->isRunning()) {
+        return;
+    }
+    intervalMs = interval;
+    tickJitter.reset();
+    resume(true);
+    qDebug() << "Fan sampler started," << intervalMs << "ms interval" << (realtime.enabled ? "(realtime)" : "");
+}
+
+void FanSampler::stop()
+{
+    if (!thread->isRunning()) {
+        return;
+    }
+    stopRequested = true;
+    periodic.interrupt();
+    // Timers must be stopped from the thread they run on
+    QMetaObject::invokeMethod(timer, [this]() { timer->stop(); }, Qt::BlockingQueuedConnection);
+    thread->quit();
+    thread->wait();
+}
+
+void FanSampler::setRealtime(const RealtimeOptions& options)
+{
+    bool running = pause();
+    realtime = options;
+    resume(running);
+}
+
+QString FanSampler::getRealtimeState() const
+{
+    QMutexLocker locker(&mutex);
+    return realtimeState;
+}
+
+LatencyHistogram FanSampler::getTickJitter() const
+{
+    QMutexLocker locker(&mutex);
+    return takeSnapshot().tickJitter;
+}
+
+void FanSampler::runRealtime()
+{
+    QString state;
+    applyRealtime(realtime, &state);
+    qDebug() << "Fan sampler scheduling:" << state;
+
+    {
+        QMutexLocker locker(&mutex);
+        realtimeState = state;
+    }
+    for (TrackedFan& fan : fans) {
+        openFiles(&fan);
+    }
+
+    if (periodic.start(intervalMs * 1000000LL)) {
+        while (!stopRequested) {
+            qint64 lateNs = 0;
+            if (periodic.wait(&lateNs) == 0) {
+                continue;       // Interrupted by stop()
+            }
+            tick(lateNs);
+        }
+        periodic.stop();
+    } else {
+        qWarning() << "Fan sampler cannot arm its timer, realtime loop not started";
+    }
+
+    closeFiles();
+    QMutexLocker locker(&mutex);
+    realtimeState.clear();
+}
+
+void FanSampler::openFiles(TrackedFan *fan)
+{
+    fan->inputFd = open(fan->inputPath.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+    fan->pwmFd = open(fan->pwmPath.toLocal8Bit().constData(), O_WRONLY | O_CLOEXEC);
+}
+
+void FanSampler::closeFiles()
+{
+    for (TrackedFan& fan : fans) {
+        if (fan.inputFd >= 0) {
+            close(fan.inputFd);
+        }
+        if (fan.pwmFd >= 0) {
+            close(fan.pwmFd);
+        }
+        fan.inputFd = -1;
+        fan.pwmFd = -1;
+    }
+}
+
+void FanSampler::applyRequests()
+{
+    quint32 generation = clearGeneration.load();
+    if (generation != appliedGeneration) {
+        for (TrackedFan& fan : fans) {
+            fan.tracker.clearTarget();
+        }
+        appliedGeneration = generation;
+    }
+
+    quint32 head = requestHead.load(std::memory_order_relaxed);
+    quint32 tail = requestTail.load(std::memory_order_acquire);
+    for (; head != tail; head++) {
+        const Request& request = requests[head % REQUEST_CAPACITY];
+        // Issued before a clearAllTargets(), e.g. a write the guard overrode
+        if (request.generation != generation || request.id < 0 || request.id >= fans.size()) {
+            continue;
+        }
+        if (request.rpm < 0) {
+            fans[request.id].tracker.clearTarget();
+        } else {
+            fans[request.id].tracker.setTarget(request.rpm, request.openLoopPWM, request.issuedMs);
+        }
+    }
+    requestHead.store(head, std::memory_order_release);
+}
+
+void FanSampler::tick(qint64 jitterNs)
+{
+    // No locks from here on: nothing the GUI thread does can delay a tick
+    ticking.store(true);
+    applyRequests();
+    qint64 now = clock.elapsed();   // Not before any request applied above
+    if (jitterNs >= 0) {
+        tickJitter.record(jitterNs);
+    }
+
+    for (TrackedFan& fan : fans) {
+        if (!fan.tracker.isActive()) {
+            continue;
+        }
+
+        int rpm = fan.inputFd >= 0 ? readInt(fan.inputFd) : readInt(fan.inputPath);
+        int pwm = fan.tracker.update(rpm, now);
+        if (pwm < 0) {
+            continue;
+        }
+
+        bool written = fan.pwmFd >= 0 ? writeInt(fan.pwmFd, pwm) : writeInt(fan.pwmPath, pwm);
+        if (!written) {
+            if (!fan.writeFailed) {
+                qWarning() << "Fan sampler cannot write" << fan.pwmPath;
+                fan.writeFailed = true;
+            }
+        } else {
+            fan.writeFailed = false;
+        }
+    }
+    ticking.store(false);
+
+    publish();
+}
@@ -0,0 +1,141 @@
+#ifndef FANSAMPLER_H
+#define FANSAMPLER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "latencystats.h"
+#include "realtime.h"
+#include "rpmtracker.h"
+
+class QThread;
+class QTimer;
+
+// Fast-rate fan I/O on a dedicated thread, independent of the 1 s GUI tick.
+// Every interval it reads fan*_input for each fan with an RPM target and lets
+// that fan's RpmTracker trim pwm* until the measured speed matches.
+//
+// In realtime mode (setRealtime()) the thread runs a timerfd loop on
+// absolute deadlines instead of a QTimer, with the requested scheduling
+// policy and locked memory, and reads and writes through file descriptors
+// opened once instead of a QFile per access.
+//
+// The tick never waits for another thread: targets reach it through a
+// fixed ring of requests written by the GUI thread, and it hands tracking
+// status and jitter out through a triple buffer. Registering a fan or
+// changing its response restarts a running sampler, so the fan list itself
+// is only touched by whichever side owns it. Public methods are meant for
+// the GUI thread, except clearAllTargets(), which may be called from any.
+class FanSampler : public QObject {
+    Q_OBJECT
+
+public:
+    static const int DEFAULT_INTERVAL_MS = 250;
+
+    // Capacity of the request ring; far more than a few ticks' worth of writes
+    static const int REQUEST_CAPACITY = 256;
+
+    explicit FanSampler(QObject *parent = nullptr);
+    ~FanSampler();
+
+    // Register a PWM fan; returns its id for the calls below. Both restart
+    // a running sampler.
+    int addFan(const QString& devicePath, int fanNumber);
+    void setFanResponse(int id, const FanCalibrationTable& calibration, int minRPM, int maxRPM);
+
+    // Track rpm; openLoopPWM is the value the caller already wrote for it.
+    // Applied by the next tick.
+    void setTarget(int id, int rpm, int openLoopPWM);
+    void clearTarget(int id);
+    // Any thread; once it returns no tick trims a fan until its next setTarget()
+    void clearAllTargets();
+
+    QVector<RpmTrackingStatus> getStatus() const;
+
+    void start(int intervalMs = DEFAULT_INTERVAL_MS);
+    void stop();
+    int getIntervalMs() const { return intervalMs; }
+
+    // Takes effect immediately, restarting the sampler if it is running
+    void setRealtime(const RealtimeOptions& options);
+    RealtimeOptions getRealtime() const { return realtime; }
+    QString getRealtimeState() const;     // Policy in effect, empty when not running realtime
+
+    // |wakeup - due time| of every tick since start()
+    LatencyHistogram getTickJitter() const;
+
+private:
+    struct TrackedFan {
+        QString inputPath;      // fanN_input
+        QString pwmPath;        // pwmN
+        RpmTracker tracker;
+        bool writeFailed;       // Already warned about a failing write
+        int inputFd;            // Open in realtime mode, -1 otherwise
+        int pwmFd;
+    };
+
+    // setTarget()/clearTarget() on its way to the tick
+    struct Request {
+        int id;
+        int rpm;                // -1 = clear the target
+        int openLoopPWM;
+        qint64 issuedMs;
+        quint32 generation;     // clearGeneration when issued; older ones are dropped
+    };
+
+    // What readers see of the tick
+    struct Snapshot {
+        QVector<RpmTrackingStatus> status;
+        LatencyHistogram tickJitter;
+    };
+
+    QThread *thread;
+    QTimer *timer;              // Lives on the sampler thread
+    int intervalMs;
+    QElapsedTimer clock;
+
+    RealtimeOptions realtime;
+    PeriodicTimer periodic;             // Realtime mode tick source
+    std::atomic<bool> stopRequested;
+
+    // Owned by the sampler thread while it runs, by the caller otherwise
+    QVector<TrackedFan> fans;
+    LatencyHistogram tickJitter;
+    qint64 lastTickNs;          // QTimer mode: previous wakeup
+    quint32 appliedGeneration;  // clearGeneration the trackers were last cleared for
+
+    // Single producer (GUI thread), single consumer (tick)
+    Request requests[REQUEST_CAPACITY];
+    std::atomic<quint32> requestHead;   // Next to apply, advanced by the tick
+    std::atomic<quint32> requestTail;   // Next free slot, advanced by the producer
+
+    std::atomic<quint32> clearGeneration;   // Bumped by clearAllTargets()
+    std::atomic<bool> ticking;              // A tick is between its generation check and its last write
+
+    // Triple buffer: the tick fills snapshots[back] and swaps it with the
+    // middle one; a reader takes the middle one if it is newer than front
+    static const int SNAPSHOT_FRESH = 4;    // Flag in middleSnapshot: not yet taken by a reader
+    Snapshot snapshots[3];
+    int backSnapshot;                       // Sampler thread's
+    mutable std::atomic<int> middleSnapshot;    // Index | SNAPSHOT_FRESH
+    mutable int frontSnapshot;              // Readers', under mutex
+
+    mutable QMutex mutex;       // Readers of the snapshot and realtimeState; never taken by the tick
+    QString realtimeState;
+
+    bool pause();               // Stops a running sampler; returns whether it ran
+    void resume(bool running);
+    void pushRequest(const Request& request);
+    void applyRequests();
+    void publish();
+    const Snapshot& takeSnapshot() const;   // Call with mutex held
+    void runRealtime();
+    void openFiles(TrackedFan *fan);
+    void closeFiles();
+    void tick(qint64 jitterNs);     // jitterNs < 0 = not known (first tick)
+};
+
+#endif // FANSAMPLER_H
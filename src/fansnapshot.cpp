@@ -0,0 +1,135 @@
+#include "fansnapshot.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+FanSnapshot FanSnapshot::capture(SMCInterface *smc, HWMonInterface *hwmon)
+{
+    FanSnapshot snapshot;
+    snapshot.macModel = smc->getMacModel();
+    snapshot.timestampMs = QDateTime::currentMSecsSinceEpoch();
+
+    QVector<FanInfo> smcFans = smc->getFans();
+    bool smcWritable = !smcFans.isEmpty() && smc->hasWritePermission();
+    for (int i = 0; i < smcFans.size(); i++) {
+        const FanInfo& fan = smcFans[i];
+        SnapshotFan entry;
+        entry.number = snapshot.fans.size() + 1;
+        entry.source = "smc";
+        entry.sourceIndex = i;
+        entry.label = fan.label;
+        entry.driver = "applesmc";
+        entry.currentRPM = smc->getFanCurrentRPM(i);
+        entry.targetRPM = fan.targetRPM;
+        entry.minRPM = fan.minRPM;
+        entry.maxRPM = fan.maxRPM;
+        entry.pwm = -1;
+        entry.manual = fan.isManual;
+        entry.controllable = smcWritable;
+        snapshot.fans.append(entry);
+    }
+
+    QVector<HWMonFan> hwmonFans = hwmon->getFans();
+    for (int i = 0; i < hwmonFans.size(); i++) {
+        const HWMonFan& fan = hwmonFans[i];
+        SnapshotFan entry;
+        entry.number = snapshot.fans.size() + 1;
+        entry.source = "hwmon";
+        entry.sourceIndex = i;
+        entry.label = fan.label;
+        entry.driver = fan.deviceName;
+        entry.currentRPM = hwmon->getFanCurrentRPM(i);
+        entry.targetRPM = -1;
+        entry.minRPM = fan.minRPM;
+        entry.maxRPM = fan.maxRPM;
+        entry.pwm = fan.supportsManualControl ? hwmon->getFanCurrentPWM(i) : -1;
+        entry.manual = fan.isManual;
+        entry.controllable = fan.supportsManualControl && hwmon->hasWritePermission();
+        snapshot.fans.append(entry);
+    }
+
+    for (const TempSensor& sensor : smc->getTemperatures()) {
+        snapshot.sensors.append({sensor.index, sensor.label, sensor.deviceName, sensor.temperature, false});
+    }
+    for (const HWMonSensor& sensor : hwmon->getTemperatures()) {
+        snapshot.sensors.append({sensor.index, sensor.label, sensor.deviceName, sensor.temperature, sensor.stale});
+    }
+
+    return snapshot;
+}
+
+QByteArray FanSnapshot::toJson() const
+{
+    QJsonArray fanArray;
+    for (const SnapshotFan& fan : fans) {
+        QJsonObject object;
+        object["number"] = fan.number;
+        object["source"] = fan.source;
+        object["index"] = fan.sourceIndex;
+        object["label"] = fan.label;
+        object["driver"] = fan.driver;
+        object["rpm"] = fan.currentRPM;
+        object["min_rpm"] = fan.minRPM;
+        object["max_rpm"] = fan.maxRPM;
+        object["manual"] = fan.manual;
+        object["controllable"] = fan.controllable;
+        if (fan.targetRPM >= 0) {
+            object["target_rpm"] = fan.targetRPM;
+        }
+        if (fan.pwm >= 0) {
+            object["pwm"] = fan.pwm;
+        }
+        fanArray.append(object);
+    }
+
+    QJsonArray sensorArray;
+    for (const SnapshotSensor& sensor : sensors) {
+        QJsonObject object;
+        object["index"] = sensor.index;
+        object["label"] = sensor.label;
+        object["driver"] = sensor.driver;
+        object["celsius"] = sensor.temperature / 1000.0;
+        if (sensor.stale) {
+            object["stale"] = true;
+        }
+        sensorArray.append(object);
+    }
+
+    QJsonObject root;
+    root["timestamp_ms"] = static_cast<double>(timestampMs);
+    if (!macModel.isEmpty()) {
+        root["mac_model"] = macModel;
+    }
+    root["fans"] = fanArray;
+    root["sensors"] = sensorArray;
+    return QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n';
+}
+
+QByteArray FanSnapshot::toTsv() const
+{
+    QByteArray out;
+    out.reserve(64 * (fans.size() + sensors.size()));
+
+    // Labels come from sysfs; keep them from breaking the columns
+    auto field = [](const QString& text) {
+        QByteArray bytes = text.toUtf8();
+        bytes.replace('\t', ' ');
+        bytes.replace('\n', ' ');
+        return bytes.isEmpty() ? QByteArray("-") : bytes;
+    };
+
+    for (const SnapshotFan& fan : fans) {
+        out += "fan\t" + QByteArray::number(fan.number) + '\t' + fan.source.toUtf8() + '\t' +
+               field(fan.label) + '\t' + field(fan.driver) + '\t' + QByteArray::number(fan.currentRPM) + '\t' +
+               QByteArray::number(fan.targetRPM) + '\t' + QByteArray::number(fan.minRPM) + '\t' +
+               QByteArray::number(fan.maxRPM) + '\t' + QByteArray::number(fan.pwm) + '\t' +
+               (fan.manual ? "manual" : "auto") + '\n';
+    }
+    for (const SnapshotSensor& sensor : sensors) {
+        out += "sensor\t" + QByteArray::number(sensor.index) + '\t' + field(sensor.label) + '\t' +
+               field(sensor.driver) + '\t' + QByteArray::number(sensor.temperature / 1000.0, 'f', 1) + '\t' +
+               (sensor.stale ? "stale" : "ok") + '\n';
+    }
+    return out;
+}
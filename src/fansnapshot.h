@@ -0,0 +1,53 @@
+#ifndef FANSNAPSHOT_H
+#define FANSNAPSHOT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+
+// One fan as numbered in the GUI: SMC fans first, then hwmon fans
+struct SnapshotFan {
+    int number;             // 1-based position in the fan list
+    QString source;         // "smc" or "hwmon"
+    int sourceIndex;        // Index within its backend's fan list
+    QString label;
+    QString driver;         // "applesmc" or the hwmon driver name
+    int currentRPM;
+    int targetRPM;          // SMC manual target, -1 for hwmon
+    int minRPM;
+    int maxRPM;
+    int pwm;                // hwmon PWM 0-255, -1 for SMC
+    bool manual;
+    bool controllable;      // Backend can set mode and speed
+};
+
+struct SnapshotSensor {
+    int index;              // TempSensor index
+    QString label;
+    QString driver;
+    int temperature;        // Millidegrees Celsius
+    bool stale;             // hwmon device missed its read deadline
+};
+
+// Point-in-time view of every fan and temperature, shared by the
+// command-line client and the benchmarks
+struct FanSnapshot {
+    QString macModel;
+    qint64 timestampMs;     // Wall clock, ms since the epoch
+    QVector<SnapshotFan> fans;
+    QVector<SnapshotSensor> sensors;
+
+    // Reads current fan speeds and temperatures from initialized backends
+    static FanSnapshot capture(SMCInterface *smc, HWMonInterface *hwmon);
+
+    QByteArray toJson() const;
+
+    // One record per line, tab separated, first column "fan" or "sensor":
+    //   fan     number source label driver rpm target min max pwm auto|manual
+    //   sensor  index label driver celsius ok|stale
+    QByteArray toTsv() const;
+};
+
+#endif // FANSNAPSHOT_H
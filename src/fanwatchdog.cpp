@@ -0,0 +1,258 @@
+#include "fanwatchdog.h"
+#include <QDebug>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Control bytes on the socket; anything else is a heartbeat
+static const char MESSAGE_HEARTBEAT = 'h';
+static const char MESSAGE_QUIT = 'q';
+static const char MESSAGE_TRIPPED = 't';    // Watchdog to control process
+
+// Descriptor the watchdog's end of the socket is moved to in the child
+static const int WATCHDOG_FD = 3;
+
+// Upper bound for closing inherited descriptors without close_range()
+static const int MAX_CLOSE_FD = 65536;
+
+static void writeMessage(const char *message)
+{
+    ssize_t ignored = write(STDERR_FILENO, message, strlen(message));
+    (void)ignored;
+}
+
+FanWatchdog::FanWatchdog()
+    : action(ACTION_AUTO),
+      timeoutMs(DEFAULT_TIMEOUT_MS),
+      pid(-1),
+      socketFd(-1),
+      peerLost(false),
+      tripReported(false)
+{
+}
+
+FanWatchdog::~FanWatchdog()
+{
+    stop();
+}
+
+void FanWatchdog::addSMCFan(const QString& fanPath, int maxRPM)
+{
+    QByteArray base = fanPath.toLocal8Bit();
+    Fan fan;
+    fan.primary[ACTION_AUTO] = {{base + "_manual", "0"}};
+    fan.primary[ACTION_MAX] = {{base + "_manual", "1"}, {base + "_output", QByteArray::number(maxRPM)}};
+    fans.append(fan);
+}
+
+void FanWatchdog::addHWMonFan(const QString& devicePath, int fanNumber)
+{
+    QByteArray pwm = (devicePath + "/pwm" + QString::number(fanNumber)).toLocal8Bit();
+    Fan fan;
+    fan.primary[ACTION_AUTO] = {{pwm + "_enable", "2"}};
+    fan.primary[ACTION_MAX] = {{pwm + "_enable", "1"}, {pwm, "255"}};
+    // Drivers without an automatic mode, or that refuse the mode change:
+    // full duty is the only safe state left
+    fan.fallback[ACTION_AUTO] = {{pwm, "255"}};
+    fan.fallback[ACTION_MAX] = {{pwm, "255"}};
+    fans.append(fan);
+}
+
+void FanWatchdog::clearFans()
+{
+    fans.clear();
+}
+
+bool FanWatchdog::parseAction(const QString& text, Action *action)
+{
+    if (text == "auto") {
+        *action = ACTION_AUTO;
+    } else if (text == "max") {
+        *action = ACTION_MAX;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool FanWatchdog::writeAll(const QVector<Write>& writes)
+{
+    bool ok = true;
+    for (const Write& entry : writes) {
+        int fd = open(entry.path.constData(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            ok = false;
+            continue;
+        }
+        ok = write(fd, entry.value.constData(), entry.value.size()) == entry.value.size() && ok;
+        close(fd);
+    }
+    return ok;
+}
+
+int FanWatchdog::applySafeState() const
+{
+    int failed = 0;
+    for (const Fan& fan : fans) {
+        if (!writeAll(fan.primary[action]) && (fan.fallback[action].isEmpty() || !writeAll(fan.fallback[action]))) {
+            failed++;
+        }
+    }
+    return failed;
+}
+
+bool FanWatchdog::start(int timeout, QString *errorMessage)
+{
+    stop();
+    timeoutMs = timeout;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot create watchdog socket: %1").arg(strerror(errno));
+        }
+        return false;
+    }
+
+    // Prepared before fork(): the child must not allocate
+    struct rlimit limit;
+    int maxFd = getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+                    ? static_cast<int>(qMin<rlim_t>(limit.rlim_cur, MAX_CLOSE_FD))
+                    : MAX_CLOSE_FD;
+
+    pid_t child = fork();
+    if (child < 0) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot start watchdog: %1").arg(strerror(errno));
+        }
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (child == 0) {
+        // Survive the terminal's Ctrl-C and a plain kill of the process
+        // group, so the app dying that way still trips the watchdog
+        struct sigaction ignore;
+        memset(&ignore, 0, sizeof(ignore));
+        ignore.sa_handler = SIG_IGN;
+        sigaction(SIGINT, &ignore, nullptr);
+        sigaction(SIGTERM, &ignore, nullptr);
+        sigaction(SIGHUP, &ignore, nullptr);
+        sigaction(SIGPIPE, &ignore, nullptr);
+
+        // Keep only stdio and our end of the socket; in particular the
+        // parent's end must close here, or its death would go unnoticed
+        if (dup2(fds[1], WATCHDOG_FD) < 0) {
+            _exit(1);
+        }
+        bool closed = false;
+#ifdef SYS_close_range
+        closed = syscall(SYS_close_range, WATCHDOG_FD + 1, ~0U, 0) == 0;
+#endif
+        for (int fd = WATCHDOG_FD + 1; !closed && fd < maxFd; fd++) {
+            close(fd);
+        }
+        run(WATCHDOG_FD);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    socketFd = fds[0];
+    fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL) | O_NONBLOCK);
+    pid = child;
+    peerLost = false;
+    tripReported = false;
+    qDebug() << "Fan watchdog started, pid" << pid << "timeout" << timeoutMs << "ms," << fans.size() << "fans";
+    return true;
+}
+
+void FanWatchdog::run(int fd) const
+{
+    bool tripped = false;
+    for (;;) {
+        struct pollfd waitFd;
+        waitFd.fd = fd;
+        waitFd.events = POLLIN;
+        waitFd.revents = 0;
+        int ready = poll(&waitFd, 1, timeoutMs);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready == 0) {
+            if (!tripped) {
+                applySafeState();
+                writeMessage("fan watchdog: control loop stalled, fans set to safe state\n");
+                // Waits in the socket until the loop resumes and reads it
+                send(fd, &MESSAGE_TRIPPED, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+                tripped = true;
+            }
+            continue;
+        }
+
+        char buffer[64];
+        ssize_t length = ready < 0 ? -1 : recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (length < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if (length <= 0) {
+            // Closed without a quit message: the control process is gone
+            applySafeState();
+            writeMessage("fan watchdog: control process exited, fans set to safe state\n");
+            return;
+        }
+        if (memchr(buffer, MESSAGE_QUIT, length)) {
+            return;
+        }
+        if (tripped) {
+            writeMessage("fan watchdog: control loop resumed\n");
+            tripped = false;
+        }
+    }
+}
+
+void FanWatchdog::heartbeat()
+{
+    if (socketFd < 0) {
+        return;
+    }
+    // Non-blocking and no SIGPIPE: a full or dead socket must not stall the loop
+    if (send(socketFd, &MESSAGE_HEARTBEAT, 1, MSG_NOSIGNAL) < 0 && errno != EAGAIN && !peerLost) {
+        qWarning() << "Fan watchdog is gone:" << strerror(errno);
+        peerLost = true;
+    }
+
+    char buffer[64];
+    ssize_t length;
+    while ((length = recv(socketFd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        if (memchr(buffer, MESSAGE_TRIPPED, length)) {
+            tripReported = true;
+        }
+    }
+}
+
+bool FanWatchdog::takeTrip()
+{
+    bool tripped = tripReported;
+    tripReported = false;
+    return tripped;
+}
+
+void FanWatchdog::stop()
+{
+    if (socketFd < 0) {
+        return;
+    }
+    send(socketFd, &MESSAGE_QUIT, 1, MSG_NOSIGNAL);
+    close(socketFd);
+    socketFd = -1;
+    waitpid(pid, nullptr, 0);
+    pid = -1;
+}
@@ -0,0 +1,90 @@
+#ifndef FANWATCHDOG_H
+#define FANWATCHDOG_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <sys/types.h>
+
+// Failsafe for fans left in manual mode by a control loop that stopped.
+// start() forks a small watchdog process connected by a socket pair; the
+// control loop calls heartbeat() every tick. When no heartbeat arrives
+// within the timeout (hung loop), or the socket closes without stop()
+// (crash, kill), the watchdog writes the safe state to every registered
+// fan: automatic control, or full speed. A stall that ends re-arms it;
+// the watchdog reports the trip back over the socket, so the control loop
+// can take the fans over again (takeTrip()).
+//
+// Everything the watchdog process does after fork() is plain system calls
+// on buffers prepared beforehand, so forking from a multithreaded process
+// is safe. Only SIGKILL of the watchdog itself defeats it.
+class FanWatchdog {
+public:
+    static const int DEFAULT_TIMEOUT_MS = 5000;
+
+    enum Action {
+        ACTION_AUTO = 0,    // Hand fans back to firmware/driver control
+        ACTION_MAX = 1      // Manual mode at maximum speed
+    };
+
+    FanWatchdog();
+    ~FanWatchdog();
+
+    // Fans are registered before start(); fanPath is the SMC fan's base
+    // path ("…/fanN"), devicePath the hwmon device directory
+    void addSMCFan(const QString& fanPath, int maxRPM);
+    void addHWMonFan(const QString& devicePath, int fanNumber);
+    void clearFans();
+    int getFanCount() const { return fans.size(); }
+
+    void setAction(Action action) { this->action = action; }
+    Action getAction() const { return action; }
+
+    bool start(int timeoutMs, QString *errorMessage = nullptr);
+    void heartbeat();
+    // True once after the watchdog reported a trip: the fans were put in the
+    // safe state while the loop stalled and must be driven again. Reports
+    // are read by heartbeat().
+    bool takeTrip();
+    // Ends the watchdog without touching the fans
+    void stop();
+
+    bool isRunning() const { return pid > 0; }
+    pid_t getPid() const { return pid; }
+    int getTimeoutMs() const { return timeoutMs; }
+
+    // The writes a trip performs, in the calling process; returns the number
+    // of fans that could not be put in the safe state
+    int applySafeState() const;
+
+    static bool parseAction(const QString& text, Action *action);
+
+private:
+    struct Write {
+        QByteArray path;
+        QByteArray value;
+    };
+
+    // Safe state of one fan: the writes of the configured action, and
+    // writes tried instead if any of those fails
+    struct Fan {
+        QVector<Write> primary[2];      // Indexed by Action
+        QVector<Write> fallback[2];
+    };
+
+    QVector<Fan> fans;
+    Action action;
+    int timeoutMs;
+    pid_t pid;
+    int socketFd;           // Parent end, -1 when not running
+    bool peerLost;          // Already warned that the watchdog is gone
+    bool tripReported;      // A trip message arrived and was not taken yet
+
+    static bool writeAll(const QVector<Write>& writes);
+    void run(int fd) const;
+
+    FanWatchdog(const FanWatchdog&) = delete;
+    FanWatchdog& operator=(const FanWatchdog&) = delete;
+};
+
+#endif // FANWATCHDOG_H
@@ -0,0 +1,118 @@
+#include "fanzone.h"
+#include <QtGlobal>
+
+bool FanZones::setZones(const QVector<FanZone>& newZones, int fanCount, QString *errorMessage)
+{
+    QVector<int> zoneIndex(fanCount, -1);
+    QVector<int> memberIndex(fanCount, -1);
+    for (int z = 0; z < newZones.size(); z++) {
+        const FanZone& zone = newZones[z];
+        QString error;
+        if (zone.name.trimmed().isEmpty()) {
+            error = "A zone has no name";
+        } else if (zone.members.size() < 2) {
+            error = QString("Zone %1 needs at least two fans").arg(zone.name);
+        }
+        for (int m = 0; m < zone.members.size() && error.isEmpty(); m++) {
+            int fan = zone.members[m].fan;
+            if (fan < 0 || fan >= fanCount) {
+                error = QString("Zone %1 refers to fan %2, which does not exist").arg(zone.name).arg(fan + 1);
+            } else if (zoneIndex[fan] >= 0) {
+                error = QString("Fan %1 is in zones %2 and %3").arg(fan + 1)
+                            .arg(newZones[zoneIndex[fan]].name, zone.name);
+            } else if (zone.members[m].scale < 0) {
+                error = QString("Zone %1 has a negative scale").arg(zone.name);
+            } else {
+                zoneIndex[fan] = z;
+                memberIndex[fan] = m;
+            }
+        }
+        if (!error.isEmpty()) {
+            if (errorMessage) {
+                *errorMessage = error;
+            }
+            return false;
+        }
+    }
+
+    zones = newZones;
+    fanZone = zoneIndex;
+    fanMember = memberIndex;
+    return true;
+}
+
+void FanZones::clear()
+{
+    zones.clear();
+    fanZone.fill(-1);
+    fanMember.fill(-1);
+}
+
+void FanZones::setFanRange(int fan, int minRPM, int maxRPM)
+{
+    if (fan < 0) {
+        return;
+    }
+    if (fan >= ranges.size()) {
+        ranges.resize(fan + 1);
+    }
+    Range range = {minRPM, maxRPM};
+    ranges[fan] = range;
+}
+
+int FanZones::zoneOf(int fan) const
+{
+    return fan >= 0 && fan < fanZone.size() ? fanZone[fan] : -1;
+}
+
+bool FanZones::isLead(int fan) const
+{
+    return zoneOf(fan) >= 0 && fanMember[fan] == 0;
+}
+
+bool FanZones::isFollower(int fan) const
+{
+    return zoneOf(fan) >= 0 && fanMember[fan] > 0;
+}
+
+int FanZones::getLead(int fan) const
+{
+    int zone = zoneOf(fan);
+    return zone >= 0 ? zones[zone].members.first().fan : fan;
+}
+
+QVector<int> FanZones::getFollowers(int fan) const
+{
+    QVector<int> followers;
+    if (isLead(fan)) {
+        const QVector<FanZoneMember>& members = zones[fanZone[fan]].members;
+        for (int m = 1; m < members.size(); m++) {
+            followers.append(members[m].fan);
+        }
+    }
+    return followers;
+}
+
+int FanZones::followerTarget(int fan, int leadRPM) const
+{
+    int zone = zoneOf(fan);
+    if (zone < 0 || fan >= ranges.size()) {
+        return leadRPM;
+    }
+    const FanZoneMember& member = zones[zone].members[fanMember[fan]];
+    int lead = zones[zone].members.first().fan;
+    if (lead >= ranges.size()) {
+        return leadRPM;
+    }
+
+    const Range& leadRange = ranges[lead];
+    const Range& range = ranges[fan];
+    double position = 1.0;
+    if (leadRange.maxRPM > leadRange.minRPM) {
+        position = static_cast<double>(leadRPM - leadRange.minRPM) / (leadRange.maxRPM - leadRange.minRPM);
+    }
+    position = qBound(0.0, position, 1.0) * member.scale / 100.0;
+
+    int rpm = range.minRPM + qRound(position * (range.maxRPM - range.minRPM)) + member.offset;
+    return qBound(range.minRPM, rpm, range.maxRPM);
+}
@@ -0,0 +1,61 @@
+#ifndef FANZONE_H
+#define FANZONE_H
+
+#include <QString>
+#include <QVector>
+
+// One fan of a zone and how it follows the lead
+struct FanZoneMember {
+    int fan;                // Fan number (fan widget order)
+    int scale;              // Percent of the lead's position in its RPM range
+    int offset;             // RPM added after scaling
+};
+
+// Fans that move together, such as the INTAKE, EXHAUST and PS fans of a
+// Mac Pro. The first member leads: its controls and its controller drive
+// the zone, and every other member's target is derived from the lead's.
+struct FanZone {
+    QString name;
+    QVector<FanZoneMember> members;
+};
+
+// The configured zones and, per fan, the zone it belongs to. A lead's new
+// target maps onto each follower by position within the fans' RPM ranges,
+// so fans of different sizes stay at the same relative speed, then the
+// follower's scale and offset apply.
+class FanZones {
+public:
+    static const int DEFAULT_SCALE = 100;
+
+    // Zones with fewer than two fans, unknown fans or fans already in
+    // another zone are rejected with an error message
+    bool setZones(const QVector<FanZone>& zones, int fanCount, QString *errorMessage = nullptr);
+    void clear();
+    const QVector<FanZone>& getZones() const { return zones; }
+    int count() const { return zones.size(); }
+
+    // RPM range of every fan, used for mapping targets
+    void setFanRange(int fan, int minRPM, int maxRPM);
+
+    int zoneOf(int fan) const;                  // -1 = in no zone
+    bool isLead(int fan) const;
+    bool isFollower(int fan) const;
+    int getLead(int fan) const;                 // The fan itself when it is in no zone
+    QVector<int> getFollowers(int fan) const;   // Empty unless fan leads a zone
+
+    // Follower's target for the lead's leadRPM, within the follower's range
+    int followerTarget(int fan, int leadRPM) const;
+
+private:
+    struct Range {
+        int minRPM;
+        int maxRPM;
+    };
+
+    QVector<FanZone> zones;
+    QVector<int> fanZone;           // Per fan: zone index, -1 = none
+    QVector<int> fanMember;         // Per fan: index within its zone's members
+    QVector<Range> ranges;          // Per fan
+};
+
+#endif // FANZONE_H
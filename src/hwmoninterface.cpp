@@ -1,7 +1,5 @@
 #include "hwmoninterface.h"
 #include <QDebug>
-#include <QDirIterator>
-#include <QRegularExpression>
 
 // Devices whose temps are always provided by the SMC on Apple hardware
 const QStringList HWMonInterface::smcDuplicateDevices = {
@@ -17,12 +15,15 @@ HWMonInterface::HWMonInterface(QObject *parent)
     : QObject(parent),
       canWrite(false),
       smcAvailable(false),
-      nextSensorIndex(1000)  // Start at 1000 to avoid conflicts with SMC indices
+      nextSensorIndex(FIRST_SENSOR_INDEX),
+      readers(nullptr),
+      profiler(nullptr)
 {
 }
 
 HWMonInterface::~HWMonInterface()
 {
+    delete readers;
 }
 
 bool HWMonInterface::initialize()
@@ -30,8 +31,15 @@ bool HWMonInterface::initialize()
     qDebug() << "Initializing HWMon interface...";
 
     // Scan for hwmon devices
-    scanHWMonDevices();
+    for (const QString& hwmonPath : listDevices()) {
+        addDevice(scanDevice(hwmonPath, smcAvailable));
+    }
+
+    return finishInitialization();
+}
 
+bool HWMonInterface::finishInitialization()
+{
     if (fans.isEmpty()) {
         qDebug() << "No hwmon fans found";
         return false;
@@ -39,9 +47,46 @@ bool HWMonInterface::initialize()
 
     qDebug() << "Found" << fans.size() << "hwmon fan(s)";
 
-    // Test write permission by checking if we can read PWM enable files
+    checkWritePermission();
+
+    return true;
+}
+
+bool HWMonInterface::initializeFromTopology(const QVector<HWMonFan>& cachedFans,
+                                            const QVector<HWMonSensor>& cachedSensors)
+{
+    fans = cachedFans;
+    sensors = cachedSensors;
+    for (const HWMonSensor& sensor : sensors) {
+        nextSensorIndex = qMax(nextSensorIndex, sensor.index + 1);
+    }
+
+    // Speeds, duty cycles and modes may have changed since the manifest was written
+    for (HWMonFan& fan : fans) {
+        QString basePath = fan.devicePath + "/fan" + QString::number(fan.fanNumber);
+        QString pwmPath = fan.devicePath + "/pwm" + QString::number(fan.fanNumber);
+        fan.currentRPM = readIntFromFile(basePath + "_input", 0);
+        fan.currentPWM = readIntFromFile(pwmPath, 0);
+        fan.isManual = (readIntFromFile(pwmPath + "_enable", 2) == 1);
+    }
+
+    if (fans.isEmpty()) {
+        qDebug() << "No hwmon fans in cached topology";
+        return false;
+    }
+
+    qDebug() << "Using cached topology with" << fans.size() << "hwmon fan(s)";
+
+    checkWritePermission();
+
+    return true;
+}
+
+void HWMonInterface::checkWritePermission()
+{
+    // Test write permission by checking if we can open the first PWM enable file
+    canWrite = false;
     if (!fans.isEmpty()) {
-        QString pwmEnablePath = getFanPWMEnablePath(0);
         QString testPath = fans[0].devicePath + "/pwm1_enable";
         QFile testFile(testPath);
         canWrite = testFile.open(QIODevice::WriteOnly);
@@ -49,85 +94,104 @@ bool HWMonInterface::initialize()
             testFile.close();
         }
     }
-
-    return true;
 }
 
-void HWMonInterface::scanHWMonDevices()
+QStringList HWMonInterface::listDevices() const
 {
-    QDir hwmonDir("/sys/class/hwmon");
-    if (!hwmonDir.exists()) {
+    QString hwmonRoot = sysfsRoot + "/sys/class/hwmon";
+    QStringList hwmonDevices;
+    if (!HWMonDirectory::listEntries(hwmonRoot, "hwmon", &hwmonDevices)) {
         qWarning() << "hwmon directory not found";
-        return;
+        return QStringList();
     }
 
-    QStringList hwmonDevices = hwmonDir.entryList(QStringList() << "hwmon*", QDir::Dirs);
-
+    QStringList paths;
     for (const QString& hwmonDev : hwmonDevices) {
-        QString hwmonPath = "/sys/class/hwmon/" + hwmonDev;
+        paths << hwmonRoot + "/" + hwmonDev;
+    }
+    return paths;
+}
 
-        // Read device name
-        QString deviceName = readSysFile(hwmonPath + "/name").trimmed();
-        if (deviceName.isEmpty()) {
-            continue;
-        }
+HWMonDeviceScan HWMonInterface::scanDevice(const QString& hwmonPath, bool smcAvailable)
+{
+    HWMonDeviceScan scan;
+    scan.path = hwmonPath;
 
-        qDebug() << "Scanning hwmon device:" << deviceName << "at" << hwmonPath;
+    // One directory fd per device; every attribute is classified in one pass
+    HWMonDirectory device(hwmonPath);
+    if (!device.isOpen()) {
+        return scan;
+    }
 
-        // Scan for fans in all devices
-        scanFansInDevice(hwmonPath, deviceName);
+    // Read device name
+    scan.name = QString::fromLocal8Bit(device.readAttribute("name"));
+    if (scan.name.isEmpty()) {
+        return scan;
+    }
 
-        // Skip temperature sensors from devices already covered by the SMC interface
-        if (smcAvailable && smcDuplicateDevices.contains(deviceName)) {
-            qDebug() << "Skipping SMC-duplicate hwmon sensors from:" << deviceName;
-            continue;
-        }
-        scanSensorsInDevice(hwmonPath, deviceName);
+    qDebug() << "Scanning hwmon device:" << scan.name << "at" << hwmonPath;
+
+    // Scan for fans in all devices
+    scanFansInDevice(device, &scan);
+
+    // Skip temperature sensors from devices already covered by the SMC interface
+    if (smcAvailable && smcDuplicateDevices.contains(scan.name)) {
+        qDebug() << "Skipping SMC-duplicate hwmon sensors from:" << scan.name;
+        return scan;
     }
+    scanSensorsInDevice(device, &scan);
+    return scan;
 }
 
-void HWMonInterface::scanFansInDevice(const QString& hwmonPath, const QString& deviceName)
+void HWMonInterface::addDevice(const HWMonDeviceScan& device)
 {
-    QDir dir(hwmonPath);
-    QStringList fanInputFiles = dir.entryList(QStringList() << "fan*_input", QDir::Files);
-
-    for (const QString& fanFile : fanInputFiles) {
-        // Extract fan number from filename (e.g., "fan1_input" -> 1)
-        QRegularExpression re("fan(\\d+)_input");
-        QRegularExpressionMatch match = re.match(fanFile);
-        if (!match.hasMatch()) {
-            continue;
+    fans += device.fans;
+    for (HWMonSensor sensor : device.sensors) {
+        if (nextSensorIndex > LAST_SENSOR_INDEX) {
+            qWarning() << "Too many hwmon sensors, ignoring the rest from" << device.name;
+            break;
         }
+        sensor.index = nextSensorIndex++;
+        sensors.append(sensor);
+    }
+}
 
-        int fanNum = match.captured(1).toInt();
-        QString basePath = hwmonPath + "/fan" + QString::number(fanNum);
+void HWMonInterface::scanFansInDevice(const HWMonDirectory& device, HWMonDeviceScan *scan)
+{
+    const QString& deviceName = scan->name;
+    const HWMonChannelTable& channels = device.getChannels();
 
-        // Read fan properties
-        int currentRPM = readIntFromFile(basePath + "_input", 0);
-        int minRPM = readIntFromFile(basePath + "_min", 0);
-        int maxRPM = readIntFromFile(basePath + "_max", 5000);
+    for (int fanNum : HWMonDirectory::sortedChannels(channels.fans, HWMON_ATTR_INPUT)) {
+        // Read fan properties; attributes missing from the table take their defaults unread
+        int currentRPM = device.readChannelInt("fan", fanNum, "_input", 0);
+        int minRPM = channels.has(channels.fans, fanNum, HWMON_ATTR_MIN)
+                         ? device.readChannelInt("fan", fanNum, "_min", 0) : 0;
+        int maxRPM = channels.has(channels.fans, fanNum, HWMON_ATTR_MAX)
+                         ? device.readChannelInt("fan", fanNum, "_max", 5000) : 5000;
 
         // Read fan label if available
-        QString label = readSysFile(basePath + "_label").trimmed();
+        QString label;
+        if (channels.has(channels.fans, fanNum, HWMON_ATTR_LABEL)) {
+            label = QString::fromLocal8Bit(device.readChannel("fan", fanNum, "_label"));
+        }
         if (label.isEmpty()) {
             label = deviceName + " Fan " + QString::number(fanNum);
         }
 
         // Check if PWM control is available
-        QString pwmPath = hwmonPath + "/pwm" + QString::number(fanNum);
-        bool supportsPWM = QFile::exists(pwmPath);
+        bool supportsPWM = channels.has(channels.pwms, fanNum, HWMON_ATTR_VALUE);
 
         // Read current PWM value
-        int currentPWM = readIntFromFile(pwmPath, 0);
+        int currentPWM = supportsPWM ? device.readChannelInt("pwm", fanNum, "", 0) : 0;
 
         // Check if in manual mode
-        QString pwmEnablePath = pwmPath + "_enable";
-        int pwmEnable = readIntFromFile(pwmEnablePath, 2);
+        int pwmEnable = channels.has(channels.pwms, fanNum, HWMON_ATTR_ENABLE)
+                            ? device.readChannelInt("pwm", fanNum, "_enable", 2) : 2;
         bool isManual = (pwmEnable == 1);
 
         HWMonFan fan;
         fan.deviceName = deviceName;
-        fan.devicePath = hwmonPath;
+        fan.devicePath = device.getPath();
         fan.fanNumber = fanNum;
         fan.label = label;
         fan.currentRPM = currentRPM;
@@ -137,7 +201,7 @@ void HWMonInterface::scanFansInDevice(const QString& hwmonPath, const QString& d
         fan.supportsManualControl = supportsPWM;
         fan.isManual = isManual;
 
-        fans.append(fan);
+        scan->fans.append(fan);
 
         qDebug() << "Found fan:" << label
                  << "RPM:" << currentRPM
@@ -148,39 +212,33 @@ void HWMonInterface::scanFansInDevice(const QString& hwmonPath, const QString& d
     }
 }
 
-void HWMonInterface::scanSensorsInDevice(const QString& hwmonPath, const QString& deviceName)
+void HWMonInterface::scanSensorsInDevice(const HWMonDirectory& device, HWMonDeviceScan *scan)
 {
-    QDir dir(hwmonPath);
-    QStringList tempInputFiles = dir.entryList(QStringList() << "temp*_input", QDir::Files);
-
-    for (const QString& tempFile : tempInputFiles) {
-        // Extract temp number from filename
-        QRegularExpression re("temp(\\d+)_input");
-        QRegularExpressionMatch match = re.match(tempFile);
-        if (!match.hasMatch()) {
-            continue;
-        }
-
-        int tempNum = match.captured(1).toInt();
-        QString basePath = hwmonPath + "/temp" + QString::number(tempNum);
+    const QString& deviceName = scan->name;
+    const HWMonChannelTable& channels = device.getChannels();
 
+    for (int tempNum : HWMonDirectory::sortedChannels(channels.temps, HWMON_ATTR_INPUT)) {
         // Read temperature
-        int temp = readIntFromFile(basePath + "_input", 0);
+        int temp = device.readChannelInt("temp", tempNum, "_input", 0);
 
         // Read label if available
-        QString label = readSysFile(basePath + "_label").trimmed();
+        QString label;
+        if (channels.has(channels.temps, tempNum, HWMON_ATTR_LABEL)) {
+            label = QString::fromLocal8Bit(device.readChannel("temp", tempNum, "_label"));
+        }
         if (label.isEmpty()) {
             label = deviceName + " Temp " + QString::number(tempNum);
         }
 
         HWMonSensor sensor;
         sensor.deviceName = deviceName;
-        sensor.devicePath = hwmonPath;
+        sensor.devicePath = device.getPath();
         sensor.label = label;
         sensor.temperature = temp;
-        sensor.index = nextSensorIndex++;
+        sensor.index = -1;
+        sensor.stale = false;
 
-        sensors.append(sensor);
+        scan->sensors.append(sensor);
     }
 }
 
@@ -235,27 +293,142 @@ QVector<HWMonFan> HWMonInterface::getFans() const
 
 QVector<HWMonSensor> HWMonInterface::getTemperatures() const
 {
-    // Update temperature readings
     QVector<HWMonSensor> currentSensors = sensors;
-    for (int i = 0; i < currentSensors.size(); i++) {
-        QString tempPath = currentSensors[i].devicePath + "/temp";
-        // Find the temp number by scanning for it
-        QDir dir(currentSensors[i].devicePath);
-        QStringList tempFiles = dir.entryList(QStringList() << "temp*_input", QDir::Files);
-        for (const QString& tempFile : tempFiles) {
-            QString labelPath = currentSensors[i].devicePath + "/" +
-                               tempFile.left(tempFile.indexOf("_input")) + "_label";
-            QString label = readSysFile(labelPath).trimmed();
-            if (label == currentSensors[i].label || label.isEmpty()) {
-                QString inputPath = currentSensors[i].devicePath + "/" + tempFile;
-                currentSensors[i].temperature = readIntFromFile(inputPath, 0);
-                break;
+    if (readers) {
+        // Late devices keep their previous values, flagged stale
+        readers->sample(&readerValues, &readerStale);
+        for (int i = 0; i < currentSensors.size(); i++) {
+            if (readerValues[i] >= 0) {
+                currentSensors[i].temperature = readerValues[i];
             }
+            currentSensors[i].stale = readerStale[i];
+        }
+        return currentSensors;
+    }
+
+    if (profiler) {
+        // Timed reads of the inputs resolved by setReadProfiler(); sensors in
+        // the slow class keep their last reading on ticks they are not due
+        for (int i = 0; i < currentSensors.size(); i++) {
+            int id = profileIds[i];
+            if (!profiler->isDue(id) || profileInputs[i].isEmpty()) {
+                currentSensors[i].temperature = profileValues[i];
+                continue;
+            }
+            qint64 start = monotonicNs();
+            currentSensors[i].temperature = readIntFromFile(profileInputs[i], 0);
+            profiler->record(id, monotonicNs() - start);
+            profileValues[i] = currentSensors[i].temperature;
+        }
+        return currentSensors;
+    }
+
+    // Update temperature readings
+    for (int i = 0; i < currentSensors.size(); i++) {
+        QString tempFile = findTemperatureInput(currentSensors[i]);
+        if (!tempFile.isEmpty()) {
+            currentSensors[i].temperature = readIntFromFile(currentSensors[i].devicePath + "/" + tempFile, 0);
         }
     }
     return currentSensors;
 }
 
+QString HWMonInterface::findTemperatureInput(const HWMonSensor& sensor) const
+{
+    // Sensors only record their label; find the temp*_input carrying it
+    QDir dir(sensor.devicePath);
+    QStringList tempFiles = dir.entryList(QStringList() << "temp*_input", QDir::Files);
+    for (const QString& tempFile : tempFiles) {
+        QString labelPath = sensor.devicePath + "/" +
+                           tempFile.left(tempFile.indexOf("_input")) + "_label";
+        QString label = readSysFile(labelPath).trimmed();
+        if (label == sensor.label || label.isEmpty()) {
+            return tempFile;
+        }
+    }
+    return QString();
+}
+
+QString HWMonInterface::getTemperatureInputPath(int sensorIndex) const
+{
+    for (const HWMonSensor& sensor : sensors) {
+        if (sensor.index == sensorIndex) {
+            QString tempFile = findTemperatureInput(sensor);
+            return tempFile.isEmpty() ? QString() : sensor.devicePath + "/" + tempFile;
+        }
+    }
+    return QString();
+}
+
+void HWMonInterface::setAsyncReads(int deadlineMs)
+{
+    delete readers;
+    readers = nullptr;
+    readerValues.clear();
+    readerStale.clear();
+    if (deadlineMs <= 0) {
+        return;
+    }
+
+    // Input files are resolved once here instead of on every read
+    QVector<HWMonReadChannel> channels;
+    for (const HWMonSensor& sensor : sensors) {
+        HWMonReadChannel channel;
+        channel.devicePath = sensor.devicePath;
+        channel.attribute = QFile::encodeName(findTemperatureInput(sensor));
+        channel.profileId = -1;
+        channels.append(channel);
+    }
+    for (const HWMonFan& fan : fans) {
+        HWMonReadChannel channel;
+        channel.devicePath = fan.devicePath;
+        channel.attribute = "fan" + QByteArray::number(fan.fanNumber) + "_input";
+        channel.profileId = -1;
+        channels.append(channel);
+    }
+    if (profiler) {
+        for (int i = 0; i < channels.size(); i++) {
+            channels[i].profileId = profileIds[i];
+        }
+    }
+    readers = new HWMonReaders(channels, deadlineMs, profiler);
+    qDebug() << "Async hwmon reads:" << readers->getStatus().size() << "device worker(s),"
+             << deadlineMs << "ms deadline";
+}
+
+void HWMonInterface::setReadProfiler(ReadProfiler *readProfiler)
+{
+    profiler = readProfiler;
+    profileIds.clear();
+    profileInputs.clear();
+    profileValues.clear();
+    if (profiler) {
+        for (const HWMonSensor& sensor : sensors) {
+            QString tempFile = findTemperatureInput(sensor);
+            QString input = tempFile.isEmpty() ? QString() : sensor.devicePath + "/" + tempFile;
+            profileInputs.append(input);
+            profileValues.append(sensor.temperature);
+            // Unresolved sensors are keyed by label so the ids stay parallel to sensors
+            profileIds.append(profiler->registerAttribute(
+                sensor.deviceName, input.isEmpty() ? sensor.devicePath + "/" + sensor.label : input, sensor.index));
+        }
+        for (const HWMonFan& fan : fans) {
+            QString input = fan.devicePath + "/fan" + QString::number(fan.fanNumber) + "_input";
+            profileIds.append(profiler->registerAttribute(fan.deviceName, input, -1));
+        }
+    }
+
+    // Running workers were built without (or with the previous) profiler
+    if (readers) {
+        setAsyncReads(readers->getDeadlineMs());
+    }
+}
+
+QVector<HWMonReaderStatus> HWMonInterface::getReaderStatus() const
+{
+    return readers ? readers->getStatus() : QVector<HWMonReaderStatus>();
+}
+
 QString HWMonInterface::getFanInputPath(int fanIndex)
 {
     if (fanIndex < 0 || fanIndex >= fans.size()) {
@@ -298,18 +471,51 @@ QString HWMonInterface::getFanPWMEnablePath(int fanIndex)
 
 int HWMonInterface::getFanCurrentRPM(int fanIndex)
 {
+    if (readers && fanIndex >= 0 && fanIndex < fans.size() && !readerValues.isEmpty()) {
+        int rpm = readerValues[sensors.size() + fanIndex];
+        if (rpm >= 0) {
+            fans[fanIndex].currentRPM = rpm;
+        }
+        return rpm;
+    }
+
     QString path = getFanInputPath(fanIndex);
     if (path.isEmpty()) {
         return -1;
     }
 
+    qint64 start = monotonicNs();
     int rpm = readIntFromFile(path, -1);
+    if (profiler) {
+        profiler->record(profileIds[sensors.size() + fanIndex], monotonicNs() - start);
+    }
     if (rpm >= 0 && fanIndex >= 0 && fanIndex < fans.size()) {
         fans[fanIndex].currentRPM = rpm;
     }
     return rpm;
 }
 
+void HWMonInterface::getFanCurrentRPMs(const QVector<int>& fanIndices, QVector<int> *rpms)
+{
+    rpms->resize(fanIndices.size());
+    if (!readers || readerValues.isEmpty()) {
+        for (int i = 0; i < fanIndices.size(); i++) {
+            (*rpms)[i] = getFanCurrentRPM(fanIndices[i]);
+        }
+        return;
+    }
+
+    const int *speeds = readerValues.constData() + sensors.size();
+    for (int i = 0; i < fanIndices.size(); i++) {
+        int fanIndex = fanIndices[i];
+        int rpm = fanIndex >= 0 && fanIndex < fans.size() ? speeds[fanIndex] : -1;
+        if (rpm >= 0) {
+            fans[fanIndex].currentRPM = rpm;
+        }
+        (*rpms)[i] = rpm;
+    }
+}
+
 int HWMonInterface::getFanCurrentPWM(int fanIndex)
 {
     QString path = getFanPWMPath(fanIndex);
@@ -324,6 +530,14 @@ int HWMonInterface::getFanCurrentPWM(int fanIndex)
     return pwm;
 }
 
+int HWMonInterface::getFanLastPWM(int fanIndex) const
+{
+    if (fanIndex < 0 || fanIndex >= fans.size() || !fans[fanIndex].supportsManualControl) {
+        return -1;
+    }
+    return fans[fanIndex].currentPWM;
+}
+
 bool HWMonInterface::setFanManualMode(int fanIndex, bool manual)
 {
     if (fanIndex < 0 || fanIndex >= fans.size()) {
@@ -375,6 +589,19 @@ bool HWMonInterface::setFanPWM(int fanIndex, int pwm)
     return false;
 }
 
+void HWMonInterface::setFanCalibration(int fanIndex, const FanCalibrationTable& table)
+{
+    if (fanIndex < 0 || fanIndex >= fans.size()) {
+        return;
+    }
+    fans[fanIndex].calibration = table;
+}
+
+void HWMonInterface::clearFanCalibration(int fanIndex)
+{
+    setFanCalibration(fanIndex, FanCalibrationTable());
+}
+
 bool HWMonInterface::setFanSpeed(int fanIndex, int rpm)
 {
     // Convert RPM to PWM (0-255)
@@ -384,8 +611,13 @@ bool HWMonInterface::setFanSpeed(int fanIndex, int rpm)
 
     const HWMonFan& fan = fans[fanIndex];
 
+    // Prefer the measured response; it knows about stall and start points
+    int pwm = fan.calibration.pwmForRPM(rpm, fan.currentRPM > 0);
+    if (pwm >= 0) {
+        return setFanPWM(fanIndex, pwm);
+    }
+
     // Calculate PWM from RPM using linear mapping
-    int pwm;
     if (fan.maxRPM > fan.minRPM) {
         double ratio = static_cast<double>(rpm - fan.minRPM) / (fan.maxRPM - fan.minRPM);
         pwm = static_cast<int>(ratio * 255);
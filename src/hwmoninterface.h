@@ -7,6 +7,10 @@
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
+#include "fancalibration.h"
+#include "hwmonscanner.h"
+#include "hwmonreaders.h"
+#include "readprofiler.h"
 
 struct HWMonFan {
     QString deviceName;      // e.g., "amdgpu"
@@ -19,6 +23,7 @@ struct HWMonFan {
     int currentPWM;          // Current PWM value (0-255)
     bool supportsManualControl;  // Whether manual control is supported
     bool isManual;           // Current mode (manual or auto)
+    FanCalibrationTable calibration;  // Measured PWM/RPM response (invalid = linear estimate)
 };
 
 struct HWMonSensor {
@@ -27,32 +32,87 @@ struct HWMonSensor {
     QString label;
     int temperature;         // Temperature in millidegrees Celsius
     int index;              // Unique index for this sensor
+    bool stale;             // Device missed the async read deadline; temperature is its last value
+};
+
+// One device's discovery result, see HWMonInterface::scanDevice()
+struct HWMonDeviceScan {
+    QString path;
+    QString name;                   // Empty = not a usable hwmon device
+    QVector<HWMonFan> fans;
+    QVector<HWMonSensor> sensors;   // Indices are assigned by addDevice()
 };
 
 class HWMonInterface : public QObject {
     Q_OBJECT
 
 public:
+    // Sensor indices: SMC sensors sit below this range and virtual sensors
+    // (VirtualSensorEngine::FIRST_INDEX) above it
+    static const int FIRST_SENSOR_INDEX = 1000;
+    static const int LAST_SENSOR_INDEX = 4999;
+
     explicit HWMonInterface(QObject *parent = nullptr);
     ~HWMonInterface();
 
     bool initialize();
+
+    // initialize() in steps, so devices can be scanned concurrently:
+    // scanDevice() touches no members and may run on any thread. Fan and
+    // sensor indices follow the order results are added in.
+    QStringList listDevices() const;
+    static HWMonDeviceScan scanDevice(const QString& hwmonPath, bool smcAvailable);
+    void addDevice(const HWMonDeviceScan& device);
+    bool finishInitialization();
+
+    // Topology found earlier (a DiscoveryManifest, or discovery run on
+    // another thread) instead of scanning; only fan state
+    // (speed, PWM, mode) is read from sysfs
+    bool initializeFromTopology(const QVector<HWMonFan>& fans, const QVector<HWMonSensor>& sensors);
+
     bool hasWritePermission() const { return canWrite; }
     void setSmcAvailable(bool available) { smcAvailable = available; }
 
+    // Prefix for all sysfs paths (empty = the real /sys); set before initialize()
+    void setSysfsRoot(const QString& root) { sysfsRoot = root; }
+    QString getSysfsRoot() const { return sysfsRoot; }
+
     QVector<HWMonFan> getFans() const;
     QVector<HWMonSensor> getTemperatures() const;
 
+    // Read temperatures and fan speeds through one worker per device, waiting
+    // at most deadlineMs per sample for each (0 = synchronous reads). Call once
+    // the topology is complete. While enabled, getFanCurrentRPM() returns the
+    // speed from the latest getTemperatures() round.
+    void setAsyncReads(int deadlineMs);
+
+    // Time every temperature and fan speed read and poll attributes in the
+    // profiler's slow class less often (nullptr = off). Call once the
+    // topology is complete; the profiler must outlive the async readers.
+    void setReadProfiler(ReadProfiler *profiler);
+    bool hasAsyncReads() const { return readers != nullptr; }
+    QVector<HWMonReaderStatus> getReaderStatus() const;
+    QVector<HWMonSensor> getSensors() const { return sensors; }    // Last readings, no I/O
+    QString getTemperatureInputPath(int sensorIndex) const;        // temp*_input file, empty if unknown
+
     // Devices whose temperature sensors are suppressed when SMC is available
     // (fans from these devices are still scanned)
     static const QStringList smcDuplicateDevices;
 
     int getFanCurrentRPM(int fanIndex);
+    // rpms[i] = getFanCurrentRPM(fanIndices[i]); with async reads a single
+    // pass over the latest round
+    void getFanCurrentRPMs(const QVector<int>& fanIndices, QVector<int> *rpms);
     int getFanCurrentPWM(int fanIndex);
+    int getFanLastPWM(int fanIndex) const;  // Last PWM written or read, without a sysfs read (-1 = none)
     bool setFanManualMode(int fanIndex, bool manual);
     bool setFanPWM(int fanIndex, int pwm);  // PWM: 0-255
     bool setFanSpeed(int fanIndex, int rpm);
 
+    // Measured response used by setFanSpeed, see FanCalibrator
+    void setFanCalibration(int fanIndex, const FanCalibrationTable& table);
+    void clearFanCalibration(int fanIndex);
+
 signals:
     void error(const QString& message);
     void warning(const QString& message);
@@ -63,10 +123,22 @@ private:
     bool canWrite;
     bool smcAvailable;
     int nextSensorIndex;
+    QString sysfsRoot;
+
+    HWMonReaders *readers;              // Async reads, nullptr = synchronous
+    mutable QVector<int> readerValues;  // Latest round: sensors, then fan speeds
+    mutable QVector<bool> readerStale;
+
+    ReadProfiler *profiler;
+    QVector<int> profileIds;            // Per sensor, then per fan
+    QVector<QString> profileInputs;     // Resolved input file of each sensor
+    mutable QVector<int> profileValues; // Last profiled reading of each sensor, held while not due
+
+    void checkWritePermission();
+    static void scanFansInDevice(const HWMonDirectory& device, HWMonDeviceScan *scan);
+    static void scanSensorsInDevice(const HWMonDirectory& device, HWMonDeviceScan *scan);
 
-    void scanHWMonDevices();
-    void scanFansInDevice(const QString& hwmonPath, const QString& deviceName);
-    void scanSensorsInDevice(const QString& hwmonPath, const QString& deviceName);
+    QString findTemperatureInput(const HWMonSensor& sensor) const;
 
     QString readSysFile(const QString& path) const;
     bool writeSysFile(const QString& path, const QString& value);
@@ -0,0 +1,193 @@
+#include "hwmonreaders.h"
+#include "hwmonscanner.h"
+#include "latencystats.h"
+#include "readprofiler.h"
+#include <QHash>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct HWMonReaders::Shared {
+    std::mutex mutex;
+    std::condition_variable answered;       // A worker finished a round
+};
+
+struct HWMonReaders::Worker {
+    QString devicePath;
+    QVector<QByteArray> attributes;
+    QVector<int> profileIds;
+    ReadProfiler *profiler;                 // Only used under shared->mutex while !quit
+    std::shared_ptr<Shared> shared;
+    std::condition_variable wake;           // A round was requested, or quit
+
+    // Guarded by shared->mutex
+    quint64 requested = 0;
+    quint64 completed = 0;
+    bool quit = false;
+    QVector<int> values;
+    quint64 answered = 0;
+    quint64 missed = 0;
+    qint64 lastReadNs = 0;
+};
+
+HWMonReaders::HWMonReaders(const QVector<HWMonReadChannel>& channels, int deadlineMs, ReadProfiler *profiler)
+    : shared(std::make_shared<Shared>()),
+      deadlineMs(deadlineMs)
+{
+    QHash<QString, int> workerIndex;
+    for (const HWMonReadChannel& channel : channels) {
+        int index = workerIndex.value(channel.devicePath, -1);
+        if (index < 0) {
+            std::shared_ptr<Worker> worker = std::make_shared<Worker>();
+            worker->devicePath = channel.devicePath;
+            worker->profiler = profiler;
+            worker->shared = shared;
+            index = workers.size();
+            workerIndex.insert(channel.devicePath, index);
+            workers.append(worker);
+        }
+        Worker& worker = *workers[index];
+        channelWorkers.append(index);
+        channelSlots.append(worker.attributes.size());
+        worker.attributes.append(channel.attribute);
+        worker.profileIds.append(channel.profileId);
+        worker.values.append(-1);
+    }
+    rounds.fill(0, workers.size());
+    issued.fill(false, workers.size());
+
+    for (const std::shared_ptr<Worker>& worker : workers) {
+        std::thread(run, worker).detach();
+    }
+}
+
+HWMonReaders::~HWMonReaders()
+{
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    for (const std::shared_ptr<Worker>& worker : workers) {
+        worker->quit = true;
+        worker->wake.notify_one();
+    }
+}
+
+void HWMonReaders::run(std::shared_ptr<Worker> worker)
+{
+    // Opened on the worker thread: even the directory open of a broken
+    // device must not block the caller
+    HWMonDirectory directory(worker->devicePath);
+    QVector<int> values(worker->attributes.size());
+    QVector<bool> due(worker->attributes.size(), true);
+    QVector<qint64> durations(worker->attributes.size());
+
+    std::unique_lock<std::mutex> lock(worker->shared->mutex);
+    for (;;) {
+        worker->wake.wait(lock, [&worker]() {
+            return worker->quit || worker->completed != worker->requested;
+        });
+        if (worker->quit) {
+            return;
+        }
+        quint64 round = worker->requested;
+        if (worker->profiler) {
+            for (int i = 0; i < due.size(); i++) {
+                due[i] = worker->profiler->isDue(worker->profileIds[i]);
+            }
+        }
+        lock.unlock();
+
+        qint64 start = monotonicNs();
+        for (int i = 0; i < worker->attributes.size(); i++) {
+            bool ok = false;
+            int value = -1;
+            if (due[i] && !worker->attributes[i].isEmpty()) {
+                qint64 readStart = monotonicNs();
+                value = directory.readAttribute(worker->attributes[i].constData()).toInt(&ok);
+                durations[i] = monotonicNs() - readStart;
+            }
+            values[i] = ok ? value : -1;
+        }
+        qint64 elapsed = monotonicNs() - start;
+
+        lock.lock();
+        if (worker->quit) {
+            return;
+        }
+        if (worker->profiler) {
+            for (int i = 0; i < due.size(); i++) {
+                if (due[i] && !worker->attributes[i].isEmpty()) {
+                    worker->profiler->record(worker->profileIds[i], durations[i]);
+                }
+            }
+        }
+        // A failed or skipped read keeps the channel's previous value
+        for (int i = 0; i < values.size(); i++) {
+            if (values[i] >= 0) {
+                worker->values[i] = values[i];
+            }
+        }
+        worker->completed = round;
+        worker->lastReadNs = elapsed;
+        worker->shared->answered.notify_all();
+    }
+}
+
+void HWMonReaders::sample(QVector<int> *values, QVector<bool> *stale)
+{
+    std::unique_lock<std::mutex> lock(shared->mutex);
+
+    // Idle workers start a new round. Busy ones still owe an older round;
+    // they are already late, so the wait below does not extend for them.
+    for (int i = 0; i < workers.size(); i++) {
+        Worker& worker = *workers[i];
+        issued[i] = worker.completed == worker.requested;
+        if (issued[i]) {
+            worker.requested++;
+            worker.wake.notify_one();
+        }
+        rounds[i] = worker.requested;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(deadlineMs);
+    shared->answered.wait_until(lock, deadline, [this]() {
+        for (int i = 0; i < workers.size(); i++) {
+            if (issued[i] && workers[i]->completed != rounds[i]) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    for (int i = 0; i < workers.size(); i++) {
+        if (workers[i]->completed == rounds[i]) {
+            workers[i]->answered++;
+        } else {
+            workers[i]->missed++;
+        }
+    }
+
+    values->resize(channelWorkers.size());
+    stale->resize(channelWorkers.size());
+    for (int c = 0; c < channelWorkers.size(); c++) {
+        const Worker& worker = *workers[channelWorkers[c]];
+        (*values)[c] = worker.values[channelSlots[c]];
+        (*stale)[c] = worker.completed != rounds[channelWorkers[c]];
+    }
+}
+
+QVector<HWMonReaderStatus> HWMonReaders::getStatus() const
+{
+    std::lock_guard<std::mutex> lock(shared->mutex);
+
+    QVector<HWMonReaderStatus> status;
+    for (const std::shared_ptr<Worker>& worker : workers) {
+        HWMonReaderStatus entry;
+        entry.devicePath = worker->devicePath;
+        entry.answered = worker->answered;
+        entry.missed = worker->missed;
+        entry.lastReadNs = worker->lastReadNs;
+        entry.busy = worker->completed != worker->requested;
+        status.append(entry);
+    }
+    return status;
+}
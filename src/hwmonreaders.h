@@ -0,0 +1,73 @@
+#ifndef HWMONREADERS_H
+#define HWMONREADERS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+class ReadProfiler;
+
+// One sysfs value read on every sample
+struct HWMonReadChannel {
+    QString devicePath;     // hwmon device directory; one worker per distinct path
+    QByteArray attribute;   // File in devicePath, e.g. "temp3_input" (empty = never read)
+    int profileId;          // ReadProfiler id, -1 = not profiled
+};
+
+// Read statistics of one device worker
+struct HWMonReaderStatus {
+    QString devicePath;
+    quint64 answered;       // Rounds answered within the deadline
+    quint64 missed;         // Rounds the device was late or still busy with an older one
+    qint64 lastReadNs;      // Duration of the last completed round
+    bool busy;              // A round is in progress right now
+};
+
+// Asynchronous hwmon reads with one worker thread per device. sample()
+// hands every idle worker a read round and waits for the answers until a
+// deadline. A device that has not answered by then (slow driver, hung
+// read) keeps its previous values, flagged stale, and gets no new round
+// until the late one returns, so it only holds back its own channels and
+// costs the snapshot at most one deadline when it first falls behind.
+//
+// Workers are detached threads: one stuck in a driver read cannot be
+// joined, so it exits on its own once the read returns.
+class HWMonReaders {
+public:
+    static const int DEFAULT_DEADLINE_MS = 50;
+
+    // profiler, if given, times every read and skips attributes in its slow
+    // class on ticks they are not due; it must outlive this object
+    explicit HWMonReaders(const QVector<HWMonReadChannel>& channels, int deadlineMs = DEFAULT_DEADLINE_MS,
+                          ReadProfiler *profiler = nullptr);
+    ~HWMonReaders();
+
+    // One read round. values and stale are indexed like the constructor's
+    // channels; a value is -1 until its channel has been read once.
+    void sample(QVector<int> *values, QVector<bool> *stale);
+
+    void setDeadlineMs(int ms) { deadlineMs = ms; }
+    int getDeadlineMs() const { return deadlineMs; }
+    int getChannelCount() const { return channelWorkers.size(); }
+    QVector<HWMonReaderStatus> getStatus() const;
+
+private:
+    struct Shared;
+    struct Worker;
+
+    std::shared_ptr<Shared> shared;         // Lock and wakeup shared with the workers
+    QVector<std::shared_ptr<Worker>> workers;
+    QVector<int> channelWorkers;            // Worker of each channel
+    QVector<int> channelSlots;              // Position within that worker's values
+    QVector<quint64> rounds;                // Round each worker is expected to answer
+    QVector<bool> issued;                   // Worker was idle and got a new round
+    int deadlineMs;
+
+    static void run(std::shared_ptr<Worker> worker);
+
+    HWMonReaders(const HWMonReaders&) = delete;
+    HWMonReaders& operator=(const HWMonReaders&) = delete;
+};
+
+#endif // HWMONREADERS_H
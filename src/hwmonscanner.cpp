@@ -0,0 +1,214 @@
+#include "hwmonscanner.h"
+#include <QFile>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Record layout filled in by getdents64 (see getdents(2))
+struct LinuxDirent64 {
+    quint64 ino;
+    qint64 off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[1];           // NUL-terminated, record is padded to reclen
+};
+
+// Calls fn(name) for every entry of an open directory; false on error
+template <typename Fn>
+bool forEachEntry(int fd, Fn fn)
+{
+    alignas(8) char buffer[8192];
+    for (;;) {
+        long bytes = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (bytes == 0) {
+            return true;
+        }
+        for (long pos = 0; pos < bytes;) {
+            const LinuxDirent64 *entry = reinterpret_cast<const LinuxDirent64 *>(buffer + pos);
+            fn(buffer + pos + offsetof(LinuxDirent64, name));
+            pos += entry->reclen;
+        }
+    }
+}
+
+int openDirectory(const QString& path)
+{
+    return ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+} // namespace
+
+HWMonDirectory::HWMonDirectory(const QString& devicePath)
+    : fd(openDirectory(devicePath)),
+      path(devicePath)
+{
+    if (fd >= 0) {
+        scan();
+    }
+}
+
+HWMonDirectory::~HWMonDirectory()
+{
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void HWMonDirectory::scan()
+{
+    forEachEntry(fd, [this](const char *name) {
+        classify(name);
+    });
+}
+
+// fan<N>[_suffix], pwm<N>[_suffix] and temp<N>[_suffix]; everything else
+// (name, device, uevent, in*, curr*, ...) is ignored
+void HWMonDirectory::classify(const char *name)
+{
+    QVector<quint8> *table;
+    const char *p;
+    if (strncmp(name, "fan", 3) == 0) {
+        table = &channels.fans;
+        p = name + 3;
+    } else if (strncmp(name, "pwm", 3) == 0) {
+        table = &channels.pwms;
+        p = name + 3;
+    } else if (strncmp(name, "temp", 4) == 0) {
+        table = &channels.temps;
+        p = name + 4;
+    } else {
+        return;
+    }
+
+    if (!isDigit(*p)) {
+        return;
+    }
+    int channel = 0;
+    while (isDigit(*p)) {
+        channel = channel * 10 + (*p++ - '0');
+        if (channel > 9999) {
+            return;
+        }
+    }
+
+    quint8 attribute;
+    if (*p == '\0') {
+        attribute = HWMON_ATTR_VALUE;
+    } else if (*p != '_') {
+        return;
+    } else if (strcmp(p + 1, "input") == 0) {
+        attribute = HWMON_ATTR_INPUT;
+    } else if (strcmp(p + 1, "label") == 0) {
+        attribute = HWMON_ATTR_LABEL;
+    } else if (strcmp(p + 1, "min") == 0) {
+        attribute = HWMON_ATTR_MIN;
+    } else if (strcmp(p + 1, "max") == 0) {
+        attribute = HWMON_ATTR_MAX;
+    } else if (strcmp(p + 1, "enable") == 0) {
+        attribute = HWMON_ATTR_ENABLE;
+    } else {
+        return;
+    }
+
+    if (channel >= table->size()) {
+        table->resize(channel + 1);
+    }
+    (*table)[channel] |= attribute;
+}
+
+QByteArray HWMonDirectory::readAttribute(const char *name) const
+{
+    if (fd < 0) {
+        return QByteArray();
+    }
+    int file = ::openat(fd, name, O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        return QByteArray();
+    }
+
+    char buffer[256];
+    ssize_t bytes;
+    do {
+        bytes = ::read(file, buffer, sizeof(buffer));
+    } while (bytes < 0 && errno == EINTR);
+    ::close(file);
+    if (bytes <= 0) {
+        return QByteArray();
+    }
+
+    const char *newline = static_cast<const char *>(memchr(buffer, '\n', bytes));
+    return QByteArray(buffer, newline ? static_cast<int>(newline - buffer) : static_cast<int>(bytes)).trimmed();
+}
+
+QByteArray HWMonDirectory::readChannel(const char *type, int channel, const char *suffix) const
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%s%d%s", type, channel, suffix);
+    return readAttribute(name);
+}
+
+int HWMonDirectory::readChannelInt(const char *type, int channel, const char *suffix, int defaultValue) const
+{
+    QByteArray content = readChannel(type, channel, suffix);
+    if (content.isEmpty()) {
+        return defaultValue;
+    }
+
+    bool ok;
+    int value = content.toInt(&ok);
+    return ok ? value : defaultValue;
+}
+
+QVector<int> HWMonDirectory::sortedChannels(const QVector<quint8>& table, quint8 attribute)
+{
+    QVector<int> result;
+    for (int channel = 0; channel < table.size(); channel++) {
+        if (table[channel] & attribute) {
+            result.append(channel);
+        }
+    }
+
+    // "temp10_input" < "temp1_input" < "temp2_input": the character after
+    // the number decides, and '_' sorts after every digit
+    std::sort(result.begin(), result.end(), [](int a, int b) {
+        return QByteArray::number(a) + '_' < QByteArray::number(b) + '_';
+    });
+    return result;
+}
+
+bool HWMonDirectory::listEntries(const QString& directory, const char *prefix, QStringList *entries)
+{
+    int dirFd = openDirectory(directory);
+    if (dirFd < 0) {
+        return false;
+    }
+
+    size_t prefixLength = strlen(prefix);
+    bool ok = forEachEntry(dirFd, [entries, prefix, prefixLength](const char *name) {
+        if (strncmp(name, prefix, prefixLength) == 0 && strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+            entries->append(QFile::decodeName(name));
+        }
+    });
+    ::close(dirFd);
+
+    entries->sort();
+    return ok;
+}
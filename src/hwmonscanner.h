@@ -0,0 +1,68 @@
+#ifndef HWMONSCANNER_H
+#define HWMONSCANNER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Attributes present for one channel (fanN_*, pwmN*, tempN_*)
+enum HWMonAttribute {
+    HWMON_ATTR_VALUE  = 0x01,   // The bare attribute, e.g. pwm2
+    HWMON_ATTR_INPUT  = 0x02,
+    HWMON_ATTR_LABEL  = 0x04,
+    HWMON_ATTR_MIN    = 0x08,
+    HWMON_ATTR_MAX    = 0x10,
+    HWMON_ATTR_ENABLE = 0x20
+};
+
+// Attribute bits of one device, indexed by channel number
+struct HWMonChannelTable {
+    QVector<quint8> fans;
+    QVector<quint8> pwms;
+    QVector<quint8> temps;
+
+    bool has(const QVector<quint8>& table, int channel, quint8 attribute) const {
+        return channel >= 0 && channel < table.size() && (table[channel] & attribute);
+    }
+};
+
+// One hwmon device directory, held open for discovery. A single getdents64
+// pass classifies every attribute name into the channel table with a
+// hand-written parser; values are read with openat() relative to the
+// directory fd, so no paths are built and no regular expressions run.
+class HWMonDirectory {
+public:
+    explicit HWMonDirectory(const QString& path);
+    ~HWMonDirectory();
+
+    bool isOpen() const { return fd >= 0; }
+    QString getPath() const { return path; }
+    const HWMonChannelTable& getChannels() const { return channels; }
+
+    // First line of an attribute, trimmed; empty when missing or unreadable
+    QByteArray readAttribute(const char *name) const;
+    QByteArray readChannel(const char *type, int channel, const char *suffix) const;
+    int readChannelInt(const char *type, int channel, const char *suffix, int defaultValue) const;
+
+    // Channels having `attribute`, in the order QDir::Name sorting of their
+    // file names gives (temp10 before temp2), which sensor indices depend on
+    static QVector<int> sortedChannels(const QVector<quint8>& table, quint8 attribute);
+
+    // Entries of a directory starting with prefix, sorted by name; false
+    // when the directory cannot be opened
+    static bool listEntries(const QString& path, const char *prefix, QStringList *entries);
+
+private:
+    int fd;
+    QString path;
+    HWMonChannelTable channels;
+
+    void scan();
+    void classify(const char *name);
+
+    HWMonDirectory(const HWMonDirectory&) = delete;
+    HWMonDirectory& operator=(const HWMonDirectory&) = delete;
+};
+
+#endif // HWMONSCANNER_H
@@ -0,0 +1,213 @@
+#include "influenceidentifier.h"
+#include <QtConcurrent>
+#include <QtMath>
+#include <functional>
+
+namespace {
+
+const double MIN_TIME_CONSTANT = 1.0;   // Seconds
+const int GRID_POINTS = 40;             // Log-spaced time constants tried first
+const int REFINE_STEPS = 30;            // Golden-section steps around the best of them
+
+// Best offset and response for a fixed time constant, by linear least
+// squares; returns the sum of squared errors
+double fitOffsetResponse(const QVector<double>& times, const QVector<double>& values, double timeConstant,
+                         double *offset, double *response, int *count)
+{
+    double n = 0.0;
+    double sumX = 0.0;
+    double sumY = 0.0;
+    double sumXX = 0.0;
+    double sumXY = 0.0;
+    double sumYY = 0.0;
+    for (int i = 0; i < times.size() && i < values.size(); i++) {
+        if (qIsNaN(values[i])) {
+            continue;
+        }
+        double x = 1.0 - qExp(-times[i] / timeConstant);
+        double y = values[i];
+        n += 1.0;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        sumYY += y * y;
+    }
+    *count = static_cast<int>(n);
+    if (n < 2.0) {
+        *offset = n > 0.0 ? sumY / n : 0.0;
+        *response = 0.0;
+        return 0.0;
+    }
+    double varX = sumXX - sumX * sumX / n;
+    double covXY = sumXY - sumX * sumY / n;
+    double varY = sumYY - sumY * sumY / n;
+    *response = varX > 1e-12 ? covXY / varX : 0.0;
+    *offset = (sumY - *response * sumX) / n;
+    return qMax(0.0, varY - *response * covXY);
+}
+
+} // namespace
+
+InfluenceIdentifier::InfluenceIdentifier()
+    : running(false), currentFan(-1)
+{
+}
+
+void InfluenceIdentifier::start(const InfluenceModel& newLayout, const Options& newOptions)
+{
+    layout = newLayout;
+    layout.resize();
+    options = newOptions;
+    recordings.clear();
+    recordings.resize(layout.fanCount());
+    for (Recording& recording : recordings) {
+        recording.values.resize(layout.sensorCount());
+    }
+    currentFan = layout.fanCount() > 0 ? 0 : -1;
+    running = currentFan >= 0;
+}
+
+int InfluenceIdentifier::getTotalSeconds() const
+{
+    return layout.fanCount() * (options.settleSeconds + options.stepSeconds);
+}
+
+bool InfluenceIdentifier::sample(double seconds, const QVector<double>& readings, QVector<int> *targets)
+{
+    int fanCount = layout.fanCount();
+    targets->resize(fanCount);
+    int period = options.settleSeconds + options.stepSeconds;
+    int slot = period > 0 ? static_cast<int>(qMax(0.0, seconds) / period) : fanCount;
+    double within = seconds - static_cast<double>(slot) * period;
+    if (!running || slot >= fanCount) {
+        running = false;
+        currentFan = -1;
+    } else {
+        currentFan = slot;
+    }
+
+    bool stepping = running && within >= options.settleSeconds;
+    for (int f = 0; f < fanCount; f++) {
+        double position = stepping && f == currentFan ? options.stepPosition : options.basePosition;
+        (*targets)[f] = layout.minRPM[f] + qRound(position * (layout.maxRPM[f] - layout.minRPM[f]));
+    }
+
+    if (stepping) {
+        Recording& recording = recordings[currentFan];
+        recording.times.append(within - options.settleSeconds);
+        for (int s = 0; s < layout.sensorCount(); s++) {
+            recording.values[s].append(readings.value(s, qQNaN()));
+        }
+    }
+    return running;
+}
+
+StepResponseFit InfluenceIdentifier::fitStep(const QVector<double>& times, const QVector<double>& values)
+{
+    StepResponseFit result = {0.0, 0.0, 0.0, 0.0};
+    double span = 0.0;
+    for (double time : times) {
+        span = qMax(span, time);
+    }
+    if (span <= 0.0) {
+        return result;
+    }
+
+    // The sum of squared errors is not convex in the time constant: search
+    // a log-spaced grid up to twice the recorded span, then refine around
+    // the best point by golden section
+    double offset;
+    double response;
+    int count;
+    auto errorAt = [&](double logTime) {
+        return fitOffsetResponse(times, values, qExp(logTime), &offset, &response, &count);
+    };
+    double low = qLn(MIN_TIME_CONSTANT);
+    double high = qLn(qMax(2.0 * MIN_TIME_CONSTANT, 2.0 * span));
+    double step = (high - low) / (GRID_POINTS - 1);
+    int best = 0;
+    double bestError = errorAt(low);
+    for (int i = 1; i < GRID_POINTS; i++) {
+        double error = errorAt(low + i * step);
+        if (error < bestError) {
+            bestError = error;
+            best = i;
+        }
+    }
+
+    const double ratio = 0.6180339887498949;
+    double a = low + qMax(0, best - 1) * step;
+    double b = low + qMin(GRID_POINTS - 1, best + 1) * step;
+    double c = b - ratio * (b - a);
+    double d = a + ratio * (b - a);
+    double errorC = errorAt(c);
+    double errorD = errorAt(d);
+    for (int i = 0; i < REFINE_STEPS; i++) {
+        if (errorC < errorD) {
+            b = d;
+            d = c;
+            errorD = errorC;
+            c = b - ratio * (b - a);
+            errorC = errorAt(c);
+        } else {
+            a = c;
+            c = d;
+            errorC = errorD;
+            d = a + ratio * (b - a);
+            errorD = errorAt(d);
+        }
+    }
+
+    double logTime = 0.5 * (a + b);
+    double error = errorAt(logTime);
+    if (error > bestError) {
+        logTime = low + best * step;
+        error = errorAt(logTime);
+    }
+    result.offset = offset;
+    result.response = response;
+    result.timeConstant = qExp(logTime);
+    result.residual = count > 0 ? qSqrt(error / count) : 0.0;
+    return result;
+}
+
+InfluenceModel InfluenceIdentifier::fit(bool parallel) const
+{
+    // One job per sensor, each fitting that sensor's response to every step
+    std::function<QVector<StepResponseFit>(int)> fitSensor = [this](int sensor) {
+        QVector<StepResponseFit> fits;
+        for (const Recording& recording : recordings) {
+            fits.append(fitStep(recording.times, recording.values[sensor]));
+        }
+        return fits;
+    };
+    QVector<int> sensors;
+    for (int s = 0; s < layout.sensorCount(); s++) {
+        sensors.append(s);
+    }
+    QVector<QVector<StepResponseFit>> rows;
+    if (parallel) {
+        rows = QtConcurrent::blockingMapped<QVector<QVector<StepResponseFit>>>(sensors, fitSensor);
+    } else {
+        for (int sensor : sensors) {
+            rows.append(fitSensor(sensor));
+        }
+    }
+
+    // Gains per full range; a response lost in the sensor's noise is no effect
+    InfluenceModel model = layout;
+    model.resize();
+    double delta = options.stepPosition - options.basePosition;
+    for (int s = 0; s < rows.size(); s++) {
+        for (int f = 0; f < rows[s].size(); f++) {
+            const StepResponseFit& step = rows[s][f];
+            if (qAbs(step.response) * 1000.0 < MIN_RESPONSE_MILLI || delta <= 0.0) {
+                continue;
+            }
+            model.setGain(s, f, step.response / delta);
+            model.setTimeConstant(s, f, step.timeConstant);
+        }
+    }
+    return model;
+}
@@ -0,0 +1,78 @@
+#ifndef INFLUENCEIDENTIFIER_H
+#define INFLUENCEIDENTIFIER_H
+
+#include <QVector>
+#include "influencemodel.h"
+
+// First-order step response fitted to one sensor's readings after a step:
+//
+//   value(t) = offset + response * (1 - exp(-t / timeConstant))
+struct StepResponseFit {
+    double offset;          // °C at the step
+    double response;        // °C once settled
+    double timeConstant;    // Seconds
+    double residual;        // RMS error of the fit, °C
+};
+
+// Measures an InfluenceModel on the running machine. Every fan is held at
+// a base position, then each fan in turn steps up and holds while every
+// sensor is recorded, and returns to base to settle before the next one.
+//
+// The routine is driven by the caller's control tick, so sensors are read
+// and fans written on the caller's thread. Afterwards fit() estimates each
+// sensor's gain and time constant for every fan by least squares, with
+// sensors fitted in parallel.
+class InfluenceIdentifier {
+public:
+    static const int MIN_RESPONSE_MILLI = 500;  // Smaller step responses count as no effect
+
+    struct Options {
+        int settleSeconds;      // All fans at base before each step
+        int stepSeconds;        // Recorded after each step
+        double basePosition;    // 0.0-1.0 of each fan's range
+        double stepPosition;
+
+        Options()
+            : settleSeconds(600), stepSeconds(300), basePosition(0.25), stepPosition(0.75) {}
+    };
+
+    InfluenceIdentifier();
+
+    // layout names the fans (with their ranges) and sensors to identify;
+    // its gains are ignored
+    void start(const InfluenceModel& layout, const Options& options = Options());
+    void cancel() { running = false; }
+    bool isRunning() const { return running; }
+    const InfluenceModel& getLayout() const { return layout; }
+
+    // One control tick: seconds since start() and one reading per layout
+    // sensor (°C, NaN = not read). Fills the RPM each layout fan should run
+    // at; returns false, and stops, once every fan has been stepped.
+    bool sample(double seconds, const QVector<double>& readings, QVector<int> *targets);
+
+    int getCurrentFan() const { return currentFan; }    // Fan stepped or settling before its step
+    int getTotalSeconds() const;
+
+    // The layout with every gain and time constant fitted from the
+    // recorded steps; serially when parallel is false
+    InfluenceModel fit(bool parallel = true) const;
+
+    // Least-squares fit over times (seconds since the step) and values;
+    // NaN values are skipped
+    static StepResponseFit fitStep(const QVector<double>& times, const QVector<double>& values);
+
+private:
+    // Readings after one fan's step
+    struct Recording {
+        QVector<double> times;              // Seconds since the step
+        QVector<QVector<double>> values;    // Per sensor, one per time
+    };
+
+    InfluenceModel layout;
+    Options options;
+    bool running;
+    int currentFan;
+    QVector<Recording> recordings;          // Per fan
+};
+
+#endif // INFLUENCEIDENTIFIER_H
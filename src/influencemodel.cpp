@@ -0,0 +1,219 @@
+#include "influencemodel.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QStandardPaths>
+#include <cstdio>
+
+namespace {
+
+// Unquoted INI values containing commas come back as string lists
+QString textValue(const QSettings& settings, const QString& key)
+{
+    QVariant value = settings.value(key);
+    if (value.type() == QVariant::StringList) {
+        return value.toStringList().join(',');
+    }
+    return value.toString();
+}
+
+bool parseRow(const QString& text, int count, QVector<double> *row)
+{
+    const QStringList parts = text.split(' ', Qt::SkipEmptyParts);
+    if (parts.size() != count) {
+        return false;
+    }
+    row->clear();
+    for (const QString& part : parts) {
+        bool ok = false;
+        row->append(part.toDouble(&ok));
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString formatRow(const QVector<double>& values, int offset, int count)
+{
+    QStringList parts;
+    for (int i = 0; i < count; i++) {
+        parts << QString::number(values[offset + i], 'g', 6);
+    }
+    return parts.join(' ');
+}
+
+} // namespace
+
+void InfluenceModel::resize()
+{
+    gain.fill(0.0, sensors.size() * fans.size());
+    timeConstant.fill(0.0, sensors.size() * fans.size());
+}
+
+bool InfluenceModel::isValid() const
+{
+    return !fans.isEmpty() && !sensors.isEmpty()
+           && minRPM.size() == fans.size() && maxRPM.size() == fans.size()
+           && gain.size() == sensors.size() * fans.size()
+           && timeConstant.size() == gain.size();
+}
+
+int InfluenceModel::suggestSensor(int fan) const
+{
+    int dominated = -1;
+    int strongest = -1;
+    for (int s = 0; s < sensors.size(); s++) {
+        double cooling = -getGain(s, fan);
+        if (cooling <= 0.0) {
+            continue;
+        }
+        if (strongest < 0 || cooling > -getGain(strongest, fan)) {
+            strongest = s;
+        }
+        bool leads = true;
+        for (int other = 0; other < fans.size() && leads; other++) {
+            leads = other == fan || -getGain(s, other) < cooling;
+        }
+        if (leads && (dominated < 0 || cooling > -getGain(dominated, fan))) {
+            dominated = s;
+        }
+    }
+    return dominated >= 0 ? dominated : strongest;
+}
+
+bool InfluenceModel::load(const QString& path, QString *errorMessage)
+{
+    auto fail = [errorMessage, &path](const QString& message) {
+        if (errorMessage) {
+            *errorMessage = QString("%1: %2").arg(path, message);
+        }
+        return false;
+    };
+
+    if (!QFileInfo(path).isReadable()) {
+        return fail("cannot read influence model");
+    }
+    QSettings settings(path, QSettings::IniFormat);
+
+    machine = textValue(settings, "model/machine");
+
+    fans.clear();
+    minRPM.clear();
+    maxRPM.clear();
+    settings.beginGroup("fans");
+    int fanTotal = settings.value("count", 0).toInt();
+    for (int i = 1; i <= fanTotal; i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        fans << textValue(settings, "label");
+        minRPM << settings.value("min", 0).toInt();
+        maxRPM << settings.value("max", 0).toInt();
+        settings.endGroup();
+        if (fans.last().isEmpty() || maxRPM.last() <= minRPM.last()) {
+            settings.endGroup();
+            return fail(QString("fan %1 needs a label and max > min").arg(i));
+        }
+    }
+    settings.endGroup();
+
+    sensors.clear();
+    gain.clear();
+    timeConstant.clear();
+    settings.beginGroup("sensors");
+    int sensorTotal = settings.value("count", 0).toInt();
+    for (int i = 1; i <= sensorTotal; i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        QString label = textValue(settings, "label");
+        QVector<double> gains;
+        QVector<double> times;
+        bool ok = parseRow(textValue(settings, "gain"), fans.size(), &gains);
+        QString timeText = textValue(settings, "timeConstant");
+        if (timeText.isEmpty()) {
+            times.fill(0.0, fans.size());
+        } else {
+            ok = ok && parseRow(timeText, fans.size(), &times);
+        }
+        settings.endGroup();
+        if (label.isEmpty() || !ok) {
+            settings.endGroup();
+            return fail(QString("sensor %1 needs a label and one gain per fan").arg(i));
+        }
+        sensors << label;
+        gain += gains;
+        timeConstant += times;
+    }
+    settings.endGroup();
+
+    if (settings.status() != QSettings::NoError) {
+        return fail("malformed INI file");
+    }
+    if (!isValid()) {
+        return fail("a model needs at least one fan and one sensor");
+    }
+    return true;
+}
+
+bool InfluenceModel::save(const QString& path, QString *errorMessage) const
+{
+    auto fail = [&](const QString& tempPath) {
+        QFile::remove(tempPath);
+        if (errorMessage) {
+            *errorMessage = QString("Cannot write %1").arg(path);
+        }
+        return false;
+    };
+
+    // Written next to the model and renamed over it, so a failed or
+    // interrupted save leaves the previous model in place
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QString tempPath = path + ".tmp";
+    QFile::remove(tempPath);
+    {
+        QSettings settings(tempPath, QSettings::IniFormat);
+
+        settings.setValue("model/machine", machine);
+
+        settings.beginGroup("fans");
+        settings.setValue("count", fans.size());
+        for (int i = 0; i < fans.size(); i++) {
+            settings.beginGroup(QString("Fan%1").arg(i + 1));
+            settings.setValue("label", fans[i]);
+            settings.setValue("min", minRPM.value(i));
+            settings.setValue("max", maxRPM.value(i));
+            settings.endGroup();
+        }
+        settings.endGroup();
+
+        settings.beginGroup("sensors");
+        settings.setValue("count", sensors.size());
+        for (int i = 0; i < sensors.size(); i++) {
+            settings.beginGroup(QString("Sensor%1").arg(i + 1));
+            settings.setValue("label", sensors[i]);
+            settings.setValue("gain", formatRow(gain, i * fans.size(), fans.size()));
+            settings.setValue("timeConstant", formatRow(timeConstant, i * fans.size(), fans.size()));
+            settings.endGroup();
+        }
+        settings.endGroup();
+
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            return fail(tempPath);
+        }
+    }
+
+    // rename() replaces the old file atomically; QFile::rename() refuses to
+    if (std::rename(QFile::encodeName(tempPath).constData(), QFile::encodeName(path).constData()) != 0) {
+        return fail(tempPath);
+    }
+    return true;
+}
+
+QString InfluenceModel::defaultPath(const QString& machine)
+{
+    QString name = machine.isEmpty() ? QString("unknown") : machine;
+    name.replace(QRegularExpression("[^A-Za-z0-9_.-]"), "_");
+    return QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) +
+           "/macsfancontrol/influence/" + name + ".ini";
+}
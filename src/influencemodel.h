@@ -0,0 +1,57 @@
+#ifndef INFLUENCEMODEL_H
+#define INFLUENCEMODEL_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// How strongly each fan affects each sensor, as identified on one machine.
+// Linear around an operating point: a sensor settles at
+//
+//   temperature = base + sum over fans of gain[sensor][fan] * position[fan]
+//
+// where a fan's position is 0.0 at its minimum and 1.0 at its maximum RPM,
+// and base depends on the load. A negative gain cools. The time constant
+// is how long the sensor takes to reach 63% of a fan step's effect.
+//
+// Stored as an INI file, one per machine model:
+//
+//   [model]    machine
+//   [fans]     count, Fan1/label, Fan1/min, Fan1/max
+//   [sensors]  count, Sensor1/label, Sensor1/gain ("g1 g2 ..." per fan, °C),
+//              Sensor1/timeConstant ("t1 t2 ..." per fan, seconds)
+struct InfluenceModel {
+    QString machine;            // Mac model it was identified on
+    QStringList fans;           // Fan labels, in gain column order
+    QVector<int> minRPM;        // Per fan
+    QVector<int> maxRPM;
+    QStringList sensors;        // Sensor labels, in gain row order
+    QVector<double> gain;       // sensors x fans, row-major, °C from minimum to maximum
+    QVector<double> timeConstant;   // sensors x fans, seconds (0 = unknown)
+
+    int fanCount() const { return fans.size(); }
+    int sensorCount() const { return sensors.size(); }
+    double getGain(int sensor, int fan) const { return gain[sensor * fans.size() + fan]; }
+    double getTimeConstant(int sensor, int fan) const { return timeConstant[sensor * fans.size() + fan]; }
+    void setGain(int sensor, int fan, double value) { gain[sensor * fans.size() + fan] = value; }
+    void setTimeConstant(int sensor, int fan, double value) { timeConstant[sensor * fans.size() + fan] = value; }
+
+    // Sizes gain and timeConstant for the current fans and sensors, zeroed
+    void resize();
+    bool isValid() const;
+    int findFan(const QString& label) const { return fans.indexOf(label); }
+    int findSensor(const QString& label) const { return sensors.indexOf(label); }
+
+    // Input a fan should follow in sensor-based mode: of the sensors it
+    // cools more than any other fan does, the one it cools most; else the
+    // sensor it cools most (-1 = it cools none)
+    int suggestSensor(int fan) const;
+
+    bool load(const QString& path, QString *errorMessage = nullptr);
+    bool save(const QString& path, QString *errorMessage = nullptr) const;
+
+    // Where the model for a machine is kept
+    static QString defaultPath(const QString& machine);
+};
+
+#endif // INFLUENCEMODEL_H
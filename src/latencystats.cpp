@@ -0,0 +1,156 @@
+#include "latencystats.h"
+#include <QtMath>
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram()
+    : counts(BUCKET_COUNT, 0),
+      total(0),
+      sum(0),
+      maxValue(0)
+{
+}
+
+qint64 LatencyHistogram::bucketUpperEdge(int bucket)
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+    int sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return (static_cast<qint64>(SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+qint64 LatencyHistogram::percentile(double fraction) const
+{
+    if (total == 0) {
+        return 0;
+    }
+
+    quint64 rank = static_cast<quint64>(qCeil(qBound(0.0, fraction, 1.0) * total));
+    rank = qMax(rank, quint64(1));
+
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            // Never report more than was actually observed
+            return qMin(bucketUpperEdge(bucket), maxValue);
+        }
+    }
+    return maxValue;
+}
+
+void LatencyHistogram::reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0;
+    maxValue = 0;
+}
+
+void TickLatencyStats::setFanCount(int count)
+{
+    fans.resize(count);
+}
+
+void TickLatencyStats::reset()
+{
+    for (FanLatency& fan : fans) {
+        fan.decision.reset();
+        fan.write.reset();
+        fan.total.reset();
+    }
+    for (BackendLatency& backend : backends) {
+        backend.sample.reset();
+        backend.write.reset();
+    }
+}
+
+QString TickLatencyStats::backendName(Backend backend)
+{
+    switch (backend) {
+    case BACKEND_SMC:   return "smc";
+    case BACKEND_HWMON: return "hwmon";
+    default:            return "unknown";
+    }
+}
+
+namespace {
+
+const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+QString formatMicros(qint64 ns)
+{
+    return QString::number(ns / 1000.0, 'f', 1);
+}
+
+QString summaryLine(const QString& name, const LatencyHistogram& histogram)
+{
+    return QString("  %1 n=%2  p50=%3  p90=%4  p99=%5  p99.9=%6  max=%7 µs")
+        .arg(name, -20)
+        .arg(histogram.count())
+        .arg(formatMicros(histogram.percentile(0.5)))
+        .arg(formatMicros(histogram.percentile(0.9)))
+        .arg(formatMicros(histogram.percentile(0.99)))
+        .arg(formatMicros(histogram.percentile(0.999)))
+        .arg(formatMicros(histogram.max()));
+}
+
+} // namespace
+
+void exportSummary(QByteArray& out, const QByteArray& metric, const QByteArray& labels,
+                   const LatencyHistogram& histogram)
+{
+    QByteArray prefix = labels.isEmpty() ? QByteArray() : labels + ",";
+    QByteArray suffix = labels.isEmpty() ? QByteArray() : "{" + labels + "}";
+    for (double quantile : QUANTILES) {
+        out += metric + "{" + prefix + "quantile=\"" + QByteArray::number(quantile) + "\"} "
+               + QByteArray::number(histogram.percentile(quantile) / 1e9, 'g', 6) + "\n";
+    }
+    out += metric + "_sum" + suffix + " " + QByteArray::number(histogram.getSum() / 1e9, 'g', 9) + "\n";
+    out += metric + "_count" + suffix + " " + QByteArray::number(histogram.count()) + "\n";
+}
+
+QStringList TickLatencyStats::summaryLines() const
+{
+    QStringList lines;
+    for (int b = 0; b < BACKEND_COUNT; b++) {
+        QString name = backendName(static_cast<Backend>(b));
+        if (backends[b].sample.count() > 0) {
+            lines << summaryLine(name + " sample", backends[b].sample);
+        }
+        if (backends[b].write.count() > 0) {
+            lines << summaryLine(name + " write", backends[b].write);
+        }
+    }
+    for (int i = 0; i < fans.size(); i++) {
+        if (fans[i].decision.count() > 0) {
+            lines << summaryLine(QString("Fan%1 decision").arg(i), fans[i].decision);
+        }
+        if (fans[i].write.count() > 0) {
+            lines << summaryLine(QString("Fan%1 write").arg(i), fans[i].write);
+            lines << summaryLine(QString("Fan%1 total").arg(i), fans[i].total);
+        }
+    }
+    return lines;
+}
+
+QByteArray TickLatencyStats::exportText() const
+{
+    const QByteArray metric = "macsfancontrol_tick_latency_seconds";
+    QByteArray out;
+    out += "# HELP macsfancontrol_tick_latency_seconds Time spent in each stage of a control tick\n";
+    out += "# TYPE macsfancontrol_tick_latency_seconds summary\n";
+    for (int b = 0; b < BACKEND_COUNT; b++) {
+        QByteArray backend = "backend=\"" + backendName(static_cast<Backend>(b)).toLatin1() + "\"";
+        exportSummary(out, metric, "stage=\"sample\"," + backend, backends[b].sample);
+        exportSummary(out, metric, "stage=\"write\"," + backend, backends[b].write);
+    }
+    for (int i = 0; i < fans.size(); i++) {
+        QByteArray fan = "fan=\"" + QByteArray::number(i) + "\"";
+        exportSummary(out, metric, "stage=\"decision\"," + fan, fans[i].decision);
+        exportSummary(out, metric, "stage=\"write\"," + fan, fans[i].write);
+        exportSummary(out, metric, "stage=\"total\"," + fan, fans[i].total);
+    }
+    return out;
+}
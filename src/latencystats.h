@@ -0,0 +1,143 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtAlgorithms>
+#include <vector>
+#include <time.h>
+
+// CLOCK_MONOTONIC in nanoseconds (vDSO call, a few tens of ns)
+inline qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Log-linear histogram of durations in nanoseconds, HdrHistogram style: values
+// below 16 ns are counted exactly, above that every power of two is split into
+// 16 linear sub-buckets (about 6% resolution). Recording is a leading-zero
+// count and an increment, with no allocation.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_MAGNITUDE = 40;                 // Values up to 2^40 ns (~18 min)
+    static const int BUCKET_COUNT = SUB_BUCKETS + (MAX_MAGNITUDE - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    void record(qint64 ns)
+    {
+        if (ns < 0) {
+            ns = 0;
+        }
+        counts[bucketFor(static_cast<quint64>(ns))]++;
+        total++;
+        sum += ns;
+        if (ns > maxValue) {
+            maxValue = ns;
+        }
+    }
+
+    quint64 count() const { return total; }
+    qint64 max() const { return maxValue; }
+    double mean() const { return total > 0 ? static_cast<double>(sum) / total : 0.0; }
+    qint64 getSum() const { return sum; }
+
+    // Value at or below which the given fraction (0.0-1.0) of samples fall,
+    // reported as the upper edge of its bucket
+    qint64 percentile(double fraction) const;
+
+    void reset();
+
+private:
+    std::vector<quint64> counts;
+    quint64 total;
+    qint64 sum;
+    qint64 maxValue;
+
+    static int bucketFor(quint64 ns)
+    {
+        if (ns < static_cast<quint64>(SUB_BUCKETS)) {
+            return static_cast<int>(ns);
+        }
+        int magnitude = 63 - qCountLeadingZeroBits(ns);     // >= SUB_BUCKET_BITS
+        if (magnitude > MAX_MAGNITUDE) {
+            return BUCKET_COUNT - 1;
+        }
+        int shift = magnitude - SUB_BUCKET_BITS;
+        int sub = static_cast<int>(ns >> shift) - SUB_BUCKETS;
+        return SUB_BUCKETS + shift * SUB_BUCKETS + sub;
+    }
+    static qint64 bucketUpperEdge(int bucket);
+};
+
+// One histogram as Prometheus summary samples of metric, in seconds: the
+// 0.5, 0.9, 0.99 and 0.999 quantiles, _sum and _count. labels ("a=\"b\",...")
+// may be empty; the HELP and TYPE lines are the caller's.
+void exportSummary(QByteArray& out, const QByteArray& metric, const QByteArray& labels,
+                   const LatencyHistogram& histogram);
+
+// Where each control tick spends its time, from the start of the sensor read
+// to the fan write landing in sysfs:
+//   sample   - one backend's temperature read (per backend)
+//   decision - snapshot ready to control decision (per fan)
+//   write    - decision to write committed (per fan and per backend)
+//   total    - sample start to write committed (per fan)
+class TickLatencyStats {
+public:
+    enum Backend {
+        BACKEND_SMC = 0,
+        BACKEND_HWMON,
+        BACKEND_COUNT
+    };
+
+    void setFanCount(int count);
+    int fanCount() const { return fans.size(); }
+
+    void recordSample(Backend backend, qint64 startNs, qint64 endNs)
+    {
+        backends[backend].sample.record(endNs - startNs);
+    }
+    void recordDecision(int fan, qint64 sampleEndNs, qint64 decisionNs)
+    {
+        fans[fan].decision.record(decisionNs - sampleEndNs);
+    }
+    void recordWrite(int fan, Backend backend, qint64 sampleStartNs,
+                     qint64 decisionNs, qint64 commitNs)
+    {
+        fans[fan].write.record(commitNs - decisionNs);
+        fans[fan].total.record(commitNs - sampleStartNs);
+        backends[backend].write.record(commitNs - decisionNs);
+    }
+
+    void reset();
+
+    // One line per non-empty histogram, for the debug log
+    QStringList summaryLines() const;
+
+    // Prometheus text exposition format (summary with quantiles)
+    QByteArray exportText() const;
+
+    static QString backendName(Backend backend);
+
+private:
+    struct FanLatency {
+        LatencyHistogram decision;
+        LatencyHistogram write;
+        LatencyHistogram total;
+    };
+    struct BackendLatency {
+        LatencyHistogram sample;
+        LatencyHistogram write;
+    };
+
+    QVector<FanLatency> fans;
+    BackendLatency backends[BACKEND_COUNT];
+};
+
+#endif // LATENCYSTATS_H
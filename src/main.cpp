@@ -1,12 +1,18 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
 #include <QMessageBox>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QStringList>
 #include "mainwindow.h"
 #include <unistd.h>
 #include <cstdio>
 
-// Captured debug log messages (appended by the message handler below)
+// Captured debug log messages (appended by the message handler below);
+// discovery and sampler threads log too
 static QStringList g_debugLog;
+static QMutex g_debugLogMutex;
 
 static void debugMessageHandler(QtMsgType type, const QMessageLogContext& /*context*/, const QString& msg)
 {
@@ -18,6 +24,7 @@ static void debugMessageHandler(QtMsgType type, const QMessageLogContext& /*cont
     case QtFatalMsg:    prefix = "[FATAL]"; break;
     default:            prefix = "[INFO] "; break;
     }
+    QMutexLocker locker(&g_debugLogMutex);
     g_debugLog.append(QString("%1 %2").arg(prefix, msg));
     fprintf(stderr, "%s %s\n", prefix, msg.toLocal8Bit().constData());
     if (type == QtFatalMsg)
@@ -27,6 +34,7 @@ static void debugMessageHandler(QtMsgType type, const QMessageLogContext& /*cont
 // Called from MainWindow to retrieve the captured log
 QStringList getDebugLog()
 {
+    QMutexLocker locker(&g_debugLogMutex);
     return g_debugLog;
 }
 
@@ -41,8 +49,46 @@ int main(int argc, char *argv[])
     app.setApplicationVersion("1.0");
     app.setOrganizationName("macsfancontrol-qt");
 
-    // Check for root privileges (effective user ID)
-    if (geteuid() != 0) {
+    // --sysfs-root (or MACSFANCONTROL_SYSFS_ROOT) runs against a copy or a
+    // synthetic tree instead of the real /sys, e.g. one built by
+    // tools/sysfsgen
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption sysfsRootOption("sysfs-root", "Prefix for all sysfs paths.", "dir",
+                                       qEnvironmentVariable("MACSFANCONTROL_SYSFS_ROOT"));
+    parser.addOption(sysfsRootOption);
+    QCommandLineOption recordTraceOption("record-trace", "Record a control trace for macsfancontrol-replay.", "file");
+    parser.addOption(recordTraceOption);
+    QCommandLineOption hwmonDeadlineOption("hwmon-deadline",
+                                           "Per-sample deadline for hwmon device reads, 0 = read synchronously.",
+                                           "ms", QString::number(HWMonReaders::DEFAULT_DEADLINE_MS));
+    parser.addOption(hwmonDeadlineOption);
+    QCommandLineOption realtimeOption("realtime",
+                                      "Fan sampler and critical sensor thread scheduling: fifo[:priority] "
+                                      "or nice[:level], with locked memory and timerfd ticks.",
+                                      "policy");
+    parser.addOption(realtimeOption);
+    QCommandLineOption watchdogTimeoutOption("watchdog-timeout",
+                                             "Put fans in a safe state when the control loop stalls this long "
+                                             "or the app dies, 0 = off.",
+                                             "ms", QString::number(FanWatchdog::DEFAULT_TIMEOUT_MS));
+    parser.addOption(watchdogTimeoutOption);
+    QCommandLineOption watchdogActionOption("watchdog-action", "Safe state: auto or max.", "action", "auto");
+    parser.addOption(watchdogActionOption);
+    QCommandLineOption criticalIntervalOption("critical-interval",
+                                              "Read interval of the critical sensors, 0 = do not watch them.",
+                                              "ms", QString::number(CriticalSensorGuard::DEFAULT_INTERVAL_MS));
+    parser.addOption(criticalIntervalOption);
+    parser.process(app);
+    QString sysfsRoot = parser.value(sysfsRootOption);
+    if (!sysfsRoot.isEmpty()) {
+        qDebug() << "Using sysfs root:" << sysfsRoot;
+    }
+
+    // Check for root privileges (effective user ID); synthetic trees are
+    // writable by their owner
+    if (geteuid() != 0 && sysfsRoot.isEmpty()) {
         QMessageBox msgBox;
         msgBox.setIcon(QMessageBox::Warning);
         msgBox.setWindowTitle("Permission Required");
@@ -61,7 +107,25 @@ int main(int argc, char *argv[])
         // If OK, continue in read-only mode
     }
 
-    MainWindow window;
+    MainWindow window(sysfsRoot);
+    window.setHWMonReadDeadline(qMax(0, parser.value(hwmonDeadlineOption).toInt()));
+    FanWatchdog::Action watchdogAction = FanWatchdog::ACTION_AUTO;
+    if (!FanWatchdog::parseAction(parser.value(watchdogActionOption), &watchdogAction)) {
+        qWarning() << "Invalid --watchdog-action:" << parser.value(watchdogActionOption);
+    }
+    window.setWatchdog(qMax(0, parser.value(watchdogTimeoutOption).toInt()), watchdogAction);
+    window.setCriticalInterval(qMax(0, parser.value(criticalIntervalOption).toInt()));
+    if (parser.isSet(realtimeOption)) {
+        RealtimeOptions realtime;
+        if (RealtimeOptions::parse(parser.value(realtimeOption), &realtime)) {
+            window.setSamplerRealtime(realtime);
+        } else {
+            qWarning() << "Invalid --realtime policy:" << parser.value(realtimeOption);
+        }
+    }
+    if (parser.isSet(recordTraceOption)) {
+        window.startTraceRecording(parser.value(recordTraceOption));
+    }
     window.show();
 
     return app.exec();
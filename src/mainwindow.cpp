@@ -19,33 +19,123 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
-
-MainWindow::MainWindow(QWidget *parent)
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHash>
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QSpinBox>
+#include <algorithm>
+
+MainWindow::MainWindow(const QString& sysfsRoot, QWidget *parent)
     : QMainWindow(parent),
       smcInterface(new SMCInterface(this)),
       hwmonInterface(new HWMonInterface(this)),
+      fanBackends(smcInterface, hwmonInterface),
       tempPanel(new TemperaturePanel(this)),
-      updateTimer(new QTimer(this))
+      updateTimer(new QTimer(this)),
+      metricsServer(new MetricsServer(this)),
+      fanSampler(new FanSampler(this)),
+      criticalGuard(new CriticalSensorGuard(this)),
+      descriptionWatcher(new ConfigFileWatcher(this)),
+      calibrationCancel(false),
+      calibrationTripped(false),
+      sensorPipeline(smcInterface, hwmonInterface, &sensorFilters, &virtualSensors)
 {
-    bool smcAvailable = false;
-    bool hwmonAvailable = false;
+    uptimeTimer.start();
+
+    smcInterface->setSysfsRoot(sysfsRoot);
+    hwmonInterface->setSysfsRoot(sysfsRoot);
+
+    // Window and menus come up empty; fans are added as backends report them
+    setupUI();
+    createMenuBar();
+    connectSignals();
+
+    // Load custom sensor descriptions if available, and again whenever the file changes
+    QString configPath = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) +
+                        "/macsfancontrol/sensor_descriptions.conf";
+    SensorDescriptions::loadCustomDescriptions(configPath);
+    QString watchError;
+    if (descriptionWatcher->watch(configPath, &watchError)) {
+        connect(descriptionWatcher, &ConfigFileWatcher::changed, this, &MainWindow::reloadSensorDescriptions);
+    } else {
+        qWarning() << watchError << "- sensor descriptions are only read at startup";
+    }
+
+    // Filters and critical sensors are keyed by sensor label and need no topology
+    loadSensorFilters();
+    loadCriticalSensors();
+
+    // Latency histograms, also served on a local socket
+    sensorPipeline.setLatencyStats(&tickLatency);
+    metricsServer->setProvider([this]() { return exportMetrics(); });
+    metricsServer->listen();
+
+    // Closed-loop RPM tracking for PWM fans runs faster than the GUI tick
+    fanSampler->start();
+
+    // Thermal emergencies bypass the GUI tick; it stops tracking on a trip
+    criticalGuard->setSampler(fanSampler);
+    connect(criticalGuard, &CriticalSensorGuard::emergencyChanged, this, &MainWindow::onCriticalEmergency);
+
+    // A matching cached topology is restored right away. Otherwise full
+    // discovery runs on a thread pool while the window is already shown,
+    // and fan widgets appear as the SMC and each hwmon device finish.
+    if (DiscoveryManifest::restoreBackends(smcInterface, hwmonInterface,
+                                           DiscoveryManifest::defaultPath(), &discovery)) {
+        addSMCFanWidgets();
+        addHWMonFanWidgets(0, hwmonInterface->getFans().size());
+        finishInitialization();
+        return;
+    }
+
+    backendDiscovery = new BackendDiscovery(smcInterface, hwmonInterface, this);
+    connect(backendDiscovery, &BackendDiscovery::smcReady, this, &MainWindow::addSMCFanWidgets);
+    connect(backendDiscovery, &BackendDiscovery::hwmonFansAdded, this, &MainWindow::addHWMonFanWidgets);
+    connect(backendDiscovery, &BackendDiscovery::discoveryFinished, this, [this]() {
+        discovery.smcAvailable = backendDiscovery->isSmcAvailable();
+        discovery.hwmonAvailable = backendDiscovery->isHWMonAvailable();
+        discovery.warm = false;
+        discovery.elapsedNs = backendDiscovery->getElapsedNs();
+        if (discovery.smcAvailable || discovery.hwmonAvailable) {
+            DiscoveryManifest::saveBackends(DiscoveryManifest::defaultPath(), discovery.smcAvailable,
+                                            *smcInterface, *hwmonInterface);
+        }
+        finishInitialization();
+    });
+    backendDiscovery->start();
+
+    // Temperatures and fan speeds of what is known so far
+    updateTimer->start(1000);
+    statusBar()->showMessage("Discovering hardware...");
+}
 
-    // Initialize SMC interface
-    if (smcInterface->initialize()) {
-        smcAvailable = true;
+void MainWindow::finishInitialization()
+{
+    bool smcAvailable = discovery.smcAvailable;
+    bool hwmonAvailable = discovery.hwmonAvailable;
+    topologyMs = uptimeTimer.nsecsElapsed() / 1.0e6;
+    if (smcAvailable) {
         qDebug() << "SMC interface initialized";
     } else {
         qWarning() << "SMC interface not available";
     }
-
-    // Initialize HWMon interface
-    hwmonInterface->setSmcAvailable(smcAvailable);
-    if (hwmonInterface->initialize()) {
-        hwmonAvailable = true;
+    if (hwmonAvailable) {
         qDebug() << "HWMon interface initialized";
     } else {
         qWarning() << "HWMon interface not available";
     }
+    qDebug() << QString("Hardware discovery (%1): %2 ms, full topology after %3 ms")
+                    .arg(discovery.warm ? "cached" : "full scan")
+                    .arg(discovery.elapsedNs / 1.0e6, 0, 'f', 1)
+                    .arg(topologyMs, 0, 'f', 1);
 
     // Check if at least one interface is available
     if (!smcAvailable && !hwmonAvailable) {
@@ -60,6 +150,7 @@ MainWindow::MainWindow(QWidget *parent)
     // Check for write permissions
     bool canWriteSMC = smcAvailable && smcInterface->hasWritePermission();
     bool canWriteHWMon = hwmonAvailable && hwmonInterface->hasWritePermission();
+    calibrateAction->setEnabled(canWriteHWMon);
 
     if ((smcAvailable && !canWriteSMC) || (hwmonAvailable && !canWriteHWMon)) {
         QMessageBox::warning(this, "Permission Warning",
@@ -68,20 +159,34 @@ MainWindow::MainWindow(QWidget *parent)
                            "Run with: sudo macsfancontrol");
     }
 
-    setupUI();
-    createMenuBar();
-    connectSignals();
+    // Measured PWM curves must be in place before fans get their saved targets
+    loadFanCalibrations();
+    updateSamplerResponses();
 
-    // Load custom sensor descriptions if available
-    QString configPath = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) +
-                        "/macsfancontrol/sensor_descriptions.conf";
-    SensorDescriptions::loadCustomDescriptions(configPath);
+    // Compile derived sensors before restoring fans that may use them as input
+    loadVirtualSensors();
 
-    // Load saved settings
+    // Load saved settings; they are per fan, so only with the full topology
     loadSettings();
+    topologyComplete = true;
+
+    // The optimizer finds its fans by label, so it also waits for the topology
+    loadOptimizer();
+
+    // Every sensor and fan speed read is timed from here on; then a slow
+    // hwmon driver only delays its own channels
+    smcInterface->setReadProfiler(&readProfiler);
+    hwmonInterface->setReadProfiler(&readProfiler);
+    hwmonInterface->setAsyncReads(hwmonReadDeadlineMs);
+
+    // Heartbeats start with the first tick below
+    startWatchdog();
+    startCriticalGuard();
 
     // Start update timer (1 second interval)
-    updateTimer->start(1000);
+    if (!updateTimer->isActive()) {
+        updateTimer->start(1000);
+    }
 
     // Initial update
     updateSensorData();
@@ -89,13 +194,303 @@ MainWindow::MainWindow(QWidget *parent)
     statusBar()->showMessage("Ready");
 }
 
+void MainWindow::addSMCFanWidgets()
+{
+    // Pass Mac model to temperature panel for sensor description lookup
+    QString macModel = smcInterface->getMacModel();
+    tempPanel->setMacModel(macModel);
+
+    // Create fan control widgets for SMC fans
+    for (const FanInfo& fan : smcInterface->getFans()) {
+        FanControlWidget *fanWidget = new FanControlWidget(fan, this);
+        fanWidget->setMacModel(macModel);  // Set Mac model for sensor descriptions
+        addFanWidget(fanWidget, FAN_SOURCE_SMC, fan.index - 1,  // SMC uses 1-based index
+                     -1);                                        // The SMC tracks RPM targets itself
+    }
+    updateSensorListInFanWidgets();
+}
+
+void MainWindow::addHWMonFanWidgets(int first, int count)
+{
+    // Create fan control widgets for HWMon fans
+    QVector<HWMonFan> hwmonFans = hwmonInterface->getFans();
+    for (int i = first; i < first + count && i < hwmonFans.size(); i++) {
+        const HWMonFan& hwFan = hwmonFans[i];
+
+        // Convert HWMonFan to FanInfo
+        FanInfo fan;
+        fan.index = fanWidgets.size() + 1;  // Sequential index
+        fan.label = hwFan.label;
+        fan.currentRPM = hwFan.currentRPM;
+        fan.targetRPM = hwFan.currentRPM;
+        fan.minRPM = hwFan.minRPM;
+        fan.maxRPM = hwFan.maxRPM;
+        fan.isManual = hwFan.isManual;
+        fan.sysfsPath = hwFan.devicePath;
+
+        FanControlWidget *fanWidget = new FanControlWidget(fan, this);
+        addFanWidget(fanWidget, FAN_SOURCE_HWMON, i,  // HWMon index
+                     hwFan.supportsManualControl ? fanSampler->addFan(hwFan.devicePath, hwFan.fanNumber) : -1);
+    }
+    updateSensorListInFanWidgets();
+}
+
+void MainWindow::addFanWidget(FanControlWidget *fanWidget, FanSource source, int sourceIndex, int samplerId)
+{
+    fanWidgets.append(fanWidget);
+    int fan = fanBackends.addFan(source, sourceIndex);
+    fanZones.setFanRange(fan, fanWidget->getMinRPM(), fanWidget->getMaxRPM());
+    samplerFanIds.append(samplerId);
+
+    // Above the stretch that keeps the list top-aligned
+    fanLayout->insertWidget(fanLayout->count() - 1, fanWidget);
+
+    // Initialize sensor-based settings
+    SensorBasedSettings settings = {false, -1, 40, 80};
+    sensorSettings.append(settings);
+    FanWriteStats stats = {0, 0};
+    fanWriteStats.append(stats);
+    tickLatency.setFanCount(fanWidgets.size());
+
+    // Connect fan widget signals
+    connect(fanWidget, &FanControlWidget::manualModeRequested,
+            this, &MainWindow::onManualModeRequested);
+    connect(fanWidget, &FanControlWidget::targetRPMChanged,
+            this, &MainWindow::onTargetRPMChanged);
+    connect(fanWidget, &FanControlWidget::sensorBasedModeChanged,
+            this, &MainWindow::onSensorBasedModeChanged);
+}
+
+void MainWindow::setSamplerRealtime(const RealtimeOptions& options)
+{
+    fanSampler->setRealtime(options);
+    criticalGuard->setRealtime(options);
+    if (topologyComplete) {
+        startCriticalGuard();
+    }
+}
+
+void MainWindow::setCriticalInterval(int ms)
+{
+    criticalIntervalMs = ms;
+    if (topologyComplete) {
+        startCriticalGuard();
+    }
+}
+
+void MainWindow::setWatchdog(int timeoutMs, FanWatchdog::Action action)
+{
+    watchdogTimeoutMs = timeoutMs;
+    watchdog.setAction(action);
+    if (topologyComplete) {
+        startWatchdog();
+    }
+}
+
+void MainWindow::startWatchdog()
+{
+    watchdog.stop();
+    watchdog.clearFans();
+    if (watchdogTimeoutMs <= 0) {
+        return;
+    }
+
+    for (const FanInfo& fan : smcInterface->getFans()) {
+        watchdog.addSMCFan(fan.sysfsPath, fan.maxRPM);
+    }
+    for (const HWMonFan& fan : hwmonInterface->getFans()) {
+        if (fan.supportsManualControl) {
+            watchdog.addHWMonFan(fan.devicePath, fan.fanNumber);
+        }
+    }
+
+    // Nothing to protect in read-only mode
+    bool canWrite = (!smcInterface->getFans().isEmpty() && smcInterface->hasWritePermission()) ||
+                    hwmonInterface->hasWritePermission();
+    if (watchdog.getFanCount() == 0 || !canWrite) {
+        return;
+    }
+
+    QString errorMessage;
+    if (!watchdog.start(watchdogTimeoutMs, &errorMessage)) {
+        qWarning() << errorMessage;
+    }
+}
+
+void MainWindow::startCriticalGuard()
+{
+    // Fans held at maximum by the old configuration go back to their modes
+    bool wasEmergency = criticalGuard->isEmergency();
+    criticalGuard->stop();
+    criticalGuard->clear();
+    if (wasEmergency) {
+        reapplyFanSettings();
+    }
+    if (criticalIntervalMs <= 0 || criticalSensors.isEmpty()) {
+        return;
+    }
+
+    // Resolve labels to input files; SMC sensors first, like the temperature panel
+    QVector<TempSensor> smcSensors = smcInterface->getSensors();
+    QVector<HWMonSensor> hwmonSensors = hwmonInterface->getSensors();
+    for (CriticalSensor sensor : criticalSensors) {
+        for (const TempSensor& smcSensor : smcSensors) {
+            if (smcSensor.label == sensor.label) {
+                sensor.inputPath = smcSensor.sysfsPath;
+                break;
+            }
+        }
+        for (int i = 0; i < hwmonSensors.size() && sensor.inputPath.isEmpty(); i++) {
+            if (hwmonSensors[i].label == sensor.label) {
+                sensor.inputPath = hwmonInterface->getTemperatureInputPath(hwmonSensors[i].index);
+            }
+        }
+        if (sensor.inputPath.isEmpty()) {
+            qWarning() << "Critical sensor" << sensor.label << "not found, not watched";
+            continue;
+        }
+        criticalGuard->addSensor(sensor);
+    }
+
+    for (const FanInfo& fan : smcInterface->getFans()) {
+        criticalGuard->addSMCFan(fan.sysfsPath, fan.maxRPM);
+    }
+    for (const HWMonFan& fan : hwmonInterface->getFans()) {
+        if (fan.supportsManualControl) {
+            criticalGuard->addHWMonFan(fan.devicePath, fan.fanNumber);
+        }
+    }
+
+    // Watching is pointless without a fan it may drive
+    bool canWrite = (!smcInterface->getFans().isEmpty() && smcInterface->hasWritePermission()) ||
+                    hwmonInterface->hasWritePermission();
+    if (criticalGuard->getSensorCount() == 0 || criticalGuard->getFanCount() == 0 || !canWrite) {
+        return;
+    }
+    criticalGuard->start(criticalIntervalMs);
+}
+
+void MainWindow::reapplyFanSettings()
+{
+    // The calibrator hands the fans back when it stops; settings follow then
+    if (calibrating) {
+        return;
+    }
+
+    // Hand every fan back to the mode its widget shows; a zone's lead does its followers
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        if (fanZones.isFollower(i)) {
+            continue;
+        }
+        if (isOptimizerFan(i)) {
+            // The next tick writes a fresh target
+            onManualModeRequested(i, true);
+            optimizerTargets[i] = -1;
+            continue;
+        }
+        FanControlWidget *fanWidget = fanWidgets[i];
+        FanMode mode = fanWidget->getCurrentMode();
+        onManualModeRequested(i, mode != MODE_AUTO);
+        if (mode == MODE_MANUAL) {
+            onTargetRPMChanged(i, fanWidget->getTargetRPM());
+        } else if (mode == MODE_SENSOR_BASED) {
+            // Rewrite the last target now, so the sampler tracks it again
+            // right away; the next tick decides a fresh one
+            int target = fanWidget->getController().getTarget();
+            fanWidget->resetController();
+            if (target >= 0) {
+                onTargetRPMChanged(i, target);
+            }
+        }
+    }
+}
+
+void MainWindow::onCriticalEmergency(bool active, const QString& label, int temperature)
+{
+    if (active) {
+        // Readings with every fan at maximum would spoil the step responses
+        if (identifier.isRunning()) {
+            finishIdentification(false);
+        }
+        // A sweep would keep writing its PWM steps between the guard's writes
+        if (calibrating) {
+            calibrationTripped = true;
+            calibrationCancel = true;
+        }
+        statusBar()->showMessage(QString("Thermal emergency: %1 at %2 °C, all fans at maximum")
+                                     .arg(label).arg(temperature / 1000.0, 0, 'f', 1));
+        return;
+    }
+
+    // A new trip may already be queued behind this; the writes below are then skipped
+    reapplyFanSettings();
+    statusBar()->showMessage(QString("%1 back below its limit, fan control restored").arg(label), 5000);
+}
+
+void MainWindow::reloadSensorDescriptions()
+{
+    // Parsed on the thread pool and swapped in here; ticks go on meanwhile
+    int reload = ++descriptionReloads;
+    QString path = descriptionWatcher->getPath();
+    QFutureWatcher<SensorDescriptions::Table> *watcher = new QFutureWatcher<SensorDescriptions::Table>(this);
+    connect(watcher, &QFutureWatcher<SensorDescriptions::Table>::finished, this, [this, watcher, reload]() {
+        watcher->deleteLater();
+        if (reload != descriptionReloads) {
+            return;     // A newer edit is being parsed
+        }
+        QSet<QString> changed = SensorDescriptions::setCustomDescriptions(watcher->result());
+        qDebug() << "Sensor descriptions reloaded," << changed.size() << "changed";
+        if (changed.isEmpty()) {
+            return;
+        }
+        tempPanel->refreshDescriptions(changed);
+        for (FanControlWidget *fanWidget : fanWidgets) {
+            fanWidget->refreshSensorDescriptions(changed);
+        }
+        statusBar()->showMessage(QString("Sensor descriptions reloaded (%1 changed)").arg(changed.size()), 3000);
+    });
+    watcher->setFuture(QtConcurrent::run([path]() {
+        return SensorDescriptions::parseCustomDescriptions(path);
+    }));
+}
+
+void MainWindow::setHWMonReadDeadline(int ms)
+{
+    hwmonReadDeadlineMs = ms;
+    if (topologyComplete) {
+        hwmonInterface->setAsyncReads(ms);
+    }
+}
+
+bool MainWindow::event(QEvent *event)
+{
+    bool handled = QMainWindow::event(event);
+    if (event->type() == QEvent::Paint && firstPaintMs < 0) {
+        firstPaintMs = uptimeTimer.nsecsElapsed() / 1.0e6;
+        qDebug() << QString("Time to first paint: %1 ms").arg(firstPaintMs, 0, 'f', 1);
+    }
+    return handled;
+}
+
 MainWindow::~MainWindow()
 {
-    // Save current settings before exit
-    saveSettings();
+    // No more PWM trims or emergency writes once fans are handed back
+    fanSampler->stop();
+    criticalGuard->stop();
+
+    // Read workers that are still busy must stop reporting to readProfiler
+    hwmonInterface->setAsyncReads(0);
+
+    // Save current settings before exit; not over a partially discovered topology
+    if (topologyComplete) {
+        saveSettings();
+    }
 
     // Restore all fans to automatic mode on exit
     restoreAutoMode();
+
+    // Fans are handed back; a clean exit must not trip the watchdog
+    watchdog.stop();
 }
 
 void MainWindow::setupUI()
@@ -103,9 +498,6 @@ void MainWindow::setupUI()
     setWindowTitle("Fan Control");
     resize(800, 600);
 
-    // Pass Mac model to temperature panel for sensor description lookup
-    tempPanel->setMacModel(smcInterface->getMacModel());
-
     // Create central widget
     QWidget *centralWidget = new QWidget(this);
     setCentralWidget(centralWidget);
@@ -131,72 +523,10 @@ void MainWindow::setupUI()
 
     // Fan controls content widget
     QWidget *fanContentWidget = new QWidget();
-    QVBoxLayout *fanLayout = new QVBoxLayout(fanContentWidget);
+    fanLayout = new QVBoxLayout(fanContentWidget);
     fanLayout->setSpacing(10);
     fanLayout->setContentsMargins(10, 10, 10, 10);
 
-    // Create fan control widgets for SMC fans
-    QVector<FanInfo> smcFans = smcInterface->getFans();
-    QString macModel = smcInterface->getMacModel();
-    for (const FanInfo& fan : smcFans) {
-        FanControlWidget *fanWidget = new FanControlWidget(fan, this);
-        fanWidget->setMacModel(macModel);  // Set Mac model for sensor descriptions
-        fanWidgets.append(fanWidget);
-        fanSources.append(FAN_SOURCE_SMC);
-        fanSourceIndices.append(fan.index - 1);  // SMC uses 1-based index
-        fanLayout->addWidget(fanWidget);
-
-        // Initialize sensor-based settings
-        SensorBasedSettings settings = {false, -1, 40, 80};
-        sensorSettings.append(settings);
-
-        // Connect fan widget signals
-        connect(fanWidget, &FanControlWidget::manualModeRequested,
-                this, &MainWindow::onManualModeRequested);
-        connect(fanWidget, &FanControlWidget::targetRPMChanged,
-                this, &MainWindow::onTargetRPMChanged);
-        connect(fanWidget, &FanControlWidget::sensorBasedModeChanged,
-                this, &MainWindow::onSensorBasedModeChanged);
-    }
-
-    // Create fan control widgets for HWMon fans
-    QVector<HWMonFan> hwmonFans = hwmonInterface->getFans();
-    for (int i = 0; i < hwmonFans.size(); i++) {
-        const HWMonFan& hwFan = hwmonFans[i];
-
-        // Convert HWMonFan to FanInfo
-        FanInfo fan;
-        fan.index = fanWidgets.size() + 1;  // Sequential index
-        fan.label = hwFan.label;
-        fan.currentRPM = hwFan.currentRPM;
-        fan.targetRPM = hwFan.currentRPM;
-        fan.minRPM = hwFan.minRPM;
-        fan.maxRPM = hwFan.maxRPM;
-        fan.isManual = hwFan.isManual;
-        fan.sysfsPath = hwFan.devicePath;
-
-        FanControlWidget *fanWidget = new FanControlWidget(fan, this);
-        fanWidgets.append(fanWidget);
-        fanSources.append(FAN_SOURCE_HWMON);
-        fanSourceIndices.append(i);  // HWMon index
-        fanLayout->addWidget(fanWidget);
-
-        // Initialize sensor-based settings
-        SensorBasedSettings settings = {false, -1, 40, 80};
-        sensorSettings.append(settings);
-
-        // Connect fan widget signals
-        connect(fanWidget, &FanControlWidget::manualModeRequested,
-                this, &MainWindow::onManualModeRequested);
-        connect(fanWidget, &FanControlWidget::targetRPMChanged,
-                this, &MainWindow::onTargetRPMChanged);
-        connect(fanWidget, &FanControlWidget::sensorBasedModeChanged,
-                this, &MainWindow::onSensorBasedModeChanged);
-    }
-
-    // Initialize sensor list in fan widgets
-    updateSensorListInFanWidgets();
-
     fanLayout->addStretch();
 
     // Add content to scroll area
@@ -244,6 +574,72 @@ void MainWindow::createMenuBar()
     connect(deletePresetAction, &QAction::triggered, this, &MainWindow::deletePreset);
     presetsMenu->addAction(deletePresetAction);
 
+    // Fans menu
+    QMenu *fansMenu = menuBar()->addMenu("F&ans");
+
+    calibrateAction = new QAction("&Calibrate hwmon Fans...", this);
+    calibrateAction->setEnabled(false);     // Until discovery finds writable hwmon fans
+    connect(calibrateAction, &QAction::triggered, this, &MainWindow::calibrateHWMonFans);
+    fansMenu->addAction(calibrateAction);
+
+    QAction *zonesAction = new QAction("Configure &Zones...", this);
+    connect(zonesAction, &QAction::triggered, this, &MainWindow::configureFanZones);
+    fansMenu->addAction(zonesAction);
+
+    fansMenu->addSeparator();
+
+    QAction *identifyAction = new QAction("&Identify Fan Influence...", this);
+    connect(identifyAction, &QAction::triggered, this, &MainWindow::identifyFanInfluence);
+    fansMenu->addAction(identifyAction);
+
+    optimizerAction = new QAction("&Acoustic Optimizer", this);
+    optimizerAction->setCheckable(true);
+    optimizerAction->setEnabled(false);     // Until an influence model is loaded
+    connect(optimizerAction, &QAction::triggered, this, &MainWindow::toggleAcousticOptimizer);
+    fansMenu->addAction(optimizerAction);
+
+    predictiveAction = new QAction("&Predictive Control", this);
+    predictiveAction->setCheckable(true);
+    predictiveAction->setEnabled(false);    // Until an influence model is loaded
+    connect(predictiveAction, &QAction::triggered, this, &MainWindow::togglePredictiveControl);
+    fansMenu->addAction(predictiveAction);
+
+    QAction *optimizerLimitsAction = new QAction("Optimizer &Limits...", this);
+    connect(optimizerLimitsAction, &QAction::triggered, this, &MainWindow::configureOptimizerLimits);
+    fansMenu->addAction(optimizerLimitsAction);
+
+    QAction *optimizerSettingsAction = new QAction("Optimizer &Settings...", this);
+    connect(optimizerSettingsAction, &QAction::triggered, this, &MainWindow::configureOptimizerSettings);
+    fansMenu->addAction(optimizerSettingsAction);
+
+    fansMenu->addSeparator();
+
+    recordTraceAction = new QAction("Record Control &Trace...", this);
+    recordTraceAction->setCheckable(true);
+    connect(recordTraceAction, &QAction::toggled, this, &MainWindow::toggleTraceRecording);
+    fansMenu->addAction(recordTraceAction);
+
+    // Sensors menu
+    QMenu *sensorsMenu = menuBar()->addMenu("&Sensors");
+
+    QAction *addVirtualAction = new QAction("&Add Virtual Sensor...", this);
+    connect(addVirtualAction, &QAction::triggered, this, &MainWindow::addVirtualSensor);
+    sensorsMenu->addAction(addVirtualAction);
+
+    QAction *removeVirtualAction = new QAction("&Remove Virtual Sensor...", this);
+    connect(removeVirtualAction, &QAction::triggered, this, &MainWindow::removeVirtualSensor);
+    sensorsMenu->addAction(removeVirtualAction);
+
+    sensorsMenu->addSeparator();
+
+    QAction *filterAction = new QAction("Configure Sensor &Filter...", this);
+    connect(filterAction, &QAction::triggered, this, &MainWindow::configureSensorFilter);
+    sensorsMenu->addAction(filterAction);
+
+    QAction *criticalAction = new QAction("Configure &Critical Sensors...", this);
+    connect(criticalAction, &QAction::triggered, this, &MainWindow::configureCriticalSensors);
+    sensorsMenu->addAction(criticalAction);
+
     // Help menu
     QMenu *helpMenu = menuBar()->addMenu("&Help");
 
@@ -252,6 +648,10 @@ void MainWindow::createMenuBar()
     connect(copyDebugAction, &QAction::triggered, this, &MainWindow::copyDebugLogToClipboard);
     helpMenu->addAction(copyDebugAction);
 
+    QAction *readCostAction = new QAction("Sensor &Read Costs...", this);
+    connect(readCostAction, &QAction::triggered, this, &MainWindow::showReadCosts);
+    helpMenu->addAction(readCostAction);
+
     helpMenu->addSeparator();
 
     QAction *aboutAction = new QAction("&About", this);
@@ -265,6 +665,7 @@ void MainWindow::createMenuBar()
                          "- Manual and automatic fan control\n"
                          "- Temperature sensor monitoring\n"
                          "- Sensor-based automatic control\n"
+                         "- Virtual sensors derived from expressions\n"
                          "- Save and load presets\n"
                          "- Settings persistence\n"
                          "- Support for multiple fan types (SMC + hwmon)\n"
@@ -276,7 +677,16 @@ void MainWindow::createMenuBar()
 void MainWindow::connectSignals()
 {
     // Connect timer to update function
-    connect(updateTimer, &QTimer::timeout, this, &MainWindow::updateSensorData);
+    connect(updateTimer, &QTimer::timeout, this, [this]() {
+        // Wakeup deviation of the control tick from its schedule; unlike
+        // the sampler's this runs on the GUI thread under normal scheduling
+        qint64 wakeup = monotonicNs();
+        if (lastControlTickNs > 0) {
+            controlTickJitter.record(qAbs(wakeup - lastControlTickNs - updateTimer->interval() * 1000000LL));
+        }
+        lastControlTickNs = wakeup;
+        updateSensorData();
+    });
 
     // Connect SMC interface signals
     connect(smcInterface, &SMCInterface::error, this, &MainWindow::showError);
@@ -285,49 +695,76 @@ void MainWindow::connectSignals()
 
 void MainWindow::updateSensorData()
 {
-    // Get temperature readings from both sources
-    QVector<TempSensor> smcTemps = smcInterface->getTemperatures();
-    QVector<HWMonSensor> hwmonSensors = hwmonInterface->getTemperatures();
-
-    // Convert hwmon sensors to TempSensor format
-    QVector<TempSensor> temps = smcTemps;
-    for (const HWMonSensor& hwSensor : hwmonSensors) {
-        TempSensor sensor;
-        sensor.index = hwSensor.index;
-        sensor.label = hwSensor.label;
-        sensor.temperature = hwSensor.temperature;
-        sensor.sysfsPath = hwSensor.devicePath;
-        temps.append(sensor);
+    // Re-rate sensors by read cost now and then; the reads below are this tick's cost
+    static int policyCount = 0;
+    if (++policyCount % ReadProfiler::SLOW_INTERVAL == 0) {
+        readProfiler.applyPolicy(usedSensorIndices());
+    }
+    readProfiler.beginTick();
+
+    // Get temperature readings from both sources, de-noised, plus derived channels
+    tickSampleStart = monotonicNs();
+    qint64 timestamp = uptimeTimer.elapsed();
+    QVector<TempSensor> raw;
+    bool recording = traceWriter.isRecording();
+    QVector<TempSensor> temps = sensorPipeline.sample(timestamp, recording ? &raw : nullptr);
+    tickSampleEnd = monotonicNs();
+    tickTimestamp = timestamp;
+
+    // System-wide CPU utilization for feed-forward
+    double cpuLoad = cpuLoadMonitor.sample();
+
+    if (recording) {
+        traceWriter.recordFans(traceFanConfigs());
+        traceWriter.recordTick(timestamp, raw, cpuLoad);
     }
 
-    // Update all fan RPMs
-    for (int i = 0; i < fanWidgets.size(); i++) {
-        FanSource source = fanSources[i];
-        int sourceIndex = fanSourceIndices[i];
-        int rpm = -1;
-
-        if (source == FAN_SOURCE_SMC) {
-            rpm = smcInterface->getFanCurrentRPM(sourceIndex);
-        } else if (source == FAN_SOURCE_HWMON) {
-            rpm = hwmonInterface->getFanCurrentRPM(sourceIndex);
-        }
+    // All fan RPMs, one batch per backend
+    fanBackends.readSpeeds(&fanSpeeds);
 
-        if (rpm >= 0) {  // Valid reading
-            fanWidgets[i]->setCurrentRPM(rpm);
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        if (fanSpeeds[i] >= 0) {  // Valid reading
+            fanWidgets[i]->setCurrentRPM(fanSpeeds[i]);
         }
 
-        // Update sensor-based fans
-        if (sensorSettings[i].enabled && sensorSettings[i].sensorIndex >= 0) {
+        // Update sensor-based fans, unless the optimizer or identification drives them
+        if (sensorSettings[i].enabled && sensorSettings[i].sensorIndex >= 0 && !isOptimizerFan(i)
+            && !identifier.isRunning()) {
             // Find the temperature for the selected sensor
             for (const TempSensor& sensor : temps) {
                 if (sensor.index == sensorSettings[i].sensorIndex) {
-                    fanWidgets[i]->updateSensorBasedSpeed(sensor.temperature);
+                    // New targets are queued by onTargetRPMChanged, with their decision time
+                    if (!fanWidgets[i]->updateSensorBasedSpeed(sensor.temperature, timestamp, cpuLoad)) {
+                        tickLatency.recordDecision(i, tickSampleEnd, monotonicNs());
+                        fanWriteStats[i].avoided++;
+                    }
                     break;
                 }
             }
         }
     }
 
+    if (identifier.isRunning()) {
+        runIdentification(temps);
+    } else {
+        runOptimizer(temps);
+    }
+    flushFanWrites();
+    tickSampleStart = -1;
+    if (recording) {
+        traceWriter.recordSpeeds(timestamp, fanSpeeds);
+    }
+
+    // The control decisions of this tick are done
+    watchdog.heartbeat();
+
+    // The watchdog put the fans in its safe state while this loop stalled:
+    // take them over again and write every target, unchanged or not
+    if (watchdog.takeTrip()) {
+        qWarning() << "Fan watchdog tripped while the control loop stalled, reapplying fan settings";
+        reapplyFanSettings();
+    }
+
     // Update temperature panel
     tempPanel->updateTemperatures(temps);
 
@@ -338,44 +775,267 @@ void MainWindow::updateSensorData()
     }
 
     // Update status bar
-    statusBar()->showMessage(QString("Last update: %1").arg(QTime::currentTime().toString("hh:mm:ss")));
+    QString emergency = criticalGuard->isEmergency()
+                            ? QString("THERMAL EMERGENCY (%1): fans at maximum  |  ").arg(criticalGuard->getTrippedLabel())
+                            : QString();
+    statusBar()->showMessage(QString("%1Last update: %2  |  %3")
+                             .arg(emergency)
+                             .arg(QTime::currentTime().toString("hh:mm:ss"))
+                             .arg(fanWriteSummary()));
+
+    if (firstSampleMs < 0) {
+        firstSampleMs = uptimeTimer.nsecsElapsed() / 1.0e6;
+        qDebug() << QString("Time to first sample: %1 ms").arg(firstSampleMs, 0, 'f', 1);
+    }
 }
 
-void MainWindow::showError(const QString& message)
+QSet<int> MainWindow::usedSensorIndices() const
 {
-    // Show error in status bar
-    statusBar()->showMessage("Error: " + message, 5000);
-
-    // Log to stderr
-    qWarning() << "SMC Error:" << message;
-
-    // For critical permission errors, show dialog
-    if (message.contains("permission", Qt::CaseInsensitive) ||
-        message.contains("root", Qt::CaseInsensitive)) {
-        QMessageBox::critical(this, "Permission Error",
-                            "Cannot write to SMC interface.\n\n" + message +
-                            "\n\nPlease run with: sudo macsfancontrol");
+    // Sensors that steer a fan, directly or through a virtual sensor
+    QSet<int> used = virtualSensors.referencedSensors();
+    for (int i = 0; i < sensorSettings.size(); i++) {
+        if (sensorSettings[i].enabled && sensorSettings[i].sensorIndex >= 0) {
+            used.insert(sensorSettings[i].sensorIndex);
+        }
+    }
+    if (optimizerEnabled) {
+        for (int index : optimizerSensorIndices) {
+            if (index >= 0) {
+                used.insert(index);
+            }
+        }
     }
+    return used;
 }
 
-void MainWindow::showWarning(const QString& message)
+void MainWindow::showReadCosts()
 {
-    // Show warning in status bar
-    statusBar()->showMessage("Warning: " + message, 3000);
+    QDialog *dialog = new QDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowTitle("Sensor Read Costs");
+    dialog->resize(900, 500);
+
+    QVBoxLayout *layout = new QVBoxLayout(dialog);
+    QLabel *summary = new QLabel(dialog);
+    summary->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(summary);
+
+    QTableWidget *table = new QTableWidget(dialog);
+    table->setColumnCount(7);
+    table->setHorizontalHeaderLabels(QStringList() << "Driver" << "Attribute" << "Rate" << "Recent (us)"
+                                                   << "Mean (us)" << "Max (us)" << "Reads");
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    layout->addWidget(table);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, dialog);
+    QPushButton *refreshButton = buttons->addButton("&Refresh", QDialogButtonBox::ActionRole);
+    connect(buttons, &QDialogButtonBox::rejected, dialog, &QDialog::close);
+    layout->addWidget(buttons);
+
+    auto refresh = [this, summary, table]() {
+        QStringList lines = readProfiler.summaryLines(0);
+        for (QString& line : lines) {
+            line = line.trimmed();
+        }
+        summary->setText(lines.join("\n"));
+
+        // Most expensive first
+        QVector<ReadCost> costs = readProfiler.getCosts();
+        std::sort(costs.begin(), costs.end(), [](const ReadCost& a, const ReadCost& b) {
+            return a.recentNs > b.recentNs;
+        });
+        table->setRowCount(costs.size());
+        for (int row = 0; row < costs.size(); row++) {
+            const ReadCost& cost = costs[row];
+            double meanNs = cost.reads > 0 ? static_cast<double>(cost.totalNs) / cost.reads : 0.0;
+            QStringList cells;
+            cells << cost.driver << cost.attribute
+                  << (cost.rate == READ_RATE_SLOW ? QString("every %1 ticks").arg(ReadProfiler::SLOW_INTERVAL)
+                                                  : QString("every tick"))
+                  << QString::number(cost.recentNs / 1.0e3, 'f', 1)
+                  << QString::number(meanNs / 1.0e3, 'f', 1)
+                  << QString::number(cost.maxNs / 1.0e3, 'f', 1)
+                  << QString::number(cost.reads);
+            for (int column = 0; column < cells.size(); column++) {
+                QTableWidgetItem *item = new QTableWidgetItem(cells[column]);
+                if (column >= 3) {
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                }
+                table->setItem(row, column, item);
+            }
+        }
+    };
+    connect(refreshButton, &QPushButton::clicked, dialog, refresh);
+    refresh();
 
-    // Log to stderr
-    qWarning() << "SMC Warning:" << message;
+    dialog->show();
 }
 
-void MainWindow::copyDebugLogToClipboard()
+QByteArray MainWindow::exportMetrics() const
 {
-    // Forward declaration — defined in main.cpp
+    QByteArray out = tickLatency.exportText();
+    out += "# HELP macsfancontrol_fan_writes_total Fan target writes issued or suppressed by hysteresis\n";
+    out += "# TYPE macsfancontrol_fan_writes_total counter\n";
+    for (int i = 0; i < fanWriteStats.size(); i++) {
+        QByteArray fan = "fan=\"" + QByteArray::number(i) + "\"";
+        out += "macsfancontrol_fan_writes_total{" + fan + ",result=\"written\"} "
+               + QByteArray::number(fanWriteStats[i].written) + "\n";
+        out += "macsfancontrol_fan_writes_total{" + fan + ",result=\"avoided\"} "
+               + QByteArray::number(fanWriteStats[i].avoided) + "\n";
+    }
+
+    QVector<RpmTrackingStatus> tracking = fanSampler->getStatus();
+    out += "# HELP macsfancontrol_rpm_tracking_error_rpm Target minus measured RPM of tracked PWM fans\n";
+    out += "# TYPE macsfancontrol_rpm_tracking_error_rpm gauge\n";
+    QByteArray convergence;
+    for (int i = 0; i < samplerFanIds.size(); i++) {
+        if (samplerFanIds[i] < 0 || !tracking[samplerFanIds[i]].active) {
+            continue;
+        }
+        const RpmTrackingStatus& status = tracking[samplerFanIds[i]];
+        QByteArray fan = "fan=\"" + QByteArray::number(i) + "\"";
+        out += "macsfancontrol_rpm_tracking_error_rpm{" + fan + "} "
+               + QByteArray::number(status.errorRPM) + "\n";
+        if (status.lastConvergenceMs >= 0) {
+            convergence += "macsfancontrol_rpm_convergence_seconds{" + fan + "} "
+                           + QByteArray::number(status.lastConvergenceMs / 1000.0) + "\n";
+        }
+    }
+    out += "# HELP macsfancontrol_rpm_convergence_seconds Time the last RPM target took to converge\n";
+    out += "# TYPE macsfancontrol_rpm_convergence_seconds gauge\n";
+    out += convergence;
+
+    LatencyHistogram jitter = fanSampler->getTickJitter();
+    out += "# HELP macsfancontrol_sampler_jitter_seconds Fan sampler wakeup deviation from its schedule\n";
+    out += "# TYPE macsfancontrol_sampler_jitter_seconds summary\n";
+    exportSummary(out, "macsfancontrol_sampler_jitter_seconds", QByteArray(), jitter);
+    out += "# HELP macsfancontrol_control_tick_jitter_seconds Control tick wakeup deviation from its schedule\n";
+    out += "# TYPE macsfancontrol_control_tick_jitter_seconds summary\n";
+    exportSummary(out, "macsfancontrol_control_tick_jitter_seconds", QByteArray(), controlTickJitter);
+
+    LatencyHistogram tripLatency = criticalGuard->getTripLatency();
+    out += "# HELP macsfancontrol_critical_trip_seconds Critical sensor limit crossing to fans written at maximum\n";
+    out += "# TYPE macsfancontrol_critical_trip_seconds summary\n";
+    exportSummary(out, "macsfancontrol_critical_trip_seconds", QByteArray(), tripLatency);
+    out += "# HELP macsfancontrol_critical_emergency Fans held at maximum by a critical sensor (1 = yes)\n";
+    out += "# TYPE macsfancontrol_critical_emergency gauge\n";
+    out += "macsfancontrol_critical_emergency " + QByteArray::number(criticalGuard->isEmergency() ? 1 : 0) + "\n";
+
+    out += "# HELP macsfancontrol_optimizer_solve_seconds Time of one acoustic optimizer solve\n";
+    out += "# TYPE macsfancontrol_optimizer_solve_seconds summary\n";
+    exportSummary(out, "macsfancontrol_optimizer_solve_seconds", QByteArray(), optimizerSolveCost);
+    out += "# HELP macsfancontrol_predictive_solve_seconds Time of one predictive control plan\n";
+    out += "# TYPE macsfancontrol_predictive_solve_seconds summary\n";
+    exportSummary(out, "macsfancontrol_predictive_solve_seconds", QByteArray(), predictiveSolveCost);
+    out += "# HELP macsfancontrol_optimizer_feasible Last acoustic optimizer solve met every limit (1 = yes)\n";
+    out += "# TYPE macsfancontrol_optimizer_feasible gauge\n";
+    out += "macsfancontrol_optimizer_feasible " + QByteArray::number(optimizerFeasible ? 1 : 0) + "\n";
+
+    QVector<HWMonReaderStatus> readers = hwmonInterface->getReaderStatus();
+    out += "# HELP macsfancontrol_hwmon_read_rounds_total Async hwmon read rounds answered or missed per device\n";
+    out += "# TYPE macsfancontrol_hwmon_read_rounds_total counter\n";
+    for (const HWMonReaderStatus& status : readers) {
+        QByteArray device = "device=\"" + status.devicePath.toUtf8() + "\"";
+        out += "macsfancontrol_hwmon_read_rounds_total{" + device + ",result=\"answered\"} "
+               + QByteArray::number(status.answered) + "\n";
+        out += "macsfancontrol_hwmon_read_rounds_total{" + device + ",result=\"missed\"} "
+               + QByteArray::number(status.missed) + "\n";
+    }
+    out += "# HELP macsfancontrol_hwmon_read_busy Async hwmon read still in progress (1 = values stale)\n";
+    out += "# TYPE macsfancontrol_hwmon_read_busy gauge\n";
+    for (const HWMonReaderStatus& status : readers) {
+        out += "macsfancontrol_hwmon_read_busy{device=\"" + status.devicePath.toUtf8() + "\"} "
+               + QByteArray::number(status.busy ? 1 : 0) + "\n";
+    }
+
+    out += "# HELP macsfancontrol_sysfs_read_seconds_total Time spent in sysfs reads per driver\n";
+    out += "# TYPE macsfancontrol_sysfs_read_seconds_total counter\n";
+    for (const DriverReadCost& driver : readProfiler.getDriverCosts()) {
+        out += "macsfancontrol_sysfs_read_seconds_total{driver=\"" + driver.driver.toUtf8() + "\"} "
+               + QByteArray::number(driver.totalNs / 1.0e9) + "\n";
+    }
+    LatencyHistogram tickReadCost = readProfiler.getTickCost();
+    out += "# HELP macsfancontrol_tick_read_seconds Summed sysfs read time per tick\n";
+    out += "# TYPE macsfancontrol_tick_read_seconds summary\n";
+    exportSummary(out, "macsfancontrol_tick_read_seconds", QByteArray(), tickReadCost);
+    out += "# HELP macsfancontrol_slow_sensors Sensors demoted to the slow polling class\n";
+    out += "# TYPE macsfancontrol_slow_sensors gauge\n";
+    out += "macsfancontrol_slow_sensors " + QByteArray::number(readProfiler.slowCount()) + "\n";
+
+    QByteArray cache = discovery.warm ? "warm" : "cold";
+    out += "# HELP macsfancontrol_startup_seconds Hardware discovery and startup milestones\n";
+    out += "# TYPE macsfancontrol_startup_seconds gauge\n";
+    out += "macsfancontrol_startup_seconds{stage=\"discovery\",cache=\"" + cache + "\"} "
+           + QByteArray::number(discovery.elapsedNs / 1.0e9) + "\n";
+    out += "macsfancontrol_startup_seconds{stage=\"first_paint\",cache=\"" + cache + "\"} "
+           + QByteArray::number(firstPaintMs / 1000.0) + "\n";
+    out += "macsfancontrol_startup_seconds{stage=\"first_sample\",cache=\"" + cache + "\"} "
+           + QByteArray::number(firstSampleMs / 1000.0) + "\n";
+    out += "macsfancontrol_startup_seconds{stage=\"full_topology\",cache=\"" + cache + "\"} "
+           + QByteArray::number(topologyMs / 1000.0) + "\n";
+    return out;
+}
+
+QString MainWindow::fanWriteSummary() const
+{
+    quint64 written = 0;
+    quint64 avoided = 0;
+    for (const FanWriteStats& stats : fanWriteStats) {
+        written += stats.written;
+        avoided += stats.avoided;
+    }
+
+    double hours = qMax(uptimeTimer.elapsed(), qint64(1000)) / 3600000.0;
+    return QString("Fan writes: %1/h, avoided: %2/h")
+        .arg(written / hours, 0, 'f', 0)
+        .arg(avoided / hours, 0, 'f', 0);
+}
+
+void MainWindow::showError(const QString& message)
+{
+    // Show error in status bar
+    statusBar()->showMessage("Error: " + message, 5000);
+
+    // Log to stderr
+    qWarning() << "SMC Error:" << message;
+
+    // For critical permission errors, show dialog
+    if (message.contains("permission", Qt::CaseInsensitive) ||
+        message.contains("root", Qt::CaseInsensitive)) {
+        QMessageBox::critical(this, "Permission Error",
+                            "Cannot write to SMC interface.\n\n" + message +
+                            "\n\nPlease run with: sudo macsfancontrol");
+    }
+}
+
+void MainWindow::showWarning(const QString& message)
+{
+    // Show warning in status bar
+    statusBar()->showMessage("Warning: " + message, 3000);
+
+    // Log to stderr
+    qWarning() << "SMC Warning:" << message;
+}
+
+void MainWindow::copyDebugLogToClipboard()
+{
+    // Forward declaration — defined in main.cpp
     extern QStringList getDebugLog();
 
     QStringList lines;
     lines << "=== Mac Fan Control Debug Log ===";
     lines << QString("Timestamp: %1").arg(QDateTime::currentDateTime().toString(Qt::ISODate));
     lines << QString("Mac Model:  %1").arg(smcInterface->getMacModel());
+    lines << QString("Startup:    discovery %1 ms (%2), first paint after %3 ms, "
+                     "first sample after %4 ms, full topology after %5 ms")
+                 .arg(discovery.elapsedNs / 1.0e6, 0, 'f', 1)
+                 .arg(discovery.warm ? "cached manifest" : "full scan")
+                 .arg(firstPaintMs, 0, 'f', 1)
+                 .arg(firstSampleMs, 0, 'f', 1)
+                 .arg(topologyMs, 0, 'f', 1);
     lines << "";
 
     // SMC fans
@@ -392,11 +1052,12 @@ void MainWindow::copyDebugLogToClipboard()
     lines << "";
     lines << "--- HWMon Fans ---";
     for (const HWMonFan& fan : hwmonInterface->getFans()) {
-        lines << QString("  %1/%2: %3 RPM  [min:%4  max:%5  manual:%6]  path:%7")
+        lines << QString("  %1/%2: %3 RPM  [min:%4  max:%5  manual:%6]  path:%7  calibration:%8")
                      .arg(fan.deviceName).arg(fan.label).arg(fan.currentRPM)
                      .arg(fan.minRPM).arg(fan.maxRPM)
                      .arg(fan.isManual ? "yes" : "no")
-                     .arg(fan.devicePath);
+                     .arg(fan.devicePath)
+                     .arg(fan.calibration.isValid() ? fan.calibration.toString() : QString("none"));
     }
 
     // SMC temperatures (live read)
@@ -413,11 +1074,227 @@ void MainWindow::copyDebugLogToClipboard()
     lines << "";
     lines << "--- HWMon Temperatures ---";
     for (const HWMonSensor& sensor : hwmonInterface->getTemperatures()) {
-        lines << QString("  %1/%2: %3 °C  (%4)")
+        lines << QString("  %1/%2: %3 °C  (%4)%5")
                      .arg(sensor.deviceName).arg(sensor.label, -20)
                      .arg(sensor.temperature / 1000.0, 5, 'f', 1)
-                     .arg(sensor.devicePath);
+                     .arg(sensor.devicePath)
+                     .arg(sensor.stale ? "  STALE" : "");
+    }
+
+    // Per-device async readers
+    lines << "";
+    lines << "--- HWMon Readers ---";
+    if (!hwmonInterface->hasAsyncReads()) {
+        lines << "  (synchronous reads)";
+    }
+    for (const HWMonReaderStatus& status : hwmonInterface->getReaderStatus()) {
+        lines << QString("  %1: answered=%2  missed=%3  last read=%4 ms%5")
+                     .arg(status.devicePath).arg(status.answered).arg(status.missed)
+                     .arg(status.lastReadNs / 1.0e6, 0, 'f', 2)
+                     .arg(status.busy ? "  BUSY" : "");
+    }
+
+    // Read cost per tick, per driver and for the most expensive attributes
+    lines << "";
+    lines << "--- Sensor Read Cost ---";
+    lines << readProfiler.summaryLines(15);
+
+    // Virtual sensors (evaluated from the live readings above)
+    lines << "";
+    lines << "--- Virtual Sensors ---";
+    if (virtualSensors.count() == 0) {
+        lines << "  (none)";
+    } else {
+        QVector<TempSensor> temps = sensorPipeline.readHardware();
+        virtualSensors.evaluate(temps);
+        QVector<TempSensor> derived;
+        virtualSensors.appendTo(derived);
+        const QVector<VirtualSensorProgram>& programs = virtualSensors.getPrograms();
+        for (int i = 0; i < programs.size(); i++) {
+            lines << QString("  %1: %2 °C  = %3  [%4 instructions]")
+                         .arg(programs[i].name)
+                         .arg(derived[i].temperature / 1000.0, 5, 'f', 1)
+                         .arg(programs[i].expression)
+                         .arg(programs[i].code.size());
+        }
+    }
+
+    // Noise filters and write statistics
+    lines << "";
+    lines << "--- Sensor Filters ---";
+    lines << QString("  default: %1").arg(sensorFilters.getDefaultSpec().toString());
+    QMap<QString, SensorFilterSpec> filterSpecs = sensorFilters.getSpecs();
+    for (auto it = filterSpecs.constBegin(); it != filterSpecs.constEnd(); ++it) {
+        lines << QString("  %1: %2").arg(it.key()).arg(it.value().toString());
+    }
+
+    lines << "";
+    lines << "--- Fan Write Statistics ---";
+    lines << QString("  %1  (over %2 min)").arg(fanWriteSummary())
+                 .arg(uptimeTimer.elapsed() / 60000.0, 0, 'f', 1);
+    for (int i = 0; i < fanWriteStats.size(); i++) {
+        const FanController& controller = fanWidgets[i]->getController();
+        lines << QString("  Fan%1: written=%2  avoided=%3  controller updates=%4 held=%5  hysteresis=%6°C"
+                         "  lead=%7s cpuBoost=%8°C slope=%9°C/s")
+                     .arg(i).arg(fanWriteStats[i].written).arg(fanWriteStats[i].avoided)
+                     .arg(controller.getUpdateCount()).arg(controller.getHeldCount())
+                     .arg(fanWidgets[i]->getHysteresis(), 0, 'f', 1)
+                     .arg(controller.getFeedForwardLead(), 0, 'f', 0)
+                     .arg(controller.getCpuLoadBoost(), 0, 'f', 0)
+                     .arg(controller.getSlope(), 0, 'f', 2);
+    }
+
+    lines << "";
+    lines << "--- RPM Tracking ---";
+    QVector<RpmTrackingStatus> tracking = fanSampler->getStatus();
+    bool anyTracked = false;
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        if (samplerFanIds[i] < 0) {
+            continue;
+        }
+        anyTracked = true;
+        const RpmTrackingStatus& status = tracking[samplerFanIds[i]];
+        if (!status.active) {
+            lines << QString("  Fan%1: idle").arg(i);
+            continue;
+        }
+        lines << QString("  Fan%1: target=%2%3 measured=%4 pwm=%5 error=%6 (mean |error| %7)  "
+                         "converged=%8 in %9 ms (max %10 ms)")
+                     .arg(i).arg(status.targetRPM)
+                     .arg(status.unreachable ? QString(" (below the lowest running speed)") : QString())
+                     .arg(status.measuredRPM).arg(status.pwm)
+                     .arg(status.errorRPM).arg(status.meanAbsError, 0, 'f', 0)
+                     .arg(status.converged ? "yes" : "no")
+                     .arg(status.lastConvergenceMs).arg(status.maxConvergenceMs);
+    }
+    if (!anyTracked) {
+        lines << "  (no PWM fans)";
+    } else {
+        lines << QString("  sampler interval: %1 ms").arg(fanSampler->getIntervalMs());
+    }
+    LatencyHistogram jitter = fanSampler->getTickJitter();
+    QString scheduling = fanSampler->getRealtimeState();
+    lines << QString("  sampler scheduling: %1, tick jitter p50=%2 ms  p99=%3 ms  max=%4 ms")
+                 .arg(scheduling.isEmpty() ? QString("QTimer") : "timerfd, " + scheduling)
+                 .arg(jitter.percentile(0.50) / 1.0e6, 0, 'f', 3)
+                 .arg(jitter.percentile(0.99) / 1.0e6, 0, 'f', 3)
+                 .arg(jitter.max() / 1.0e6, 0, 'f', 3);
+    lines << QString("  control tick (GUI thread, not realtime): jitter p50=%1 ms  p99=%2 ms  max=%3 ms")
+                 .arg(controlTickJitter.percentile(0.50) / 1.0e6, 0, 'f', 3)
+                 .arg(controlTickJitter.percentile(0.99) / 1.0e6, 0, 'f', 3)
+                 .arg(controlTickJitter.max() / 1.0e6, 0, 'f', 3);
+
+    lines << "";
+    lines << "--- Watchdog ---";
+    if (watchdog.isRunning()) {
+        lines << QString("  pid %1, timeout %2 ms, %3 fans, action %4")
+                     .arg(watchdog.getPid()).arg(watchdog.getTimeoutMs()).arg(watchdog.getFanCount())
+                     .arg(watchdog.getAction() == FanWatchdog::ACTION_MAX ? "max" : "auto");
+    } else {
+        lines << "  (not running)";
+    }
+
+    lines << "";
+    lines << "--- Fan Zones ---";
+    if (fanZones.count() == 0) {
+        lines << "  (none)";
+    }
+    for (const FanZone& zone : fanZones.getZones()) {
+        QStringList members;
+        for (const FanZoneMember& member : zone.members) {
+            members << QString("fan %1 (%2%, %3%4 RPM)").arg(member.fan + 1).arg(member.scale)
+                           .arg(member.offset >= 0 ? "+" : "").arg(member.offset);
+        }
+        lines << QString("  %1: %2").arg(zone.name, members.join(", "));
+    }
+
+    lines << "";
+    lines << "--- Acoustic Optimizer ---";
+    const InfluenceModel& model = optimizer.getModel();
+    if (identifier.isRunning()) {
+        lines << QString("  identification running: fan %1 of %2, %3 sensors")
+                     .arg(identifier.getCurrentFan() + 1).arg(identifier.getLayout().fanCount())
+                     .arg(identifier.getLayout().sensorCount());
+    }
+    if (!model.isValid()) {
+        lines << "  (no influence model)";
+    } else {
+        QString status = !optimizerEnabled ? "off"
+                         : predictiveEnabled ? QString("predictive, %1 s horizon").arg(predictive.getHorizon())
+                                             : QString("on");
+        if (optimizerEnabled && !optimizerFeasible) {
+            status += ", limits out of reach";
+        }
+        lines << QString("  %1, model of %2: %3 fans, %4 sensors, margin %5 °C")
+                     .arg(status)
+                     .arg(model.machine).arg(model.fanCount()).arg(model.sensorCount())
+                     .arg(optimizer.getMargin());
+        const QVector<OptimizerLimit>& limits = optimizer.getLimits();
+        for (int l = 0; l < limits.size(); l++) {
+            QString line = QString("  %1 <= %2 °C").arg(model.sensors[limits[l].sensor]).arg(limits[l].limit);
+            if (predictiveEnabled && predictiveSolveCost.count() > 0) {
+                line += QString(", predicted %1 °C").arg(predictive.getPredicted(l), 0, 'f', 1);
+            }
+            lines << line;
+        }
+        for (int f = 0; f < model.fanCount(); f++) {
+            int fan = optimizerFans.value(f, -1);
+            lines << QString("  %1: weight %2, %3").arg(model.fans[f]).arg(optimizer.getNoiseWeights()[f])
+                         .arg(fan >= 0 ? QString("fan %1").arg(fan + 1) : QString("not controlled"));
+        }
+        if (optimizerSolveCost.count() > 0) {
+            lines << QString("  solve p50=%1 us  p99=%2 us  max=%3 us")
+                         .arg(optimizerSolveCost.percentile(0.50) / 1.0e3, 0, 'f', 1)
+                         .arg(optimizerSolveCost.percentile(0.99) / 1.0e3, 0, 'f', 1)
+                         .arg(optimizerSolveCost.max() / 1.0e3, 0, 'f', 1);
+        }
+        if (predictiveSolveCost.count() > 0) {
+            lines << QString("  plan p50=%1 us  p99=%2 us  max=%3 us, last %4 sweeps")
+                         .arg(predictiveSolveCost.percentile(0.50) / 1.0e3, 0, 'f', 1)
+                         .arg(predictiveSolveCost.percentile(0.99) / 1.0e3, 0, 'f', 1)
+                         .arg(predictiveSolveCost.max() / 1.0e3, 0, 'f', 1)
+                         .arg(predictive.getLastSweeps());
+        }
+    }
+
+    lines << "";
+    lines << "--- Critical Sensors ---";
+    if (criticalSensors.isEmpty()) {
+        lines << "  (none)";
+    }
+    for (const CriticalSensor& sensor : criticalSensors) {
+        lines << QString("  %1: limit %2 °C, release %3 °C")
+                     .arg(sensor.label).arg(sensor.limit / 1000.0, 0, 'f', 1)
+                     .arg(sensor.release / 1000.0, 0, 'f', 1);
+    }
+    if (criticalGuard->isRunning()) {
+        LatencyHistogram tripLatency = criticalGuard->getTripLatency();
+        LatencyHistogram tickCost = criticalGuard->getTickCost();
+        lines << QString("  guard: %1 ms interval, %2 sensors, %3 fans, %4, trips=%5")
+                     .arg(criticalGuard->getIntervalMs()).arg(criticalGuard->getSensorCount())
+                     .arg(criticalGuard->getFanCount())
+                     .arg(criticalGuard->isEmergency() ? "EMERGENCY (" + criticalGuard->getTrippedLabel() + ")"
+                                                       : QString("normal"))
+                     .arg(criticalGuard->getTripCount());
+        lines << QString("  crossing to fan write max=%1 ms, tick p50=%2 us  max=%3 us")
+                     .arg(tripLatency.max() / 1.0e6, 0, 'f', 3)
+                     .arg(tickCost.percentile(0.50) / 1.0e3, 0, 'f', 1)
+                     .arg(tickCost.max() / 1.0e3, 0, 'f', 1);
+    } else if (!criticalSensors.isEmpty()) {
+        lines << "  guard: not running";
+    }
+
+    lines << "";
+    lines << "--- Tick Latency ---";
+    QStringList latencyLines = tickLatency.summaryLines();
+    if (latencyLines.isEmpty()) {
+        lines << "  (no samples yet)";
+    } else {
+        lines << latencyLines;
     }
+    lines << QString("  Metrics endpoint: %1").arg(metricsServer->socketPath().isEmpty()
+                                                    ? QString("not listening")
+                                                    : metricsServer->socketPath());
 
     // Saved presets
     lines << "";
@@ -482,12 +1359,13 @@ void MainWindow::copyDebugLogToClipboard()
 
     // --- hwmon devices ---
     lines << "";
-    lines << "--- /sys/class/hwmon ---";
-    QDir hwmonDir("/sys/class/hwmon");
+    QString hwmonRoot = hwmonInterface->getSysfsRoot() + "/sys/class/hwmon";
+    lines << "--- " + hwmonRoot + " ---";
+    QDir hwmonDir(hwmonRoot);
     if (hwmonDir.exists()) {
         QStringList hwmonDevs = hwmonDir.entryList(QStringList() << "hwmon*", QDir::Dirs, QDir::Name);
         for (const QString& dev : hwmonDevs) {
-            QString devPath = "/sys/class/hwmon/" + dev;
+            QString devPath = hwmonRoot + "/" + dev;
             QString name = readSysfsValue(devPath + "/name");
             bool isTempDup = HWMonInterface::smcDuplicateDevices.contains(name);
 
@@ -557,16 +1435,7 @@ void MainWindow::copyDebugLogToClipboard()
 void MainWindow::restoreAutoMode()
 {
     // Restore all fans to automatic mode
-    for (int i = 0; i < fanWidgets.size(); i++) {
-        FanSource source = fanSources[i];
-        int sourceIndex = fanSourceIndices[i];
-
-        if (source == FAN_SOURCE_SMC) {
-            smcInterface->setFanManualMode(sourceIndex, false);
-        } else if (source == FAN_SOURCE_HWMON) {
-            hwmonInterface->setFanManualMode(sourceIndex, false);
-        }
-    }
+    fanBackends.setAllManual(false);
 }
 
 void MainWindow::onManualModeRequested(int fanWidgetIndex, bool enable)
@@ -575,13 +1444,25 @@ void MainWindow::onManualModeRequested(int fanWidgetIndex, bool enable)
         return;
     }
 
-    FanSource source = fanSources[fanWidgetIndex];
-    int sourceIndex = fanSourceIndices[fanWidgetIndex];
+    // A zone's lead switches every fan of the zone
+    QVector<int> followers = fanZones.getFollowers(fanWidgetIndex);
+    for (int follower : followers) {
+        fanWidgets[follower]->setMode(fanWidgets[fanWidgetIndex]->getCurrentMode());
+    }
+
+    // The critical sensor guard holds every fan at maximum until it hands back
+    if (criticalGuard->isEmergency()) {
+        return;
+    }
+
+    followers.prepend(fanWidgetIndex);
+    for (int fan : followers) {
+        fanBackends.setManual(fan, enable);
 
-    if (source == FAN_SOURCE_SMC) {
-        smcInterface->setFanManualMode(sourceIndex, enable);
-    } else if (source == FAN_SOURCE_HWMON) {
-        hwmonInterface->setFanManualMode(sourceIndex, enable);
+        // Back in firmware control: stop trimming the PWM value
+        if (!enable && samplerFanIds[fan] >= 0) {
+            fanSampler->clearTarget(samplerFanIds[fan]);
+        }
     }
 }
 
@@ -591,14 +1472,67 @@ void MainWindow::onTargetRPMChanged(int fanWidgetIndex, int rpm)
         return;
     }
 
-    FanSource source = fanSources[fanWidgetIndex];
-    int sourceIndex = fanSourceIndices[fanWidgetIndex];
+    if (criticalGuard->isEmergency()) {
+        return;
+    }
+
+    // Called synchronously from the controller when a tick decides on a new
+    // target. A zone's lead decides for every fan of the zone: the targets
+    // are queued together and written as one batch, per backend, at the end
+    // of the tick or right away outside one.
+    qint64 decided = monotonicNs();
+    FanSpeedWrite write = {fanWidgetIndex, rpm, decided, 0, false};
+    pendingWrites.append(write);
+    for (int follower : fanZones.getFollowers(fanWidgetIndex)) {
+        FanSpeedWrite followerWrite = {follower, fanZones.followerTarget(follower, rpm), decided, 0, false};
+        fanWidgets[follower]->setTargetRPM(followerWrite.rpm);
+        pendingWrites.append(followerWrite);
+    }
+
+    if (tickSampleStart < 0) {
+        flushFanWrites();
+    }
+}
+
+void MainWindow::flushFanWrites()
+{
+    // The guard may have tripped since the targets were decided
+    if (pendingWrites.isEmpty() || criticalGuard->isEmergency()) {
+        pendingWrites.clear();
+        return;
+    }
 
-    if (source == FAN_SOURCE_SMC) {
-        smcInterface->setFanSpeed(sourceIndex, rpm);
-    } else if (source == FAN_SOURCE_HWMON) {
-        hwmonInterface->setFanSpeed(sourceIndex, rpm);
+    bool inTick = tickSampleStart >= 0;
+    fanBackends.setSpeeds(&pendingWrites);
+    for (const FanSpeedWrite& write : pendingWrites) {
+        int fan = write.fan;
+        if (inTick) {
+            tickLatency.recordDecision(fan, tickSampleEnd, write.decidedNs);
+        }
+        // A failed write left the fan as it was: not counted, tracked or
+        // traced, and whoever decided it forgets it so the next tick retries
+        if (!write.ok) {
+            fanWidgets[fanZones.getLead(fan)]->resetController();
+            if (fan < optimizerTargets.size()) {
+                optimizerTargets[fan] = -1;
+            }
+            if (fan < identifyWritten.size()) {
+                identifyWritten[fan] = -1;
+            }
+            continue;
+        }
+        // The PWM value is an open-loop guess; the sampler trims it from here
+        if (samplerFanIds[fan] >= 0) {
+            fanSampler->setTarget(samplerFanIds[fan], write.rpm, fanBackends.getPWM(fan));
+        }
+        fanWriteStats[fan].written++;
+        if (inTick) {
+            tickLatency.recordWrite(fan, fanBackends.getLatencyBackend(fan),
+                                    tickSampleStart, write.decidedNs, write.committedNs);
+            traceWriter.recordWrite(tickTimestamp, fan, write.rpm);
+        }
     }
+    pendingWrites.clear();
 }
 
 void MainWindow::onSensorBasedModeChanged(int fanWidgetIndex, bool enable, int sensorIndex, int minTemp, int maxTemp)
@@ -623,20 +1557,8 @@ void MainWindow::onSensorBasedModeChanged(int fanWidgetIndex, bool enable, int s
 
 void MainWindow::updateSensorListInFanWidgets()
 {
-    // Get current temperature sensors from both sources
-    QVector<TempSensor> smcTemps = smcInterface->getTemperatures();
-    QVector<HWMonSensor> hwmonSensors = hwmonInterface->getTemperatures();
-
-    // Convert hwmon sensors to TempSensor format
-    QVector<TempSensor> temps = smcTemps;
-    for (const HWMonSensor& hwSensor : hwmonSensors) {
-        TempSensor sensor;
-        sensor.index = hwSensor.index;
-        sensor.label = hwSensor.label;
-        sensor.temperature = hwSensor.temperature;
-        sensor.sysfsPath = hwSensor.devicePath;
-        temps.append(sensor);
-    }
+    // Get current temperature sensors from both sources plus derived channels
+    QVector<TempSensor> temps = sensorPipeline.catalog();
 
     // Update sensor list in each fan widget
     for (FanControlWidget* fanWidget : fanWidgets) {
@@ -655,16 +1577,72 @@ void MainWindow::saveSettings()
         settings.beginGroup(QString("Fan%1").arg(i));
         settings.setValue("mode", static_cast<int>(fanWidgets[i]->getCurrentMode()));
         settings.setValue("targetRPM", fanWidgets[i]->getTargetRPM());
+        settings.setValue("fanId", fanIdentity(i));
         settings.setValue("sensorIndex", fanWidgets[i]->getSelectedSensorIndex());
+        settings.setValue("sensorLabel", fanWidgets[i]->getSelectedSensorLabel());
         settings.setValue("minTemp", fanWidgets[i]->getMinTemp());
         settings.setValue("maxTemp", fanWidgets[i]->getMaxTemp());
+        settings.setValue("hysteresis", fanWidgets[i]->getHysteresis());
+        settings.setValue("feedForwardLead", fanWidgets[i]->getFeedForwardLead());
+        settings.setValue("cpuLoadBoost", fanWidgets[i]->getCpuLoadBoost());
         settings.endGroup();
     }
+    saveFanZones(settings);
 
     settings.endGroup();
     qDebug() << "Settings saved";
 }
 
+QString MainWindow::fanIdentity(int fan) const
+{
+    int index = fanBackends.getSourceIndex(fan);
+    if (fanBackends.getSource(fan) == FAN_SOURCE_SMC) {
+        return "applesmc/" + QFileInfo(smcInterface->getFans().value(index).sysfsPath).fileName();
+    }
+    HWMonFan hwFan = hwmonInterface->getFans().value(index);
+    return QString("%1/fan%2").arg(DiscoveryManifest::deviceIdentity(hwFan.devicePath)).arg(hwFan.fanNumber);
+}
+
+// Widget index for each FanN group of the session or preset group being
+// read. Saves without identities, or whose fans are not all present once
+// each, map by position.
+QVector<int> MainWindow::savedFanOrder(QSettings& settings) const
+{
+    QHash<QString, int> widgets;
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        widgets.insert(fanIdentity(i), i);
+    }
+
+    QVector<int> order;
+    QSet<int> used;
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        int fan = widgets.value(settings.value(QString("Fan%1/fanId").arg(i)).toString(), -1);
+        if (fan < 0 || used.contains(fan)) {
+            order.clear();
+            break;
+        }
+        order.append(fan);
+        used.insert(fan);
+    }
+    if (order.isEmpty()) {
+        for (int i = 0; i < fanWidgets.size(); i++) {
+            order.append(i);
+        }
+    }
+    return order;
+}
+
+QHash<QString, int> MainWindow::sensorIndicesByLabel()
+{
+    QHash<QString, int> indices;
+    for (const TempSensor& sensor : sensorPipeline.catalog()) {
+        if (!indices.contains(sensor.label)) {
+            indices.insert(sensor.label, sensor.index);
+        }
+    }
+    return indices;
+}
+
 void MainWindow::loadSettings()
 {
     QSettings settings("macsfancontrol", "macsfancontrol-qt");
@@ -678,19 +1656,30 @@ void MainWindow::loadSettings()
         return;
     }
 
+    QVector<int> fanOrder = savedFanOrder(settings);
+    QHash<QString, int> sensorIndices = sensorIndicesByLabel();
     for (int i = 0; i < fanWidgets.size(); i++) {
         settings.beginGroup(QString("Fan%1").arg(i));
 
+        int fan = fanOrder[i];
         FanMode mode = static_cast<FanMode>(settings.value("mode", MODE_AUTO).toInt());
         int targetRPM = settings.value("targetRPM", 2000).toInt();
         int sensorIndex = settings.value("sensorIndex", -1).toInt();
+        QString sensorLabel = settings.value("sensorLabel").toString();
+        if (!sensorLabel.isEmpty()) {
+            sensorIndex = sensorIndices.value(sensorLabel, -1);
+        }
         int minTemp = settings.value("minTemp", 40).toInt();
         int maxTemp = settings.value("maxTemp", 80).toInt();
 
-        applyFanSettings(i, mode, targetRPM, sensorIndex, minTemp, maxTemp);
+        fanWidgets[fan]->setHysteresis(settings.value("hysteresis", 2.0).toDouble());
+        fanWidgets[fan]->setFeedForward(settings.value("feedForwardLead", 0.0).toDouble(),
+                                        settings.value("cpuLoadBoost", 0).toInt());
+        applyFanSettings(fan, mode, targetRPM, sensorIndex, minTemp, maxTemp);
 
         settings.endGroup();
     }
+    loadFanZones(settings, fanOrder);
 
     settings.endGroup();
     qDebug() << "Settings loaded";
@@ -708,11 +1697,17 @@ void MainWindow::savePresetToSettings(const QString& presetName)
         settings.beginGroup(QString("Fan%1").arg(i));
         settings.setValue("mode", static_cast<int>(fanWidgets[i]->getCurrentMode()));
         settings.setValue("targetRPM", fanWidgets[i]->getTargetRPM());
+        settings.setValue("fanId", fanIdentity(i));
         settings.setValue("sensorIndex", fanWidgets[i]->getSelectedSensorIndex());
+        settings.setValue("sensorLabel", fanWidgets[i]->getSelectedSensorLabel());
         settings.setValue("minTemp", fanWidgets[i]->getMinTemp());
         settings.setValue("maxTemp", fanWidgets[i]->getMaxTemp());
+        settings.setValue("hysteresis", fanWidgets[i]->getHysteresis());
+        settings.setValue("feedForwardLead", fanWidgets[i]->getFeedForwardLead());
+        settings.setValue("cpuLoadBoost", fanWidgets[i]->getCpuLoadBoost());
         settings.endGroup();
     }
+    saveFanZones(settings);
 
     settings.endGroup();
     settings.endGroup();
@@ -735,19 +1730,30 @@ void MainWindow::loadPresetFromSettings(const QString& presetName)
         return;
     }
 
+    QVector<int> fanOrder = savedFanOrder(settings);
+    QHash<QString, int> sensorIndices = sensorIndicesByLabel();
     for (int i = 0; i < fanWidgets.size(); i++) {
         settings.beginGroup(QString("Fan%1").arg(i));
 
+        int fan = fanOrder[i];
         FanMode mode = static_cast<FanMode>(settings.value("mode", MODE_AUTO).toInt());
         int targetRPM = settings.value("targetRPM", 2000).toInt();
         int sensorIndex = settings.value("sensorIndex", -1).toInt();
+        QString sensorLabel = settings.value("sensorLabel").toString();
+        if (!sensorLabel.isEmpty()) {
+            sensorIndex = sensorIndices.value(sensorLabel, -1);
+        }
         int minTemp = settings.value("minTemp", 40).toInt();
         int maxTemp = settings.value("maxTemp", 80).toInt();
 
-        applyFanSettings(i, mode, targetRPM, sensorIndex, minTemp, maxTemp);
+        fanWidgets[fan]->setHysteresis(settings.value("hysteresis", 2.0).toDouble());
+        fanWidgets[fan]->setFeedForward(settings.value("feedForwardLead", 0.0).toDouble(),
+                                        settings.value("cpuLoadBoost", 0).toInt());
+        applyFanSettings(fan, mode, targetRPM, sensorIndex, minTemp, maxTemp);
 
         settings.endGroup();
     }
+    loadFanZones(settings, fanOrder);
 
     settings.endGroup();
     settings.endGroup();
@@ -760,9 +1766,6 @@ void MainWindow::applyFanSettings(int fanIndex, FanMode mode, int targetRPM, int
         return;
     }
 
-    FanSource source = fanSources[fanIndex];
-    int sourceIndex = fanSourceIndices[fanIndex];
-
     // Apply settings to widget
     fanWidgets[fanIndex]->setMode(mode);
     fanWidgets[fanIndex]->setTargetRPM(targetRPM);
@@ -770,8 +1773,8 @@ void MainWindow::applyFanSettings(int fanIndex, FanMode mode, int targetRPM, int
     if (mode == MODE_SENSOR_BASED) {
         fanWidgets[fanIndex]->setSensorBasedSettings(sensorIndex, minTemp, maxTemp);
 
-        // Update sensor-based settings
-        sensorSettings[fanIndex].enabled = true;
+        // Update sensor-based settings; a zone follower has its lead's controller
+        sensorSettings[fanIndex].enabled = !fanZones.isFollower(fanIndex);
         sensorSettings[fanIndex].sensorIndex = sensorIndex;
         sensorSettings[fanIndex].minTemp = minTemp;
         sensorSettings[fanIndex].maxTemp = maxTemp;
@@ -779,27 +1782,16 @@ void MainWindow::applyFanSettings(int fanIndex, FanMode mode, int targetRPM, int
         sensorSettings[fanIndex].enabled = false;
     }
 
-    // Apply to the correct interface
-    if (mode == MODE_AUTO) {
-        if (source == FAN_SOURCE_SMC) {
-            smcInterface->setFanManualMode(sourceIndex, false);
-        } else if (source == FAN_SOURCE_HWMON) {
-            hwmonInterface->setFanManualMode(sourceIndex, false);
-        }
-    } else if (mode == MODE_MANUAL) {
-        if (source == FAN_SOURCE_SMC) {
-            smcInterface->setFanManualMode(sourceIndex, true);
-            smcInterface->setFanSpeed(sourceIndex, targetRPM);
-        } else if (source == FAN_SOURCE_HWMON) {
-            hwmonInterface->setFanManualMode(sourceIndex, true);
-            hwmonInterface->setFanSpeed(sourceIndex, targetRPM);
-        }
-    } else if (mode == MODE_SENSOR_BASED) {
-        if (source == FAN_SOURCE_SMC) {
-            smcInterface->setFanManualMode(sourceIndex, true);
-        } else if (source == FAN_SOURCE_HWMON) {
-            hwmonInterface->setFanManualMode(sourceIndex, true);
-        }
+    // The widget shows the new mode; fans follow once an emergency is over
+    if (criticalGuard->isEmergency()) {
+        return;
+    }
+
+    // Through the same paths as the widget's own changes, so the sampler
+    // tracks a manual target and lets go of a fan back in auto
+    onManualModeRequested(fanIndex, mode != MODE_AUTO);
+    if (mode == MODE_MANUAL) {
+        onTargetRPMChanged(fanIndex, targetRPM);
     }
 }
 
@@ -873,3 +1865,1337 @@ void MainWindow::deletePreset()
         }
     }
 }
+
+void MainWindow::saveVirtualSensors()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    settings.remove("VirtualSensors");
+    settings.beginGroup("VirtualSensors");
+    const QVector<VirtualSensorProgram>& programs = virtualSensors.getPrograms();
+    settings.setValue("count", programs.size());
+
+    for (int i = 0; i < programs.size(); i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        settings.setValue("name", programs[i].name);
+        settings.setValue("expression", programs[i].expression);
+        settings.setValue("index", programs[i].index);
+        settings.endGroup();
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::loadVirtualSensors()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+    QVector<TempSensor> catalog = sensorPipeline.readHardware();
+
+    settings.beginGroup("VirtualSensors");
+    int count = settings.value("count", 0).toInt();
+
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        QString name = settings.value("name").toString();
+        QString expression = settings.value("expression").toString();
+        int index = settings.value("index", -1).toInt();
+        settings.endGroup();
+
+        QString errorMessage;
+        if (virtualSensors.addSensor(name, expression, catalog, index, &errorMessage) < 0) {
+            qWarning() << "Skipping virtual sensor" << name << ":" << errorMessage;
+        }
+    }
+
+    settings.endGroup();
+
+    if (virtualSensors.count() > 0) {
+        updateSensorListInFanWidgets();
+    }
+}
+
+void MainWindow::addVirtualSensor()
+{
+    bool ok;
+    QString name = QInputDialog::getText(this, "Add Virtual Sensor",
+                                         "Sensor name:",
+                                         QLineEdit::Normal,
+                                         "", &ok).trimmed();
+    if (!ok || name.isEmpty()) {
+        return;
+    }
+
+    QString expression = QInputDialog::getText(this, "Add Virtual Sensor",
+                                               "Expression (e.g. max(TC0C..TC7C) - TA0P or avg(drivetemp:*)):",
+                                               QLineEdit::Normal,
+                                               "", &ok).trimmed();
+    if (!ok || expression.isEmpty()) {
+        return;
+    }
+
+    QString errorMessage;
+    if (virtualSensors.addSensor(name, expression, sensorPipeline.readHardware(), -1, &errorMessage) < 0) {
+        QMessageBox::warning(this, "Virtual Sensor Error", errorMessage);
+        return;
+    }
+
+    saveVirtualSensors();
+    traceWriter.recordVirtualSensors(virtualSensors);
+    updateSensorListInFanWidgets();
+    updateSensorData();
+    statusBar()->showMessage(QString("Virtual sensor '%1' added").arg(name), 3000);
+}
+
+void MainWindow::removeVirtualSensor()
+{
+    QStringList names = virtualSensors.names();
+    if (names.isEmpty()) {
+        QMessageBox::information(this, "Remove Virtual Sensor",
+                               "No virtual sensors defined.");
+        return;
+    }
+
+    bool ok;
+    QString name = QInputDialog::getItem(this, "Remove Virtual Sensor",
+                                         "Select virtual sensor to remove:",
+                                         names, 0, false, &ok);
+    if (!ok || name.isEmpty()) {
+        return;
+    }
+
+    int sensorIndex = -1;
+    for (const VirtualSensorProgram& program : virtualSensors.getPrograms()) {
+        if (program.name == name) {
+            sensorIndex = program.index;
+        }
+    }
+
+    virtualSensors.removeSensor(name);
+    saveVirtualSensors();
+    traceWriter.recordVirtualSensors(virtualSensors);
+    tempPanel->removeSensor(sensorIndex);
+    updateSensorListInFanWidgets();
+    statusBar()->showMessage(QString("Virtual sensor '%1' removed").arg(name), 3000);
+}
+
+void MainWindow::saveSensorFilters()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    settings.remove("SensorFilters");
+    settings.beginGroup("SensorFilters");
+    settings.setValue("default", sensorFilters.getDefaultSpec().toString());
+
+    QMap<QString, SensorFilterSpec> specs = sensorFilters.getSpecs();
+    settings.setValue("count", specs.size());
+    int i = 0;
+    for (auto it = specs.constBegin(); it != specs.constEnd(); ++it, ++i) {
+        settings.beginGroup(QString("Filter%1").arg(i));
+        settings.setValue("label", it.key());
+        settings.setValue("spec", it.value().toString());
+        settings.endGroup();
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::loadSensorFilters()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    settings.beginGroup("SensorFilters");
+    sensorFilters.setDefaultSpec(SensorFilterSpec::fromString(settings.value("default", "none").toString()));
+
+    int count = settings.value("count", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Filter%1").arg(i));
+        QString label = settings.value("label").toString();
+        bool ok;
+        SensorFilterSpec spec = SensorFilterSpec::fromString(settings.value("spec").toString(), &ok);
+        if (ok && !label.isEmpty()) {
+            sensorFilters.setSpec(label, spec);
+        } else {
+            qWarning() << "Ignoring invalid sensor filter for" << label;
+        }
+        settings.endGroup();
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::saveCriticalSensors()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    settings.remove("CriticalSensors");
+    settings.beginGroup("CriticalSensors");
+    settings.setValue("count", criticalSensors.size());
+    for (int i = 0; i < criticalSensors.size(); i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        settings.setValue("label", criticalSensors[i].label);
+        settings.setValue("limit", criticalSensors[i].limit / 1000);
+        settings.setValue("release", criticalSensors[i].release / 1000);
+        settings.endGroup();
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::loadCriticalSensors()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    criticalSensors.clear();
+    settings.beginGroup("CriticalSensors");
+    int count = settings.value("count", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Sensor%1").arg(i));
+        CriticalSensor sensor;
+        sensor.label = settings.value("label").toString();
+        sensor.limit = settings.value("limit", 0).toInt() * 1000;
+        sensor.release = settings.value("release", 0).toInt() * 1000;
+        if (!sensor.label.isEmpty() && sensor.limit > 0 && sensor.release < sensor.limit) {
+            criticalSensors.append(sensor);
+        } else {
+            qWarning() << "Ignoring invalid critical sensor" << sensor.label;
+        }
+        settings.endGroup();
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::saveFanZones(QSettings& settings) const
+{
+    // Into the session or preset group being written
+    settings.remove("Zones");
+    settings.beginGroup("Zones");
+    const QVector<FanZone>& zones = fanZones.getZones();
+    settings.setValue("count", zones.size());
+    for (int i = 0; i < zones.size(); i++) {
+        settings.beginGroup(QString("Zone%1").arg(i));
+        settings.setValue("name", zones[i].name);
+        settings.setValue("count", zones[i].members.size());
+        for (int m = 0; m < zones[i].members.size(); m++) {
+            settings.beginGroup(QString("Fan%1").arg(m));
+            settings.setValue("fan", zones[i].members[m].fan);     // Position in the saved FanN groups
+            settings.setValue("scale", zones[i].members[m].scale);
+            settings.setValue("offset", zones[i].members[m].offset);
+            settings.endGroup();
+        }
+        settings.endGroup();
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::loadFanZones(QSettings& settings, const QVector<int>& fanOrder)
+{
+    // A session or preset without zones has every fan on its own
+    QVector<FanZone> zones;
+    settings.beginGroup("Zones");
+    int count = settings.value("count", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Zone%1").arg(i));
+        FanZone zone;
+        zone.name = settings.value("name").toString();
+        int memberCount = settings.value("count", 0).toInt();
+        for (int m = 0; m < memberCount; m++) {
+            settings.beginGroup(QString("Fan%1").arg(m));
+            FanZoneMember member;
+            member.fan = settings.value("fan", -1).toInt();
+            if (member.fan >= 0 && member.fan < fanOrder.size()) {
+                member.fan = fanOrder[member.fan];
+            }
+            member.scale = settings.value("scale", FanZones::DEFAULT_SCALE).toInt();
+            member.offset = settings.value("offset", 0).toInt();
+            zone.members.append(member);
+            settings.endGroup();
+        }
+        zones.append(zone);
+        settings.endGroup();
+    }
+    settings.endGroup();
+
+    QString errorMessage;
+    if (!fanZones.setZones(zones, fanWidgets.size(), &errorMessage)) {
+        qWarning() << "Ignoring saved fan zones:" << errorMessage;
+        fanZones.clear();
+    }
+    applyFanZones();
+}
+
+void MainWindow::applyFanZones()
+{
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        int zone = fanZones.zoneOf(i);
+        if (zone < 0) {
+            fanWidgets[i]->setZone(QString(), QString());
+            // A former follower in sensor mode goes back to its own sensor, if it has one
+            if (fanWidgets[i]->getCurrentMode() == MODE_SENSOR_BASED) {
+                sensorSettings[i].enabled = fanWidgets[i]->getSelectedSensorIndex() >= 0;
+                sensorSettings[i].sensorIndex = fanWidgets[i]->getSelectedSensorIndex();
+            }
+            continue;
+        }
+
+        int lead = fanZones.getLead(i);
+        fanWidgets[i]->setZone(fanZones.getZones()[zone].name,
+                               lead == i ? QString() : fanWidgets[lead]->getLabel());
+        if (lead != i) {
+            sensorSettings[i].enabled = false;
+        }
+    }
+
+    // Followers take on their lead's mode and target
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        if (!fanZones.isLead(i)) {
+            continue;
+        }
+        FanMode mode = fanWidgets[i]->getCurrentMode();
+        onManualModeRequested(i, mode != MODE_AUTO);
+        if (mode == MODE_MANUAL) {
+            onTargetRPMChanged(i, fanWidgets[i]->getTargetRPM());
+        } else if (mode == MODE_SENSOR_BASED) {
+            // The next tick writes a target for the whole zone
+            fanWidgets[i]->resetController();
+        }
+    }
+
+    // A new follower leaves the optimizer; a former one may join it
+    applyOptimizer();
+}
+
+void MainWindow::configureFanZones()
+{
+    if (fanWidgets.isEmpty()) {
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Configure Fan Zones");
+    dialog.resize(600, 400);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+
+    QLabel *help = new QLabel("Fans with the same zone name move together, controlled by the first fan of the zone. "
+                              "The others run at the same position in their own RPM range, times the scale, "
+                              "plus the offset. Leave the zone empty for a fan on its own.", &dialog);
+    help->setWordWrap(true);
+    layout->addWidget(help);
+
+    QTableWidget *table = new QTableWidget(fanWidgets.size(), 4, &dialog);
+    table->setHorizontalHeaderLabels(QStringList() << "Fan" << "Zone" << "Scale" << "Offset");
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    QVector<QSpinBox*> scales;
+    QVector<QSpinBox*> offsets;
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        QTableWidgetItem *fanItem = new QTableWidgetItem(QString("%1 %2").arg(i + 1).arg(fanWidgets[i]->getLabel()));
+        fanItem->setFlags(fanItem->flags() & ~Qt::ItemIsEditable);
+        table->setItem(i, 0, fanItem);
+
+        int zone = fanZones.zoneOf(i);
+        FanZoneMember member = {i, FanZones::DEFAULT_SCALE, 0};
+        if (zone >= 0) {
+            for (const FanZoneMember& existing : fanZones.getZones()[zone].members) {
+                if (existing.fan == i) {
+                    member = existing;
+                }
+            }
+        }
+        table->setItem(i, 1, new QTableWidgetItem(zone >= 0 ? fanZones.getZones()[zone].name : QString()));
+
+        QSpinBox *scale = new QSpinBox(table);
+        scale->setRange(0, 200);
+        scale->setSuffix(" %");
+        scale->setValue(member.scale);
+        table->setCellWidget(i, 2, scale);
+        scales.append(scale);
+
+        QSpinBox *offset = new QSpinBox(table);
+        offset->setRange(-5000, 5000);
+        offset->setSingleStep(100);
+        offset->setSuffix(" RPM");
+        offset->setValue(member.offset);
+        table->setCellWidget(i, 3, offset);
+        offsets.append(offset);
+    }
+    layout->addWidget(table);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    // In fan order, so each zone's first fan leads
+    QVector<FanZone> zones;
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        QString name = table->item(i, 1)->text().trimmed();
+        if (name.isEmpty()) {
+            continue;
+        }
+        int zone = 0;
+        while (zone < zones.size() && zones[zone].name != name) {
+            zone++;
+        }
+        if (zone == zones.size()) {
+            FanZone created;
+            created.name = name;
+            zones.append(created);
+        }
+        FanZoneMember member = {i, scales[i]->value(), offsets[i]->value()};
+        zones[zone].members.append(member);
+    }
+
+    QString errorMessage;
+    if (!fanZones.setZones(zones, fanWidgets.size(), &errorMessage)) {
+        QMessageBox::warning(this, "Fan Zone Error", errorMessage);
+        return;
+    }
+    applyFanZones();
+    statusBar()->showMessage(QString("%1 fan zones configured").arg(zones.size()), 3000);
+}
+
+void MainWindow::loadOptimizer()
+{
+    QString path = InfluenceModel::defaultPath(smcInterface->getMacModel());
+    InfluenceModel model;
+    QString errorMessage;
+    if (!model.load(path, &errorMessage)) {
+        qDebug() << "No influence model, acoustic optimizer unavailable:" << errorMessage;
+        return;
+    }
+    optimizer.setModel(model);
+
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+    settings.beginGroup("Optimizer");
+    optimizer.setMargin(settings.value("margin", AcousticOptimizer::DEFAULT_MARGIN).toDouble());
+
+    // Limits and weights are stored by label and kept only for what the model knows
+    QVector<OptimizerLimit> limits;
+    int count = settings.value("count", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Limit%1").arg(i));
+        QString label = settings.value("sensor").toString();
+        OptimizerLimit limit = {model.findSensor(label), settings.value("limit", 0.0).toDouble()};
+        if (limit.sensor >= 0 && limit.limit > 0.0) {
+            limits.append(limit);
+        } else {
+            qWarning() << "Ignoring optimizer limit on" << label << "- not in the influence model";
+        }
+        settings.endGroup();
+    }
+    optimizer.setLimits(limits);
+
+    QVector<double> weights = optimizer.getNoiseWeights();
+    settings.beginGroup("Weights");
+    for (int f = 0; f < model.fanCount(); f++) {
+        weights[f] = settings.value(model.fans[f], weights[f]).toDouble();
+    }
+    settings.endGroup();
+    optimizer.setNoiseWeights(weights);
+
+    optimizerEnabled = settings.value("enabled", false).toBool() && !limits.isEmpty();
+    predictiveEnabled = settings.value("predictive", false).toBool() && optimizerEnabled;
+    predictive.setHorizon(settings.value("horizon", PredictiveController::DEFAULT_HORIZON).toInt());
+    settings.endGroup();
+
+    qDebug() << "Influence model loaded:" << path << model.fanCount() << "fans," << model.sensorCount() << "sensors";
+    optimizerAction->setEnabled(true);
+    optimizerAction->setChecked(optimizerEnabled && !predictiveEnabled);
+    predictiveAction->setEnabled(true);
+    predictiveAction->setChecked(predictiveEnabled);
+    applyOptimizer();
+}
+
+void MainWindow::saveOptimizer()
+{
+    const InfluenceModel& model = optimizer.getModel();
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    settings.remove("Optimizer");
+    settings.beginGroup("Optimizer");
+    settings.setValue("enabled", optimizerEnabled);
+    settings.setValue("predictive", predictiveEnabled);
+    settings.setValue("horizon", predictive.getHorizon());
+    settings.setValue("margin", optimizer.getMargin());
+    const QVector<OptimizerLimit>& limits = optimizer.getLimits();
+    settings.setValue("count", limits.size());
+    for (int i = 0; i < limits.size(); i++) {
+        settings.beginGroup(QString("Limit%1").arg(i));
+        settings.setValue("sensor", model.sensors[limits[i].sensor]);
+        settings.setValue("limit", limits[i].limit);
+        settings.endGroup();
+    }
+
+    settings.beginGroup("Weights");
+    for (int f = 0; f < model.fanCount(); f++) {
+        settings.setValue(model.fans[f], optimizer.getNoiseWeights()[f]);
+    }
+    settings.endGroup();
+
+    settings.endGroup();
+}
+
+void MainWindow::applyOptimizer()
+{
+    // Model fans are matched to widgets by label; zone followers stay with their lead
+    const InfluenceModel& model = optimizer.getModel();
+    optimizerFans.fill(-1, model.fanCount());
+    for (int f = 0; f < model.fanCount(); f++) {
+        for (int i = 0; i < fanWidgets.size(); i++) {
+            if (fanWidgets[i]->getLabel() == model.fans[f] && !fanZones.isFollower(i)) {
+                optimizerFans[f] = i;
+            }
+        }
+    }
+    optimizerTargets.fill(-1, fanWidgets.size());
+    optimizerSensorIndices.fill(-1, optimizer.getLimits().size());
+    optimizerFeasible = true;
+
+    // The predictive controller plans against the same model and settings,
+    // from a fresh state
+    predictive.setModel(model);
+    predictive.setLimits(optimizer.getLimits());
+    predictive.setNoiseWeights(optimizer.getNoiseWeights());
+    predictive.setMargin(optimizer.getMargin());
+
+    QString owner = predictiveEnabled ? "predictive control" : "acoustic optimizer";
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        bool controlled = isOptimizerFan(i);
+        fanWidgets[i]->setControlledBy(controlled ? owner : QString());
+        if (controlled) {
+            // Targets come from the next tick's solve
+            onManualModeRequested(i, true);
+        }
+    }
+}
+
+void MainWindow::runOptimizer(const QVector<TempSensor>& temps)
+{
+    if (!optimizerEnabled || optimizer.getLimits().isEmpty() || criticalGuard->isEmergency()) {
+        return;
+    }
+
+    const InfluenceModel& model = optimizer.getModel();
+    const QVector<OptimizerLimit>& limits = optimizer.getLimits();
+    optimizerReadings.fill(qQNaN(), limits.size());
+    for (int l = 0; l < limits.size(); l++) {
+        const QString& label = model.sensors[limits[l].sensor];
+        for (const TempSensor& sensor : temps) {
+            if (sensor.label == label) {
+                optimizerReadings[l] = sensor.temperature / 1000.0;
+                optimizerSensorIndices[l] = sensor.index;
+                break;
+            }
+        }
+    }
+    optimizerCurrent.resize(model.fanCount());
+    for (int f = 0; f < model.fanCount(); f++) {
+        int fan = optimizerFans[f];
+        int speed = fan >= 0 ? fanSpeeds.value(fan, -1) : -1;
+        optimizerCurrent[f] = speed >= 0 ? speed : model.minRPM[f];
+    }
+
+    bool feasible;
+    qint64 start = monotonicNs();
+    if (predictiveEnabled) {
+        feasible = predictive.update(optimizerReadings, optimizerCurrent, tickTimestamp, &optimizerSolution);
+        predictiveSolveCost.record(monotonicNs() - start);
+    } else {
+        feasible = optimizer.solve(optimizerReadings, optimizerCurrent, &optimizerSolution);
+        optimizerSolveCost.record(monotonicNs() - start);
+    }
+    if (feasible != optimizerFeasible) {
+        optimizerFeasible = feasible;
+        if (!feasible && predictiveEnabled) {
+            qWarning() << "Predictive control: a sensor is predicted above its limit, cooling fans at maximum";
+        } else if (!feasible) {
+            qWarning() << "Acoustic optimizer: limits out of reach, cooling fans at maximum";
+        }
+    }
+
+    // Queued like any controller's targets, lead and followers together
+    for (int f = 0; f < model.fanCount(); f++) {
+        int fan = optimizerFans[f];
+        if (fan < 0) {
+            continue;
+        }
+        int rpm = optimizerSolution[f];
+        if (optimizerTargets[fan] >= 0 && qAbs(rpm - optimizerTargets[fan]) < AcousticOptimizer::RPM_DEADBAND) {
+            tickLatency.recordDecision(fan, tickSampleEnd, monotonicNs());
+            fanWriteStats[fan].avoided++;
+            continue;
+        }
+        optimizerTargets[fan] = rpm;
+        fanWidgets[fan]->setTargetRPM(rpm);
+        onTargetRPMChanged(fan, rpm);
+    }
+}
+
+void MainWindow::identifyFanInfluence()
+{
+    if (identifier.isRunning() || fanWidgets.isEmpty()) {
+        return;
+    }
+
+    // Every fan with its range, every hardware sensor once by label
+    InfluenceModel layout;
+    layout.machine = smcInterface->getMacModel();
+    for (FanControlWidget *fanWidget : fanWidgets) {
+        layout.fans << fanWidget->getLabel();
+        layout.minRPM << fanWidget->getMinRPM();
+        layout.maxRPM << fanWidget->getMaxRPM();
+    }
+    for (const TempSensor& sensor : sensorPipeline.catalog()) {
+        if (sensor.deviceName != "virtual" && !layout.sensors.contains(sensor.label)) {
+            layout.sensors << sensor.label;
+        }
+    }
+    if (layout.sensors.isEmpty()) {
+        QMessageBox::information(this, "Identify Fan Influence", "No temperature sensors found.");
+        return;
+    }
+
+    InfluenceIdentifier::Options options;
+    int minutes = (layout.fanCount() * (options.settleSeconds + options.stepSeconds) + 59) / 60;
+    QMessageBox::StandardButton answer = QMessageBox::question(this, "Identify Fan Influence",
+        QString("Each of the %1 fans will be stepped up in turn while all %2 sensors are recorded, "
+                "to measure which sensors each fan cools and how fast. The other fans stay at a "
+                "quarter of their range. This takes about %3 minutes.\n\n"
+                "Keep the machine idle meanwhile. Critical sensors stay watched. Continue?")
+            .arg(layout.fanCount()).arg(layout.sensorCount()).arg(minutes),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+    if (answer != QMessageBox::Yes) {
+        return;
+    }
+
+    // The routine drives every fan directly, zone followers included
+    identifier.start(layout, options);
+    identifyStartMs = uptimeTimer.elapsed();
+    identifyWritten.fill(-1, fanWidgets.size());
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        fanWidgets[i]->setControlledBy("influence identification");
+        if (!criticalGuard->isEmergency()) {
+            fanBackends.setManual(i, true);
+        }
+    }
+
+    identifyProgress = new QProgressDialog("Identifying fan influence...", "Cancel", 0,
+                                           identifier.getTotalSeconds(), this);
+    identifyProgress->setWindowModality(Qt::NonModal);
+    identifyProgress->setMinimumDuration(0);
+    identifyProgress->setAutoReset(false);
+    identifyProgress->setAutoClose(false);
+    connect(identifyProgress, &QProgressDialog::canceled, this, [this]() { finishIdentification(false); });
+}
+
+void MainWindow::runIdentification(const QVector<TempSensor>& temps)
+{
+    const InfluenceModel& layout = identifier.getLayout();
+    identifyReadings.fill(qQNaN(), layout.sensorCount());
+    for (const TempSensor& sensor : temps) {
+        int row = layout.findSensor(sensor.label);
+        if (row >= 0 && qIsNaN(identifyReadings[row])) {
+            identifyReadings[row] = sensor.temperature / 1000.0;
+        }
+    }
+
+    double seconds = (tickTimestamp - identifyStartMs) / 1000.0;
+    bool more = identifier.sample(seconds, identifyReadings, &identifyTargets);
+
+    // Only changed targets; the routine holds each one for minutes
+    qint64 decided = monotonicNs();
+    for (int f = 0; f < identifyTargets.size() && f < fanWidgets.size(); f++) {
+        if (identifyTargets[f] == identifyWritten[f]) {
+            continue;
+        }
+        FanSpeedWrite write = {f, identifyTargets[f], decided, 0, false};
+        pendingWrites.append(write);
+        identifyWritten[f] = identifyTargets[f];
+        fanWidgets[f]->setTargetRPM(identifyTargets[f]);
+    }
+
+    if (!more) {
+        finishIdentification(true);
+        return;
+    }
+    if (identifyProgress) {
+        int fan = identifier.getCurrentFan();
+        identifyProgress->setValue(qMin(static_cast<int>(seconds), identifier.getTotalSeconds()));
+        identifyProgress->setLabelText(QString("Stepping %1 (fan %2 of %3)...")
+                                           .arg(layout.fans.value(fan)).arg(fan + 1).arg(layout.fanCount()));
+    }
+}
+
+void MainWindow::finishIdentification(bool completed)
+{
+    if (identifyProgress) {
+        identifyProgress->deleteLater();
+        identifyProgress = nullptr;
+    }
+    identifier.cancel();
+    identifyStartMs = -1;
+
+    // Fans go back to the optimizer or their widgets' modes
+    applyOptimizer();
+    reapplyFanSettings();
+    if (!completed) {
+        statusBar()->showMessage("Fan influence identification cancelled", 5000);
+        return;
+    }
+
+    // Sensors are fitted in parallel on the thread pool
+    statusBar()->showMessage("Fitting fan influence...");
+    InfluenceIdentifier recorded = identifier;
+    QFutureWatcher<InfluenceModel> *watcher = new QFutureWatcher<InfluenceModel>(this);
+    connect(watcher, &QFutureWatcher<InfluenceModel>::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        applyIdentifiedModel(watcher->result());
+    });
+    watcher->setFuture(QtConcurrent::run([recorded]() { return recorded.fit(); }));
+}
+
+void MainWindow::applyIdentifiedModel(const InfluenceModel& model)
+{
+    QString path = InfluenceModel::defaultPath(model.machine);
+    QString errorMessage;
+    if (!model.save(path, &errorMessage)) {
+        QMessageBox::warning(this, "Identify Fan Influence", errorMessage);
+        return;
+    }
+    qDebug() << "Influence model saved:" << path;
+
+    // The optimizer works from the new model right away
+    loadOptimizer();
+
+    // Suggest as each fan's input the sensor it has most say over
+    QVector<TempSensor> catalog = sensorPipeline.catalog();
+    QVector<int> suggested(fanWidgets.size(), -1);
+    QStringList lines;
+    for (int f = 0; f < model.fanCount() && f < fanWidgets.size(); f++) {
+        int affected = 0;
+        for (int s = 0; s < model.sensorCount(); s++) {
+            if (model.getGain(s, f) < 0.0) {
+                affected++;
+            }
+        }
+        int sensor = model.suggestSensor(f);
+        if (sensor < 0) {
+            lines << QString("%1: no measurable effect").arg(model.fans[f]);
+            continue;
+        }
+        lines << QString("%1: cools %2 sensors; follow %3 (%4 °C over its range, %5 s)")
+                     .arg(model.fans[f]).arg(affected).arg(model.sensors[sensor])
+                     .arg(model.getGain(sensor, f), 0, 'f', 1)
+                     .arg(qRound(model.getTimeConstant(sensor, f)));
+        for (const TempSensor& candidate : catalog) {
+            if (candidate.label == model.sensors[sensor]) {
+                suggested[f] = candidate.index;
+                break;
+            }
+        }
+    }
+    statusBar()->showMessage("Fan influence identified", 5000);
+
+    QMessageBox::StandardButton answer = QMessageBox::question(this, "Identify Fan Influence",
+        QString("Influence model saved to %1.\n\n%2\n\n"
+                "Use the suggested sensors as the fans' inputs in sensor-based mode?")
+            .arg(path, lines.join('\n')),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+    if (answer != QMessageBox::Yes) {
+        return;
+    }
+    for (int f = 0; f < suggested.size(); f++) {
+        // A follower's input is its lead's
+        if (suggested[f] >= 0 && !fanZones.isFollower(f)) {
+            fanWidgets[f]->setSensorBasedSettings(suggested[f], fanWidgets[f]->getMinTemp(),
+                                                  fanWidgets[f]->getMaxTemp());
+        }
+    }
+}
+
+void MainWindow::toggleAcousticOptimizer(bool enable)
+{
+    setModelControl(enable, false);
+}
+
+void MainWindow::togglePredictiveControl(bool enable)
+{
+    setModelControl(enable, true);
+}
+
+// The acoustic optimizer and predictive control drive the same fans from
+// the same limits; turning one on switches from the other
+void MainWindow::setModelControl(bool enable, bool predictivePlan)
+{
+    QString name = predictivePlan ? "Predictive control" : "Acoustic optimizer";
+    if (enable && optimizer.getLimits().isEmpty()) {
+        QMessageBox::information(this, name, "Set at least one sensor limit under Optimizer Limits first.");
+        (predictivePlan ? predictiveAction : optimizerAction)->setChecked(false);
+        return;
+    }
+
+    optimizerEnabled = enable;
+    predictiveEnabled = enable && predictivePlan;
+    optimizerAction->setChecked(optimizerEnabled && !predictiveEnabled);
+    predictiveAction->setChecked(predictiveEnabled);
+    applyOptimizer();
+    if (!enable) {
+        // Each fan goes back to what its widget shows
+        reapplyFanSettings();
+    }
+    saveOptimizer();
+    statusBar()->showMessage(name + (enable ? " on" : " off"), 3000);
+}
+
+void MainWindow::configureOptimizerLimits()
+{
+    const InfluenceModel& model = optimizer.getModel();
+    if (!model.isValid()) {
+        QMessageBox::information(this, "Acoustic Optimizer",
+                                 QString("No influence model for this machine. It is read from\n%1")
+                                     .arg(InfluenceModel::defaultPath(smcInterface->getMacModel())));
+        return;
+    }
+
+    bool ok;
+    QString label = QInputDialog::getItem(this, "Optimizer Limits", "Sensor:", model.sensors, 0, false, &ok);
+    if (!ok || label.isEmpty()) {
+        return;
+    }
+
+    int sensor = model.findSensor(label);
+    QVector<OptimizerLimit> limits = optimizer.getLimits();
+    int existing = -1;
+    for (int i = 0; i < limits.size(); i++) {
+        if (limits[i].sensor == sensor) {
+            existing = i;
+        }
+    }
+
+    QString text = QInputDialog::getText(this, "Optimizer Limits",
+                                         QString("Highest temperature of %1 in °C; the optimizer keeps it\n"
+                                                 "%2 °C below this with the quietest fan speeds\n"
+                                                 "(empty to stop limiting this sensor):")
+                                             .arg(label).arg(optimizer.getMargin()),
+                                         QLineEdit::Normal,
+                                         existing >= 0 ? QString::number(limits[existing].limit) : QString(),
+                                         &ok).trimmed();
+    if (!ok) {
+        return;
+    }
+
+    if (text.isEmpty()) {
+        if (existing >= 0) {
+            limits.remove(existing);
+        }
+    } else {
+        bool limitOk = false;
+        OptimizerLimit limit = {sensor, text.toDouble(&limitOk)};
+        if (!limitOk || limit.limit <= 0.0) {
+            QMessageBox::warning(this, "Optimizer Limit Error", QString("Invalid temperature: %1").arg(text));
+            return;
+        }
+        if (existing >= 0) {
+            limits[existing] = limit;
+        } else {
+            limits.append(limit);
+        }
+    }
+
+    optimizer.setLimits(limits);
+    if (limits.isEmpty() && optimizerEnabled) {
+        setModelControl(false, false);
+        return;
+    }
+    applyOptimizer();
+    saveOptimizer();
+    statusBar()->showMessage(QString("Optimizer limit for %1 updated").arg(label), 3000);
+}
+
+void MainWindow::configureOptimizerSettings()
+{
+    const InfluenceModel& model = optimizer.getModel();
+    if (!model.isValid()) {
+        QMessageBox::information(this, "Acoustic Optimizer",
+                                 QString("No influence model for this machine. It is read from\n%1")
+                                     .arg(InfluenceModel::defaultPath(smcInterface->getMacModel())));
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Optimizer Settings");
+    dialog.resize(450, 350);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+
+    QLabel *help = new QLabel("The optimizer keeps every limited sensor the margin below its limit with the "
+                              "least noise. A fan's weight is how much its speed counts as noise: raise it "
+                              "for a fan that is loud or close to you. Predictive control plans the fans "
+                              "over the horizon from how fast each one reaches each sensor.", &dialog);
+    help->setWordWrap(true);
+    layout->addWidget(help);
+
+    QHBoxLayout *marginLayout = new QHBoxLayout();
+    marginLayout->addWidget(new QLabel("Margin:", &dialog));
+    QDoubleSpinBox *margin = new QDoubleSpinBox(&dialog);
+    margin->setRange(0.0, 20.0);
+    margin->setSingleStep(0.5);
+    margin->setSuffix(" °C");
+    margin->setValue(optimizer.getMargin());
+    marginLayout->addWidget(margin);
+    marginLayout->addStretch();
+    layout->addLayout(marginLayout);
+
+    QHBoxLayout *horizonLayout = new QHBoxLayout();
+    horizonLayout->addWidget(new QLabel("Prediction horizon:", &dialog));
+    QSpinBox *horizon = new QSpinBox(&dialog);
+    horizon->setRange(PredictiveController::MIN_HORIZON, PredictiveController::MAX_HORIZON);
+    horizon->setSingleStep(PredictiveController::HORIZON_STEPS);
+    horizon->setSuffix(" s");
+    horizon->setValue(predictive.getHorizon());
+    horizonLayout->addWidget(horizon);
+    horizonLayout->addStretch();
+    layout->addLayout(horizonLayout);
+
+    QTableWidget *table = new QTableWidget(model.fanCount(), 2, &dialog);
+    table->setHorizontalHeaderLabels(QStringList() << "Fan" << "Noise Weight");
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    QVector<QDoubleSpinBox*> weights;
+    for (int f = 0; f < model.fanCount(); f++) {
+        QTableWidgetItem *fanItem = new QTableWidgetItem(optimizerFans.value(f, -1) >= 0
+                                                             ? model.fans[f]
+                                                             : model.fans[f] + " (not controlled)");
+        fanItem->setFlags(fanItem->flags() & ~Qt::ItemIsEditable);
+        table->setItem(f, 0, fanItem);
+
+        QDoubleSpinBox *weight = new QDoubleSpinBox(table);
+        weight->setRange(0.1, 10.0);
+        weight->setSingleStep(0.1);
+        weight->setValue(optimizer.getNoiseWeights()[f]);
+        table->setCellWidget(f, 1, weight);
+        weights.append(weight);
+    }
+    layout->addWidget(table);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    QVector<double> values;
+    for (QDoubleSpinBox *weight : weights) {
+        values.append(weight->value());
+    }
+    optimizer.setNoiseWeights(values);
+    optimizer.setMargin(margin->value());
+    predictive.setNoiseWeights(values);
+    predictive.setMargin(margin->value());
+    predictive.setHorizon(horizon->value());
+    saveOptimizer();
+    statusBar()->showMessage("Optimizer settings updated", 3000);
+}
+
+// Calibrations are stored per device identity, so two chips with the same
+// driver name keep their own tables
+static QString calibrationKey(const QString& device, int fanNumber)
+{
+    return QString("%1/fan%2").arg(device).arg(fanNumber);
+}
+
+static QString calibrationKey(const HWMonFan& fan)
+{
+    return calibrationKey(DiscoveryManifest::deviceIdentity(fan.devicePath), fan.fanNumber);
+}
+
+// Older settings were keyed by driver name; such an entry still applies to
+// a fan whose driver name no other present device shares
+static QString legacyCalibrationKey(const HWMonFan& fan, const QVector<HWMonFan>& fans)
+{
+    for (const HWMonFan& other : fans) {
+        if (other.deviceName == fan.deviceName && other.devicePath != fan.devicePath) {
+            return QString();
+        }
+    }
+    return calibrationKey(fan.deviceName, fan.fanNumber);
+}
+
+void MainWindow::saveFanCalibrations()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    // Keep entries for devices that are not present right now
+    QMap<QString, QString> tables;
+    settings.beginGroup("FanCalibration");
+    int count = settings.value("count", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        tables.insert(calibrationKey(settings.value("device").toString(), settings.value("fan").toInt()),
+                      settings.value("table").toString());
+        settings.endGroup();
+    }
+    settings.endGroup();
+
+    QVector<HWMonFan> fans = hwmonInterface->getFans();
+    for (const HWMonFan& fan : fans) {
+        QString key = calibrationKey(fan);
+        tables.remove(legacyCalibrationKey(fan, fans));
+        if (fan.calibration.isValid()) {
+            tables.insert(key, fan.calibration.toString());
+        } else {
+            tables.remove(key);
+        }
+    }
+
+    settings.remove("FanCalibration");
+    settings.beginGroup("FanCalibration");
+    settings.setValue("count", tables.size());
+    int i = 0;
+    for (auto it = tables.constBegin(); it != tables.constEnd(); ++it, ++i) {
+        int slash = it.key().lastIndexOf("/fan");
+        settings.beginGroup(QString("Fan%1").arg(i));
+        settings.setValue("device", it.key().left(slash));
+        settings.setValue("fan", it.key().mid(slash + 4).toInt());
+        settings.setValue("table", it.value());
+        settings.endGroup();
+    }
+    settings.endGroup();
+}
+
+void MainWindow::loadFanCalibrations()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    QMap<QString, FanCalibrationTable> tables;
+    settings.beginGroup("FanCalibration");
+    int count = settings.value("count", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        QString key = calibrationKey(settings.value("device").toString(), settings.value("fan").toInt());
+        bool ok;
+        FanCalibrationTable table = FanCalibrationTable::fromString(settings.value("table").toString(), &ok);
+        if (ok) {
+            tables.insert(key, table);
+        } else {
+            qWarning() << "Ignoring invalid fan calibration for" << key;
+        }
+        settings.endGroup();
+    }
+    settings.endGroup();
+
+    QVector<HWMonFan> fans = hwmonInterface->getFans();
+    for (int i = 0; i < fans.size(); i++) {
+        QString key = calibrationKey(fans[i]);
+        if (!tables.contains(key)) {
+            key = legacyCalibrationKey(fans[i], fans);
+        }
+        if (tables.contains(key)) {
+            hwmonInterface->setFanCalibration(i, tables.value(key));
+            qDebug() << "Loaded fan calibration for" << key;
+        }
+    }
+}
+
+void MainWindow::updateSamplerResponses()
+{
+    QVector<HWMonFan> fans = hwmonInterface->getFans();
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        if (samplerFanIds[i] < 0) {
+            continue;
+        }
+        const HWMonFan& fan = fans[fanBackends.getSourceIndex(i)];
+        fanSampler->setFanResponse(samplerFanIds[i], fan.calibration, fan.minRPM, fan.maxRPM);
+    }
+}
+
+void MainWindow::calibrateHWMonFans()
+{
+    QVector<FanCalibrationTarget> targets;
+    for (const HWMonFan& fan : hwmonInterface->getFans()) {
+        if (fan.supportsManualControl) {
+            targets.append({fan.devicePath, fan.deviceName, fan.fanNumber});
+        }
+    }
+    if (targets.isEmpty()) {
+        QMessageBox::information(this, "Calibrate Fans", "No PWM-controlled hwmon fans found.");
+        return;
+    }
+    // The control loop is stopped meanwhile; only the guard watches temperatures
+    if (!criticalGuard->isRunning()) {
+        QMessageBox::warning(this, "Calibrate Fans",
+            "Calibration stops the fans for a while and pauses the control loop, so it needs "
+            "the critical sensor guard to stop it if a sensor gets too hot.\n\n"
+            "Mark at least one sensor in Sensors, Configure Critical Sensors... first.");
+        return;
+    }
+
+    QMessageBox::StandardButton answer = QMessageBox::question(this, "Calibrate Fans",
+        QString("%1 fan(s) will be stepped from full speed down to standstill to measure "
+                "how they respond to PWM. Fans may be loud or stop for a few seconds; "
+                "this takes a few minutes. Devices are calibrated in parallel.\n\n"
+                "Avoid heavy load while calibrating. Continue?").arg(targets.size()),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+    if (answer != QMessageBox::Yes) {
+        return;
+    }
+
+    // The control loops must not write to fans that are being measured
+    updateTimer->stop();
+    lastControlTickNs = -1;     // The pause is not jitter
+    fanSampler->clearAllTargets();
+    calibrationCancel = false;
+    calibrationTripped = false;
+    calibrating = true;
+
+    QProgressDialog *progress = new QProgressDialog("Calibrating fans...", "Cancel", 0, 0, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(0);
+    connect(progress, &QProgressDialog::canceled, this, [this]() { calibrationCancel = true; });
+
+    FanCalibrator::Options options;
+    options.cancel = &calibrationCancel;
+    options.tripped = &calibrationTripped;
+
+    QFutureWatcher<QVector<FanCalibrationResult>> *watcher =
+        new QFutureWatcher<QVector<FanCalibrationResult>>(this);
+    connect(watcher, &QFutureWatcher<QVector<FanCalibrationResult>>::finished, this,
+            [this, watcher, progress]() {
+        progress->deleteLater();
+        watcher->deleteLater();
+        calibrating = false;
+        applyCalibrationResults(watcher->result());
+        updateTimer->start(1000);
+    });
+    // The calibrator drives the fans meanwhile; keep the watchdog fed while it runs
+    QTimer *heartbeatTimer = new QTimer(watcher);
+    connect(heartbeatTimer, &QTimer::timeout, this, [this]() { watchdog.heartbeat(); });
+    heartbeatTimer->start(1000);
+    watcher->setFuture(QtConcurrent::run([targets, options]() {
+        return FanCalibrator::calibrateAll(targets, options);
+    }));
+}
+
+void MainWindow::applyCalibrationResults(const QVector<FanCalibrationResult>& results)
+{
+    QVector<HWMonFan> fans = hwmonInterface->getFans();
+    QStringList summary;
+    for (const FanCalibrationResult& result : results) {
+        QString name = QString("%1/fan%2").arg(result.target.deviceName).arg(result.target.fanNumber);
+        if (!result.errorMessage.isEmpty()) {
+            summary << QString("%1: failed (%2)").arg(name).arg(result.errorMessage);
+            continue;
+        }
+
+        for (int i = 0; i < fans.size(); i++) {
+            if (fans[i].devicePath == result.target.devicePath &&
+                fans[i].fanNumber == result.target.fanNumber) {
+                hwmonInterface->setFanCalibration(i, result.table);
+            }
+        }
+        summary << QString("%1: %2-%3 RPM, stall at PWM %4, starts at PWM %5")
+                       .arg(name).arg(result.table.minRPM()).arg(result.table.maxRPM())
+                       .arg(result.table.stallPWM).arg(result.table.startPWM);
+    }
+
+    saveFanCalibrations();
+    updateSamplerResponses();
+
+    // The calibrator restored the PWM values it found and the sampler
+    // targets were cleared: write every fan's setting again, with the new
+    // tables, before the summary blocks
+    if (!criticalGuard->isEmergency()) {
+        reapplyFanSettings();
+    }
+    QMessageBox::information(this, "Calibrate Fans", summary.join('\n'));
+}
+
+void MainWindow::configureSensorFilter()
+{
+    const QString allSensors = "(All sensors - default)";
+
+    QStringList labels;
+    labels << allSensors;
+    for (const TempSensor& sensor : sensorPipeline.readHardware()) {
+        if (!labels.contains(sensor.label)) {
+            labels << sensor.label;
+        }
+    }
+
+    bool ok;
+    QString label = QInputDialog::getItem(this, "Configure Sensor Filter",
+                                          "Sensor:", labels, 0, false, &ok);
+    if (!ok || label.isEmpty()) {
+        return;
+    }
+
+    bool isDefault = (label == allSensors);
+    SensorFilterSpec current = isDefault ? sensorFilters.getDefaultSpec()
+                                         : sensorFilters.getSpecs().value(label, sensorFilters.getDefaultSpec());
+
+    QString text = QInputDialog::getText(this, "Configure Sensor Filter",
+                                         "Filter stages, e.g. \"median:5 ema:0.3 rate:2\"\n"
+                                         "(median window, EMA weight, max °C per second; \"none\" to disable,\n"
+                                         "empty to use the default):",
+                                         QLineEdit::Normal,
+                                         current.toString(), &ok).trimmed();
+    if (!ok) {
+        return;
+    }
+
+    if (text.isEmpty() && !isDefault) {
+        sensorFilters.removeSpec(label);
+    } else {
+        bool valid;
+        SensorFilterSpec spec = SensorFilterSpec::fromString(text, &valid);
+        if (!valid) {
+            QMessageBox::warning(this, "Sensor Filter Error",
+                                 QString("Invalid filter specification: %1").arg(text));
+            return;
+        }
+        if (isDefault) {
+            sensorFilters.setDefaultSpec(spec);
+        } else {
+            sensorFilters.setSpec(label, spec);
+        }
+    }
+
+    saveSensorFilters();
+    traceWriter.recordFilters(sensorFilters);
+    statusBar()->showMessage(QString("Filter for %1 updated").arg(label), 3000);
+}
+
+void MainWindow::configureCriticalSensors()
+{
+    // Only hardware sensors: the guard reads their files directly
+    QStringList labels;
+    for (const TempSensor& sensor : sensorPipeline.readHardware()) {
+        if (!labels.contains(sensor.label)) {
+            labels << sensor.label;
+        }
+    }
+    if (labels.isEmpty()) {
+        return;
+    }
+
+    bool ok;
+    QString label = QInputDialog::getItem(this, "Configure Critical Sensors",
+                                          "Sensor:", labels, 0, false, &ok);
+    if (!ok || label.isEmpty()) {
+        return;
+    }
+
+    int existing = -1;
+    for (int i = 0; i < criticalSensors.size(); i++) {
+        if (criticalSensors[i].label == label) {
+            existing = i;
+        }
+    }
+    QString current = existing >= 0 ? QString("%1 %2").arg(criticalSensors[existing].limit / 1000)
+                                                      .arg(criticalSensors[existing].release / 1000)
+                                     : QString();
+
+    QString text = QInputDialog::getText(this, "Configure Critical Sensors",
+                                         "Limit and release temperature in °C, e.g. \"95 88\"\n"
+                                         "(all fans go to maximum at the limit and back to normal control\n"
+                                         "once every critical sensor is below its release temperature;\n"
+                                         "empty to stop watching this sensor):",
+                                         QLineEdit::Normal, current, &ok).trimmed();
+    if (!ok) {
+        return;
+    }
+
+    if (text.isEmpty()) {
+        if (existing >= 0) {
+            criticalSensors.remove(existing);
+        }
+    } else {
+        QStringList parts = text.split(' ', Qt::SkipEmptyParts);
+        bool limitOk = false;
+        bool releaseOk = true;
+        CriticalSensor sensor;
+        sensor.label = label;
+        sensor.limit = parts.value(0).toInt(&limitOk) * 1000;
+        sensor.release = parts.size() > 1 ? parts[1].toInt(&releaseOk) * 1000
+                                          : sensor.limit - CriticalSensorGuard::DEFAULT_RELEASE_MARGIN;
+        if (!limitOk || !releaseOk || parts.size() > 2 || sensor.limit <= 0 || sensor.release >= sensor.limit) {
+            QMessageBox::warning(this, "Critical Sensor Error",
+                                 QString("Invalid limit and release temperature: %1").arg(text));
+            return;
+        }
+        if (existing >= 0) {
+            criticalSensors[existing] = sensor;
+        } else {
+            criticalSensors.append(sensor);
+        }
+    }
+
+    saveCriticalSensors();
+    if (topologyComplete) {
+        startCriticalGuard();
+    }
+    statusBar()->showMessage(QString("Critical sensor %1 updated").arg(label), 3000);
+}
+
+QVector<TraceFanConfig> MainWindow::traceFanConfigs() const
+{
+    QVector<TraceFanConfig> configs;
+    configs.reserve(fanWidgets.size());
+    for (int i = 0; i < fanWidgets.size(); i++) {
+        bool sensorBased = sensorSettings[i].enabled && fanWidgets[i]->getCurrentMode() == MODE_SENSOR_BASED;
+        configs.append(TraceFanConfig::fromController(fanWidgets[i]->getController(),
+                                                      sensorBased ? sensorSettings[i].sensorIndex : -1));
+    }
+    return configs;
+}
+
+bool MainWindow::startTraceRecording(const QString& path)
+{
+    QString errorMessage;
+    if (!traceWriter.start(path, smcInterface->getMacModel(), &errorMessage)) {
+        showError(errorMessage);
+        return false;
+    }
+
+    // Configuration first, so the trace replays on its own
+    traceWriter.recordFilters(sensorFilters);
+    traceWriter.recordVirtualSensors(virtualSensors);
+    traceWriter.recordFans(traceFanConfigs());
+
+    if (recordTraceAction) {
+        QSignalBlocker blocker(recordTraceAction);
+        recordTraceAction->setChecked(true);
+    }
+    qDebug() << "Recording control trace to" << path;
+    statusBar()->showMessage(QString("Recording control trace to %1").arg(path), 3000);
+    return true;
+}
+
+void MainWindow::toggleTraceRecording(bool enable)
+{
+    if (!enable) {
+        qDebug() << "Stopped control trace," << traceWriter.getTickCount() << "ticks in" << traceWriter.getPath();
+        statusBar()->showMessage(QString("Control trace saved: %1 ticks in %2")
+                                 .arg(traceWriter.getTickCount()).arg(traceWriter.getPath()), 5000);
+        traceWriter.stop();
+        return;
+    }
+
+    QString defaultPath = QDir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation))
+                              .filePath(QString("macsfancontrol-%1.trace")
+                                        .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+    QString path = QFileDialog::getSaveFileName(this, "Record Control Trace", defaultPath,
+                                                "Control traces (*.trace);;All files (*)");
+    if (path.isEmpty() || !startTraceRecording(path)) {
+        QSignalBlocker blocker(recordTraceAction);
+        recordTraceAction->setChecked(false);
+    }
+}
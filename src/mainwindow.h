@@ -5,23 +5,66 @@
 #include <QTimer>
 #include <QVector>
 #include <QSettings>
+#include <QElapsedTimer>
+#include <atomic>
 #include "smcinterface.h"
 #include "hwmoninterface.h"
 #include "fancontrolwidget.h"
 #include "temperaturepanel.h"
+#include "virtualsensors.h"
+#include "sensorfilter.h"
+#include "cpuloadmonitor.h"
+#include "latencystats.h"
+#include "metricsserver.h"
+#include "fansampler.h"
+#include "sensorpipeline.h"
+#include "controltrace.h"
+#include "discoverymanifest.h"
+#include "backenddiscovery.h"
+#include "readprofiler.h"
+#include "fanwatchdog.h"
+#include "criticalguard.h"
+#include "configwatcher.h"
+#include "fanbackend.h"
+#include "fanzone.h"
+#include "acousticoptimizer.h"
+#include "predictivecontroller.h"
+#include "influenceidentifier.h"
+#include <QHash>
+#include <QSet>
 
-enum FanSource {
-    FAN_SOURCE_SMC = 0,
-    FAN_SOURCE_HWMON = 1
-};
+class QVBoxLayout;
+class QSettings;
+class QProgressDialog;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = nullptr);
+    // sysfsRoot prefixes every sysfs path (empty = the real /sys)
+    explicit MainWindow(const QString& sysfsRoot = QString(), QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Record every tick's raw readings and fan writes for offline replay
+    bool startTraceRecording(const QString& path);
+
+    // Per-sample deadline of the async hwmon readers (0 = synchronous reads)
+    void setHWMonReadDeadline(int ms);
+
+    // Scheduling, memory locking and timer of the fan sampler and critical
+    // sensor threads
+    void setSamplerRealtime(const RealtimeOptions& options);
+
+    // Read rate of the critical sensors (0 = not watched)
+    void setCriticalInterval(int ms);
+
+    // Failsafe process that puts fans in a safe state when the control loop
+    // misses heartbeats for timeoutMs or the app dies (0 = off)
+    void setWatchdog(int timeoutMs, FanWatchdog::Action action);
+
+protected:
+    bool event(QEvent *event) override;
+
 private slots:
     void updateSensorData();
     void showError(const QString& message);
@@ -33,15 +76,91 @@ private slots:
     void loadPreset();
     void deletePreset();
     void copyDebugLogToClipboard();
+    void addVirtualSensor();
+    void removeVirtualSensor();
+    void configureSensorFilter();
+    void configureCriticalSensors();
+    void configureFanZones();
+    void identifyFanInfluence();
+    void toggleAcousticOptimizer(bool enable);
+    void togglePredictiveControl(bool enable);
+    void configureOptimizerLimits();
+    void configureOptimizerSettings();
+    void onCriticalEmergency(bool active, const QString& label, int temperature);
+    void reloadSensorDescriptions();
+    void calibrateHWMonFans();
+    void toggleTraceRecording(bool enable);
+    void addSMCFanWidgets();
+    void showReadCosts();
+    void addHWMonFanWidgets(int first, int count);
 
 private:
     SMCInterface *smcInterface;
     HWMonInterface *hwmonInterface;
     QVector<FanControlWidget*> fanWidgets;
-    QVector<FanSource> fanSources;  // Track which interface each fan belongs to
-    QVector<int> fanSourceIndices;  // Index within the source interface
+    FanBackends fanBackends;        // Backend of each fan, numbered like fanWidgets
+    QVector<int> fanSpeeds;         // Last readSpeeds(), per fan
+    QVector<FanSpeedWrite> pendingWrites;   // Targets decided by the running tick
+    FanZones fanZones;
+    QVector<int> samplerFanIds;     // FanSampler id for closed-loop RPM tracking (-1 = none)
     TemperaturePanel *tempPanel;
     QTimer *updateTimer;
+    VirtualSensorEngine virtualSensors;
+    SensorFilterBank sensorFilters;
+    CpuLoadMonitor cpuLoadMonitor;
+    QElapsedTimer uptimeTimer;      // Monotonic clock for filters and write statistics
+    TickLatencyStats tickLatency;
+    LatencyHistogram controlTickJitter;     // |wakeup - due time| of each timer-driven control tick
+    qint64 lastControlTickNs = -1;          // monotonicNs() of the previous one, -1 = none
+    MetricsServer *metricsServer;
+    FanSampler *fanSampler;
+    CriticalSensorGuard *criticalGuard;
+    qint64 tickSampleStart = -1;    // monotonicNs() of the running tick, -1 outside a tick
+    qint64 tickSampleEnd = -1;
+    std::atomic<bool> calibrationCancel;
+    std::atomic<bool> calibrationTripped;   // The cancel came from a thermal emergency
+    bool calibrating = false;       // A calibration sweep drives the hwmon fans
+    SensorPipeline sensorPipeline;
+    ControlTraceWriter traceWriter;
+    QAction *recordTraceAction = nullptr;
+    qint64 tickTimestamp = -1;      // uptimeTimer time of the running tick
+    DiscoveryManifest::Result discovery = {false, false, false, 0};
+    double firstSampleMs = -1.0;    // Construction to end of the first tick
+    double firstPaintMs = -1.0;     // Construction to the first paint of the window
+    double topologyMs = -1.0;       // Construction to all backends discovered
+    bool topologyComplete = false;  // Per-fan settings loaded; safe to save them
+    BackendDiscovery *backendDiscovery = nullptr;
+    QVBoxLayout *fanLayout = nullptr;
+    QAction *calibrateAction = nullptr;
+    int hwmonReadDeadlineMs = HWMonReaders::DEFAULT_DEADLINE_MS;
+    ReadProfiler readProfiler;      // Per-attribute read cost and polling rates
+    FanWatchdog watchdog;
+    int watchdogTimeoutMs = FanWatchdog::DEFAULT_TIMEOUT_MS;
+    QVector<CriticalSensor> criticalSensors;    // Configured by label; input paths resolved on start
+    int criticalIntervalMs = CriticalSensorGuard::DEFAULT_INTERVAL_MS;
+    ConfigFileWatcher *descriptionWatcher;      // sensor_descriptions.conf
+    int descriptionReloads = 0;     // Reloads started; a finished one that is not the latest is dropped
+    AcousticOptimizer optimizer;    // Influence model of this machine, limits and noise weights
+    QAction *optimizerAction = nullptr;
+    bool optimizerEnabled = false;
+    bool optimizerFeasible = true;  // Last solve met every limit
+    QVector<int> optimizerFans;     // Widget index of each model fan (-1 = absent or a zone follower)
+    QVector<int> optimizerTargets;  // Last target written per widget fan (-1 = none yet)
+    QVector<int> optimizerSensorIndices;    // TempSensor index per limit, found by label (-1 = not seen)
+    QVector<double> optimizerReadings;  // Solve inputs and result, reused every tick
+    QVector<int> optimizerCurrent;
+    QVector<int> optimizerSolution;
+    LatencyHistogram optimizerSolveCost;
+    PredictiveController predictive;    // Plans the optimizer's fans over a horizon when enabled
+    QAction *predictiveAction = nullptr;
+    bool predictiveEnabled = false;     // Only with optimizerEnabled
+    LatencyHistogram predictiveSolveCost;
+    InfluenceIdentifier identifier;     // Step-response routine, driven by the tick while it runs
+    QProgressDialog *identifyProgress = nullptr;
+    qint64 identifyStartMs = -1;        // uptimeTimer time the routine started
+    QVector<double> identifyReadings;   // Per layout sensor, reused every tick
+    QVector<int> identifyTargets;
+    QVector<int> identifyWritten;       // Last target written per fan
 
     // Sensor-based control settings
     struct SensorBasedSettings {
@@ -52,10 +171,23 @@ private:
     };
     QVector<SensorBasedSettings> sensorSettings;
 
+    // Fan target writes issued vs. suppressed by hysteresis
+    struct FanWriteStats {
+        quint64 written;
+        quint64 avoided;
+    };
+    QVector<FanWriteStats> fanWriteStats;
+
     void setupUI();
+    void finishInitialization();
+    void addFanWidget(FanControlWidget *fanWidget, FanSource source, int sourceIndex, int samplerId);
     void createMenuBar();
     void connectSignals();
     void restoreAutoMode();
+    void flushFanWrites();
+    void startWatchdog();
+    void startCriticalGuard();
+    void reapplyFanSettings();
     void updateSensorListInFanWidgets();
 
     // Settings management
@@ -64,6 +196,37 @@ private:
     void savePresetToSettings(const QString& presetName);
     void loadPresetFromSettings(const QString& presetName);
     void applyFanSettings(int fanIndex, FanMode mode, int targetRPM, int sensorIndex, int minTemp, int maxTemp);
+    void saveVirtualSensors();
+    void loadVirtualSensors();
+    void saveSensorFilters();
+    void loadSensorFilters();
+    void saveCriticalSensors();
+    void saveFanZones(QSettings& settings) const;
+    void loadFanZones(QSettings& settings, const QVector<int>& fanOrder);
+    // Saved settings survive hwmon fans and sensors being numbered in the
+    // order discovery finished: fans are matched by identity, sensors by label
+    QString fanIdentity(int fan) const;
+    QVector<int> savedFanOrder(QSettings& settings) const;
+    QHash<QString, int> sensorIndicesByLabel();
+    void applyFanZones();
+    void loadOptimizer();
+    void saveOptimizer();
+    void applyOptimizer();
+    void setModelControl(bool enable, bool predictivePlan);
+    void runOptimizer(const QVector<TempSensor>& temps);
+    void runIdentification(const QVector<TempSensor>& temps);
+    void finishIdentification(bool completed);
+    void applyIdentifiedModel(const InfluenceModel& model);
+    bool isOptimizerFan(int fan) const { return optimizerEnabled && optimizerFans.contains(fan); }
+    void loadCriticalSensors();
+    void saveFanCalibrations();
+    void loadFanCalibrations();
+    void applyCalibrationResults(const QVector<FanCalibrationResult>& results);
+    void updateSamplerResponses();
+    QString fanWriteSummary() const;
+    QSet<int> usedSensorIndices() const;
+    QByteArray exportMetrics() const;
+    QVector<TraceFanConfig> traceFanConfigs() const;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,45 @@
+#include "metricsserver.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDebug>
+
+const char *const MetricsServer::DEFAULT_NAME = "macsfancontrol-metrics";
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent),
+      server(new QLocalServer(this))
+{
+    connect(server, &QLocalServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+bool MetricsServer::listen(const QString& name)
+{
+    // Read-only data; let unprivileged users query a root instance
+    server->setSocketOptions(QLocalServer::WorldAccessOption);
+
+    // A stale socket from a crashed instance would make listen() fail
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+        qWarning() << "Metrics endpoint not available:" << server->errorString();
+        return false;
+    }
+
+    qDebug() << "Metrics endpoint listening on" << server->fullServerName();
+    return true;
+}
+
+QString MetricsServer::socketPath() const
+{
+    return server->fullServerName();
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+        if (provider) {
+            socket->write(provider());
+        }
+        socket->disconnectFromServer();     // Flushes pending data first
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+class QLocalServer;
+
+// Serves a metrics snapshot on a local socket: every client that connects gets
+// the current text from the provider and the connection is closed, e.g.
+//   socat - UNIX-CONNECT:/tmp/macsfancontrol-metrics
+class MetricsServer : public QObject {
+    Q_OBJECT
+
+public:
+    static const char *const DEFAULT_NAME;
+
+    explicit MetricsServer(QObject *parent = nullptr);
+
+    void setProvider(const std::function<QByteArray()>& provider) { this->provider = provider; }
+    bool listen(const QString& name = DEFAULT_NAME);
+    QString socketPath() const;
+
+private slots:
+    void onNewConnection();
+
+private:
+    QLocalServer *server;
+    std::function<QByteArray()> provider;
+};
+
+#endif // METRICSSERVER_H
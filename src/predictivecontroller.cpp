@@ -0,0 +1,316 @@
+#include "predictivecontroller.h"
+#include <QDebug>
+#include <QtMath>
+
+namespace {
+
+// First prediction step of each move block, and the end of the last: the
+// first position holds one step, the next three, the last the rest
+const int BLOCK_START[PredictiveController::MOVE_BLOCKS + 1] = {0, 1, 4, PredictiveController::HORIZON_STEPS};
+
+// Cost per °C^2 of predicted overshoot per step, per unit of noise (as in
+// AcousticOptimizer, per step) and per unit of squared position change.
+// Below (limit - margin) a sensor costs nothing; noise keeps fans down.
+const double OVERSHOOT_WEIGHT = 1.0;
+const double NOISE_WEIGHT = 0.5;
+const double MOVE_WEIGHT = 5.0;
+
+const double TREND_SMOOTHING = 60.0;    // Seconds, for the disturbance slope
+const double TREND_SECONDS = 30.0;      // The trend is extrapolated this far at most
+const double RESTART_SECONDS = 10.0;    // A longer gap between updates restarts the prediction
+const double CONVERGED = 1e-6;          // Largest position change of a final sweep
+const int NEWTON_STEPS = 4;             // Per position per sweep; the overshoot cost has kinks
+const double MIN_WEIGHT = 1e-3;
+
+} // namespace
+
+PredictiveController::PredictiveController()
+    : margin(AcousticOptimizer::DEFAULT_MARGIN),
+      horizon(DEFAULT_HORIZON),
+      fanCount(0),
+      limitCount(0),
+      variableCount(0),
+      started(false),
+      lastTimestamp(0),
+      lastSweeps(0)
+{
+    for (int f = 0; f < MAX_FANS; f++) {
+        weights[f] = 1.0;
+    }
+}
+
+void PredictiveController::setModel(const InfluenceModel& newModel)
+{
+    model = newModel;
+    if (model.fanCount() > MAX_FANS) {
+        qWarning() << "Predictive control plans" << MAX_FANS << "of" << model.fanCount() << "fans";
+    }
+    limits.clear();
+    for (int f = 0; f < MAX_FANS; f++) {
+        weights[f] = 1.0;
+    }
+    prepare();
+}
+
+void PredictiveController::setLimits(const QVector<OptimizerLimit>& newLimits)
+{
+    limits.clear();
+    for (const OptimizerLimit& limit : newLimits) {
+        if (limit.sensor >= 0 && limit.sensor < model.sensorCount() && limits.size() < MAX_LIMITS) {
+            limits.append(limit);
+        }
+    }
+    prepare();
+}
+
+void PredictiveController::setNoiseWeights(const QVector<double>& newWeights)
+{
+    for (int f = 0; f < MAX_FANS && f < newWeights.size(); f++) {
+        weights[f] = qMax(MIN_WEIGHT, newWeights[f]);
+    }
+    prepare();
+}
+
+void PredictiveController::setMargin(double celsius)
+{
+    margin = celsius;
+}
+
+void PredictiveController::setHorizon(int seconds)
+{
+    horizon = qBound(static_cast<int>(MIN_HORIZON), seconds, static_cast<int>(MAX_HORIZON));
+    prepare();
+}
+
+double PredictiveController::positionOf(int fan, int rpm) const
+{
+    int range = model.maxRPM[fan] - model.minRPM[fan];
+    return range > 0 ? qBound(0.0, static_cast<double>(rpm - model.minRPM[fan]) / range, 1.0) : 0.0;
+}
+
+void PredictiveController::prepare()
+{
+    fanCount = qMin(model.fanCount(), static_cast<int>(MAX_FANS));
+    limitCount = qMin(limits.size(), static_cast<int>(MAX_LIMITS));
+    variableCount = fanCount * MOVE_BLOCKS;
+    started = false;
+    double stepSeconds = static_cast<double>(horizon) / HORIZON_STEPS;
+
+    // Each fan's state decays towards gain * position by this per step; an
+    // unknown time constant acts within the step
+    for (int l = 0; l < limitCount; l++) {
+        for (int f = 0; f < fanCount; f++) {
+            double timeConstant = model.getTimeConstant(limits[l].sensor, f);
+            double factor = timeConstant > 0.0 ? qExp(-stepSeconds / timeConstant) : 0.0;
+            decay[l][f][0] = 1.0;
+            for (int k = 1; k <= HORIZON_STEPS; k++) {
+                decay[l][f][k] = decay[l][f][k - 1] * factor;
+            }
+        }
+    }
+
+    // A position held over steps [start, end) moves the state at step j by
+    // gain * (decay^(j - min(end, j)) - decay^(j - start))
+    for (int l = 0; l < limitCount; l++) {
+        for (int j = 0; j < HORIZON_STEPS; j++) {
+            int steps = j + 1;
+            for (int b = 0; b < MOVE_BLOCKS; b++) {
+                for (int f = 0; f < fanCount; f++) {
+                    double value = 0.0;
+                    if (steps > BLOCK_START[b]) {
+                        int end = qMin(BLOCK_START[b + 1], steps);
+                        value = model.getGain(limits[l].sensor, f)
+                                * (decay[l][f][steps - end] - decay[l][f][steps - BLOCK_START[b]]);
+                    }
+                    response[l][j][b * fanCount + f] = value;
+                }
+            }
+        }
+    }
+
+    for (int v = 0; v < variableCount; v++) {
+        noiseGradient[v] = 0.0;
+        for (int k = 0; k < variableCount; k++) {
+            hessian[v][k] = 0.0;
+        }
+    }
+    for (int b = 0; b < MOVE_BLOCKS; b++) {
+        for (int f = 0; f < fanCount; f++) {
+            // weight * (rpm / 1000)^2 per step the block holds
+            int v = b * fanCount + f;
+            double cost = NOISE_WEIGHT * weights[f] * (BLOCK_START[b + 1] - BLOCK_START[b]);
+            double minimum = model.minRPM[f] / 1000.0;
+            double range = (model.maxRPM[f] - model.minRPM[f]) / 1000.0;
+            hessian[v][v] += 2.0 * cost * range * range;
+            noiseGradient[v] = 2.0 * cost * minimum * range;
+
+            // Position changes, the first from the fan's current position
+            hessian[v][v] += 2.0 * MOVE_WEIGHT;
+            if (b > 0) {
+                int previous = v - fanCount;
+                hessian[previous][previous] += 2.0 * MOVE_WEIGHT;
+                hessian[v][previous] -= 2.0 * MOVE_WEIGHT;
+                hessian[previous][v] -= 2.0 * MOVE_WEIGHT;
+            }
+        }
+    }
+}
+
+bool PredictiveController::update(const QVector<double>& readings, const QVector<int>& current, qint64 timestampMs,
+                                  QVector<int> *targets)
+{
+    // Fans past MAX_FANS keep their speed
+    int fanTotal = model.fanCount();
+    targets->resize(fanTotal);
+    for (int f = 0; f < fanTotal; f++) {
+        (*targets)[f] = current.value(f, model.minRPM[f]);
+    }
+    if (variableCount == 0 || limitCount == 0) {
+        return true;
+    }
+
+    double position[MAX_FANS];
+    for (int f = 0; f < fanCount; f++) {
+        position[f] = positionOf(f, current.value(f, model.minRPM[f]));
+    }
+
+    // Advance each fan's state over the time since the last update; a
+    // missing reading keeps its sensor's disturbance
+    double elapsed = (timestampMs - lastTimestamp) / 1000.0;
+    if (!started || elapsed < 0.0 || elapsed > RESTART_SECONDS) {
+        for (int l = 0; l < limitCount; l++) {
+            double sum = 0.0;
+            for (int f = 0; f < fanCount; f++) {
+                state[l][f] = model.getGain(limits[l].sensor, f) * position[f];
+                sum += state[l][f];
+            }
+            double reading = readings.value(l, qQNaN());
+            disturbance[l] = (qIsNaN(reading) ? limits[l].limit - margin : reading) - sum;
+            trend[l] = 0.0;
+        }
+        for (int b = 0; b < MOVE_BLOCKS; b++) {
+            for (int f = 0; f < fanCount; f++) {
+                plan[b * fanCount + f] = position[f];
+            }
+        }
+        started = true;
+        elapsed = 0.0;
+    }
+    lastTimestamp = timestampMs;
+
+    if (elapsed > 0.0) {
+        double smoothing = 1.0 - qExp(-elapsed / TREND_SMOOTHING);
+        for (int l = 0; l < limitCount; l++) {
+            double sum = 0.0;
+            for (int f = 0; f < fanCount; f++) {
+                double timeConstant = model.getTimeConstant(limits[l].sensor, f);
+                double factor = timeConstant > 0.0 ? qExp(-elapsed / timeConstant) : 0.0;
+                state[l][f] = factor * state[l][f]
+                              + (1.0 - factor) * model.getGain(limits[l].sensor, f) * position[f];
+                sum += state[l][f];
+            }
+            double reading = readings.value(l, qQNaN());
+            if (qIsNaN(reading)) {
+                continue;
+            }
+            double slope = (reading - sum - disturbance[l]) / elapsed;
+            trend[l] += smoothing * (slope - trend[l]);
+            disturbance[l] = reading - sum;
+        }
+    }
+
+    // Noise and the pull of the current positions, and each step's
+    // predicted distance above (limit - margin) under the last plan
+    double gradient[MAX_VARIABLES];
+    double error[MAX_LIMITS][HORIZON_STEPS];
+    for (int v = 0; v < variableCount; v++) {
+        gradient[v] = noiseGradient[v];
+    }
+    for (int f = 0; f < fanCount; f++) {
+        gradient[f] -= 2.0 * MOVE_WEIGHT * position[f];
+    }
+    double stepSeconds = static_cast<double>(horizon) / HORIZON_STEPS;
+    for (int l = 0; l < limitCount; l++) {
+        for (int j = 0; j < HORIZON_STEPS; j++) {
+            double ahead = qMin((j + 1) * stepSeconds, TREND_SECONDS);
+            double value = disturbance[l] + trend[l] * ahead - (limits[l].limit - margin);
+            for (int f = 0; f < fanCount; f++) {
+                value += decay[l][f][j + 1] * state[l][f];
+            }
+            const double *row = response[l][j];
+            for (int v = 0; v < variableCount; v++) {
+                value += row[v] * plan[v];
+            }
+            error[l][j] = value;
+        }
+    }
+
+    // Projected Gauss-Seidel from the last plan: each position in turn
+    // minimizes the cost given the others, clamped to the fan's range. Only
+    // steps predicted above their target count, so the cost is piecewise
+    // quadratic in each position; a few Newton steps find its minimum.
+    lastSweeps = 0;
+    for (int sweep = 0; sweep < MAX_SWEEPS; sweep++) {
+        double moved = 0.0;
+        for (int v = 0; v < variableCount; v++) {
+            const double *row = hessian[v];
+            double start = plan[v];
+            for (int step = 0; step < NEWTON_STEPS; step++) {
+                double slope = gradient[v];
+                for (int k = 0; k < variableCount; k++) {
+                    slope += row[k] * plan[k];
+                }
+                double curvature = row[v];
+                for (int l = 0; l < limitCount; l++) {
+                    for (int j = 0; j < HORIZON_STEPS; j++) {
+                        if (error[l][j] > 0.0) {
+                            double effect = response[l][j][v];
+                            slope += 2.0 * OVERSHOOT_WEIGHT * error[l][j] * effect;
+                            curvature += 2.0 * OVERSHOOT_WEIGHT * effect * effect;
+                        }
+                    }
+                }
+                double value = qBound(0.0, plan[v] - slope / curvature, 1.0);
+                double change = value - plan[v];
+                if (change == 0.0) {
+                    break;
+                }
+                for (int l = 0; l < limitCount; l++) {
+                    for (int j = 0; j < HORIZON_STEPS; j++) {
+                        error[l][j] += response[l][j][v] * change;
+                    }
+                }
+                plan[v] = value;
+                if (qAbs(change) < CONVERGED) {
+                    break;
+                }
+            }
+            moved = qMax(moved, qAbs(plan[v] - start));
+        }
+        lastSweeps = sweep + 1;
+        if (moved < CONVERGED) {
+            break;
+        }
+    }
+
+    for (int f = 0; f < fanCount; f++) {
+        (*targets)[f] = model.minRPM[f] + qRound(plan[f] * (model.maxRPM[f] - model.minRPM[f]));
+    }
+
+    // Limits the plan cannot keep get every fan that cools them, as in
+    // AcousticOptimizer; the plan itself stays the next warm start
+    bool feasible = true;
+    for (int l = 0; l < limitCount; l++) {
+        predicted[l] = error[l][HORIZON_STEPS - 1] + limits[l].limit - margin;
+        if (predicted[l] <= limits[l].limit) {
+            continue;
+        }
+        feasible = false;
+        for (int f = 0; f < fanCount; f++) {
+            if (model.getGain(limits[l].sensor, f) < 0.0) {
+                (*targets)[f] = model.maxRPM[f];
+            }
+        }
+    }
+    return feasible;
+}
@@ -0,0 +1,105 @@
+#ifndef PREDICTIVECONTROLLER_H
+#define PREDICTIVECONTROLLER_H
+
+#include <QVector>
+#include "acousticoptimizer.h"
+#include "influencemodel.h"
+
+// Model-predictive control of the fans an InfluenceModel knows. Where the
+// acoustic optimizer only looks at where temperatures settle, this plans
+// every fan's position over a short horizon from how fast each fan reaches
+// each sensor (the model's time constants) and how the load is trending.
+//
+// Each limited sensor is predicted as
+//
+//   temperature(t) = disturbance + trend * t + sum over fans of state[fan](t)
+//
+// where state[fan] follows gain * position with the fan's time constant,
+// and the disturbance (load, ambient, model error) is whatever the reading
+// leaves unexplained. Every control period the plan minimizes
+//
+//   squared overshoot of each prediction above (limit - margin)
+//   + noise weight * (rpm / 1000)^2 per fan, as in AcousticOptimizer
+//   + a small cost per change of position
+//
+// over HORIZON_STEPS prediction steps, with MOVE_BLOCKS positions per fan
+// held over consecutive steps. A sensor below its target costs nothing, so
+// a cool sensor never holds back fans another one needs; quietness comes
+// from the noise term alone. Only the first position is written; the next
+// period plans again from new readings. The problem is a dense convex
+// program with box bounds of at most MAX_VARIABLES variables. The noise and
+// move costs depend only on the model and are built once; update() solves
+// by projected Gauss-Seidel in fixed-size arrays, without allocating.
+class PredictiveController {
+public:
+    static const int MAX_FANS = 8;              // Model fans past these are not planned
+    static const int MAX_LIMITS = 8;            // Limits past these are ignored
+    static const int HORIZON_STEPS = 12;
+    static const int MOVE_BLOCKS = 3;
+    static const int MAX_VARIABLES = MAX_FANS * MOVE_BLOCKS;
+    static const int MAX_SWEEPS = 200;
+    static const int DEFAULT_HORIZON = 120;     // Seconds
+    static const int MIN_HORIZON = 12;
+    static const int MAX_HORIZON = 600;
+
+    PredictiveController();
+
+    // Same model, limits, weights and margin as the acoustic optimizer.
+    // Except for the margin, each of these rebuilds the Hessian and restarts
+    // the prediction.
+    void setModel(const InfluenceModel& model);
+    void setLimits(const QVector<OptimizerLimit>& limits);
+    void setNoiseWeights(const QVector<double>& weights);
+    void setMargin(double celsius);
+    double getMargin() const { return margin; }
+    void setHorizon(int seconds);
+    int getHorizon() const { return horizon; }
+
+    // Forget the tracked state; the next update() starts from its readings
+    // as if every fan had been at its current speed for a long time
+    void reset() { started = false; }
+
+    // readings: °C per limit, in setLimits() order (NaN = not read);
+    // current: RPM per model fan; timestampMs on a monotonic clock. Fills
+    // the RPM each model fan should run at now. Returns false when even the
+    // plan leaves a limited sensor above its limit at the end of the horizon;
+    // every fan that cools such a sensor is then set to maximum.
+    bool update(const QVector<double>& readings, const QVector<int>& current, qint64 timestampMs,
+                QVector<int> *targets);
+
+    // From the last update(): predicted °C at the end of the horizon per
+    // limit, and the solver sweeps it took
+    double getPredicted(int limit) const { return limit >= 0 && limit < limitCount ? predicted[limit] : 0.0; }
+    int getLastSweeps() const { return lastSweeps; }
+
+private:
+    InfluenceModel model;
+    QVector<OptimizerLimit> limits;
+    double weights[MAX_FANS];
+    double margin;
+    int horizon;
+    int fanCount;               // Planned fans, at most MAX_FANS
+    int limitCount;             // At most MAX_LIMITS
+    int variableCount;          // fanCount * MOVE_BLOCKS, ordered block by block
+
+    // Fixed by prepare()
+    double decay[MAX_LIMITS][MAX_FANS][HORIZON_STEPS + 1];      // Per prediction step, 0^0 = 1
+    double response[MAX_LIMITS][HORIZON_STEPS][MAX_VARIABLES];  // °C at each step per unit of each position
+    double hessian[MAX_VARIABLES][MAX_VARIABLES];              // Noise and move costs
+    double noiseGradient[MAX_VARIABLES];
+
+    // Tracked between updates
+    bool started;
+    qint64 lastTimestamp;
+    double state[MAX_LIMITS][MAX_FANS];     // °C each fan currently contributes
+    double disturbance[MAX_LIMITS];         // °C
+    double trend[MAX_LIMITS];               // Smoothed °C per second
+    double plan[MAX_VARIABLES];             // Last solution, 0.0-1.0, warm start
+    double predicted[MAX_LIMITS];
+    int lastSweeps;
+
+    void prepare();
+    double positionOf(int fan, int rpm) const;
+};
+
+#endif // PREDICTIVECONTROLLER_H
@@ -0,0 +1,181 @@
+#include "readprofiler.h"
+#include <QMap>
+#include <QMutexLocker>
+#include <algorithm>
+
+// Weight of the newest read in ReadCost::recentNs
+static const double RECENT_ALPHA = 0.1;
+
+ReadProfiler::ReadProfiler()
+    : tick(0),
+      currentTickNs(0),
+      thresholdNs(DEFAULT_THRESHOLD_NS)
+{
+}
+
+int ReadProfiler::registerAttribute(const QString& driver, const QString& attribute, int sensorIndex)
+{
+    QMutexLocker locker(&mutex);
+
+    auto it = ids.constFind(attribute);
+    if (it != ids.constEnd()) {
+        costs[it.value()].driver = driver;
+        costs[it.value()].sensorIndex = sensorIndex;
+        return it.value();
+    }
+
+    ReadCost cost;
+    cost.driver = driver;
+    cost.attribute = attribute;
+    cost.sensorIndex = sensorIndex;
+    cost.reads = 0;
+    cost.totalNs = 0;
+    cost.maxNs = 0;
+    cost.recentNs = 0.0;
+    cost.rate = READ_RATE_FAST;
+    costs.append(cost);
+    ids.insert(attribute, costs.size() - 1);
+    return costs.size() - 1;
+}
+
+bool ReadProfiler::isDue(int id) const
+{
+    QMutexLocker locker(&mutex);
+    if (id < 0 || id >= costs.size() || costs[id].rate == READ_RATE_FAST) {
+        return true;
+    }
+    // Staggered by id so slow attributes do not all land on the same tick
+    return (tick + static_cast<quint64>(id)) % SLOW_INTERVAL == 0;
+}
+
+void ReadProfiler::record(int id, qint64 ns)
+{
+    QMutexLocker locker(&mutex);
+    if (id < 0 || id >= costs.size()) {
+        return;
+    }
+    ReadCost& cost = costs[id];
+    cost.recentNs = cost.reads == 0 ? ns : cost.recentNs + RECENT_ALPHA * (ns - cost.recentNs);
+    cost.reads++;
+    cost.totalNs += ns;
+    cost.maxNs = qMax(cost.maxNs, ns);
+    currentTickNs += ns;
+}
+
+void ReadProfiler::beginTick()
+{
+    QMutexLocker locker(&mutex);
+    if (tick > 0) {
+        tickCost.record(currentTickNs);
+    }
+    currentTickNs = 0;
+    tick++;
+}
+
+void ReadProfiler::applyPolicy(const QSet<int>& usedSensors)
+{
+    QMutexLocker locker(&mutex);
+    for (ReadCost& cost : costs) {
+        if (cost.sensorIndex < 0) {
+            continue;
+        }
+        bool used = usedSensors.contains(cost.sensorIndex);
+        if (cost.rate == READ_RATE_FAST) {
+            if (!used && cost.reads >= static_cast<quint64>(MIN_READS) && cost.recentNs > thresholdNs) {
+                cost.rate = READ_RATE_SLOW;
+            }
+        } else if (used || cost.recentNs < thresholdNs / 2) {
+            // Half the threshold, so a sensor near it does not flip every pass
+            cost.rate = READ_RATE_FAST;
+        }
+    }
+}
+
+void ReadProfiler::setThresholdNs(qint64 ns)
+{
+    QMutexLocker locker(&mutex);
+    thresholdNs = ns;
+}
+
+qint64 ReadProfiler::getThresholdNs() const
+{
+    QMutexLocker locker(&mutex);
+    return thresholdNs;
+}
+
+QVector<ReadCost> ReadProfiler::getCosts() const
+{
+    QMutexLocker locker(&mutex);
+    return costs;
+}
+
+QVector<DriverReadCost> ReadProfiler::getDriverCosts() const
+{
+    QMutexLocker locker(&mutex);
+
+    QMap<QString, DriverReadCost> drivers;
+    for (const ReadCost& cost : costs) {
+        DriverReadCost& driver = drivers[cost.driver];
+        if (driver.driver.isEmpty()) {
+            driver = {cost.driver, 0, 0, 0, 0};
+        }
+        driver.attributes++;
+        driver.slow += cost.rate == READ_RATE_SLOW ? 1 : 0;
+        driver.reads += cost.reads;
+        driver.totalNs += cost.totalNs;
+    }
+    return drivers.values().toVector();
+}
+
+LatencyHistogram ReadProfiler::getTickCost() const
+{
+    QMutexLocker locker(&mutex);
+    return tickCost;
+}
+
+int ReadProfiler::slowCount() const
+{
+    QMutexLocker locker(&mutex);
+    int count = 0;
+    for (const ReadCost& cost : costs) {
+        count += cost.rate == READ_RATE_SLOW ? 1 : 0;
+    }
+    return count;
+}
+
+QStringList ReadProfiler::summaryLines(int topAttributes) const
+{
+    LatencyHistogram perTick = getTickCost();
+    QVector<DriverReadCost> drivers = getDriverCosts();
+    QVector<ReadCost> sorted = getCosts();
+
+    QStringList lines;
+    lines << QString("  per tick: p50=%1 ms  p99=%2 ms  max=%3 ms  (%4 ticks, %5 slow attributes, threshold %6 ms)")
+                 .arg(perTick.percentile(0.50) / 1.0e6, 0, 'f', 3)
+                 .arg(perTick.percentile(0.99) / 1.0e6, 0, 'f', 3)
+                 .arg(perTick.max() / 1.0e6, 0, 'f', 3)
+                 .arg(perTick.count())
+                 .arg(slowCount())
+                 .arg(getThresholdNs() / 1.0e6, 0, 'f', 1);
+    for (const DriverReadCost& driver : drivers) {
+        lines << QString("  %1: %2 attributes (%3 slow)  reads=%4  mean=%5 us  total=%6 ms")
+                     .arg(driver.driver).arg(driver.attributes).arg(driver.slow).arg(driver.reads)
+                     .arg(driver.reads > 0 ? driver.totalNs / 1.0e3 / driver.reads : 0.0, 0, 'f', 1)
+                     .arg(driver.totalNs / 1.0e6, 0, 'f', 1);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const ReadCost& a, const ReadCost& b) {
+        return a.recentNs > b.recentNs;
+    });
+    for (int i = 0; i < sorted.size() && i < topAttributes; i++) {
+        const ReadCost& cost = sorted[i];
+        lines << QString("  %1  %2: recent=%3 us  mean=%4 us  max=%5 us  reads=%6")
+                     .arg(cost.rate == READ_RATE_SLOW ? "SLOW" : "fast")
+                     .arg(cost.attribute)
+                     .arg(cost.recentNs / 1.0e3, 0, 'f', 1)
+                     .arg(cost.reads > 0 ? cost.totalNs / 1.0e3 / cost.reads : 0.0, 0, 'f', 1)
+                     .arg(cost.maxNs / 1.0e3, 0, 'f', 1)
+                     .arg(cost.reads);
+    }
+    return lines;
+}
@@ -0,0 +1,85 @@
+#ifndef READPROFILER_H
+#define READPROFILER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "latencystats.h"
+
+// How often an attribute is read
+enum ReadRate {
+    READ_RATE_FAST = 0,     // Every tick
+    READ_RATE_SLOW = 1      // Every ReadProfiler::SLOW_INTERVAL ticks
+};
+
+// Accumulated read cost of one sysfs attribute
+struct ReadCost {
+    QString driver;         // "applesmc" or the hwmon driver name
+    QString attribute;      // sysfs file
+    int sensorIndex;        // TempSensor index, -1 for fan speeds (never demoted)
+    quint64 reads;
+    qint64 totalNs;
+    qint64 maxNs;
+    double recentNs;        // Exponential average over the latest reads
+    ReadRate rate;
+};
+
+// Read cost of all attributes of one driver
+struct DriverReadCost {
+    QString driver;
+    int attributes;
+    int slow;               // Attributes in the slow class
+    quint64 reads;
+    qint64 totalNs;
+};
+
+// Times every sysfs read per attribute and per driver, and decides how often
+// each attribute is polled. Backends register the attributes they read, ask
+// isDue() before a read and record() its duration. applyPolicy() moves
+// sensors that are consistently expensive and feed no fan or virtual sensor
+// to the slow class, and back once they are cheap or used again.
+//
+// Thread-safe: hwmon reads are timed on the per-device worker threads.
+class ReadProfiler {
+public:
+    static const int SLOW_INTERVAL = 10;                // Ticks between reads of a slow attribute
+    static const int MIN_READS = 20;                    // Reads before an attribute can be demoted
+    static const qint64 DEFAULT_THRESHOLD_NS = 1000000; // Recent mean cost that demotes
+
+    ReadProfiler();
+
+    // Same attribute again returns the same id, so statistics survive re-registration
+    int registerAttribute(const QString& driver, const QString& attribute, int sensorIndex);
+
+    bool isDue(int id) const;
+    void record(int id, qint64 ns);
+
+    // Start of a sampling tick; the reads since the previous call are its cost
+    void beginTick();
+
+    // Re-evaluate rates; usedSensors are the indices fans or virtual sensors read
+    void applyPolicy(const QSet<int>& usedSensors);
+    void setThresholdNs(qint64 ns);
+    qint64 getThresholdNs() const;
+
+    QVector<ReadCost> getCosts() const;
+    QVector<DriverReadCost> getDriverCosts() const;
+    LatencyHistogram getTickCost() const;     // Summed read time per tick
+    int slowCount() const;
+
+    QStringList summaryLines(int topAttributes) const;
+
+private:
+    mutable QMutex mutex;
+    QVector<ReadCost> costs;
+    QHash<QString, int> ids;            // Attribute path → index into costs
+    quint64 tick;
+    qint64 currentTickNs;
+    LatencyHistogram tickCost;
+    qint64 thresholdNs;
+};
+
+#endif // READPROFILER_H
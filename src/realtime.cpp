@@ -0,0 +1,206 @@
+#include "realtime.h"
+#include "latencystats.h"
+#include <QDebug>
+#include <QStringList>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// Stack the control thread may touch, faulted in up front
+static const int PREFAULT_STACK_BYTES = 64 * 1024;
+
+bool RealtimeOptions::parse(const QString& text, RealtimeOptions *options)
+{
+    RealtimeOptions parsed;
+    if (text.isEmpty() || text == "off") {
+        *options = parsed;
+        return true;
+    }
+
+    QString policy = text.section(':', 0, 0);
+    QString value = text.section(':', 1);
+    bool ok = true;
+    parsed.enabled = true;
+    parsed.niceLevel = DEFAULT_NICE_LEVEL;
+    if (policy == "fifo") {
+        parsed.fifoPriority = value.isEmpty() ? DEFAULT_FIFO_PRIORITY : value.toInt(&ok);
+        ok = ok && parsed.fifoPriority >= 1 && parsed.fifoPriority <= 99;
+    } else if (policy == "nice") {
+        parsed.niceLevel = value.isEmpty() ? DEFAULT_NICE_LEVEL : value.toInt(&ok);
+        ok = ok && parsed.niceLevel >= -20 && parsed.niceLevel <= 19;
+    } else {
+        ok = false;
+    }
+    if (ok) {
+        *options = parsed;
+    }
+    return ok;
+}
+
+// Touch the stack now so the first deep call in a tick does not page-fault
+static void prefaultStack()
+{
+    volatile char stack[PREFAULT_STACK_BYTES];
+    for (int i = 0; i < PREFAULT_STACK_BYTES; i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+bool applyRealtime(const RealtimeOptions& options, QString *applied)
+{
+    QStringList parts;
+    bool ok = true;
+
+    if (options.lockMemory) {
+        // MCL_ONFAULT locks pages as they are touched instead of populating
+        // every mapping, which would make each thread stack fully resident
+        int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+        flags |= MCL_ONFAULT;
+#endif
+        if (mlockall(flags) == 0) {
+            parts << "memory locked";
+        } else {
+            qWarning() << "mlockall failed:" << strerror(errno);
+            ok = false;
+        }
+    }
+
+    bool fifo = false;
+    if (options.fifoPriority > 0) {
+        sched_param param;
+        param.sched_priority = qBound(sched_get_priority_min(SCHED_FIFO), options.fifoPriority,
+                                      sched_get_priority_max(SCHED_FIFO));
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result == 0) {
+            fifo = true;
+            parts.prepend(QString("SCHED_FIFO %1").arg(param.sched_priority));
+        } else {
+            qWarning() << "SCHED_FIFO refused:" << strerror(result) << "- falling back to nice";
+            ok = false;
+        }
+    }
+
+    if (!fifo && options.niceLevel != 0) {
+        // On Linux the nice value belongs to the thread, not the process
+        pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, options.niceLevel) == 0) {
+            parts.prepend(QString("nice %1").arg(options.niceLevel));
+        } else {
+            qWarning() << "setpriority failed:" << strerror(errno);
+            ok = false;
+        }
+    }
+
+    prefaultStack();
+    if (applied) {
+        *applied = parts.isEmpty() ? QString("normal scheduling") : parts.join(", ");
+    }
+    return ok;
+}
+
+PeriodicTimer::PeriodicTimer()
+    : timerFd(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)),
+      wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      intervalNs(0),
+      nextDeadlineNs(0)
+{
+    if (!isValid()) {
+        qWarning() << "Cannot create periodic timer:" << strerror(errno);
+    }
+}
+
+PeriodicTimer::~PeriodicTimer()
+{
+    if (timerFd >= 0) {
+        close(timerFd);
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+}
+
+static timespec toTimespec(qint64 ns)
+{
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000LL);
+    return ts;
+}
+
+bool PeriodicTimer::start(qint64 interval)
+{
+    if (!isValid() || interval <= 0) {
+        return false;
+    }
+
+    // Drop an interrupt left over from a previous run
+    eventfd_t pending;
+    eventfd_read(wakeFd, &pending);
+
+    intervalNs = interval;
+    nextDeadlineNs = monotonicNs() + interval;
+    itimerspec spec;
+    spec.it_value = toTimespec(nextDeadlineNs);
+    spec.it_interval = toTimespec(interval);
+    return timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+}
+
+void PeriodicTimer::stop()
+{
+    if (timerFd >= 0) {
+        itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        timerfd_settime(timerFd, 0, &spec, nullptr);
+    }
+}
+
+quint64 PeriodicTimer::wait(qint64 *lateNs)
+{
+    pollfd fds[2];
+    fds[0].fd = timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        if (fds[1].revents & POLLIN) {
+            return 0;
+        }
+
+        uint64_t expirations = 0;
+        if (read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0) {
+            continue;
+        }
+        qint64 now = monotonicNs();
+        qint64 latestDeadline = nextDeadlineNs + static_cast<qint64>(expirations - 1) * intervalNs;
+        nextDeadlineNs = latestDeadline + intervalNs;
+        if (lateNs) {
+            *lateNs = now - latestDeadline;
+        }
+        return expirations;
+    }
+}
+
+void PeriodicTimer::interrupt()
+{
+    if (wakeFd >= 0) {
+        eventfd_write(wakeFd, 1);
+    }
+}
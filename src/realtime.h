@@ -0,0 +1,60 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <QString>
+#include <QtGlobal>
+
+// Scheduling for a latency-sensitive thread, so fan updates are not delayed
+// by CPU-bound work (compilers, renders) competing for the same cores
+struct RealtimeOptions {
+    bool enabled = false;
+    int fifoPriority = 0;       // SCHED_FIFO 1-99, 0 = stay SCHED_OTHER
+    int niceLevel = 0;          // -20..19; used without FIFO or if FIFO is refused
+    bool lockMemory = true;     // mlockall(), so no tick waits for a page-in
+
+    static const int DEFAULT_FIFO_PRIORITY = 10;
+    static const int DEFAULT_NICE_LEVEL = -10;
+
+    // "fifo", "fifo:PRIORITY", "nice" or "nice:LEVEL"; "off" or empty
+    // disables. Returns false on malformed input.
+    static bool parse(const QString& text, RealtimeOptions *options);
+};
+
+// Applies options to the calling thread (memory locking applies to the whole
+// process). Parts that are refused, typically for lack of CAP_SYS_NICE or
+// CAP_IPC_LOCK, are logged and skipped; FIFO falls back to the nice level.
+// applied receives what is in effect, e.g. "SCHED_FIFO 10, memory locked".
+bool applyRealtime(const RealtimeOptions& options, QString *applied);
+
+// Fixed-rate wakeups on a timerfd armed with absolute CLOCK_MONOTONIC
+// deadlines: a late tick does not push back the ones after it, and the
+// lateness of each wakeup is known exactly. interrupt() (any thread) makes
+// a pending wait() return.
+class PeriodicTimer {
+public:
+    PeriodicTimer();
+    ~PeriodicTimer();
+
+    bool isValid() const { return timerFd >= 0 && wakeFd >= 0; }
+
+    // First deadline one interval from now; also clears a pending interrupt
+    bool start(qint64 intervalNs);
+    void stop();
+
+    // Blocks until the next deadline. Returns the number of intervals that
+    // elapsed (more than 1 = ticks were missed) and sets lateNs to how long
+    // after the latest of them the wakeup happened; 0 when interrupted.
+    quint64 wait(qint64 *lateNs);
+    void interrupt();
+
+private:
+    int timerFd;
+    int wakeFd;                 // eventfd written by interrupt()
+    qint64 intervalNs;
+    qint64 nextDeadlineNs;
+
+    PeriodicTimer(const PeriodicTimer&) = delete;
+    PeriodicTimer& operator=(const PeriodicTimer&) = delete;
+};
+
+#endif // REALTIME_H
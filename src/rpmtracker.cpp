@@ -0,0 +1,152 @@
+#include "rpmtracker.h"
+#include <QtMath>
+
+// Weight of each sample in the smoothed tracking error
+static const double ERROR_SMOOTHING = 0.1;
+
+RpmTracker::RpmTracker(const Config& config)
+    : config(config),
+      minRPM(0),
+      maxRPM(0),
+      trackedRPM(0),
+      openLoopPWM(0),
+      learnedOffset(0),
+      pendingWrite(false),
+      targetSetMs(0),
+      lastWriteMs(0),
+      inBandCount(0)
+{
+    status.active = false;
+    status.targetRPM = 0;
+    status.measuredRPM = -1;
+    status.pwm = 0;
+    status.errorRPM = 0;
+    status.unreachable = false;
+    status.meanAbsError = 0.0;
+    status.converged = false;
+    status.lastConvergenceMs = -1;
+    status.maxConvergenceMs = -1;
+    status.convergences = 0;
+    status.trims = 0;
+}
+
+void RpmTracker::setResponse(const FanCalibrationTable& table, int min, int max)
+{
+    calibration = table;
+    minRPM = min;
+    maxRPM = max;
+    learnedOffset = 0;
+}
+
+double RpmTracker::pwmPerRPM(int rpm) const
+{
+    const QVector<FanCalibrationPoint>& points = calibration.points;
+    if (calibration.isValid()) {
+        // Slope of the segment around rpm; flat segments borrow the next one
+        for (int i = 0; i + 1 < points.size(); i++) {
+            int span = points[i + 1].rpm - points[i].rpm;
+            if (span > 0 && (rpm <= points[i + 1].rpm || i + 2 == points.size())) {
+                return static_cast<double>(points[i + 1].pwm - points[i].pwm) / span;
+            }
+        }
+    }
+    if (maxRPM > minRPM) {
+        return 255.0 / (maxRPM - minRPM);
+    }
+    return 255.0 / 5000.0;
+}
+
+int RpmTracker::lowestPWM() const
+{
+    // The calibration's points are speeds the fan kept running at
+    return status.targetRPM > 0 && calibration.isValid() ? calibration.points.first().pwm : 0;
+}
+
+void RpmTracker::setTarget(int rpm, int openLoop, qint64 nowMs)
+{
+    bool changed = !status.active || rpm != status.targetRPM;
+
+    status.active = true;
+    status.targetRPM = rpm;
+    status.unreachable = rpm > 0 && calibration.isValid() && rpm < calibration.minRPM();
+    trackedRPM = status.unreachable ? calibration.minRPM() : rpm;
+    openLoopPWM = openLoop;
+    status.pwm = qBound(lowestPWM(), openLoop + learnedOffset, 255);
+    pendingWrite = (status.pwm != openLoop);
+    lastWriteMs = nowMs;
+
+    if (changed) {
+        status.converged = false;
+        targetSetMs = nowMs;
+        inBandCount = 0;
+    }
+}
+
+void RpmTracker::clearTarget()
+{
+    status.active = false;
+    pendingWrite = false;
+}
+
+int RpmTracker::update(int measuredRPM, qint64 nowMs)
+{
+    if (!status.active) {
+        return -1;
+    }
+
+    status.measuredRPM = measuredRPM;
+    if (measuredRPM < 0) {
+        return -1;
+    }
+
+    if (pendingWrite) {
+        pendingWrite = false;
+        lastWriteMs = nowMs;
+        status.trims++;
+        return status.pwm;
+    }
+
+    int error = trackedRPM - measuredRPM;
+    status.errorRPM = error;
+    status.meanAbsError += ERROR_SMOOTHING * (qAbs(error) - status.meanAbsError);
+
+    int tolerance = qMax(config.toleranceRPM, trackedRPM * config.tolerancePercent / 100);
+    if (qAbs(error) <= tolerance) {
+        if (!status.converged && ++inBandCount >= config.inBandSamples) {
+            status.converged = true;
+            status.lastConvergenceMs = nowMs - targetSetMs;
+            status.maxConvergenceMs = qMax(status.maxConvergenceMs, status.lastConvergenceMs);
+            status.convergences++;
+            learnedOffset = status.pwm - openLoopPWM;
+        }
+        return -1;
+    }
+    inBandCount = 0;
+
+    // Give the fan time to respond to the previous correction
+    if (nowMs - lastWriteMs < config.settleMs) {
+        return -1;
+    }
+
+    int pwm;
+    if (status.targetRPM > 0 && measuredRPM == 0 && status.pwm < calibration.startPWM) {
+        // Stalled below the start threshold; integral steps would take ages
+        pwm = calibration.startPWM;
+    } else {
+        double step = error * pwmPerRPM(trackedRPM) * config.loopGain;
+        int rounded = qBound(-config.maxStep, static_cast<int>(qRound(step)), config.maxStep);
+        if (rounded == 0) {
+            rounded = error > 0 ? 1 : -1;
+        }
+        pwm = qBound(lowestPWM(), status.pwm + rounded, 255);
+    }
+
+    if (pwm == status.pwm) {
+        return -1;      // Saturated at the lowest running PWM or 255
+    }
+
+    status.pwm = pwm;
+    lastWriteMs = nowMs;
+    status.trims++;
+    return pwm;
+}
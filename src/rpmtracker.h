@@ -0,0 +1,86 @@
+#ifndef RPMTRACKER_H
+#define RPMTRACKER_H
+
+#include <QtGlobal>
+#include "fancalibration.h"
+
+// Snapshot of one fan's closed-loop tracking, for the debug log and metrics
+struct RpmTrackingStatus {
+    bool active;                // A target is being tracked
+    int targetRPM;
+    int measuredRPM;            // Last fan*_input reading (-1 = read failed)
+    int pwm;                    // Last PWM written
+    int errorRPM;               // Tracked speed - measured
+    bool unreachable;           // Target below the fan's lowest running speed; that speed is tracked instead
+    double meanAbsError;        // Smoothed |error| over recent samples, RPM
+    bool converged;             // Reached the tolerance band since the last target change
+    qint64 lastConvergenceMs;   // Time from target change to convergence (-1 = not yet)
+    qint64 maxConvergenceMs;
+    quint64 convergences;       // Target changes that converged
+    quint64 trims;              // PWM corrections written
+};
+
+// Inner control loop for one PWM fan: given a target RPM and periodic
+// fan*_input readings, trims the PWM value until the measured speed is
+// within tolerance of the target. UI-free and I/O-free; FanSampler does the
+// sysfs reads and writes.
+//
+// Corrections are integral steps scaled by the local PWM/RPM slope, taken
+// from the fan's calibration table when it has one. After each correction
+// the loop waits for the fan to spin up or down before judging it again.
+// The PWM offset that converged is remembered and applied to the open-loop
+// guess of the next target. With a calibration, a running target never
+// takes the PWM below the lowest point the fan ran at: a target slower than
+// that is tracked at that point and reported unreachable, since trimming
+// into the stall would only stop and restart the fan over and over.
+class RpmTracker {
+public:
+    struct Config {
+        int toleranceRPM;           // Absolute tolerance band
+        int tolerancePercent;       // Relative tolerance band, whichever is larger
+        int settleMs;               // Wait after a correction before the next one
+        double loopGain;            // Fraction of the estimated PWM error corrected per step
+        int maxStep;                // Largest single PWM correction
+        int inBandSamples;          // Consecutive in-band samples that count as converged
+
+        Config()
+            : toleranceRPM(50), tolerancePercent(3), settleMs(750),
+              loopGain(0.5), maxStep(12), inBandSamples(2) {}
+    };
+
+    explicit RpmTracker(const Config& config = Config());
+
+    // Response estimate used for the step size: the calibration table if
+    // valid, otherwise a linear map over [minRPM, maxRPM]
+    void setResponse(const FanCalibrationTable& calibration, int minRPM, int maxRPM);
+
+    // New target. openLoopPWM is what the caller already wrote for it.
+    void setTarget(int rpm, int openLoopPWM, qint64 nowMs);
+    void clearTarget();
+    bool isActive() const { return status.active; }
+
+    // Feed one reading. Returns the PWM to write, or -1 to leave it alone.
+    int update(int measuredRPM, qint64 nowMs);
+
+    RpmTrackingStatus getStatus() const { return status; }
+
+private:
+    Config config;
+    FanCalibrationTable calibration;
+    int minRPM;
+    int maxRPM;
+
+    RpmTrackingStatus status;
+    int trackedRPM;             // targetRPM, raised to the lowest running speed
+    int openLoopPWM;
+    int learnedOffset;          // PWM that converged minus its open-loop guess
+    bool pendingWrite;          // Learned offset not written yet
+    qint64 targetSetMs;
+    qint64 lastWriteMs;
+    int inBandCount;
+
+    double pwmPerRPM(int rpm) const;
+    int lowestPWM() const;
+};
+
+#endif // RPMTRACKER_H
@@ -3,13 +3,16 @@
 #include <QTextStream>
 #include <QDebug>
 
-QMap<QString, QString> SensorDescriptions::customDescriptions;
+std::shared_ptr<const SensorDescriptions::Table> SensorDescriptions::customDescriptions =
+    std::make_shared<const SensorDescriptions::Table>();
 
 QString SensorDescriptions::getDescription(const QString& sensorLabel, const QString& macModel)
 {
-    // Check custom descriptions first
-    if (customDescriptions.contains(sensorLabel)) {
-        return customDescriptions[sensorLabel];
+    // Check custom descriptions first; the table stays alive while we use it
+    std::shared_ptr<const Table> custom = std::atomic_load(&customDescriptions);
+    auto it = custom->constFind(sensorLabel);
+    if (it != custom->constEnd()) {
+        return it.value();
     }
 
     // Get model-specific descriptions
@@ -38,9 +41,15 @@ QString SensorDescriptions::getDescription(const QString& sensorLabel, const QSt
 
 void SensorDescriptions::loadCustomDescriptions(const QString& configPath)
 {
+    setCustomDescriptions(parseCustomDescriptions(configPath));
+}
+
+SensorDescriptions::Table SensorDescriptions::parseCustomDescriptions(const QString& configPath)
+{
+    Table table;
     QFile file(configPath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return;
+        return table;
     }
 
     QTextStream in(&file);
@@ -57,12 +66,34 @@ void SensorDescriptions::loadCustomDescriptions(const QString& configPath)
         if (equalPos > 0) {
             QString sensorCode = line.left(equalPos).trimmed();
             QString description = line.mid(equalPos + 1).trimmed();
-            customDescriptions[sensorCode] = description;
+            table[sensorCode] = description;
             qDebug() << "Loaded custom description:" << sensorCode << "=" << description;
         }
     }
 
     file.close();
+    return table;
+}
+
+QSet<QString> SensorDescriptions::setCustomDescriptions(const Table& table)
+{
+    std::shared_ptr<const Table> next = std::make_shared<const Table>(table);
+    std::shared_ptr<const Table> previous = std::atomic_exchange(&customDescriptions, next);
+
+    // Added, removed and reworded labels
+    QSet<QString> changed;
+    for (auto it = table.constBegin(); it != table.constEnd(); ++it) {
+        auto old = previous->constFind(it.key());
+        if (old == previous->constEnd() || old.value() != it.value()) {
+            changed.insert(it.key());
+        }
+    }
+    for (auto it = previous->constBegin(); it != previous->constEnd(); ++it) {
+        if (!table.contains(it.key())) {
+            changed.insert(it.key());
+        }
+    }
+    return changed;
 }
 
 QMap<QString, QString> SensorDescriptions::getDefaultDescriptions()
@@ -3,19 +3,32 @@
 
 #include <QString>
 #include <QMap>
+#include <QSet>
+#include <memory>
 
+// Custom descriptions from the config file take precedence over the
+// built-in per-model tables. The custom table is immutable once published:
+// a reload parses into a new table and swaps the pointer atomically, so a
+// lookup never sees a half-loaded table and never waits for a reload.
 class SensorDescriptions {
 public:
+    typedef QMap<QString, QString> Table;   // Sensor label -> description
+
     static QString getDescription(const QString& sensorLabel, const QString& macModel);
     static void loadCustomDescriptions(const QString& configPath);
 
+    // Reads "LABEL=Description" lines; no side effects, safe on any thread
+    static Table parseCustomDescriptions(const QString& configPath);
+    // Publishes table; returns the labels whose custom description changed
+    static QSet<QString> setCustomDescriptions(const Table& table);
+
 private:
     static QMap<QString, QString> getDefaultDescriptions();
     static QMap<QString, QString> getMacProDescriptions();
     static QMap<QString, QString> getMacBookProDescriptions();
     static QMap<QString, QString> getMacMiniDescriptions();
     static QMap<QString, QString> getiMacDescriptions();
-    static QMap<QString, QString> customDescriptions;
+    static std::shared_ptr<const Table> customDescriptions;    // Access with std::atomic_load/store
 };
 
 #endif // SENSORDESCRIPTIONS_H
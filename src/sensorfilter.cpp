@@ -0,0 +1,215 @@
+#include "sensorfilter.h"
+#include <QStringList>
+#include <QRegularExpression>
+#include <QtMath>
+#include <algorithm>
+
+// Large but finite so that rate * dt never produces inf - inf
+static const float RATE_UNLIMITED = 1.0e9f;
+
+QString SensorFilterSpec::toString() const
+{
+    if (isPassThrough()) {
+        return "none";
+    }
+
+    QStringList parts;
+    if (medianWindow > 1) {
+        parts << QString("median:%1").arg(medianWindow);
+    }
+    if (emaAlpha < 1.0) {
+        parts << QString("ema:%1").arg(emaAlpha);
+    }
+    if (maxRate > 0.0) {
+        parts << QString("rate:%1").arg(maxRate);
+    }
+    return parts.join(' ');
+}
+
+SensorFilterSpec SensorFilterSpec::fromString(const QString& text, bool *ok)
+{
+    SensorFilterSpec spec;
+    bool valid = true;
+
+    const QStringList parts = text.split(QRegularExpression("[\\s,]+"), Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        if (part == "none") {
+            continue;
+        }
+
+        int colon = part.indexOf(':');
+        QString key = part.left(colon).toLower();
+        bool numberOk = false;
+        double value = part.mid(colon + 1).toDouble(&numberOk);
+        if (colon < 0 || !numberOk) {
+            valid = false;
+            continue;
+        }
+
+        if (key == "median" && value >= 1 && value <= SensorFilterBank::MAX_MEDIAN_WINDOW) {
+            spec.medianWindow = static_cast<int>(value);
+        } else if (key == "ema" && value > 0.0 && value <= 1.0) {
+            spec.emaAlpha = value;
+        } else if (key == "rate" && value >= 0.0) {
+            spec.maxRate = value;
+        } else {
+            valid = false;
+        }
+    }
+
+    if (ok) {
+        *ok = valid;
+    }
+    return spec;
+}
+
+void SensorFilterBank::setDefaultSpec(const SensorFilterSpec& spec)
+{
+    defaultSpec = spec;
+    configChanged = true;
+}
+
+void SensorFilterBank::setSpec(const QString& label, const SensorFilterSpec& spec)
+{
+    specs[label] = spec;
+    configChanged = true;
+}
+
+void SensorFilterBank::removeSpec(const QString& label)
+{
+    specs.remove(label);
+    configChanged = true;
+}
+
+SensorFilterSpec SensorFilterBank::specFor(const QString& label) const
+{
+    return specs.value(label, defaultSpec);
+}
+
+void SensorFilterBank::reset()
+{
+    std::fill(primed.begin(), primed.end(), 0);
+    std::fill(medianFill.begin(), medianFill.end(), 0);
+    lastTimestamp = -1;
+}
+
+void SensorFilterBank::rebind(const QVector<TempSensor>& sensors)
+{
+    const size_t count = sensors.size();
+
+    // Carry history over for sensors that were already filtered
+    std::vector<float> oldState = state;
+    std::vector<unsigned char> oldPrimed = primed;
+    QMap<int, size_t> oldPosition;
+    for (size_t i = 0; i < channelSensor.size(); i++) {
+        oldPosition.insert(channelSensor[i], i);
+    }
+
+    channelSensor.assign(count, 0);
+    alpha.assign(count, 1.0f);
+    maxRate.assign(count, RATE_UNLIMITED);
+    input.assign(count, 0.0f);
+    state.assign(count, 0.0f);
+    primed.assign(count, 0);
+
+    medianChannels.clear();
+    medianWindow.clear();
+    medianFill.clear();
+    medianPos.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        const TempSensor& sensor = sensors[static_cast<int>(i)];
+        SensorFilterSpec spec = specFor(sensor.label);
+
+        channelSensor[i] = sensor.index;
+        alpha[i] = static_cast<float>(spec.emaAlpha);
+        if (spec.maxRate > 0.0) {
+            maxRate[i] = static_cast<float>(spec.maxRate);
+        }
+        if (spec.medianWindow > 1) {
+            medianChannels.push_back(static_cast<int>(i));
+            medianWindow.push_back(spec.medianWindow);
+            medianFill.push_back(0);
+            medianPos.push_back(0);
+        }
+
+        QMap<int, size_t>::const_iterator old = oldPosition.constFind(sensor.index);
+        if (old != oldPosition.constEnd()) {
+            state[i] = oldState[old.value()];
+            primed[i] = oldPrimed[old.value()];
+        }
+    }
+
+    medianRing.assign(medianChannels.size() * MAX_MEDIAN_WINDOW, 0.0f);
+    configChanged = false;
+}
+
+void SensorFilterBank::apply(QVector<TempSensor>& sensors, qint64 timestampMs)
+{
+    const size_t count = sensors.size();
+    bool layoutChanged = configChanged || count != channelSensor.size();
+    for (size_t i = 0; !layoutChanged && i < count; i++) {
+        layoutChanged = (sensors[static_cast<int>(i)].index != channelSensor[i]);
+    }
+    if (layoutChanged) {
+        rebind(sensors);
+    }
+
+    // The first tick has no interval; allow one second's worth of change
+    float dt = (lastTimestamp >= 0 && timestampMs > lastTimestamp)
+               ? (timestampMs - lastTimestamp) / 1000.0f : 1.0f;
+    lastTimestamp = timestampMs;
+
+    TempSensor *data = sensors.data();
+
+    // Gather. Invalid readings leave the channel untouched; feeding the
+    // previous output back in keeps the loops below branch-free.
+    for (size_t i = 0; i < count; i++) {
+        int reading = data[i].temperature;
+        if (reading <= -100000) {
+            input[i] = state[i];
+        } else {
+            input[i] = reading / 1000.0f;
+            if (!primed[i]) {
+                state[i] = input[i];
+                primed[i] = 1;
+            }
+        }
+    }
+
+    // Median of the last N samples. A channel without a valid reading yet
+    // has nothing to feed back and stays out of its window.
+    for (size_t m = 0; m < medianChannels.size(); m++) {
+        int channel = medianChannels[m];
+        if (!primed[channel]) {
+            continue;
+        }
+        float *ring = &medianRing[m * MAX_MEDIAN_WINDOW];
+        ring[medianPos[m]] = input[channel];
+        medianPos[m] = (medianPos[m] + 1) % medianWindow[m];
+        medianFill[m] = qMin(medianFill[m] + 1, medianWindow[m]);
+
+        float window[MAX_MEDIAN_WINDOW];
+        std::copy(ring, ring + medianFill[m], window);
+        std::nth_element(window, window + medianFill[m] / 2, window + medianFill[m]);
+        input[channel] = window[medianFill[m] / 2];
+    }
+
+    // EMA and rate limit over contiguous arrays
+    float *x = input.data();
+    float *y = state.data();
+    const float *a = alpha.data();
+    const float *r = maxRate.data();
+    for (size_t i = 0; i < count; i++) {
+        float target = y[i] + a[i] * (x[i] - y[i]);
+        float step = r[i] * dt;
+        y[i] = qBound(y[i] - step, target, y[i] + step);
+    }
+
+    // Scatter
+    for (size_t i = 0; i < count; i++) {
+        if (data[i].temperature > -100000) {
+            data[i].temperature = qRound(y[i] * 1000.0f);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef SENSORFILTER_H
+#define SENSORFILTER_H
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+#include <vector>
+#include "smcinterface.h"
+
+// Noise filter settings for one sensor. Stages run in the order
+// median -> EMA -> rate limit; each stage can be disabled on its own.
+struct SensorFilterSpec {
+    int medianWindow;       // Median of the last N samples (1 = off)
+    double emaAlpha;        // Exponential moving average weight (1.0 = off)
+    double maxRate;         // Max change in °C per second (0 = off)
+
+    SensorFilterSpec() : medianWindow(1), emaAlpha(1.0), maxRate(0.0) {}
+
+    bool isPassThrough() const { return medianWindow <= 1 && emaAlpha >= 1.0 && maxRate <= 0.0; }
+
+    // Text form used in settings and dialogs, e.g. "median:5 ema:0.3 rate:2"
+    // or "none"
+    QString toString() const;
+    static SensorFilterSpec fromString(const QString& text, bool *ok = nullptr);
+};
+
+// Applies per-sensor filters to a whole temperature snapshot. Filter state is
+// kept in flat per-channel arrays in snapshot order, so a tick is one gather,
+// a few branch-free loops over contiguous floats and one scatter.
+class SensorFilterBank {
+public:
+    static const int MAX_MEDIAN_WINDOW = 9;
+
+    void setDefaultSpec(const SensorFilterSpec& spec);
+    SensorFilterSpec getDefaultSpec() const { return defaultSpec; }
+
+    // Per-sensor override, keyed by sensor label
+    void setSpec(const QString& label, const SensorFilterSpec& spec);
+    void removeSpec(const QString& label);
+    QMap<QString, SensorFilterSpec> getSpecs() const { return specs; }
+
+    // Filter the readings in place. timestampMs drives the rate limiter.
+    void apply(QVector<TempSensor>& sensors, qint64 timestampMs);
+
+    // Forget all filter history (e.g. after a long pause)
+    void reset();
+
+private:
+    SensorFilterSpec defaultSpec;
+    QMap<QString, SensorFilterSpec> specs;
+    bool configChanged = true;
+    qint64 lastTimestamp = -1;
+
+    // Per-channel configuration and state, indexed by snapshot position
+    std::vector<int> channelSensor;     // TempSensor::index, used to detect layout changes
+    std::vector<float> alpha;           // EMA weight (1 = off)
+    std::vector<float> maxRate;         // °C/s (very large = off)
+    std::vector<float> input;           // This tick's raw (or median) reading, °C
+    std::vector<float> state;           // Last filtered output, °C
+    std::vector<unsigned char> primed;  // State holds a real reading
+
+    // Median stage, only for channels that use it
+    std::vector<int> medianChannels;
+    std::vector<int> medianWindow;
+    std::vector<int> medianFill;
+    std::vector<int> medianPos;
+    std::vector<float> medianRing;      // MAX_MEDIAN_WINDOW entries per median channel
+
+    void rebind(const QVector<TempSensor>& sensors);
+    SensorFilterSpec specFor(const QString& label) const;
+};
+
+#endif // SENSORFILTER_H
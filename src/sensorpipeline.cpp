@@ -0,0 +1,57 @@
+#include "sensorpipeline.h"
+
+SensorPipeline::SensorPipeline(SMCInterface *smc, HWMonInterface *hwmon,
+                               SensorFilterBank *filters, VirtualSensorEngine *virtualSensors)
+    : smc(smc),
+      hwmon(hwmon),
+      filters(filters),
+      virtualSensors(virtualSensors),
+      latency(nullptr)
+{
+}
+
+QVector<TempSensor> SensorPipeline::readHardware()
+{
+    qint64 start = monotonicNs();
+    QVector<TempSensor> temps = smc->getTemperatures();
+    qint64 smcDone = monotonicNs();
+    QVector<HWMonSensor> hwmonSensors = hwmon->getTemperatures();
+    if (latency) {
+        latency->recordSample(TickLatencyStats::BACKEND_SMC, start, smcDone);
+        latency->recordSample(TickLatencyStats::BACKEND_HWMON, smcDone, monotonicNs());
+    }
+
+    // Convert hwmon sensors to TempSensor format
+    temps.reserve(temps.size() + hwmonSensors.size());
+    for (const HWMonSensor& hwSensor : hwmonSensors) {
+        TempSensor sensor;
+        sensor.index = hwSensor.index;
+        sensor.label = hwSensor.label;
+        sensor.temperature = hwSensor.temperature;
+        sensor.sysfsPath = hwSensor.devicePath;
+        sensor.deviceName = hwSensor.deviceName;
+        temps.append(sensor);
+    }
+
+    return temps;
+}
+
+QVector<TempSensor> SensorPipeline::sample(qint64 timestampMs, QVector<TempSensor> *raw)
+{
+    QVector<TempSensor> temps = readHardware();
+    if (raw) {
+        *raw = temps;
+    }
+    filters->apply(temps, timestampMs);
+    virtualSensors->evaluate(temps);
+    virtualSensors->appendTo(temps);
+    return temps;
+}
+
+QVector<TempSensor> SensorPipeline::catalog()
+{
+    QVector<TempSensor> temps = readHardware();
+    virtualSensors->evaluate(temps);
+    virtualSensors->appendTo(temps);
+    return temps;
+}
@@ -0,0 +1,42 @@
+#ifndef SENSORPIPELINE_H
+#define SENSORPIPELINE_H
+
+#include <QVector>
+#include "smcinterface.h"
+#include "hwmoninterface.h"
+#include "sensorfilter.h"
+#include "virtualsensors.h"
+#include "latencystats.h"
+
+// Builds the temperature snapshot the control loop works on: SMC and hwmon
+// readings merged into one list, de-noised by the sensor filters, with the
+// virtual sensors appended. Kept free of any UI so the app, benchmarks and
+// tools all run the same code.
+class SensorPipeline {
+public:
+    SensorPipeline(SMCInterface *smc, HWMonInterface *hwmon,
+                   SensorFilterBank *filters, VirtualSensorEngine *virtualSensors);
+
+    // Optional per-backend read latency recording
+    void setLatencyStats(TickLatencyStats *stats) { latency = stats; }
+
+    // Raw readings from both backends
+    QVector<TempSensor> readHardware();
+
+    // Full snapshot for one tick; timestampMs drives the filters. raw, if
+    // given, receives the unfiltered backend readings (for trace recording).
+    QVector<TempSensor> sample(qint64 timestampMs, QVector<TempSensor> *raw = nullptr);
+
+    // Raw readings plus freshly evaluated virtual sensors, without advancing
+    // filter state (for sensor lists and diagnostics)
+    QVector<TempSensor> catalog();
+
+private:
+    SMCInterface *smc;
+    HWMonInterface *hwmon;
+    SensorFilterBank *filters;
+    VirtualSensorEngine *virtualSensors;
+    TickLatencyStats *latency;
+};
+
+#endif // SENSORPIPELINE_H
@@ -1,4 +1,5 @@
 #include "smcinterface.h"
+#include "readprofiler.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDir>
@@ -10,7 +11,7 @@ SMCInterface::SMCInterface(QObject *parent)
 {
 }
 
-bool SMCInterface::findBasePath()
+QString SMCInterface::probeBasePath() const
 {
     // Candidate paths in order of preference
     QStringList candidates = {
@@ -19,14 +20,23 @@ bool SMCInterface::findBasePath()
     };
 
     for (const QString& candidate : candidates) {
-        if (QFile::exists(candidate + "/fan1_input")) {
-            basePath = candidate;
-            qDebug() << "Found SMC interface at:" << basePath;
-            return true;
+        if (QFile::exists(sysfsRoot + candidate + "/fan1_input")) {
+            return sysfsRoot + candidate;
         }
     }
 
-    return false;
+    return QString();
+}
+
+bool SMCInterface::findBasePath()
+{
+    QString found = probeBasePath();
+    if (found.isEmpty()) {
+        return false;
+    }
+    basePath = found;
+    qDebug() << "Found SMC interface at:" << basePath;
+    return true;
 }
 
 bool SMCInterface::initialize()
@@ -59,6 +69,31 @@ bool SMCInterface::initialize()
     return true;
 }
 
+bool SMCInterface::initializeFromTopology(const QString& cachedBasePath, const QString& cachedMacModel,
+                                          const QVector<FanInfo>& cachedFans,
+                                          const QVector<TempSensor>& cachedSensors)
+{
+    basePath = cachedBasePath;
+    macModel = cachedMacModel;
+    fans = cachedFans;
+    sensors = cachedSensors;
+    qDebug() << "Using cached SMC topology at:" << basePath << "for" << macModel;
+
+    // Speeds and modes may have changed since the manifest was written
+    for (FanInfo& fan : fans) {
+        fan.currentRPM = readSysfsInt(fan.sysfsPath + "_input");
+        fan.isManual = (readSysfsInt(fan.sysfsPath + "_manual") == 1);
+        fan.targetRPM = readSysfsInt(fan.sysfsPath + "_output");
+    }
+
+    if (fans.isEmpty()) {
+        emit error("No fans discovered!");
+        return false;
+    }
+
+    return true;
+}
+
 bool SMCInterface::hasWritePermission()
 {
     // Try to open fan1_manual for writing (without actually writing)
@@ -110,6 +145,7 @@ void SMCInterface::discoverTemperatureSensors()
             sensor.label = readSysfsString(tempBase + "_label").trimmed();
             sensor.temperature = readSysfsInt(inputPath);
             sensor.sysfsPath = inputPath;
+            sensor.deviceName = "applesmc";
 
             // Only add sensors with valid readings (skip -128°C and similar invalid values)
             if (sensor.temperature > -100000) {  // -100°C in millidegrees
@@ -183,7 +219,11 @@ int SMCInterface::getFanCurrentRPM(int fanIndex)
         return -1;
     }
 
+    qint64 start = monotonicNs();
     int rpm = readSysfsInt(fans[fanIndex].sysfsPath + "_input");
+    if (profiler) {
+        profiler->record(fanProfileIds[fanIndex], monotonicNs() - start);
+    }
     fans[fanIndex].currentRPM = rpm;
     return rpm;
 }
@@ -236,16 +276,42 @@ QVector<TempSensor> SMCInterface::getTemperatures()
 {
     // Update temperature readings
     for (int i = 0; i < sensors.size(); i++) {
-        sensors[i].temperature = readSysfsInt(sensors[i].sysfsPath);
+        if (!profiler) {
+            sensors[i].temperature = readSysfsInt(sensors[i].sysfsPath);
+            continue;
+        }
+        // Sensors in the slow class keep their last reading until due
+        int id = sensorProfileIds[i];
+        if (profiler->isDue(id)) {
+            qint64 start = monotonicNs();
+            sensors[i].temperature = readSysfsInt(sensors[i].sysfsPath);
+            profiler->record(id, monotonicNs() - start);
+        }
     }
 
     return sensors;
 }
 
+void SMCInterface::setReadProfiler(ReadProfiler *readProfiler)
+{
+    profiler = readProfiler;
+    sensorProfileIds.clear();
+    fanProfileIds.clear();
+    if (!profiler) {
+        return;
+    }
+    for (const TempSensor& sensor : sensors) {
+        sensorProfileIds.append(profiler->registerAttribute("applesmc", sensor.sysfsPath, sensor.index));
+    }
+    for (const FanInfo& fan : fans) {
+        fanProfileIds.append(profiler->registerAttribute("applesmc", fan.sysfsPath + "_input", -1));
+    }
+}
+
 void SMCInterface::detectMacModel()
 {
     // Try to read Mac model from DMI information
-    QFile productNameFile("/sys/devices/virtual/dmi/id/product_name");
+    QFile productNameFile(sysfsRoot + "/sys/devices/virtual/dmi/id/product_name");
     if (productNameFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
         QTextStream in(&productNameFile);
         macModel = in.readLine().trimmed();
@@ -254,7 +320,7 @@ void SMCInterface::detectMacModel()
 
     // If that fails, try to read from board_name
     if (macModel.isEmpty()) {
-        QFile boardNameFile("/sys/devices/virtual/dmi/id/board_name");
+        QFile boardNameFile(sysfsRoot + "/sys/devices/virtual/dmi/id/board_name");
         if (boardNameFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
             QTextStream in(&boardNameFile);
             macModel = in.readLine().trimmed();
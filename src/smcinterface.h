@@ -5,6 +5,8 @@
 #include <QString>
 #include <QVector>
 
+class ReadProfiler;
+
 // Fan data structure
 struct FanInfo {
     int index;              // 1-6
@@ -23,6 +25,7 @@ struct TempSensor {
     QString label;          // Sensor code (e.g., "TA0P")
     int temperature;        // In millidegrees Celsius
     QString sysfsPath;      // Path to temp file
+    QString deviceName;     // "applesmc", hwmon driver name or "virtual"
 };
 
 class SMCInterface : public QObject {
@@ -33,6 +36,16 @@ public:
 
     // Initialization
     bool initialize();
+
+    // Topology found earlier (a DiscoveryManifest, or discovery run on
+    // another thread) instead of probing; only fan state
+    // (speed, mode, target) is read from sysfs
+    bool initializeFromTopology(const QString& basePath, const QString& macModel,
+                                const QVector<FanInfo>& fans, const QVector<TempSensor>& sensors);
+
+    // applesmc directory that would be used, without discovering anything
+    // (empty = none found)
+    QString probeBasePath() const;
     bool hasWritePermission();
 
     // Fan operations
@@ -43,11 +56,23 @@ public:
 
     // Temperature operations
     QVector<TempSensor> getTemperatures();
+    QVector<TempSensor> getSensors() const { return sensors; }  // Last readings, no I/O
 
     // System information
     QString getMacModel() const { return macModel; }
     QString getBasePath() const { return basePath; }
 
+    // Prefix for all sysfs paths (empty = the real /sys); set before initialize()
+    void setSysfsRoot(const QString& root) { sysfsRoot = root; }
+    QString getSysfsRoot() const { return sysfsRoot; }
+
+    // Time every temperature and fan speed read and poll sensors in the
+    // profiler's slow class less often (nullptr = off); call after initialization
+    void setReadProfiler(ReadProfiler *profiler);
+
+    // Low-level sysfs access, public for tools and benchmarks
+    int readSysfsInt(const QString& path);
+
 signals:
     void error(const QString& message);
     void warning(const QString& message);
@@ -58,8 +83,13 @@ private:
     QVector<TempSensor> sensors;
     QString macModel;
 
+    QString sysfsRoot;
+
+    ReadProfiler *profiler = nullptr;
+    QVector<int> sensorProfileIds;
+    QVector<int> fanProfileIds;
+
     // Helper functions for sysfs I/O
-    int readSysfsInt(const QString& path);
     QString readSysfsString(const QString& path);
     bool writeSysfsInt(const QString& path, int value);
 
@@ -5,7 +5,8 @@
 #include <QScrollBar>
 
 TemperaturePanel::TemperaturePanel(QWidget *parent)
-    : QWidget(parent)
+    : QWidget(parent),
+      nextRow(0)
 {
     // Create main layout
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
@@ -35,17 +36,12 @@ TemperaturePanel::TemperaturePanel(QWidget *parent)
 
 void TemperaturePanel::updateTemperatures(const QVector<TempSensor>& sensors)
 {
-    int row = 0;
-    int col = 0;
-    const int maxColumns = 1;  // Display in 1 column for better scrolling
-
     for (const TempSensor& sensor : sensors) {
         // Skip invalid readings
         if (sensor.temperature <= -100000) {  // -100°C in millidegrees
             continue;
         }
 
-        QString description = SensorDescriptions::getDescription(sensor.label, macModel);
         QString tempStr = formatTemperature(sensor.temperature);
         double celsius = sensor.temperature / 1000.0;
         QColor color = getTemperatureColor(celsius);
@@ -53,27 +49,22 @@ void TemperaturePanel::updateTemperatures(const QVector<TempSensor>& sensors)
         // Create or update label if it doesn't exist
         if (!tempLabels.contains(sensor.index)) {
             // Create label row with description
-            // If description is the raw label (no mapping found), don't repeat it
-        QString labelText = (description == sensor.label)
-            ? sensor.label + ":"
-            : QString("%1 (%2):").arg(description).arg(sensor.label);
-            QLabel *nameLabel = new QLabel(labelText, contentWidget);
+            QLabel *nameLabel = new QLabel(nameText(sensor.label), contentWidget);
             nameLabel->setStyleSheet("font-size: 11px;");
 
             QLabel *tempLabel = new QLabel(tempStr, contentWidget);
             tempLabel->setStyleSheet(QString("font-weight: bold; font-size: 11px; color: %1;")
                                      .arg(color.name()));
 
-            gridLayout->addWidget(nameLabel, row, col * 2);
-            gridLayout->addWidget(tempLabel, row, col * 2 + 1);
+            // Display in 1 column for better scrolling; sensors added later
+            // (e.g. virtual sensors) continue below the existing rows
+            gridLayout->addWidget(nameLabel, nextRow, 0);
+            gridLayout->addWidget(tempLabel, nextRow, 1);
+            nextRow++;
 
+            nameLabels[sensor.index] = nameLabel;
             tempLabels[sensor.index] = tempLabel;
-
-            col++;
-            if (col >= maxColumns) {
-                col = 0;
-                row++;
-            }
+            sensorLabels[sensor.index] = sensor.label;
         } else {
             // Update existing label
             QLabel *tempLabel = tempLabels[sensor.index];
@@ -84,6 +75,37 @@ void TemperaturePanel::updateTemperatures(const QVector<TempSensor>& sensors)
     }
 }
 
+void TemperaturePanel::removeSensor(int sensorIndex)
+{
+    if (!tempLabels.contains(sensorIndex)) {
+        return;
+    }
+
+    sensorLabels.remove(sensorIndex);
+    QLabel *nameLabel = nameLabels.take(sensorIndex);
+    QLabel *tempLabel = tempLabels.take(sensorIndex);
+    gridLayout->removeWidget(nameLabel);
+    gridLayout->removeWidget(tempLabel);
+    nameLabel->deleteLater();
+    tempLabel->deleteLater();
+}
+
+void TemperaturePanel::refreshDescriptions(const QSet<QString>& labels)
+{
+    for (auto it = sensorLabels.constBegin(); it != sensorLabels.constEnd(); ++it) {
+        if (labels.contains(it.value())) {
+            nameLabels[it.key()]->setText(nameText(it.value()));
+        }
+    }
+}
+
+QString TemperaturePanel::nameText(const QString& label) const
+{
+    // If description is the raw label (no mapping found), don't repeat it
+    QString description = SensorDescriptions::getDescription(label, macModel);
+    return description == label ? label + ":" : QString("%1 (%2):").arg(description).arg(label);
+}
+
 QString TemperaturePanel::formatTemperature(int millidegrees)
 {
     double celsius = millidegrees / 1000.0;
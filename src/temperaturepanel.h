@@ -6,6 +6,7 @@
 #include <QGridLayout>
 #include <QLabel>
 #include <QMap>
+#include <QSet>
 #include "smcinterface.h"
 
 class TemperaturePanel : public QWidget {
@@ -15,6 +16,9 @@ public:
     explicit TemperaturePanel(QWidget *parent = nullptr);
 
     void updateTemperatures(const QVector<TempSensor>& sensors);
+    void removeSensor(int sensorIndex);
+    // Re-label the rows of these sensors after the descriptions changed
+    void refreshDescriptions(const QSet<QString>& labels);
     void setMacModel(const QString& model) { macModel = model; }
 
 private:
@@ -22,9 +26,13 @@ private:
     QWidget *contentWidget;
     QGridLayout *gridLayout;
     QMap<int, QLabel*> tempLabels;  // Maps sensor index to temperature label
+    QMap<int, QLabel*> nameLabels;  // Maps sensor index to name label
+    QMap<int, QString> sensorLabels;    // Maps sensor index to its raw label
+    int nextRow;
     QString macModel;
 
     QString formatTemperature(int millidegrees);
+    QString nameText(const QString& label) const;
     QColor getTemperatureColor(double celsius);
 };
 
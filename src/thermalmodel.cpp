@@ -0,0 +1,275 @@
+#include "thermalmodel.h"
+#include <QFileInfo>
+#include <QSettings>
+#include <QStringList>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// Unquoted INI values containing commas come back as string lists
+QString textValue(const QSettings& settings, const QString& key)
+{
+    QVariant value = settings.value(key);
+    if (value.type() == QVariant::StringList) {
+        return value.toStringList().join(',');
+    }
+    return value.toString();
+}
+
+} // namespace
+
+bool ThermalModel::load(const QString& path, QString *errorMessage)
+{
+    auto fail = [errorMessage, &path](const QString& message) {
+        if (errorMessage) {
+            *errorMessage = QString("%1: %2").arg(path, message);
+        }
+        return false;
+    };
+
+    if (!QFileInfo(path).isReadable()) {
+        return fail("cannot read model file");
+    }
+    QSettings settings(path, QSettings::IniFormat);
+
+    name = textValue(settings, "model/name");
+    ambient = settings.value("model/ambient", 25.0).toDouble();
+    airflowExponent = settings.value("model/airflowExponent", 0.8).toDouble();
+
+    fans.clear();
+    settings.beginGroup("fans");
+    int fanCount = settings.value("count", 0).toInt();
+    for (int i = 1; i <= fanCount; i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        ThermalFan fan;
+        fan.label = textValue(settings, "label");
+        fan.minRPM = settings.value("min", 0).toInt();
+        fan.maxRPM = settings.value("max", 0).toInt();
+        fan.timeConstant = settings.value("timeConstant", 2.0).toDouble();
+        settings.endGroup();
+        if (fan.maxRPM <= fan.minRPM || fan.timeConstant <= 0.0) {
+            settings.endGroup();
+            return fail(QString("fan %1 needs max > min and a positive time constant").arg(i));
+        }
+        fans.append(fan);
+    }
+    settings.endGroup();
+
+    nodes.clear();
+    settings.beginGroup("nodes");
+    int nodeCount = settings.value("count", 0).toInt();
+    for (int i = 1; i <= nodeCount; i++) {
+        settings.beginGroup(QString("Node%1").arg(i));
+        ThermalNode node;
+        node.name = textValue(settings, "name");
+        node.sensorLabel = textValue(settings, "sensor");
+        node.capacity = settings.value("capacity", 0.0).toDouble();
+        node.idlePower = settings.value("idlePower", 0.0).toDouble();
+        node.loadPower = settings.value("loadPower", 0.0).toDouble();
+        node.ambientConductance = settings.value("ambient", 0.0).toDouble();
+        const QStringList couplings = textValue(settings, "cooling").split(' ', Qt::SkipEmptyParts);
+        settings.endGroup();
+
+        if (node.name.isEmpty() || node.capacity <= 0.0) {
+            settings.endGroup();
+            return fail(QString("node %1 needs a name and a positive capacity").arg(i));
+        }
+        for (const QString& coupling : couplings) {
+            const QStringList parts = coupling.split(':');
+            bool fanOk = false;
+            bool conductanceOk = false;
+            int fan = parts.value(0).toInt(&fanOk) - 1;
+            double conductance = parts.value(1).toDouble(&conductanceOk);
+            if (parts.size() != 2 || !fanOk || !conductanceOk || fan < 0 || fan >= fans.size()) {
+                settings.endGroup();
+                return fail(QString("node %1: invalid cooling entry %2").arg(node.name, coupling));
+            }
+            node.cooling.append({fan, conductance});
+        }
+        nodes.append(node);
+    }
+    settings.endGroup();
+
+    links.clear();
+    settings.beginGroup("links");
+    int linkCount = settings.value("count", 0).toInt();
+    for (int i = 1; i <= linkCount; i++) {
+        settings.beginGroup(QString("Link%1").arg(i));
+        ThermalLink link;
+        link.from = findNode(textValue(settings, "from"));
+        link.to = findNode(textValue(settings, "to"));
+        link.conductance = settings.value("conductance", 0.0).toDouble();
+        settings.endGroup();
+        if (link.from < 0 || link.to < 0 || link.from == link.to || link.conductance <= 0.0) {
+            settings.endGroup();
+            return fail(QString("link %1 needs two different known nodes and a positive conductance").arg(i));
+        }
+        links.append(link);
+    }
+    settings.endGroup();
+
+    if (settings.status() != QSettings::NoError) {
+        return fail("malformed INI file");
+    }
+    if (name.isEmpty() || fans.isEmpty() || nodes.isEmpty()) {
+        return fail("a model needs a name, at least one fan and at least one node");
+    }
+    return true;
+}
+
+int ThermalModel::findNode(const QString& nodeName) const
+{
+    for (int i = 0; i < nodes.size(); i++) {
+        if (nodes[i].name == nodeName) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+ThermalSimulator::ThermalSimulator(const ThermalModel& thermalModel)
+    : model(thermalModel),
+      load(0.0),
+      time(0.0),
+      maxStep(1.0)
+{
+    for (int i = 0; i < model.fans.size(); i++) {
+        FanInfo fan;
+        fan.index = i + 1;
+        fan.label = model.fans[i].label;
+        fan.minRPM = model.fans[i].minRPM;
+        fan.maxRPM = model.fans[i].maxRPM;
+        fan.currentRPM = fan.minRPM;
+        fan.targetRPM = fan.minRPM;
+        fan.isManual = false;
+        fans.append(fan);
+    }
+
+    for (int i = 0; i < model.nodes.size(); i++) {
+        if (model.nodes[i].sensorLabel.isEmpty()) {
+            continue;
+        }
+        TempSensor sensor;
+        sensor.index = sensors.size() + 1;
+        sensor.label = model.nodes[i].sensorLabel;
+        sensor.deviceName = "simulated";
+        sensor.temperature = 0;
+        sensors.append(sensor);
+        sensorNodes.push_back(i);
+    }
+
+    // Explicit Euler is stable while dt < capacity / total conductance
+    std::vector<double> conductance(model.nodes.size(), 0.0);
+    for (int i = 0; i < model.nodes.size(); i++) {
+        conductance[i] = model.nodes[i].ambientConductance;
+        for (const ThermalCoupling& coupling : model.nodes[i].cooling) {
+            conductance[i] += coupling.conductance;
+        }
+    }
+    for (const ThermalLink& link : model.links) {
+        conductance[link.from] += link.conductance;
+        conductance[link.to] += link.conductance;
+    }
+    for (int i = 0; i < model.nodes.size(); i++) {
+        if (conductance[i] > 0.0) {
+            maxStep = qMin(maxStep, 0.5 * model.nodes[i].capacity / conductance[i]);
+        }
+    }
+
+    heatFlow.assign(model.nodes.size(), 0.0);
+    reset();
+}
+
+void ThermalSimulator::reset()
+{
+    temperature.assign(model.nodes.size(), model.ambient);
+    fanSpeed.assign(model.fans.size(), 0.0);
+    for (int i = 0; i < fans.size(); i++) {
+        fanSpeed[i] = fans[i].minRPM;
+        fans[i].currentRPM = fans[i].minRPM;
+        fans[i].targetRPM = fans[i].minRPM;
+        fans[i].isManual = false;
+    }
+    time = 0.0;
+}
+
+QVector<TempSensor> ThermalSimulator::getTemperatures()
+{
+    for (int i = 0; i < sensors.size(); i++) {
+        sensors[i].temperature = qRound(temperature[sensorNodes[i]] * 1000.0);
+    }
+    return sensors;
+}
+
+int ThermalSimulator::getFanCurrentRPM(int fanIndex)
+{
+    if (fanIndex < 0 || fanIndex >= fans.size()) {
+        return -1;
+    }
+    fans[fanIndex].currentRPM = qRound(fanSpeed[fanIndex]);
+    return fans[fanIndex].currentRPM;
+}
+
+bool ThermalSimulator::setFanManualMode(int fanIndex, bool enable)
+{
+    if (fanIndex < 0 || fanIndex >= fans.size()) {
+        return false;
+    }
+    fans[fanIndex].isManual = enable;
+    return true;
+}
+
+bool ThermalSimulator::setFanSpeed(int fanIndex, int rpm)
+{
+    if (fanIndex < 0 || fanIndex >= fans.size()) {
+        return false;
+    }
+    fans[fanIndex].targetRPM = qBound(fans[fanIndex].minRPM, rpm, fans[fanIndex].maxRPM);
+    return true;
+}
+
+void ThermalSimulator::setLoad(double utilization)
+{
+    load = qBound(0.0, utilization, 1.0);
+}
+
+void ThermalSimulator::step(double seconds)
+{
+    while (seconds > 1e-9) {
+        double dt = qMin(seconds, maxStep);
+        integrate(dt);
+        seconds -= dt;
+    }
+}
+
+void ThermalSimulator::integrate(double dt)
+{
+    // Fans approach their target with a first-order lag; in automatic mode
+    // the simulated SMC holds them at minimum speed
+    QVector<double> airflow(model.fans.size());
+    for (int i = 0; i < model.fans.size(); i++) {
+        const ThermalFan& fan = model.fans[i];
+        int target = fans[i].isManual ? fans[i].targetRPM : fan.minRPM;
+        fanSpeed[i] += (target - fanSpeed[i]) * (1.0 - qExp(-dt / fan.timeConstant));
+        airflow[i] = qPow(qMax(0.0, fanSpeed[i]) / fan.maxRPM, model.airflowExponent);
+    }
+
+    for (int i = 0; i < model.nodes.size(); i++) {
+        const ThermalNode& node = model.nodes[i];
+        double conductance = node.ambientConductance;
+        for (const ThermalCoupling& coupling : node.cooling) {
+            conductance += coupling.conductance * airflow[coupling.fan];
+        }
+        heatFlow[i] = node.idlePower + load * node.loadPower - conductance * (temperature[i] - model.ambient);
+    }
+    for (const ThermalLink& link : model.links) {
+        double flow = link.conductance * (temperature[link.from] - temperature[link.to]);
+        heatFlow[link.from] -= flow;
+        heatFlow[link.to] += flow;
+    }
+    for (int i = 0; i < model.nodes.size(); i++) {
+        temperature[i] += heatFlow[i] / model.nodes[i].capacity * dt;
+    }
+    time += dt;
+}
@@ -0,0 +1,102 @@
+#ifndef THERMALMODEL_H
+#define THERMALMODEL_H
+
+#include <QString>
+#include <QVector>
+#include <vector>
+#include "smcinterface.h"
+
+// Airflow contribution of one fan to a node's cooling
+struct ThermalCoupling {
+    int fan;                // Index into ThermalModel::fans
+    double conductance;     // W/K added at maximum RPM
+};
+
+// Lumped thermal mass: a die, heatsink, board region or air volume
+struct ThermalNode {
+    QString name;
+    QString sensorLabel;    // SMC key reported for this node (empty = no sensor)
+    double capacity;        // J/K
+    double idlePower;       // W dissipated at idle
+    double loadPower;       // W added at 100% CPU utilization
+    double ambientConductance;          // W/K to ambient with all fans stopped
+    QVector<ThermalCoupling> cooling;   // Airflow-dependent W/K to ambient
+};
+
+// Thermal resistance between two nodes
+struct ThermalLink {
+    int from;               // Node indices
+    int to;
+    double conductance;     // W/K
+};
+
+struct ThermalFan {
+    QString label;
+    int minRPM;
+    int maxRPM;
+    double timeConstant;    // Spin-up/down, seconds
+};
+
+// RC network description, loaded from an INI model file:
+//
+//   [model]   name, ambient (°C), airflowExponent
+//   [fans]    count, Fan1/label, Fan1/min, Fan1/max, Fan1/timeConstant
+//   [nodes]   count, Node1/name, Node1/sensor, Node1/capacity, Node1/idlePower,
+//             Node1/loadPower, Node1/ambient, Node1/cooling ("fan:W/K ...", 1-based)
+//   [links]   count, Link1/from, Link1/to (node names), Link1/conductance
+//
+// Cooling by a fan scales with (rpm / maxRPM)^airflowExponent.
+struct ThermalModel {
+    QString name;           // Reported as the Mac model
+    double ambient;         // °C
+    double airflowExponent;
+    QVector<ThermalFan> fans;
+    QVector<ThermalNode> nodes;
+    QVector<ThermalLink> links;
+
+    ThermalModel() : ambient(25.0), airflowExponent(0.8) {}
+
+    bool load(const QString& path, QString *errorMessage = nullptr);
+    int findNode(const QString& name) const;
+};
+
+// Steps a ThermalModel in simulated time. Exposes the SMCInterface surface
+// (fans, manual mode, targets, temperature sensors) so control code can run
+// against it; there is no I/O, and one instance per thread can be stepped
+// much faster than real time.
+class ThermalSimulator {
+public:
+    explicit ThermalSimulator(const ThermalModel& model);
+
+    // SMCInterface-compatible access
+    QString getMacModel() const { return model.name; }
+    QVector<FanInfo> getFans() const { return fans; }
+    QVector<TempSensor> getTemperatures();
+    int getFanCurrentRPM(int fanIndex);
+    bool setFanManualMode(int fanIndex, bool enable);
+    bool setFanSpeed(int fanIndex, int rpm);
+
+    // Simulation control
+    void setLoad(double utilization);       // 0.0-1.0
+    void step(double seconds);
+    void reset();                           // Back to ambient, fans at minimum
+    double getTime() const { return time; }
+    double getNodeTemperature(int node) const { return temperature[node]; }
+    double getMaxStep() const { return maxStep; }
+
+private:
+    ThermalModel model;
+    QVector<FanInfo> fans;
+    QVector<TempSensor> sensors;
+    std::vector<int> sensorNodes;       // Node behind each sensor
+    std::vector<double> temperature;    // °C per node
+    std::vector<double> fanSpeed;       // Actual RPM, lags the target
+    std::vector<double> heatFlow;       // Scratch, W per node
+    double load;
+    double time;
+    double maxStep;                     // Largest stable Euler step, seconds
+
+    void integrate(double dt);
+};
+
+#endif // THERMALMODEL_H
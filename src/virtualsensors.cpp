@@ -0,0 +1,782 @@
+#include "virtualsensors.h"
+#include <QHash>
+#include <QtMath>
+#include <QDebug>
+#include <limits>
+
+namespace {
+
+// Readings at or below -100°C are treated as invalid throughout the app
+const int INVALID_READING = -128000;
+
+// Parentheses, negations and function calls nested deeper than this fail to
+// compile before the recursion can exhaust the native stack; far more than
+// any expression that fits MAX_STACK would sensibly use
+const int MAX_NESTING = VirtualSensorEngine::MAX_STACK * 4;
+
+// Recursive-descent compiler emitting postfix code directly
+class ExpressionCompiler {
+public:
+    ExpressionCompiler(const QString& source, const QVector<TempSensor>& catalog,
+                       int slotBase, VirtualSensorProgram& program)
+        : src(source), catalog(catalog), slotBase(slotBase), program(program),
+          pos(0), depth(0), nesting(0)
+    {
+    }
+
+    bool compile(QString *errorMessage)
+    {
+        program.code.clear();
+        program.constants.clear();
+        program.maxStack = 0;
+        slotSensors.clear();
+
+        bool ok = parseExpression() && expectEnd();
+        if (ok && program.maxStack > VirtualSensorEngine::MAX_STACK) {
+            ok = fail("Expression is nested too deeply");
+        }
+        if (!ok && errorMessage) {
+            *errorMessage = error;
+        }
+        return ok;
+    }
+
+    // Sensor indices bound to this program's slots, in slot order
+    QVector<int> slotSensors;
+
+private:
+    enum TokenType { TOK_END, TOK_NUMBER, TOK_IDENT, TOK_STRING, TOK_RANGE, TOK_CHAR };
+
+    struct Token {
+        TokenType type;
+        QString text;
+        double number;
+        QChar ch;
+        int start;
+    };
+
+    const QString& src;
+    const QVector<TempSensor>& catalog;
+    int slotBase;
+    VirtualSensorProgram& program;
+    int pos;
+    int depth;
+    int nesting;            // parseUnary() calls in progress
+    QString error;
+
+    bool fail(const QString& message)
+    {
+        if (error.isEmpty()) {
+            error = message;
+        }
+        return false;
+    }
+
+    // --- Lexer ---
+
+    Token peek(int ahead = 0)
+    {
+        int saved = pos;
+        Token token = next();
+        for (int i = 0; i < ahead; i++) {
+            token = next();
+        }
+        pos = saved;
+        return token;
+    }
+
+    Token next()
+    {
+        while (pos < src.size() && src[pos].isSpace()) {
+            pos++;
+        }
+
+        Token token;
+        token.type = TOK_END;
+        token.number = 0.0;
+        token.start = pos;
+        if (pos >= src.size()) {
+            return token;
+        }
+
+        QChar c = src[pos];
+        if (c.isDigit() || (c == '.' && pos + 1 < src.size() && src[pos + 1].isDigit())) {
+            int start = pos;
+            while (pos < src.size() && src[pos].isDigit()) {
+                pos++;
+            }
+            // A single '.' followed by a digit is a fraction; ".." is a range
+            if (pos + 1 < src.size() && src[pos] == '.' && src[pos + 1].isDigit()) {
+                pos++;
+                while (pos < src.size() && src[pos].isDigit()) {
+                    pos++;
+                }
+            }
+            token.type = TOK_NUMBER;
+            token.text = src.mid(start, pos - start);
+            token.number = token.text.toDouble();
+        } else if (c.isLetter() || c == '_') {
+            int start = pos;
+            while (pos < src.size() && (src[pos].isLetterOrNumber() || src[pos] == '_')) {
+                pos++;
+            }
+            token.type = TOK_IDENT;
+            token.text = src.mid(start, pos - start);
+        } else if (c == '"') {
+            int end = src.indexOf('"', pos + 1);
+            if (end < 0) {
+                token.type = TOK_CHAR;
+                token.ch = c;
+                pos = src.size();
+                return token;
+            }
+            token.type = TOK_STRING;
+            token.text = src.mid(pos + 1, end - pos - 1);
+            pos = end + 1;
+        } else if (c == '.' && pos + 1 < src.size() && src[pos + 1] == '.') {
+            token.type = TOK_RANGE;
+            token.text = "..";
+            pos += 2;
+        } else {
+            token.type = TOK_CHAR;
+            token.ch = c;
+            pos++;
+        }
+        return token;
+    }
+
+    bool accept(QChar c)
+    {
+        Token token = peek();
+        if (token.type == TOK_CHAR && token.ch == c) {
+            next();
+            return true;
+        }
+        return false;
+    }
+
+    bool expect(QChar c)
+    {
+        if (!accept(c)) {
+            return fail(QString("Expected '%1' at position %2").arg(c).arg(peek().start + 1));
+        }
+        return true;
+    }
+
+    bool expectEnd()
+    {
+        Token token = peek();
+        if (token.type != TOK_END) {
+            return fail(QString("Unexpected input at position %1").arg(token.start + 1));
+        }
+        return true;
+    }
+
+    // --- Code emission ---
+
+    void emitOp(int op, int arg = 0, int count = 0)
+    {
+        VirtualSensorInstr instr;
+        instr.op = static_cast<quint16>(op);
+        instr.count = static_cast<quint16>(count);
+        instr.arg = static_cast<quint32>(arg);
+        program.code.append(instr);
+
+        switch (op) {
+        case VirtualSensorEngine::OP_CONST:
+        case VirtualSensorEngine::OP_SLOT:
+        case VirtualSensorEngine::OP_RANGE_MAX:
+        case VirtualSensorEngine::OP_RANGE_MIN:
+        case VirtualSensorEngine::OP_RANGE_SUM:
+        case VirtualSensorEngine::OP_RANGE_AVG:
+        case VirtualSensorEngine::OP_RANGE_TOTAL:
+        case VirtualSensorEngine::OP_RANGE_COUNT:
+            depth++;
+            break;
+        case VirtualSensorEngine::OP_NEG:
+            break;
+        default:
+            depth--;    // Binary operators pop two and push one
+            break;
+        }
+        program.maxStack = qMax(program.maxStack, depth);
+    }
+
+    void emitConstant(double value)
+    {
+        program.constants.append(value);
+        emitOp(VirtualSensorEngine::OP_CONST, program.constants.size() - 1);
+    }
+
+    // Allocate a contiguous run of slots and return the first one
+    int allocateSlots(const QVector<int>& sensorIndices)
+    {
+        int first = slotBase + slotSensors.size();
+        slotSensors += sensorIndices;
+        return first;
+    }
+
+    // --- Sensor lookup ---
+
+    int findSensor(const QString& label, const QString& device = QString()) const
+    {
+        for (const TempSensor& sensor : catalog) {
+            if (sensor.label == label && (device.isEmpty() || sensor.deviceName == device)) {
+                return sensor.index;
+            }
+        }
+        return -1;
+    }
+
+    static bool splitNumbered(const QString& label, const QString& prefix, const QString& suffix,
+                              int *number)
+    {
+        if (label.size() <= prefix.size() + suffix.size() ||
+            !label.startsWith(prefix) || !label.endsWith(suffix)) {
+            return false;
+        }
+        QString middle = label.mid(prefix.size(), label.size() - prefix.size() - suffix.size());
+        for (const QChar& c : middle) {
+            if (!c.isDigit()) {
+                return false;
+            }
+        }
+        *number = middle.toInt();
+        return true;
+    }
+
+    // Expand "TC0C..TC7C": the labels share a prefix and suffix around a number
+    bool expandRange(const QString& from, const QString& to, QVector<int>& out)
+    {
+        int prefixLen = 0;
+        while (prefixLen < from.size() && prefixLen < to.size() &&
+               from[prefixLen] == to[prefixLen] && !from[prefixLen].isDigit()) {
+            prefixLen++;
+        }
+        int suffixLen = 0;
+        while (suffixLen < from.size() - prefixLen && suffixLen < to.size() - prefixLen &&
+               from[from.size() - 1 - suffixLen] == to[to.size() - 1 - suffixLen] &&
+               !from[from.size() - 1 - suffixLen].isDigit()) {
+            suffixLen++;
+        }
+
+        QString prefix = from.left(prefixLen);
+        QString suffix = from.right(suffixLen);
+        int lo, hi;
+        if (!splitNumbered(from, prefix, suffix, &lo) || !splitNumbered(to, prefix, suffix, &hi)) {
+            return fail(QString("Cannot form a range from %1 to %2").arg(from, to));
+        }
+        if (lo > hi) {
+            qSwap(lo, hi);
+        }
+
+        // Keep numeric order (TC2C before TC10C) rather than catalog order
+        int before = out.size();
+        for (int n = lo; n <= hi; n++) {
+            for (const TempSensor& sensor : catalog) {
+                int number;
+                if (splitNumbered(sensor.label, prefix, suffix, &number) && number == n) {
+                    out.append(sensor.index);
+                    break;
+                }
+            }
+        }
+        if (out.size() == before) {
+            return fail(QString("Range %1..%2 matches no sensors").arg(from, to));
+        }
+        return true;
+    }
+
+    bool isSensorName(const Token& token) const
+    {
+        return token.type == TOK_IDENT || token.type == TOK_STRING;
+    }
+
+    // Parse a sensor reference that may expand to several sensors:
+    //   LABEL | "label" | device:LABEL | device:* | LABEL..LABEL
+    bool parseSensorSet(QVector<int>& out, bool allowMany)
+    {
+        Token first = next();
+
+        if (peek().type == TOK_CHAR && peek().ch == ':') {
+            next();
+            QString device = first.text;
+            if (accept('*')) {
+                if (!allowMany) {
+                    return fail(QString("%1:* can only be used inside max/min/sum/avg").arg(device));
+                }
+                int before = out.size();
+                for (const TempSensor& sensor : catalog) {
+                    if (sensor.deviceName == device) {
+                        out.append(sensor.index);
+                    }
+                }
+                if (out.size() == before) {
+                    return fail(QString("No sensors found for device %1").arg(device));
+                }
+                return true;
+            }
+            Token label = next();
+            if (!isSensorName(label)) {
+                return fail(QString("Expected a sensor label after '%1:'").arg(device));
+            }
+            int index = findSensor(label.text, device);
+            if (index < 0) {
+                return fail(QString("Unknown sensor %1:%2").arg(device, label.text));
+            }
+            out.append(index);
+            return true;
+        }
+
+        if (peek().type == TOK_RANGE) {
+            next();
+            Token last = next();
+            if (!isSensorName(last)) {
+                return fail(QString("Expected a sensor label after '%1..'").arg(first.text));
+            }
+            if (!allowMany) {
+                return fail(QString("Range %1..%2 can only be used inside max/min/sum/avg")
+                            .arg(first.text, last.text));
+            }
+            return expandRange(first.text, last.text, out);
+        }
+
+        int index = findSensor(first.text);
+        if (index < 0) {
+            return fail(QString("Unknown sensor %1").arg(first.text));
+        }
+        out.append(index);
+        return true;
+    }
+
+    // --- Grammar ---
+
+    bool parseExpression()
+    {
+        if (!parseTerm()) {
+            return false;
+        }
+        for (;;) {
+            if (accept('+')) {
+                if (!parseTerm()) return false;
+                emitOp(VirtualSensorEngine::OP_ADD);
+            } else if (accept('-')) {
+                if (!parseTerm()) return false;
+                emitOp(VirtualSensorEngine::OP_SUB);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseTerm()
+    {
+        if (!parseUnary()) {
+            return false;
+        }
+        for (;;) {
+            if (accept('*')) {
+                if (!parseUnary()) return false;
+                emitOp(VirtualSensorEngine::OP_MUL);
+            } else if (accept('/')) {
+                if (!parseUnary()) return false;
+                emitOp(VirtualSensorEngine::OP_DIV);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseUnary()
+    {
+        // Every '-', '(' and function call descends through here
+        if (nesting >= MAX_NESTING) {
+            return fail("Expression is nested too deeply");
+        }
+        nesting++;
+        bool ok;
+        if (accept('-')) {
+            ok = parseUnary();
+            if (ok) {
+                emitOp(VirtualSensorEngine::OP_NEG);
+            }
+        } else {
+            ok = parsePrimary();
+        }
+        nesting--;
+        return ok;
+    }
+
+    bool parsePrimary()
+    {
+        Token token = peek();
+
+        if (token.type == TOK_NUMBER) {
+            next();
+            emitConstant(token.number);
+            return true;
+        }
+
+        if (accept('(')) {
+            return parseExpression() && expect(')');
+        }
+
+        if (token.type == TOK_IDENT && peek(1).type == TOK_CHAR && peek(1).ch == '(') {
+            return parseAggregate();
+        }
+
+        if (isSensorName(token)) {
+            QVector<int> sensors;
+            if (!parseSensorSet(sensors, false)) {
+                return false;
+            }
+            emitOp(VirtualSensorEngine::OP_SLOT, allocateSlots(sensors));
+            return true;
+        }
+
+        if (token.type == TOK_END) {
+            return fail("Unexpected end of expression");
+        }
+        return fail(QString("Unexpected input at position %1").arg(token.start + 1));
+    }
+
+    // max/min/sum/avg(arg, ...). Sensor arguments are gathered into one slot
+    // run and reduced by a single range instruction; other arguments are
+    // compiled as expressions and folded in with the matching binary operator.
+    bool parseAggregate()
+    {
+        Token name = next();
+        next();  // '('
+
+        QString function = name.text.toLower();
+        int rangeOp, foldOp;
+        if (function == "max") {
+            rangeOp = VirtualSensorEngine::OP_RANGE_MAX;
+            foldOp = VirtualSensorEngine::OP_MAX;
+        } else if (function == "min") {
+            rangeOp = VirtualSensorEngine::OP_RANGE_MIN;
+            foldOp = VirtualSensorEngine::OP_MIN;
+        } else if (function == "sum") {
+            rangeOp = VirtualSensorEngine::OP_RANGE_SUM;
+            foldOp = VirtualSensorEngine::OP_ADD;
+        } else if (function == "avg") {
+            rangeOp = VirtualSensorEngine::OP_RANGE_AVG;
+            foldOp = VirtualSensorEngine::OP_ADD;
+        } else {
+            return fail(QString("Unknown function %1()").arg(name.text));
+        }
+
+        QVector<int> sensors;
+        int expressionArgs = 0;
+        do {
+            if (isSensorArgument()) {
+                if (!parseSensorSet(sensors, true)) {
+                    return false;
+                }
+            } else {
+                if (!parseExpression()) {
+                    return false;
+                }
+                if (++expressionArgs > 1) {
+                    emitOp(foldOp);
+                }
+            }
+        } while (accept(','));
+
+        if (!expect(')')) {
+            return false;
+        }
+
+        // Mixed avg() adds the valid sensors to the expressions here and
+        // divides by the expressions plus the sensors that had a reading
+        bool mixedAverage = (function == "avg" && expressionArgs > 0);
+        int first = -1;
+        if (!sensors.isEmpty()) {
+            int op = mixedAverage ? static_cast<int>(VirtualSensorEngine::OP_RANGE_TOTAL) : rangeOp;
+            if (sensors.size() > 0xFFFF) {
+                return fail(QString("Too many sensors in %1()").arg(name.text));
+            }
+            first = allocateSlots(sensors);
+            emitOp(op, first, sensors.size());
+            if (expressionArgs > 0) {
+                emitOp(foldOp);
+            }
+        } else if (expressionArgs == 0) {
+            return fail(QString("%1() needs at least one argument").arg(name.text));
+        }
+
+        if (mixedAverage) {
+            emitConstant(expressionArgs);
+            if (!sensors.isEmpty()) {
+                emitOp(VirtualSensorEngine::OP_RANGE_COUNT, first, sensors.size());
+                emitOp(VirtualSensorEngine::OP_ADD);
+            }
+            emitOp(VirtualSensorEngine::OP_DIV);
+        }
+        return true;
+    }
+
+    // An aggregate argument that is only a sensor reference (possibly a range
+    // or device selector), as opposed to an arithmetic expression
+    bool isSensorArgument()
+    {
+        Token first = peek();
+        if (!isSensorName(first)) {
+            return false;
+        }
+        Token second = peek(1);
+        if (second.type == TOK_RANGE) {
+            return true;
+        }
+        if (second.type == TOK_CHAR && second.ch == ':') {
+            Token third = peek(3);
+            return third.type == TOK_END ||
+                   (third.type == TOK_CHAR && (third.ch == ',' || third.ch == ')'));
+        }
+        return second.type == TOK_CHAR && (second.ch == ',' || second.ch == ')');
+    }
+};
+
+} // namespace
+
+int VirtualSensorEngine::addSensor(const QString& name, const QString& expression,
+                                   const QVector<TempSensor>& catalog, int index,
+                                   QString *errorMessage)
+{
+    if (name.trimmed().isEmpty()) {
+        if (errorMessage) *errorMessage = "Virtual sensor name is empty";
+        return -1;
+    }
+
+    int nextIndex = FIRST_INDEX;
+    for (const VirtualSensorProgram& existing : programs) {
+        if (existing.name == name) {
+            if (errorMessage) *errorMessage = QString("A virtual sensor named %1 already exists").arg(name);
+            return -1;
+        }
+        if (existing.index == index) {
+            index = -1;  // Taken; fall back to a fresh index
+        }
+        nextIndex = qMax(nextIndex, existing.index + 1);
+    }
+
+    VirtualSensorProgram program;
+    program.index = (index >= FIRST_INDEX) ? index : nextIndex;
+    program.name = name;
+    program.expression = expression;
+    program.firstSlot = static_cast<int>(slotSensorIndex.size());
+
+    ExpressionCompiler compiler(expression, catalog, program.firstSlot, program);
+    if (!compiler.compile(errorMessage)) {
+        return -1;
+    }
+    program.slotCount = compiler.slotSensors.size();
+
+    for (int sensorIndex : compiler.slotSensors) {
+        slotSensorIndex.push_back(sensorIndex);
+        slotPosition.push_back(-1);
+        slotValues.push_back(std::numeric_limits<double>::quiet_NaN());
+    }
+
+    programs.append(program);
+    results.push_back(INVALID_READING);
+
+    qDebug() << "Compiled virtual sensor" << name << "=" << expression
+             << "->" << program.code.size() << "instructions,"
+             << program.slotCount << "slots";
+    return program.index;
+}
+
+bool VirtualSensorEngine::removeSensor(const QString& name)
+{
+    for (int p = 0; p < programs.size(); p++) {
+        if (programs[p].name != name) {
+            continue;
+        }
+
+        // Drop this program's slot run and shift later programs down
+        int first = programs[p].firstSlot;
+        int removed = programs[p].slotCount;
+        slotSensorIndex.erase(slotSensorIndex.begin() + first, slotSensorIndex.begin() + first + removed);
+        slotPosition.erase(slotPosition.begin() + first, slotPosition.begin() + first + removed);
+        slotValues.erase(slotValues.begin() + first, slotValues.begin() + first + removed);
+
+        for (int q = p + 1; q < programs.size(); q++) {
+            VirtualSensorProgram& later = programs[q];
+            later.firstSlot -= removed;
+            for (VirtualSensorInstr& instr : later.code) {
+                if (instr.op == OP_SLOT || instr.op >= OP_RANGE_MAX) {
+                    instr.arg -= removed;
+                }
+            }
+        }
+
+        programs.remove(p);
+        results.erase(results.begin() + p);
+        return true;
+    }
+    return false;
+}
+
+void VirtualSensorEngine::clear()
+{
+    programs.clear();
+    results.clear();
+    slotSensorIndex.clear();
+    slotPosition.clear();
+    slotValues.clear();
+}
+
+QStringList VirtualSensorEngine::names() const
+{
+    QStringList list;
+    for (const VirtualSensorProgram& program : programs) {
+        list << program.name;
+    }
+    return list;
+}
+
+QSet<int> VirtualSensorEngine::referencedSensors() const
+{
+    QSet<int> indices;
+    for (int index : slotSensorIndex) {
+        indices.insert(index);
+    }
+    return indices;
+}
+
+void VirtualSensorEngine::rebind(const QVector<TempSensor>& sensors)
+{
+    QHash<int, int> positionByIndex;
+    for (int i = 0; i < sensors.size(); i++) {
+        positionByIndex.insert(sensors[i].index, i);
+    }
+    for (size_t s = 0; s < slotSensorIndex.size(); s++) {
+        slotPosition[s] = positionByIndex.value(slotSensorIndex[s], -1);
+    }
+}
+
+void VirtualSensorEngine::evaluate(const QVector<TempSensor>& sensors)
+{
+    const int sensorCount = sensors.size();
+
+    for (size_t s = 0; s < slotSensorIndex.size(); s++) {
+        int position = slotPosition[s];
+        if (position < 0 || position >= sensorCount ||
+            sensors[position].index != slotSensorIndex[s]) {
+            rebind(sensors);
+            break;
+        }
+    }
+
+    for (size_t s = 0; s < slotSensorIndex.size(); s++) {
+        int position = slotPosition[s];
+        int reading = (position >= 0) ? sensors[position].temperature : INVALID_READING;
+        slotValues[s] = (reading > -100000) ? reading / 1000.0
+                                            : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    for (int p = 0; p < programs.size(); p++) {
+        double value = run(programs[p]);
+        results[p] = qIsFinite(value) ? qRound(value * 1000.0) : INVALID_READING;
+    }
+}
+
+double VirtualSensorEngine::run(const VirtualSensorProgram& program) const
+{
+    double stack[MAX_STACK];
+    int sp = 0;
+
+    const VirtualSensorInstr *ip = program.code.constData();
+    const VirtualSensorInstr *end = ip + program.code.size();
+    const double *constants = program.constants.constData();
+    const double *values = slotValues.data();
+
+    for (; ip != end; ++ip) {
+        switch (ip->op) {
+        case OP_CONST:
+            stack[sp++] = constants[ip->arg];
+            break;
+        case OP_SLOT:
+            stack[sp++] = values[ip->arg];
+            break;
+        case OP_ADD:
+            --sp;
+            stack[sp - 1] += stack[sp];
+            break;
+        case OP_SUB:
+            --sp;
+            stack[sp - 1] -= stack[sp];
+            break;
+        case OP_MUL:
+            --sp;
+            stack[sp - 1] *= stack[sp];
+            break;
+        case OP_DIV:
+            --sp;
+            stack[sp - 1] /= stack[sp];
+            break;
+        case OP_NEG:
+            stack[sp - 1] = -stack[sp - 1];
+            break;
+        case OP_MAX:
+            // An invalid operand makes the result invalid
+            --sp;
+            if (qIsNaN(stack[sp]) || stack[sp] > stack[sp - 1]) {
+                stack[sp - 1] = stack[sp];
+            }
+            break;
+        case OP_MIN:
+            --sp;
+            if (qIsNaN(stack[sp]) || stack[sp] < stack[sp - 1]) {
+                stack[sp - 1] = stack[sp];
+            }
+            break;
+        default: {
+            // Range aggregates skip missing sensors
+            const double *v = values + ip->arg;
+            double acc = 0.0;
+            int valid = 0;
+            for (int i = 0; i < ip->count; i++) {
+                if (qIsNaN(v[i])) {
+                    continue;
+                }
+                if (valid == 0) {
+                    acc = v[i];
+                } else if (ip->op == OP_RANGE_MAX) {
+                    acc = qMax(acc, v[i]);
+                } else if (ip->op == OP_RANGE_MIN) {
+                    acc = qMin(acc, v[i]);
+                } else {
+                    acc += v[i];
+                }
+                valid++;
+            }
+            if (ip->op == OP_RANGE_COUNT) {
+                acc = valid;
+            } else if (valid == 0) {
+                acc = ip->op == OP_RANGE_TOTAL ? 0.0 : std::numeric_limits<double>::quiet_NaN();
+            } else if (ip->op == OP_RANGE_AVG) {
+                acc /= valid;
+            }
+            stack[sp++] = acc;
+            break;
+        }
+        }
+    }
+
+    return (sp > 0) ? stack[0] : std::numeric_limits<double>::quiet_NaN();
+}
+
+void VirtualSensorEngine::appendTo(QVector<TempSensor>& sensors) const
+{
+    for (int p = 0; p < programs.size(); p++) {
+        TempSensor sensor;
+        sensor.index = programs[p].index;
+        sensor.label = programs[p].name;
+        sensor.deviceName = "virtual";
+        sensor.temperature = results[p];
+        sensor.sysfsPath = QString();
+        sensors.append(sensor);
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef VIRTUALSENSORS_H
+#define VIRTUALSENSORS_H
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+#include "smcinterface.h"
+
+// Derived temperature channels defined by expressions over real sensors, e.g.
+//   max(TC0C..TC7C) - TA0P
+//   avg(drivetemp:*)
+//   ("Package id 0" + TC0P) / 2
+//
+// Each expression is compiled once into a flat postfix program whose operands
+// are slots in a shared value table. A tick copies the referenced readings into
+// the slot table in one pass and then runs every program over it with a fixed
+// size stack, so evaluation never allocates.
+
+// One postfix instruction (8 bytes)
+struct VirtualSensorInstr {
+    quint16 op;             // VirtualSensorEngine::OpCode
+    quint16 count;          // Slot count for range aggregates
+    quint32 arg;            // Slot index or constant pool index
+};
+
+struct VirtualSensorProgram {
+    int index;                          // Sensor index, stable across restarts
+    QString name;                       // Label shown in the UI
+    QString expression;                 // Source text, kept for settings and display
+    QVector<VirtualSensorInstr> code;
+    QVector<double> constants;
+    int firstSlot;                      // This program's run in the slot table
+    int slotCount;
+    int maxStack;                       // Deepest stack use, checked at compile time
+};
+
+class VirtualSensorEngine {
+public:
+    // Virtual sensors get indices above SMC (1-68) and hwmon (1000-4999,
+    // see HWMonInterface::LAST_SENSOR_INDEX) sensors
+    static const int FIRST_INDEX = 5000;
+    static const int MAX_STACK = 32;
+
+    enum OpCode {
+        OP_CONST = 0,
+        OP_SLOT,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_NEG,
+        OP_MAX,
+        OP_MIN,
+        OP_RANGE_MAX,       // Aggregates over a contiguous run of slots,
+        OP_RANGE_MIN,       // skipping sensors without a valid reading
+        OP_RANGE_SUM,
+        OP_RANGE_AVG,
+        OP_RANGE_TOTAL,     // As OP_RANGE_SUM but 0 without any valid reading,
+        OP_RANGE_COUNT      // and the number of valid readings, for mixed avg()
+    };
+
+    // Compile an expression against the current sensor catalog. On success the
+    // program is appended and its sensor index returned (index, if given, is
+    // reused so saved fan settings keep pointing at the same channel). On
+    // failure -1 is returned and errorMessage explains what is wrong.
+    int addSensor(const QString& name, const QString& expression,
+                  const QVector<TempSensor>& catalog, int index = -1,
+                  QString *errorMessage = nullptr);
+    bool removeSensor(const QString& name);
+    void clear();
+
+    const QVector<VirtualSensorProgram>& getPrograms() const { return programs; }
+    int count() const { return programs.size(); }
+    QStringList names() const;
+
+    // Indices of the real sensors any program reads
+    QSet<int> referencedSensors() const;
+
+    // Refresh all virtual readings from the given snapshot (no allocation unless
+    // the sensor layout changed since the previous call)
+    void evaluate(const QVector<TempSensor>& sensors);
+
+    // Append the virtual sensors with their latest readings
+    void appendTo(QVector<TempSensor>& sensors) const;
+
+private:
+    QVector<VirtualSensorProgram> programs;
+    std::vector<int> results;           // Latest value per program, millidegrees
+
+    // Slot table shared by all programs
+    std::vector<int> slotSensorIndex;   // TempSensor::index bound to each slot
+    std::vector<int> slotPosition;      // Position of that sensor in the last snapshot
+    std::vector<double> slotValues;     // Degrees Celsius, NaN when unavailable
+
+    void rebind(const QVector<TempSensor>& sensors);
+    double run(const VirtualSensorProgram& program) const;
+};
+
+#endif // VIRTUALSENSORS_H
@@ -0,0 +1,28 @@
+QT       += core
+QT       -= gui
+CONFIG   += c++11 console
+CONFIG   -= app_bundle
+TARGET   = macsfanctl
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+# Core backend only: no widgets, no control loop
+SOURCES += \
+    main.cpp \
+    ../../src/fansnapshot.cpp \
+    ../../src/smcinterface.cpp \
+    ../../src/hwmoninterface.cpp \
+    ../../src/hwmonscanner.cpp \
+    ../../src/hwmonreaders.cpp \
+    ../../src/readprofiler.cpp \
+    ../../src/latencystats.cpp \
+    ../../src/fancalibration.cpp \
+    ../../src/discoverymanifest.cpp
+
+HEADERS += \
+    ../../src/smcinterface.h \
+    ../../src/hwmoninterface.h
+
+# Compiler flags
+QMAKE_CXXFLAGS += -Wall -Wextra
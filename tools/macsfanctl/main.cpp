@@ -0,0 +1,259 @@
+#include "discoverymanifest.h"
+#include "fancalibration.h"
+#include "fancontroller.h"
+#include "fansnapshot.h"
+#include "latencystats.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QMap>
+#include <QSettings>
+#include <cstdio>
+
+static bool verbose = false;
+
+static void quietMessageHandler(QtMsgType type, const QMessageLogContext& /*context*/, const QString& msg)
+{
+    if (type == QtDebugMsg && !verbose) {
+        return;
+    }
+    fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+    if (type == QtFatalMsg)
+        abort();
+}
+
+static void printError(const QString& message)
+{
+    fprintf(stderr, "macsfanctl: %s\n", message.toLocal8Bit().constData());
+}
+
+// Fan by 1-based number (GUI order) or case-insensitive label; -1 = none
+static int findFan(const FanSnapshot& snapshot, const QString& name)
+{
+    bool isNumber = false;
+    int number = name.toInt(&isNumber);
+    if (isNumber) {
+        return number >= 1 && number <= snapshot.fans.size() ? number - 1 : -1;
+    }
+    for (int i = 0; i < snapshot.fans.size(); i++) {
+        if (snapshot.fans[i].label.compare(name, Qt::CaseInsensitive) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Same store as MainWindow::loadFanCalibrations(), so RPM targets on hwmon
+// fans map to the PWM the GUI would write
+static void loadFanCalibrations(HWMonInterface *hwmon)
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+
+    QMap<QString, FanCalibrationTable> tables;
+    settings.beginGroup("FanCalibration");
+    int count = settings.value("count", 0).toInt();
+    for (int i = 0; i < count; i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        QString key = QString("%1/fan%2").arg(settings.value("device").toString()).arg(settings.value("fan").toInt());
+        bool ok;
+        FanCalibrationTable table = FanCalibrationTable::fromString(settings.value("table").toString(), &ok);
+        if (ok) {
+            tables.insert(key, table);
+        }
+        settings.endGroup();
+    }
+    settings.endGroup();
+
+    QVector<HWMonFan> fans = hwmon->getFans();
+    for (int i = 0; i < fans.size(); i++) {
+        QString key = QString("%1/fan%2").arg(fans[i].deviceName).arg(fans[i].fanNumber);
+        if (tables.contains(key)) {
+            hwmon->setFanCalibration(i, tables.value(key));
+        }
+    }
+}
+
+// Applies a mode to one fan; rpm is only used in manual mode and clamped to
+// the fan's range like the GUI slider
+static bool applyFan(SMCInterface *smc, HWMonInterface *hwmon, const SnapshotFan& fan, FanMode mode, int rpm)
+{
+    if (!fan.controllable) {
+        if (mode == MODE_AUTO) {
+            return true;    // Nothing to hand back
+        }
+        printError(QString("fan %1 (%2) cannot be controlled").arg(fan.number).arg(fan.label));
+        return false;
+    }
+
+    bool manual = mode == MODE_MANUAL;
+    rpm = qBound(fan.minRPM, rpm, fan.maxRPM);
+    if (fan.source == "smc") {
+        return smc->setFanManualMode(fan.sourceIndex, manual) && (!manual || smc->setFanSpeed(fan.sourceIndex, rpm));
+    }
+    return hwmon->setFanManualMode(fan.sourceIndex, manual) && (!manual || hwmon->setFanSpeed(fan.sourceIndex, rpm));
+}
+
+static QStringList presetNames()
+{
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+    settings.beginGroup("Presets");
+    return settings.childGroups();
+}
+
+// Applies a preset saved by the GUI. There is no control loop here, so
+// sensor-based fans are handed back to automatic control.
+static bool applyPreset(SMCInterface *smc, HWMonInterface *hwmon, const FanSnapshot& snapshot, const QString& name)
+{
+    if (!presetNames().contains(name)) {
+        printError(QString("no preset named \"%1\"").arg(name));
+        return false;
+    }
+
+    QSettings settings("macsfancontrol", "macsfancontrol-qt");
+    settings.beginGroup("Presets");
+    settings.beginGroup(name);
+    int savedFanCount = settings.value("fanCount", 0).toInt();
+    if (savedFanCount != snapshot.fans.size()) {
+        printError(QString("preset \"%1\" was saved with %2 fans, this machine has %3")
+                       .arg(name).arg(savedFanCount).arg(snapshot.fans.size()));
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < snapshot.fans.size(); i++) {
+        settings.beginGroup(QString("Fan%1").arg(i));
+        FanMode mode = static_cast<FanMode>(settings.value("mode", MODE_AUTO).toInt());
+        int targetRPM = settings.value("targetRPM", 2000).toInt();
+        settings.endGroup();
+
+        if (mode == MODE_SENSOR_BASED) {
+            printError(QString("fan %1 (%2) is sensor-based in this preset; set to auto, "
+                               "sensor-based control needs the GUI running")
+                           .arg(snapshot.fans[i].number).arg(snapshot.fans[i].label));
+            mode = MODE_AUTO;
+        }
+        ok = applyFan(smc, hwmon, snapshot.fans[i], mode, targetRPM) && ok;
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    qint64 start = monotonicNs();
+    qInstallMessageHandler(quietMessageHandler);
+
+    // No QCoreApplication on the normal path: nothing here needs an event
+    // loop, and creating one (event dispatcher, locale setup) would cost more
+    // than the snapshot itself. Help and usage errors construct it below.
+    QStringList arguments;
+    for (int i = 0; i < argc; i++) {
+        arguments.append(QString::fromLocal8Bit(argv[i]));
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Prints a snapshot of all fans and temperatures, sets fan modes and targets,\n"
+        "and applies presets saved by macsfancontrol.\n"
+        "\n"
+        "Commands:\n"
+        "  snapshot                   All fans and sensors (default)\n"
+        "  set FAN auto               Hand a fan back to automatic control\n"
+        "  set FAN manual RPM         Fixed target; \"set FAN RPM\" is the same\n"
+        "  preset NAME                Apply a saved preset\n"
+        "  presets                    List saved presets\n"
+        "\n"
+        "FAN is the number shown by snapshot (SMC fans first, then hwmon) or a fan label.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "snapshot, set, preset or presets.", "[command [args...]]");
+
+    QCommandLineOption format("format", "Snapshot output: json or tsv.", "format", "json");
+    QCommandLineOption sysfsRoot("sysfs-root", "Prefix for all sysfs paths.", "dir",
+                                 qEnvironmentVariable("MACSFANCONTROL_SYSFS_ROOT"));
+    QCommandLineOption noCache("no-cache", "Run full discovery instead of using the startup cache.");
+    QCommandLineOption timing("timing", "Print the time from start to exit on stderr.");
+    QCommandLineOption verboseOption("verbose", "Show debug messages.");
+    parser.addOptions({format, sysfsRoot, noCache, timing, verboseOption});
+
+    QStringList positional;
+    QString command;
+    bool usageOk = parser.parse(arguments);
+    if (usageOk && !parser.isSet("help")) {
+        positional = parser.positionalArguments();
+        command = positional.isEmpty() ? QString("snapshot") : positional.takeFirst();
+        usageOk = (command == "snapshot" && positional.isEmpty()) ||
+                  (command == "set" && (positional.size() == 2 || positional.size() == 3)) ||
+                  (command == "preset" && positional.size() == 1) ||
+                  (command == "presets" && positional.isEmpty());
+        usageOk = usageOk && (parser.value(format) == "json" || parser.value(format) == "tsv");
+    }
+    if (!usageOk || parser.isSet("help")) {
+        QCoreApplication app(argc, argv);
+        app.setApplicationName("macsfanctl");
+        parser.process(app);            // Exits on --help and unknown options
+        parser.showHelp(1);
+    }
+    verbose = parser.isSet(verboseOption);
+
+    if (command == "presets") {
+        for (const QString& name : presetNames()) {
+            printf("%s\n", name.toLocal8Bit().constData());
+        }
+        return 0;
+    }
+
+    SMCInterface smc;
+    HWMonInterface hwmon;
+    QObject::connect(&smc, &SMCInterface::error, printError);
+    QObject::connect(&hwmon, &HWMonInterface::error, printError);
+    smc.setSysfsRoot(parser.value(sysfsRoot));
+    hwmon.setSysfsRoot(parser.value(sysfsRoot));
+
+    // The GUI's startup cache: a warm start only re-reads fan state
+    DiscoveryManifest::Result discovery = DiscoveryManifest::initializeBackends(
+        &smc, &hwmon, parser.isSet(noCache) ? QString() : DiscoveryManifest::defaultPath());
+    if (!discovery.smcAvailable && !discovery.hwmonAvailable) {
+        printError("no fans found (neither applesmc nor hwmon)");
+        return 1;
+    }
+
+    FanSnapshot snapshot = FanSnapshot::capture(&smc, &hwmon);
+    bool ok = true;
+    if (command == "snapshot") {
+        QByteArray out = parser.value(format) == "json" ? snapshot.toJson() : snapshot.toTsv();
+        fwrite(out.constData(), 1, out.size(), stdout);
+    } else if (command == "set") {
+        int fan = findFan(snapshot, positional[0]);
+        QString modeName = positional[1].toLower();
+        FanMode mode = MODE_AUTO;
+        int rpm = 0;
+        bool argsOk = true;
+        if (modeName == "auto") {
+            argsOk = positional.size() == 2;
+        } else {
+            // "set FAN manual RPM" or the short "set FAN RPM"
+            mode = MODE_MANUAL;
+            rpm = positional.last().toInt(&argsOk);
+            argsOk = argsOk && positional.size() == (modeName == "manual" ? 3 : 2);
+        }
+        if (fan < 0) {
+            printError(QString("no fan \"%1\"").arg(positional[0]));
+            ok = false;
+        } else if (!argsOk) {
+            printError("usage: set FAN auto | set FAN manual RPM | set FAN RPM");
+            ok = false;
+        } else {
+            if (snapshot.fans[fan].source == "hwmon") {
+                loadFanCalibrations(&hwmon);
+            }
+            ok = applyFan(&smc, &hwmon, snapshot.fans[fan], mode, rpm);
+        }
+    } else if (command == "preset") {
+        loadFanCalibrations(&hwmon);
+        ok = applyPreset(&smc, &hwmon, snapshot, positional[0]);
+    }
+
+    if (parser.isSet(timing)) {
+        fprintf(stderr, "macsfanctl: %.3f ms (%s topology %.3f ms)\n", (monotonicNs() - start) / 1.0e6,
+                discovery.warm ? "cached" : "discovered", discovery.elapsedNs / 1.0e6);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include "controltrace.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <cstdio>
+
+// Parses "FAN:VALUE[:VALUE]" overrides; returns false on malformed input
+static bool parseFanOverride(const QString& text, int values, int *fan, double *out)
+{
+    const QStringList parts = text.split(':');
+    if (parts.size() != values + 1) {
+        return false;
+    }
+    bool ok = false;
+    *fan = parts[0].toInt(&ok);
+    for (int i = 0; ok && i < values; i++) {
+        out[i] = parts[i + 1].toDouble(&ok);
+    }
+    return ok && *fan >= 0;
+}
+
+static void quietMessageHandler(QtMsgType type, const QMessageLogContext& /*context*/, const QString& msg)
+{
+    if (type == QtDebugMsg) {
+        return;
+    }
+    fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+    if (type == QtFatalMsg)
+        abort();
+}
+
+int main(int argc, char *argv[])
+{
+    qInstallMessageHandler(quietMessageHandler);
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("macsfancontrol-replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Replays a control trace recorded by macsfancontrol --record-trace through the\n"
+        "sensor filters, virtual sensors and fan controllers, optionally with different\n"
+        "settings, and prints the fan targets they would have issued.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace", "Recorded control trace");
+
+    QCommandLineOption sensor("sensor", "Make fan follow sensor index (-1 = off).", "fan:index");
+    QCommandLineOption curve("curve", "Ramp from min to max °C.", "fan:min:max");
+    QCommandLineOption hysteresis("hysteresis", "Temperature hysteresis in °C.", "fan:celsius");
+    QCommandLineOption deadband("deadband", "RPM deadband.", "fan:rpm");
+    QCommandLineOption lead("lead", "Feed-forward lead in seconds.", "fan:seconds");
+    QCommandLineOption boost("boost", "°C added at 100% CPU load.", "fan:celsius");
+    QCommandLineOption filter("filter", "Default sensor filter for all sensors, e.g. \"median:3 ema:0.5\".", "spec");
+    QCommandLineOption commands("commands", "Print every fan target as \"ms fan rpm\".");
+    QCommandLineOption repeat("repeat", "Replay n times (timing and determinism check).", "n", "1");
+    parser.addOptions({sensor, curve, hysteresis, deadband, lead, boost, filter, commands, repeat});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    ControlTraceReplay replay;
+    QString errorMessage;
+    if (!replay.load(parser.positionalArguments().first(), &errorMessage)) {
+        fprintf(stderr, "%s\n", errorMessage.toLocal8Bit().constData());
+        return 1;
+    }
+
+    // Overrides start from the recorded configuration of each fan
+    QVector<TraceFanConfig> fans = replay.getRecordedFans();
+    QVector<bool> overridden(fans.size(), false);
+    struct FanOption {
+        const QCommandLineOption *option;
+        int values;
+    };
+    const FanOption fanOptions[] = {
+        {&sensor, 1}, {&curve, 2}, {&hysteresis, 1}, {&deadband, 1}, {&lead, 1}, {&boost, 1}
+    };
+    for (const FanOption& fanOption : fanOptions) {
+        for (const QString& value : parser.values(*fanOption.option)) {
+            int fan;
+            double args[2];
+            if (!parseFanOverride(value, fanOption.values, &fan, args) || fan >= fans.size()) {
+                fprintf(stderr, "Invalid --%s %s\n",
+                        fanOption.option->names().first().toLocal8Bit().constData(),
+                        value.toLocal8Bit().constData());
+                return 1;
+            }
+            TraceFanConfig& config = fans[fan];
+            if (fanOption.option == &sensor) {
+                config.sensorIndex = static_cast<int>(args[0]);
+            } else if (fanOption.option == &curve) {
+                config.minTemp = static_cast<int>(args[0]);
+                config.maxTemp = static_cast<int>(args[1]);
+            } else if (fanOption.option == &hysteresis) {
+                config.hysteresis = args[0];
+            } else if (fanOption.option == &deadband) {
+                config.rpmDeadband = static_cast<int>(args[0]);
+            } else if (fanOption.option == &lead) {
+                config.leadSeconds = args[0];
+            } else {
+                config.cpuLoadBoost = args[0];
+            }
+            overridden[fan] = true;
+        }
+    }
+    for (int i = 0; i < fans.size(); i++) {
+        if (overridden[i]) {
+            replay.overrideFan(i, fans[i]);
+        }
+    }
+    if (parser.isSet(filter)) {
+        bool ok = false;
+        SensorFilterSpec spec = SensorFilterSpec::fromString(parser.value(filter), &ok);
+        if (!ok) {
+            fprintf(stderr, "Invalid --filter %s\n", parser.value(filter).toLocal8Bit().constData());
+            return 1;
+        }
+        replay.overrideFilter(spec);
+    }
+
+    int runs = qMax(1, parser.value(repeat).toInt());
+    QElapsedTimer timer;
+    timer.start();
+    ControlTraceReplay::Result result = replay.run();
+    for (int i = 1; i < runs; i++) {
+        ControlTraceReplay::Result again = replay.run();
+        bool identical = again.commands.size() == result.commands.size();
+        for (int c = 0; identical && c < again.commands.size(); c++) {
+            identical = again.commands[c].timestampMs == result.commands[c].timestampMs &&
+                        again.commands[c].fan == result.commands[c].fan &&
+                        again.commands[c].rpm == result.commands[c].rpm;
+        }
+        if (!identical) {
+            fprintf(stderr, "Replay %d differs from the first one\n", i + 1);
+            return 2;
+        }
+    }
+    double wallMs = timer.nsecsElapsed() / 1.0e6 / runs;
+
+    if (parser.isSet(commands)) {
+        for (const TraceCommand& command : result.commands) {
+            printf("%lld %d %d\n", static_cast<long long>(command.timestampMs), command.fan, command.rpm);
+        }
+    }
+
+    fprintf(stderr, "%s: %d ticks over %.1f s, %d fan(s)\n",
+            replay.getMacModel().toLocal8Bit().constData(), result.ticks,
+            result.durationMs / 1000.0, fans.size());
+    fprintf(stderr, "Replayed in %.2f ms (%.0fx real time)\n",
+            wallMs, wallMs > 0.0 ? result.durationMs / wallMs : 0.0);
+    fprintf(stderr, "Commands: %d issued, %d recorded, %d identical to the recording\n",
+            result.commands.size(), result.recordedWrites, result.matchingWrites);
+    return 0;
+}
@@ -0,0 +1,18 @@
+QT       += core
+QT       -= gui
+CONFIG   += c++11 console
+CONFIG   -= app_bundle
+TARGET   = macsfancontrol-replay
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    ../../src/controltrace.cpp \
+    ../../src/sensorfilter.cpp \
+    ../../src/virtualsensors.cpp \
+    ../../src/fancontroller.cpp
+
+# Compiler flags
+QMAKE_CXXFLAGS += -Wall -Wextra
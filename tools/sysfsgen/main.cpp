@@ -0,0 +1,115 @@
+#include "synthetictree.h"
+#include "sysfsscript.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <csignal>
+#include <cstdio>
+
+// Set from SIGINT/SIGTERM; checked by the update timer
+static volatile sig_atomic_t g_interrupted = 0;
+
+static void handleSignal(int)
+{
+    g_interrupted = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("macsfancontrol-sysfsgen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Builds a fake applesmc/hwmon sysfs tree for macsfancontrol --sysfs-root,\n"
+        "optionally driving it with a script of value changes and injected faults.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("root", "Directory to build the tree in");
+
+    QCommandLineOption smcFans("smc-fans", "applesmc fans (1-6).", "n", "2");
+    QCommandLineOption smcSensors("smc-sensors", "applesmc temperature sensors (0-68).", "n", "40");
+    QCommandLineOption hwmonDevices("hwmon-devices", "Extra hwmon devices.", "n", "2");
+    QCommandLineOption hwmonSensors("hwmon-sensors", "Temperature sensors per hwmon device.", "n", "8");
+    QCommandLineOption hwmonFans("hwmon-fans", "PWM fans per hwmon device.", "n", "1");
+    QCommandLineOption model("model", "DMI product name.", "name", "MacPro5,1");
+    QCommandLineOption script("script", "Run a script of value changes and faults.", "file");
+    QCommandLineOption rate("rate", "Script updates per second.", "hz", "10");
+    QCommandLineOption speed("speed", "Script time multiplier.", "factor", "1");
+    QCommandLineOption loop("loop", "Restart the script when it ends.");
+    QCommandLineOption hold("hold", "Keep running after the script ends (serves slow reads and sines).");
+    parser.addOptions({smcFans, smcSensors, hwmonDevices, hwmonSensors, hwmonFans, model,
+                       script, rate, speed, loop, hold});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    SyntheticSysfsTree::Options options;
+    options.smcFans = parser.value(smcFans).toInt();
+    options.smcSensors = parser.value(smcSensors).toInt();
+    options.hwmonDevices = parser.value(hwmonDevices).toInt();
+    options.hwmonSensorsPerDevice = parser.value(hwmonSensors).toInt();
+    options.hwmonFansPerDevice = parser.value(hwmonFans).toInt();
+    options.macModel = parser.value(model);
+
+    SysfsScript events;
+    if (parser.isSet(script)) {
+        QString errorMessage;
+        if (!events.load(parser.value(script), &errorMessage)) {
+            fprintf(stderr, "%s\n", errorMessage.toLocal8Bit().constData());
+            return 1;
+        }
+    }
+
+    SyntheticSysfsTree tree(options, parser.positionalArguments().first());
+    if (!tree.isValid()) {
+        fprintf(stderr, "Cannot build the tree under %s\n",
+                parser.positionalArguments().first().toLocal8Bit().constData());
+        return 1;
+    }
+    printf("Built %s: %d sensors, %d value files\n", tree.root().toLocal8Bit().constData(),
+           tree.sensorCount(), tree.valueFiles().size());
+    printf("Run: macsfancontrol --sysfs-root %s\n", tree.root().toLocal8Bit().constData());
+    fflush(stdout);
+
+    if (!parser.isSet(script) && !parser.isSet(hold)) {
+        return 0;
+    }
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+
+    double timeScale = qMax(0.001, parser.value(speed).toDouble());
+    int intervalMs = qMax(1, qRound(1000.0 / qMax(0.1, parser.value(rate).toDouble())));
+    bool looping = parser.isSet(loop);
+    bool holding = parser.isSet(hold);
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 offsetMs = 0;   // Clock time at which the current script pass started
+
+    QTimer timer;
+    QObject::connect(&timer, &QTimer::timeout, [&]() {
+        if (g_interrupted) {
+            app.quit();
+            return;
+        }
+        double seconds = (clock.elapsed() - offsetMs) / 1000.0 * timeScale;
+        events.step(tree, seconds);
+        if (events.isFinished(seconds)) {
+            if (looping && events.eventCount() > 0) {
+                events.rewind();
+                offsetMs = clock.elapsed();
+            } else if (!holding) {
+                app.quit();
+            }
+        }
+    });
+    timer.start(intervalMs);
+
+    int result = app.exec();
+    printf("Stopped with %d injected fault(s) left in place\n", tree.faultCount());
+    return result;
+}
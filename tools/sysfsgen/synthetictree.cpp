@@ -0,0 +1,313 @@
+#include "synthetictree.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QThread>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// SMC keys with descriptions, so getDescription() hits its tables
+const char *const SMC_KEYS[] = {
+    "TA0P", "TC0C", "TC1C", "TC2C", "TC3C", "TC4C", "TC5C", "TC6C", "TC7C",
+    "TC8C", "TC9C", "TC10C", "TC11C", "TC0D", "TC1D", "TC0E", "TC0F", "TC0H",
+    "TC0P", "TCAC", "TCAD", "TCAG", "TCAH", "TCAS", "TCBC", "TCBD", "TCBG",
+    "TCBH", "TCBS", "TH1P", "TH2P", "TH3P", "TH4P", "TM1P", "TM2P", "TM3P",
+    "TM4P", "TM5P", "TM6P", "TM7P", "TM8P", "TN0D", "TN0H", "Te1P", "Tp0C",
+    "Tp1C"
+};
+const int SMC_KEY_COUNT = sizeof(SMC_KEYS) / sizeof(SMC_KEYS[0]);
+
+const char *const SMC_PREFIX = "sys/devices/platform/applesmc.768/";
+const char *const HWMON_PREFIX = "sys/class/hwmon/";
+
+} // namespace
+
+// Serves one FIFO: every reader that opens it gets the current value after
+// delayMs, like a sysfs attribute behind a slow bus transaction.
+class SlowReadServer : public QThread {
+public:
+    SlowReadServer(const QString& path, int delayMs, int value)
+        : path(QFile::encodeName(path)), delayMs(delayMs), value(value), stopping(false)
+    {
+    }
+
+    void setValue(int v) { value.store(v); }
+    void setDelay(int ms) { delayMs.store(ms); }
+
+    void shutdown()
+    {
+        stopping.store(true);
+        // The thread is usually blocked in open() waiting for a reader
+        while (!wait(20)) {
+            int fd = ::open(path.constData(), O_RDONLY | O_NONBLOCK);
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+protected:
+    void run() override
+    {
+        while (!stopping.load()) {
+            int fd = ::open(path.constData(), O_WRONLY);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (!stopping.load()) {
+                msleep(delayMs.load());
+                QByteArray line = QByteArray::number(value.load()) + "\n";
+                ssize_t written = ::write(fd, line.constData(), line.size());
+                Q_UNUSED(written);  // The reader may have given up
+            }
+            ::close(fd);
+        }
+    }
+
+private:
+    QByteArray path;
+    std::atomic<int> delayMs;
+    std::atomic<int> value;
+    std::atomic<bool> stopping;
+};
+
+SyntheticSysfsTree::SyntheticSysfsTree(const Options& opts)
+    : options(opts),
+      tempDir(new QTemporaryDir),
+      valid(false)
+{
+    if (tempDir->isValid()) {
+        rootPath = tempDir->path();
+        build();
+    }
+}
+
+SyntheticSysfsTree::SyntheticSysfsTree(const Options& opts, const QString& path)
+    : options(opts),
+      tempDir(nullptr),
+      rootPath(QDir(path).absolutePath()),
+      valid(false)
+{
+    if (QDir().mkpath(rootPath)) {
+        build();
+    }
+}
+
+SyntheticSysfsTree::~SyntheticSysfsTree()
+{
+    // Leave no FIFOs behind that would block readers forever
+    for (const QString& path : slowServers.keys()) {
+        restore(path);
+    }
+    delete tempDir;
+}
+
+void SyntheticSysfsTree::build()
+{
+    options.smcFans = qBound(1, options.smcFans, 6);
+    options.smcSensors = qBound(0, options.smcSensors, 68);
+    options.hwmonDevices = qMax(0, options.hwmonDevices);
+    options.hwmonSensorsPerDevice = qMax(0, options.hwmonSensorsPerDevice);
+    options.hwmonFansPerDevice = qMax(0, options.hwmonFansPerDevice);
+
+    bool ok = writeFile("sys/devices/virtual/dmi/id/product_name", options.macModel);
+
+    const QString smc = SMC_PREFIX;
+    for (int i = 1; i <= options.smcFans; i++) {
+        QString fan = smc + "fan" + QString::number(i);
+        ok = ok && setValue(fan + "_input", 1200 + 100 * i)
+                && writeFile(fan + "_label", QString("Fan %1").arg(i))
+                && writeFile(fan + "_min", "800")
+                && writeFile(fan + "_max", "5200")
+                && writeFile(fan + "_manual", "0")
+                && setValue(fan + "_output", 1200);
+    }
+    for (int i = 1; i <= options.smcSensors; i++) {
+        QString temp = smc + "temp" + QString::number(i);
+        ok = ok && setValue(temp + "_input", 40000 + 250 * i)
+                && writeFile(temp + "_label", smcLabel(i));
+    }
+
+    // Generic Super I/O chips; names must not be in smcDuplicateDevices
+    for (int d = 0; d < options.hwmonDevices; d++) {
+        QString device = QString("%1hwmon%2/").arg(HWMON_PREFIX).arg(d);
+        ok = ok && writeFile(device + "name", QString("nct%1").arg(6775 + d));
+        for (int j = 1; j <= options.hwmonSensorsPerDevice; j++) {
+            QString temp = device + "temp" + QString::number(j);
+            ok = ok && setValue(temp + "_input", 35000 + 500 * (j % 40))
+                    && writeFile(temp + "_label", QString("AUXTIN%1").arg(j - 1));
+        }
+        for (int j = 1; j <= options.hwmonFansPerDevice; j++) {
+            QString index = QString::number(j);
+            ok = ok && setValue(device + "fan" + index + "_input", 900)
+                    && writeFile(device + "fan" + index + "_min", "0")
+                    && writeFile(device + "fan" + index + "_max", "2000")
+                    && setValue(device + "pwm" + index, 128)
+                    && writeFile(device + "pwm" + index + "_enable", "2");
+        }
+    }
+
+    valid = ok;
+}
+
+QString SyntheticSysfsTree::resolve(const QString& path) const
+{
+    if (path.startsWith("applesmc/")) {
+        return SMC_PREFIX + path.mid(9);
+    }
+    if (path.startsWith("hwmon")) {
+        return HWMON_PREFIX + path;
+    }
+    return path;
+}
+
+QStringList SyntheticSysfsTree::match(const QString& pattern) const
+{
+    QString resolved = resolve(pattern);
+    if (!resolved.contains('*') && !resolved.contains('?') && !resolved.contains('[')) {
+        return files.contains(resolved) ? QStringList(resolved) : QStringList();
+    }
+    QRegularExpression re(QRegularExpression::wildcardToRegularExpression(resolved));
+    return files.filter(re);
+}
+
+bool SyntheticSysfsTree::setValue(const QString& path, int value)
+{
+    QString file = resolve(path);
+    if (!values.contains(file)) {
+        files.append(file);
+    }
+    values[file] = value;
+
+    switch (states.value(file, STATE_NORMAL)) {
+    case STATE_NORMAL:
+        return writeFile(file, QString::number(value));
+    case STATE_SLOW:
+        slowServers[file]->setValue(value);
+        return true;
+    default:
+        return true;        // Applied on restore()
+    }
+}
+
+int SyntheticSysfsTree::getValue(const QString& path) const
+{
+    return values.value(resolve(path), -1);
+}
+
+bool SyntheticSysfsTree::injectFailure(const QString& path)
+{
+    QString file = resolve(path);
+    if (!replaceFile(file)) {
+        return false;
+    }
+    // Dangling symlink: open() fails with ENOENT, even for root
+    QByteArray link = QFile::encodeName(rootPath + "/" + file);
+    if (::symlink((link + ".missing").constData(), link.constData()) != 0) {
+        return false;
+    }
+    states[file] = STATE_FAILING;
+    return true;
+}
+
+bool SyntheticSysfsTree::injectGarbage(const QString& path)
+{
+    QString file = resolve(path);
+    if (!replaceFile(file) || !writeFile(file, "garbage")) {
+        return false;
+    }
+    states[file] = STATE_GARBAGE;
+    return true;
+}
+
+bool SyntheticSysfsTree::injectDelay(const QString& path, int delayMs)
+{
+    QString file = resolve(path);
+    if (states.value(file) == STATE_SLOW) {
+        slowServers[file]->setDelay(delayMs);
+        return true;
+    }
+    if (!replaceFile(file)) {
+        return false;
+    }
+
+    QString absolute = rootPath + "/" + file;
+    if (::mkfifo(QFile::encodeName(absolute).constData(), 0666) != 0) {
+        return false;
+    }
+
+    // Readers that give up early must not kill the server with SIGPIPE
+    ::signal(SIGPIPE, SIG_IGN);
+
+    SlowReadServer *server = new SlowReadServer(absolute, delayMs, values.value(file));
+    server->start();
+    slowServers[file] = server;
+    states[file] = STATE_SLOW;
+    return true;
+}
+
+bool SyntheticSysfsTree::restore(const QString& path)
+{
+    QString file = resolve(path);
+    if (!states.contains(file)) {
+        return true;
+    }
+    if (!replaceFile(file)) {
+        return false;
+    }
+    return writeFile(file, QString::number(values.value(file)));
+}
+
+int SyntheticSysfsTree::faultCount() const
+{
+    return states.size();
+}
+
+QString SyntheticSysfsTree::smcLabel(int n)
+{
+    if (n >= 1 && n <= SMC_KEY_COUNT) {
+        return SMC_KEYS[n - 1];
+    }
+    return QString("TX%1P").arg(n);      // Unknown key: description falls back to the label
+}
+
+bool SyntheticSysfsTree::writeFile(const QString& relativePath, const QString& content)
+{
+    QString path = rootPath + "/" + relativePath;
+    if (!QDir().mkpath(QFileInfo(path).path())) {
+        return false;
+    }
+
+    // Replace atomically so concurrent readers never see a half-written value
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    file.write(content.toUtf8() + "\n");
+    return file.commit();
+}
+
+bool SyntheticSysfsTree::replaceFile(const QString& relativePath)
+{
+    SlowReadServer *server = slowServers.take(relativePath);
+    if (server) {
+        server->shutdown();
+        delete server;
+    }
+    states.remove(relativePath);
+
+    // unlink() removes symlinks and FIFOs themselves
+    QByteArray path = QFile::encodeName(rootPath + "/" + relativePath);
+    return ::unlink(path.constData()) == 0 || errno == ENOENT;
+}
@@ -0,0 +1,81 @@
+#ifndef SYNTHETICTREE_H
+#define SYNTHETICTREE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+
+class SlowReadServer;
+
+// Fake sysfs tree laid out like an applesmc Mac with additional hwmon
+// devices, so the real backends can be run and load-tested on machines
+// without Apple hardware. Point SMCInterface/HWMonInterface at it with
+// setSysfsRoot(root()), or start the app with --sysfs-root.
+//
+// Paths passed to the methods below are relative to the root; the
+// shorthands "applesmc/temp3_input" and "hwmon2/pwm1" are accepted.
+class SyntheticSysfsTree {
+public:
+    struct Options {
+        int smcFans = 2;                // applesmc fans (1-6)
+        int smcSensors = 40;            // applesmc temperature sensors (0-68)
+        int hwmonDevices = 2;           // Extra hwmon devices
+        int hwmonSensorsPerDevice = 8;  // temp*_input per hwmon device
+        int hwmonFansPerDevice = 1;     // PWM fans per hwmon device
+        QString macModel = "MacPro5,1"; // DMI product_name
+    };
+
+    // Build in a fresh temporary directory that is removed again on destruction
+    explicit SyntheticSysfsTree(const Options& options);
+    // Build under rootPath (created if missing); the tree is left in place
+    SyntheticSysfsTree(const Options& options, const QString& rootPath);
+    ~SyntheticSysfsTree();
+
+    bool isValid() const { return valid; }
+    QString root() const { return rootPath; }
+    const Options& getOptions() const { return options; }
+    int sensorCount() const { return options.smcSensors + options.hwmonDevices * options.hwmonSensorsPerDevice; }
+
+    // Value files (temperatures, fan speeds, PWM), relative to the root
+    QStringList valueFiles() const { return files; }
+    QString resolve(const QString& path) const;
+    QStringList match(const QString& pattern) const;    // Shell wildcards
+
+    // Scripted changes and fault injection
+    bool setValue(const QString& path, int value);
+    int getValue(const QString& path) const;
+    bool injectFailure(const QString& path);            // Reads fail with ENOENT
+    bool injectGarbage(const QString& path);            // Reads return a non-integer
+    bool injectDelay(const QString& path, int delayMs); // Reads block for delayMs
+    bool restore(const QString& path);                  // Back to a plain file
+
+    int faultCount() const;
+
+    // Real SMC key used for synthetic sensor n (1-based)
+    static QString smcLabel(int n);
+
+private:
+    enum FileState {
+        STATE_NORMAL,
+        STATE_FAILING,
+        STATE_GARBAGE,
+        STATE_SLOW
+    };
+
+    Options options;
+    QTemporaryDir *tempDir;     // Only for trees in a temporary directory
+    QString rootPath;
+    bool valid;
+
+    QStringList files;
+    QHash<QString, int> values;             // Last value per file
+    QHash<QString, FileState> states;       // Files not in STATE_NORMAL
+    QHash<QString, SlowReadServer *> slowServers;
+
+    void build();
+    bool writeFile(const QString& relativePath, const QString& content);
+    bool replaceFile(const QString& relativePath);
+};
+
+#endif // SYNTHETICTREE_H
@@ -0,0 +1,18 @@
+QT       += core
+QT       -= gui
+CONFIG   += c++11 console
+CONFIG   -= app_bundle
+TARGET   = macsfancontrol-sysfsgen
+TEMPLATE = app
+
+SOURCES += \
+    main.cpp \
+    synthetictree.cpp \
+    sysfsscript.cpp
+
+HEADERS += \
+    synthetictree.h \
+    sysfsscript.h
+
+# Compiler flags
+QMAKE_CXXFLAGS += -Wall -Wextra
@@ -0,0 +1,229 @@
+#include "sysfsscript.h"
+#include "synthetictree.h"
+#include <QDebug>
+#include <QFile>
+#include <QRegularExpression>
+#include <QtMath>
+#include <algorithm>
+
+bool SysfsScript::load(const QString& path, QString *errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot read %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+    return parse(QString::fromUtf8(file.readAll()), errorMessage);
+}
+
+bool SysfsScript::parse(const QString& text, QString *errorMessage)
+{
+    static const struct {
+        const char *name;
+        Action action;
+        int args;
+    } actions[] = {
+        {"set", ACTION_SET, 1},
+        {"ramp", ACTION_RAMP, 3},
+        {"sine", ACTION_SINE, 3},
+        {"slow", ACTION_SLOW, 1},
+        {"fail", ACTION_FAIL, 0},
+        {"garbage", ACTION_GARBAGE, 0},
+        {"restore", ACTION_RESTORE, 0},
+    };
+
+    auto fail = [errorMessage](int line, const QString& message) {
+        if (errorMessage) {
+            *errorMessage = QString("Line %1: %2").arg(line).arg(message);
+        }
+        return false;
+    };
+
+    QVector<Event> parsed;
+    const QStringList lines = text.split('\n');
+    for (int i = 0; i < lines.size(); i++) {
+        QString line = lines[i];
+        int comment = line.indexOf('#');
+        if (comment >= 0) {
+            line.truncate(comment);
+        }
+        const QStringList tokens = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        if (tokens.isEmpty()) {
+            continue;
+        }
+        if (tokens.size() < 3) {
+            return fail(i + 1, "expected <seconds> <action> <path> [arguments]");
+        }
+
+        Event event;
+        event.line = i + 1;
+        event.pattern = tokens[2];
+        event.args[0] = event.args[1] = event.args[2] = 0.0;
+
+        bool ok = false;
+        event.time = tokens[0].toDouble(&ok);
+        if (!ok || event.time < 0.0) {
+            return fail(event.line, "invalid time " + tokens[0]);
+        }
+
+        int argCount = -1;
+        for (const auto& candidate : actions) {
+            if (tokens[1] == candidate.name) {
+                event.action = candidate.action;
+                argCount = candidate.args;
+                break;
+            }
+        }
+        if (argCount < 0) {
+            return fail(event.line, "unknown action " + tokens[1]);
+        }
+        if (tokens.size() != 3 + argCount) {
+            return fail(event.line, QString("%1 takes %2 argument(s)").arg(tokens[1]).arg(argCount));
+        }
+        for (int a = 0; a < argCount; a++) {
+            event.args[a] = tokens[3 + a].toDouble(&ok);
+            if (!ok) {
+                return fail(event.line, "invalid number " + tokens[3 + a]);
+            }
+        }
+        if ((event.action == ACTION_RAMP && event.args[2] <= 0.0) ||
+            (event.action == ACTION_SINE && event.args[2] <= 0.0) ||
+            (event.action == ACTION_SLOW && event.args[0] < 0.0)) {
+            return fail(event.line, "duration, period and delay must be positive");
+        }
+
+        parsed.append(event);
+    }
+
+    std::stable_sort(parsed.begin(), parsed.end(), [](const Event& a, const Event& b) {
+        return a.time < b.time;
+    });
+    events = parsed;
+    rewind();
+    return true;
+}
+
+void SysfsScript::rewind()
+{
+    nextEvent = 0;
+    running.clear();
+}
+
+double SysfsScript::duration() const
+{
+    double end = 0.0;
+    for (const Event& event : events) {
+        end = qMax(end, event.action == ACTION_RAMP ? event.time + event.args[2] : event.time);
+    }
+    return end;
+}
+
+bool SysfsScript::isFinished(double seconds) const
+{
+    return nextEvent >= events.size() && seconds >= duration();
+}
+
+QStringList SysfsScript::resolveFiles(SyntheticSysfsTree& tree, const QString& pattern) const
+{
+    QStringList files = tree.match(pattern);
+    if (!files.isEmpty() || !pattern.startsWith("applesmc/")) {
+        return files;
+    }
+
+    // applesmc/TC0C: look sensors up by label
+    QRegularExpression label(QRegularExpression::wildcardToRegularExpression(pattern.mid(9)));
+    for (int n = 1; n <= tree.getOptions().smcSensors; n++) {
+        if (label.match(SyntheticSysfsTree::smcLabel(n)).hasMatch()) {
+            files += tree.match(QString("applesmc/temp%1_input").arg(n));
+        }
+    }
+    return files;
+}
+
+void SysfsScript::stopRunning(const QStringList& files)
+{
+    for (int i = running.size() - 1; i >= 0; i--) {
+        for (const QString& file : files) {
+            running[i].files.removeOne(file);
+        }
+        if (running[i].files.isEmpty()) {
+            running.remove(i);
+        }
+    }
+}
+
+bool SysfsScript::step(SyntheticSysfsTree& tree, double seconds)
+{
+    bool ok = true;
+
+    for (; nextEvent < events.size() && events[nextEvent].time <= seconds; nextEvent++) {
+        const Event& event = events[nextEvent];
+        QStringList files = resolveFiles(tree, event.pattern);
+        if (files.isEmpty()) {
+            qWarning() << "Script line" << event.line << "matches no file:" << event.pattern;
+            continue;
+        }
+
+        switch (event.action) {
+        case ACTION_SET:
+            stopRunning(files);
+            for (const QString& file : files) {
+                ok = tree.setValue(file, qRound(event.args[0])) && ok;
+            }
+            break;
+        case ACTION_RAMP:
+        case ACTION_SINE:
+            stopRunning(files);
+            running.append({nextEvent, files});
+            break;
+        case ACTION_SLOW:
+            for (const QString& file : files) {
+                ok = tree.injectDelay(file, qRound(event.args[0])) && ok;
+            }
+            break;
+        case ACTION_FAIL:
+            for (const QString& file : files) {
+                ok = tree.injectFailure(file) && ok;
+            }
+            break;
+        case ACTION_GARBAGE:
+            for (const QString& file : files) {
+                ok = tree.injectGarbage(file) && ok;
+            }
+            break;
+        case ACTION_RESTORE:
+            for (const QString& file : files) {
+                ok = tree.restore(file) && ok;
+            }
+            break;
+        }
+    }
+
+    for (int i = running.size() - 1; i >= 0; i--) {
+        const Event& event = events[running[i].event];
+        double t = seconds - event.time;
+        double value;
+        bool done = false;
+        if (event.action == ACTION_RAMP) {
+            double fraction = qMin(1.0, t / event.args[2]);
+            value = event.args[0] + (event.args[1] - event.args[0]) * fraction;
+            done = fraction >= 1.0;
+        } else {
+            value = event.args[0] + event.args[1] * qSin(2.0 * M_PI * t / event.args[2]);
+        }
+
+        int rounded = qRound(value);
+        for (const QString& file : running[i].files) {
+            if (tree.getValue(file) != rounded) {
+                ok = tree.setValue(file, rounded) && ok;
+            }
+        }
+        if (done) {
+            running.remove(i);
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,70 @@
+#ifndef SYSFSSCRIPT_H
+#define SYSFSSCRIPT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class SyntheticSysfsTree;
+
+// Timed value changes and faults for a SyntheticSysfsTree. One event per
+// line, times in seconds from the start, '#' starts a comment:
+//
+//   0    set     applesmc/temp*_input 45000
+//   5    ramp    hwmon*/temp1_input 45000 90000 30   # from, to, seconds
+//   10   sine    applesmc/TC0C 60000 5000 8           # mean, amplitude, period
+//   20   slow    hwmon3/temp2_input 250               # every read blocks 250 ms
+//   25   fail    applesmc/temp5_input                 # reads fail with ENOENT
+//   25   garbage hwmon0/fan1_input                    # reads return non-numbers
+//   40   restore applesmc/temp5_input
+//
+// Paths accept shell wildcards; applesmc/LABEL names a sensor by its label.
+// A set, ramp or sine on a file ends any earlier ramp or sine on it.
+class SysfsScript {
+public:
+    bool load(const QString& path, QString *errorMessage);
+    bool parse(const QString& text, QString *errorMessage);
+
+    // Apply everything due at elapsed seconds (monotonic across calls) and
+    // advance running ramps and sines. Returns false if a step failed.
+    bool step(SyntheticSysfsTree& tree, double seconds);
+    void rewind();
+
+    // Time of the last event or end of the last ramp
+    double duration() const;
+    bool isFinished(double seconds) const;
+    int eventCount() const { return events.size(); }
+
+private:
+    enum Action {
+        ACTION_SET,
+        ACTION_RAMP,
+        ACTION_SINE,
+        ACTION_SLOW,
+        ACTION_FAIL,
+        ACTION_GARBAGE,
+        ACTION_RESTORE
+    };
+
+    struct Event {
+        double time;            // Seconds from start
+        Action action;
+        QString pattern;        // Path or wildcard, shorthand allowed
+        double args[3];         // Action parameters in script order
+        int line;               // Script line, for error messages
+    };
+
+    struct Running {
+        int event;              // Index into events
+        QStringList files;
+    };
+
+    QVector<Event> events;      // Sorted by time
+    int nextEvent = 0;
+    QVector<Running> running;   // Ramps and sines in progress
+
+    QStringList resolveFiles(SyntheticSysfsTree& tree, const QString& pattern) const;
+    void stopRunning(const QStringList& files);
+};
+
+#endif // SYSFSSCRIPT_H
@@ -0,0 +1,282 @@
+#include "thermalmodel.h"
+#include "fancontroller.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstdio>
+
+struct LoadSample {
+    double time;            // Seconds
+    double utilization;     // 0.0-1.0
+};
+
+// One point of the sweep grid
+struct SweepConfig {
+    int minTemp;
+    int maxTemp;
+    double hysteresis;
+    double lead;
+    double boost;
+};
+
+struct SweepResult {
+    SweepConfig config;
+    double peakTemp;        // °C at the controlled sensor
+    double secondsAbove;    // Time above the limit
+    double meanRPM;         // Across all fans
+    int writes;             // Fan target changes
+};
+
+// Shared, read-only inputs of every run
+struct SweepSetup {
+    ThermalModel model;
+    QVector<LoadSample> trace;
+    int node;               // Node behind the controlled sensor
+    double limit;           // °C
+    double tick;            // Controller period, seconds
+};
+
+static bool loadTrace(const QString& path, QVector<LoadSample> *trace, QString *errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *errorMessage = QString("Cannot open trace %1").arg(path);
+        return false;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QStringList fields = line.split(',');
+        bool timeOk = false;
+        bool loadOk = false;
+        double time = fields.value(0).toDouble(&timeOk);
+        double utilization = fields.value(1).toDouble(&loadOk);
+        if (!timeOk || !loadOk) {
+            *errorMessage = QString("%1: invalid line \"%2\"").arg(path, line);
+            return false;
+        }
+        trace->append({time, utilization});
+    }
+    if (trace->isEmpty()) {
+        *errorMessage = QString("%1: no samples").arg(path);
+        return false;
+    }
+    return true;
+}
+
+// Parses "value" or "from:to[:step]" into the list of values to sweep
+static bool parseRange(const QString& text, QVector<double> *values)
+{
+    const QStringList parts = text.split(':');
+    if (parts.size() > 3) {
+        return false;
+    }
+    bool ok = false;
+    double from = parts.value(0).toDouble(&ok);
+    double to = from;
+    double step = 1.0;
+    if (ok && parts.size() > 1) {
+        to = parts[1].toDouble(&ok);
+    }
+    if (ok && parts.size() > 2) {
+        step = parts[2].toDouble(&ok);
+    }
+    if (!ok || step <= 0.0 || to < from) {
+        return false;
+    }
+    values->clear();
+    for (double value = from; value <= to + step * 1e-6; value += step) {
+        values->append(value);
+    }
+    return true;
+}
+
+static SweepResult simulate(const SweepSetup& setup, const SweepConfig& config)
+{
+    ThermalSimulator simulator(setup.model);
+    QVector<FanController> controllers;
+    for (const FanInfo& fan : simulator.getFans()) {
+        FanController controller(fan.minRPM, fan.maxRPM);
+        controller.setCurve(config.minTemp, config.maxTemp);
+        controller.setHysteresis(config.hysteresis, controller.getRPMDeadband());
+        controller.setFeedForward(config.lead, config.boost);
+        controllers.append(controller);
+        simulator.setFanManualMode(fan.index - 1, true);
+    }
+
+    SweepResult result = {config, 0.0, 0.0, 0.0, 0};
+    double rpmSum = 0.0;
+    int samples = 0;
+    int sample = 0;
+    double end = setup.trace.last().time;
+    for (double time = setup.trace.first().time; time <= end; time += setup.tick) {
+        while (sample + 1 < setup.trace.size() && setup.trace[sample + 1].time <= time) {
+            sample++;
+        }
+        double utilization = setup.trace[sample].utilization;
+        simulator.setLoad(utilization);
+
+        double temperature = simulator.getNodeTemperature(setup.node);
+        int reading = qRound(temperature * 1000.0);
+        qint64 timestampMs = static_cast<qint64>(time * 1000.0);
+        for (int i = 0; i < controllers.size(); i++) {
+            int target;
+            controllers[i].setCpuLoad(utilization);
+            if (controllers[i].update(reading, timestampMs, &target)) {
+                simulator.setFanSpeed(i, target);
+                result.writes++;
+            }
+            rpmSum += simulator.getFanCurrentRPM(i);
+            samples++;
+        }
+
+        result.peakTemp = qMax(result.peakTemp, temperature);
+        if (temperature > setup.limit) {
+            result.secondsAbove += setup.tick;
+        }
+        simulator.step(setup.tick);
+    }
+    result.meanRPM = samples > 0 ? rpmSum / samples : 0.0;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("macsfancontrol-thermalsim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Runs the fan controller against a lumped thermal model driven by a CPU\n"
+        "utilization trace, for every combination of the swept settings, and ranks\n"
+        "the settings by time above the limit, then mean fan speed.\n"
+        "Ranges are \"value\" or \"from:to[:step]\".");
+    parser.addHelpOption();
+    parser.addPositionalArgument("model", "Thermal model (.ini)");
+    parser.addPositionalArgument("trace", "CPU utilization trace (time_s,cpu_utilization)");
+
+    QCommandLineOption sensor("sensor", "Sensor all fans follow (default: first sensor).", "label");
+    QCommandLineOption minTemp("min-temp", "Curve start in °C.", "range", "45");
+    QCommandLineOption maxTemp("max-temp", "Curve end in °C.", "range", "85");
+    QCommandLineOption hysteresis("hysteresis", "Temperature hysteresis in °C.", "range", "2");
+    QCommandLineOption lead("lead", "Feed-forward lead in seconds.", "range", "0");
+    QCommandLineOption boost("boost", "°C added at 100% CPU load.", "range", "0");
+    QCommandLineOption limit("limit", "Temperature limit in °C.", "celsius", "80");
+    QCommandLineOption tick("tick", "Controller period in seconds.", "seconds", "1");
+    QCommandLineOption threads("threads", "Worker threads (default: all cores).", "n");
+    QCommandLineOption top("top", "Number of results to print.", "n", "10");
+    parser.addOptions({sensor, minTemp, maxTemp, hysteresis, lead, boost, limit, tick, threads, top});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 2) {
+        parser.showHelp(1);
+    }
+
+    SweepSetup setup;
+    QString errorMessage;
+    if (!setup.model.load(parser.positionalArguments()[0], &errorMessage) ||
+        !loadTrace(parser.positionalArguments()[1], &setup.trace, &errorMessage)) {
+        fprintf(stderr, "%s\n", errorMessage.toLocal8Bit().constData());
+        return 1;
+    }
+
+    setup.node = -1;
+    for (int i = 0; i < setup.model.nodes.size() && setup.node < 0; i++) {
+        const QString& label = setup.model.nodes[i].sensorLabel;
+        if (!label.isEmpty() && (!parser.isSet(sensor) || label == parser.value(sensor))) {
+            setup.node = i;
+        }
+    }
+    if (setup.node < 0) {
+        fprintf(stderr, "Model has no sensor %s\n", parser.value(sensor).toLocal8Bit().constData());
+        return 1;
+    }
+    setup.limit = parser.value(limit).toDouble();
+    setup.tick = parser.value(tick).toDouble();
+    if (setup.tick <= 0.0) {
+        fprintf(stderr, "Invalid --tick %s\n", parser.value(tick).toLocal8Bit().constData());
+        return 1;
+    }
+
+    const QCommandLineOption *rangeOptions[] = {&minTemp, &maxTemp, &hysteresis, &lead, &boost};
+    QVector<double> ranges[5];
+    for (int i = 0; i < 5; i++) {
+        if (!parseRange(parser.value(*rangeOptions[i]), &ranges[i])) {
+            fprintf(stderr, "Invalid --%s %s\n",
+                    rangeOptions[i]->names().first().toLocal8Bit().constData(),
+                    parser.value(*rangeOptions[i]).toLocal8Bit().constData());
+            return 1;
+        }
+    }
+
+    QVector<SweepConfig> configs;
+    for (double from : ranges[0]) {
+        for (double to : ranges[1]) {
+            if (to <= from) {
+                continue;
+            }
+            for (double band : ranges[2]) {
+                for (double leadSeconds : ranges[3]) {
+                    for (double boostCelsius : ranges[4]) {
+                        configs.append({qRound(from), qRound(to), band, leadSeconds, boostCelsius});
+                    }
+                }
+            }
+        }
+    }
+    if (configs.isEmpty()) {
+        fprintf(stderr, "No configuration with --max-temp above --min-temp\n");
+        return 1;
+    }
+
+    if (parser.isSet(threads)) {
+        QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, parser.value(threads).toInt()));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::function<SweepResult(const SweepConfig&)> run = [&setup](const SweepConfig& config) {
+        return simulate(setup, config);
+    };
+    QVector<SweepResult> results = QtConcurrent::blockingMapped<QVector<SweepResult>>(configs, run);
+    double wallSeconds = timer.nsecsElapsed() / 1.0e9;
+
+    std::sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b) {
+        if (a.secondsAbove != b.secondsAbove) {
+            return a.secondsAbove < b.secondsAbove;
+        }
+        if (a.meanRPM != b.meanRPM) {
+            return a.meanRPM < b.meanRPM;
+        }
+        return a.writes < b.writes;
+    });
+
+    const ThermalNode& node = setup.model.nodes[setup.node];
+    double traceSeconds = setup.trace.last().time - setup.trace.first().time;
+    printf("%s, sensor %s, limit %.1f °C, %d configuration(s) over %.0f s of trace\n",
+           setup.model.name.toLocal8Bit().constData(), node.sensorLabel.toLocal8Bit().constData(),
+           setup.limit, configs.size(), traceSeconds);
+    printf("%6s %6s %6s %6s %6s %8s %8s %8s %7s\n",
+           "min", "max", "hyst", "lead", "boost", "peak", "above", "meanRPM", "writes");
+    int shown = qMin(results.size(), qMax(0, parser.value(top).toInt()));
+    for (int i = 0; i < shown; i++) {
+        const SweepResult& r = results[i];
+        printf("%6d %6d %6.1f %6.1f %6.1f %8.1f %8.0f %8.0f %7d\n",
+               r.config.minTemp, r.config.maxTemp, r.config.hysteresis, r.config.lead,
+               r.config.boost, r.peakTemp, r.secondsAbove, r.meanRPM, r.writes);
+    }
+    fprintf(stderr, "Simulated in %.2f s on %d thread(s): %.0f configurations/s, %.0fx real time per thread\n",
+            wallSeconds, QThreadPool::globalInstance()->maxThreadCount(),
+            wallSeconds > 0.0 ? configs.size() / wallSeconds : 0.0,
+            wallSeconds > 0.0 ? traceSeconds * configs.size() / wallSeconds
+                                / QThreadPool::globalInstance()->maxThreadCount() : 0.0);
+    return 0;
+}
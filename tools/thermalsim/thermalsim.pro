@@ -0,0 +1,19 @@
+QT       += core concurrent
+QT       -= gui
+CONFIG   += c++11 console
+CONFIG   -= app_bundle
+TARGET   = macsfancontrol-thermalsim
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    ../../src/thermalmodel.cpp \
+    ../../src/fancontroller.cpp
+
+HEADERS += \
+    ../../src/thermalmodel.h
+
+# Compiler flags
+QMAKE_CXXFLAGS += -Wall -Wextra